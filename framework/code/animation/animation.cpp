@@ -9,7 +9,11 @@
 #include "animation.hpp"
 #include "skeleton.hpp"
 #include "skeletonData.hpp"
+#include "skinData.hpp"
+#include "system/simd_common.hpp"
+#include "system/Worker.h"
 #include <algorithm>
+#include <cassert>
 #include <iterator>
 #include <optional>
 #include <string>
@@ -23,82 +27,248 @@ Animation::Animation(AnimationData&& d)
     : m_AnimationData(std::move(d))
 {
     // Find the 'biggest' timestamp value in the animation to determine the enimation length
+    uint32_t endTime = 0;
     for (const auto& animNode : m_AnimationData.GetNodes())
-        if (!animNode.Frames.empty() && animNode.Frames.back().Timestamp > m_EndTime)
-            m_EndTime = animNode.Frames.back().Timestamp;
+    {
+        if (!animNode.Translation.Times.empty())
+            endTime = std::max(endTime, (uint32_t)animNode.Translation.Times.back());
+        if (!animNode.Rotation.Times.empty())
+            endTime = std::max(endTime, (uint32_t)animNode.Rotation.Times.back());
+        if (!animNode.Scale.Times.empty())
+            endTime = std::max(endTime, (uint32_t)animNode.Scale.Times.back());
+    }
+    m_EndTime = float(endTime) * m_AnimationData.GetTimeQuantum();
+    m_InvTimeQuantum = m_AnimationData.GetTimeQuantum() > 0.0f ? 1.0f / m_AnimationData.GetTimeQuantum() : 0.0f;
 }
 
 Animation::~Animation()
 {
 }
 
-static float CalcFrameMix(const std::vector<AnimationFrameData>& frames, float time, float loopTime, uint32_t& startFrameIdx, uint32_t& nextFrameIdx)
+/// Find the keys either side of 'time' and return the interpolation amount between them.
+/// @param keyTimes quantized key times (must not be empty)
+/// @param time and loopTime are in quantized time units
+/// @param keyDt output time between the two keys (quantized time units)
+static float CalcKeyMix(const std::vector<uint16_t>& keyTimes, float time, float loopTime, uint32_t& startKeyIdx, uint32_t& nextKeyIdx, float& keyDt)
 {
-    const AnimationFrameData* pStartFrame = &frames[(startFrameIdx < frames.size()) ? startFrameIdx:0];
-    if (time > pStartFrame->Timestamp)
+    const uint16_t* pStartKey = &keyTimes[(startKeyIdx < keyTimes.size()) ? startKeyIdx : 0];
+    if (time > float(*pStartKey))
     {
-        while (pStartFrame <= &frames.back() && (time > pStartFrame->Timestamp))
-            ++pStartFrame;
-        pStartFrame--;
+        while (pStartKey <= &keyTimes.back() && (time > float(*pStartKey)))
+            ++pStartKey;
+        pStartKey--;
     }
     else
     {
-        while (pStartFrame != &frames.front() && (time < pStartFrame->Timestamp))
-            --pStartFrame;
+        while (pStartKey != &keyTimes.front() && (time < float(*pStartKey)))
+            --pStartKey;
     }
-    startFrameIdx = (uint32_t)(pStartFrame - &frames.front());
-    nextFrameIdx = startFrameIdx + 1;
+    startKeyIdx = (uint32_t)(pStartKey - &keyTimes.front());
+    nextKeyIdx = startKeyIdx + 1;
 
-    float frameDt = 0.0f;
+    keyDt = 0.0f;
     // Fix cases where we are straddling the 'loop'
-    if (nextFrameIdx >= frames.size())
+    if (nextKeyIdx >= keyTimes.size())
     {
-        nextFrameIdx = 0;
-        frameDt = loopTime;
+        nextKeyIdx = 0;
+        keyDt = loopTime;
     }
 
-    const auto& nextFrame = frames[nextFrameIdx];
-    frameDt += nextFrame.Timestamp - pStartFrame->Timestamp;
-    if (frameDt <= 0.0001f)
+    keyDt += float(keyTimes[nextKeyIdx]) - float(*pStartKey);
+    if (keyDt <= 0.0001f)
         return 0.0f;
-    return (time - pStartFrame->Timestamp) / frameDt;
+    return (time - float(*pStartKey)) / keyDt;
 }
 
-glm::vec3 Animation::CalcLocalTranslation(uint32_t animationNodeIdx, float time, uint32_t& startFrameIdx) const
+/// Binary search for the key at (or before) 'time' (in quantized time units).  Used as the starting point for CalcKeyMix when there is no hint.
+static uint32_t FindKey(const std::vector<uint16_t>& keyTimes, float time)
 {
-    const auto& frames = m_AnimationData.GetNodes()[animationNodeIdx].Frames;
-    if (frames.empty())
-        return { 0.0f,0.0f,0.0f };
+    const auto it = std::upper_bound(keyTimes.begin(), keyTimes.end(), time, [](float t, uint16_t keyTime) { return t < float(keyTime); });
+    return (it == keyTimes.begin()) ? 0 : (uint32_t)(it - keyTimes.begin() - 1);
+}
 
-    uint32_t nextFrameIdx;
-    float mix = CalcFrameMix(frames, time, m_EndTime, startFrameIdx, nextFrameIdx);
+static const glm::vec3& DecodeKey(const glm::vec3& value) { return value; }
+static glm::vec4 DecodeKey(const AnimationQuantizedQuat& value) { const glm::quat q = value.Dequantize(); return glm::vec4(q.x, q.y, q.z, q.w); }
 
-    return glm::mix(frames[startFrameIdx].Translation, frames[nextFrameIdx].Translation, mix );
+/// Cubic Hermite spline (as defined by the gltf spec for CUBICSPLINE samplers) between two keys.
+/// @param keyDt time between the keys (seconds)
+template<typename T>
+static T CalcCubicSpline(const T& startValue, const T& startOutTangent, const T& nextValue, const T& nextInTangent, float mix, float keyDt)
+{
+    const float mix2 = mix * mix;
+    const float mix3 = mix2 * mix;
+    return startValue * (2.0f * mix3 - 3.0f * mix2 + 1.0f)
+         + startOutTangent * (keyDt * (mix3 - 2.0f * mix2 + mix))
+         + nextValue * (-2.0f * mix3 + 3.0f * mix2)
+         + nextInTangent * (keyDt * (mix3 - mix2));
+}
+
+/// Sample one channel at 'time' (in quantized time units).
+/// Linear channels output the keys either side of 'time' and the interpolation amount between them (so the caller can do the lerp/slerp/nlerp).
+/// Step and cubic spline channels output the evaluated value as both keys with an interpolation amount of 0.
+/// Rotation values are output as (unnormalized) xyzw vec4.
+/// @param pKeyHint optional key index hint (updated).  If null a binary search is used to find the keys.
+/// @returns false if the channel is empty
+template<typename T_VALUE, typename T_TANGENT>
+static bool SampleChannel(const AnimationChannelData<T_VALUE, T_TANGENT>& channel, float time, float loopTime, float timeQuantum, uint32_t* pKeyHint, T_TANGENT& outStart, T_TANGENT& outNext, float& outMix)
+{
+    if (channel.Times.empty())
+        return false;
+
+    uint32_t startKeyIdx = pKeyHint ? *pKeyHint : FindKey(channel.Times, time);
+    uint32_t nextKeyIdx;
+    float keyDt;
+    const float mix = CalcKeyMix(channel.Times, time, loopTime, startKeyIdx, nextKeyIdx, keyDt);
+    if (pKeyHint)
+        *pKeyHint = startKeyIdx;
+
+    outStart = DecodeKey(channel.Values[startKeyIdx]);
+    switch (channel.Interpolation)
+    {
+    case AnimationInterpolation::Step:
+        outNext = outStart;
+        outMix = 0.0f;
+        break;
+    case AnimationInterpolation::CubicSpline:
+        outStart = CalcCubicSpline(outStart, channel.OutTangents[startKeyIdx], T_TANGENT(DecodeKey(channel.Values[nextKeyIdx])), channel.InTangents[nextKeyIdx], mix, keyDt * timeQuantum);
+        outNext = outStart;
+        outMix = 0.0f;
+        break;
+    case AnimationInterpolation::Linear:
+    default:
+        outNext = DecodeKey(channel.Values[nextKeyIdx]);
+        outMix = mix;
+        break;
+    }
+    return true;
 }
 
-glm::quat Animation::CalcLocalRotation(uint32_t animationNodeIdx, float time, uint32_t& startFrameIdx) const
+static glm::quat ToQuat(const glm::vec4& v) { return glm::quat(v.w, v.x, v.y, v.z); }
+
+glm::vec3 Animation::CalcLocalTranslation(uint32_t animationNodeIdx, float time, uint32_t& startKeyIdx) const
 {
-    const AnimationNodeData& nodeData = m_AnimationData.GetNodes()[animationNodeIdx];
+    glm::vec3 start, next;
+    float mix;
+    if (!SampleChannel(m_AnimationData.GetNodes()[animationNodeIdx].Translation, time * m_InvTimeQuantum, m_EndTime * m_InvTimeQuantum, m_AnimationData.GetTimeQuantum(), &startKeyIdx, start, next, mix))
+        return { 0.0f,0.0f,0.0f };
 
-    const auto& frames = nodeData.Frames;
-    if (frames.empty())
+    return glm::mix(start, next, mix);
+}
+
+glm::quat Animation::CalcLocalRotation(uint32_t animationNodeIdx, float time, uint32_t& startKeyIdx) const
+{
+    glm::vec4 start, next;
+    float mix;
+    if (!SampleChannel(m_AnimationData.GetNodes()[animationNodeIdx].Rotation, time * m_InvTimeQuantum, m_EndTime * m_InvTimeQuantum, m_AnimationData.GetTimeQuantum(), &startKeyIdx, start, next, mix))
         return cIdentityRotate;
 
-    uint32_t nextFrameIdx;
-    float mix = CalcFrameMix(frames, time, m_EndTime, startFrameIdx, nextFrameIdx);
-    return glm::slerp(frames[startFrameIdx].Rotation, frames[nextFrameIdx].Rotation, mix);
+    if (mix == 0.0f)
+        return glm::normalize(ToQuat(start)); // step, cubic spline (or exactly on a key)
+    return glm::slerp(ToQuat(start), ToQuat(next), mix);
 }
 
-glm::vec3 Animation::CalcLocalScale(uint32_t animationNodeIdx, float time, uint32_t& startFrameIdx) const
+glm::vec3 Animation::CalcLocalScale(uint32_t animationNodeIdx, float time, uint32_t& startKeyIdx) const
 {
-    const auto& frames = m_AnimationData.GetNodes()[animationNodeIdx].Frames;
-    if (frames.empty())
+    glm::vec3 start, next;
+    float mix;
+    if (!SampleChannel(m_AnimationData.GetNodes()[animationNodeIdx].Scale, time * m_InvTimeQuantum, m_EndTime * m_InvTimeQuantum, m_AnimationData.GetTimeQuantum(), &startKeyIdx, start, next, mix))
         return { 1.0f,1.0f,1.0f };
 
-    uint32_t nextFrameIdx;
-    float mix = CalcFrameMix(frames, time, m_EndTime, startFrameIdx, nextFrameIdx);
-    
-    return glm::mix(frames[startFrameIdx].Scale, frames[nextFrameIdx].Scale, mix);
+    return glm::mix(start, next, mix);
+}
+
+void Animation::SamplePose(float time, tcb::span<AnimationLocalTransform> outLocalTransforms, tcb::span<AnimationNodeIterator> keyHints) const
+{
+    const auto& nodes = m_AnimationData.GetNodes();
+    const uint32_t numNodes = (uint32_t)nodes.size();
+    assert(outLocalTransforms.size() >= numNodes);
+    assert(keyHints.empty() || keyHints.size() >= numNodes);
+
+    const float keyTime = time * m_InvTimeQuantum;
+    const float loopTime = m_EndTime * m_InvTimeQuantum;
+
+    using namespace Simd;
+    const Float4 zero = Set1(0.0f);
+    const Float4 one = Set1(1.0f);
+
+    for (uint32_t baseNodeIdx = 0; baseNodeIdx < numNodes; baseNodeIdx += 4)
+    {
+        // Gather the start and end keys of (up to) 4 nodes in to SoA arrays.
+        float t0[3][4], t1[3][4], r0[4][4], r1[4][4], s0[3][4], s1[3][4], mixT[4], mixR[4], mixS[4];
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            const uint32_t nodeIdx = baseNodeIdx + lane;
+            glm::vec3 startTranslation{ 0.0f }, nextTranslation{ 0.0f };
+            glm::vec4 startRotation{ 0.0f, 0.0f, 0.0f, 1.0f }, nextRotation{ 0.0f, 0.0f, 0.0f, 1.0f };
+            glm::vec3 startScale{ 1.0f }, nextScale{ 1.0f };
+            mixT[lane] = mixR[lane] = mixS[lane] = 0.0f;
+            if (nodeIdx < numNodes) // else padding lane; identity transform.
+            {
+                // Empty channels leave the identity values.  Step and cubic spline channels are evaluated here (start == next, mix 0).
+                const AnimationNodeData& node = nodes[nodeIdx];
+                AnimationNodeIterator* pHint = keyHints.empty() ? nullptr : &keyHints[nodeIdx];
+                const float timeQuantum = m_AnimationData.GetTimeQuantum();
+                SampleChannel(node.Translation, keyTime, loopTime, timeQuantum, pHint ? &pHint->translationKeyIdx : nullptr, startTranslation, nextTranslation, mixT[lane]);
+                SampleChannel(node.Rotation, keyTime, loopTime, timeQuantum, pHint ? &pHint->rotationKeyIdx : nullptr, startRotation, nextRotation, mixR[lane]);
+                SampleChannel(node.Scale, keyTime, loopTime, timeQuantum, pHint ? &pHint->scaleKeyIdx : nullptr, startScale, nextScale, mixS[lane]);
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                t0[c][lane] = startTranslation[c];
+                t1[c][lane] = nextTranslation[c];
+                s0[c][lane] = startScale[c];
+                s1[c][lane] = nextScale[c];
+            }
+            r0[0][lane] = startRotation.x; r0[1][lane] = startRotation.y; r0[2][lane] = startRotation.z; r0[3][lane] = startRotation.w;
+            r1[0][lane] = nextRotation.x;  r1[1][lane] = nextRotation.y;  r1[2][lane] = nextRotation.z;  r1[3][lane] = nextRotation.w;
+        }
+
+        // Lerp translation and scale.
+        const Float4 mT = Load(mixT);
+        const Float4 mS = Load(mixS);
+        for (int c = 0; c < 3; ++c)
+        {
+            const Float4 t = Load(t0[c]);
+            Store(t0[c], MulAdd(Sub(Load(t1[c]), t), mT, t));
+            const Float4 s = Load(s0[c]);
+            Store(s0[c], MulAdd(Sub(Load(s1[c]), s), mS, s));
+        }
+
+        // Normalized lerp of rotation, taking the shortest path (negate the end quaternion if the two are more than 180 degrees apart).
+        const Float4 mR = Load(mixR);
+        Float4 qa[4], qb[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            qa[c] = Load(r0[c]);
+            qb[c] = Load(r1[c]);
+        }
+        const Float4 cosAngle = MulAdd(qa[3], qb[3], MulAdd(qa[2], qb[2], MulAdd(qa[1], qb[1], Mul(qa[0], qb[0]))));
+        const Mask4 flip = CmpLt(cosAngle, zero);
+        Float4 q[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            const Float4 b = Select(flip, Sub(zero, qb[c]), qb[c]);
+            q[c] = MulAdd(Sub(b, qa[c]), mR, qa[c]);
+        }
+        const Float4 lengthSq = MulAdd(q[3], q[3], MulAdd(q[2], q[2], MulAdd(q[1], q[1], Mul(q[0], q[0]))));
+        const Float4 invLength = Div(one, Sqrt(lengthSq));
+        for (int c = 0; c < 4; ++c)
+            Store(r0[c], Mul(q[c], invLength));
+
+        // Scatter back out to the (AoS) output.
+        const uint32_t numLanes = std::min(4u, numNodes - baseNodeIdx);
+        for (uint32_t lane = 0; lane < numLanes; ++lane)
+        {
+            AnimationLocalTransform& out = outLocalTransforms[baseNodeIdx + lane];
+            out.Translation = glm::vec3(t0[0][lane], t0[1][lane], t0[2][lane]);
+            out.Rotation.x = r0[0][lane];
+            out.Rotation.y = r0[1][lane];
+            out.Rotation.z = r0[2][lane];
+            out.Rotation.w = r0[3][lane];
+            out.Scale = glm::vec3(s0[0][lane], s0[1][lane], s0[2][lane]);
+        }
+    }
 }
 
 
@@ -162,7 +332,8 @@ AnimationIterator AnimationList::MakeIterator(const Animation& animation)
 {
     AnimationIterator iter{ animation };
     const auto& animationDataNodes = animation.GetAnimationData().GetNodes();
-    iter.nodeIterators.resize(animationDataNodes.size(), { 0 });
+    iter.nodeIterators.resize(animationDataNodes.size());
+    iter.localTransforms.resize(animationDataNodes.size());
     return iter;
 }
 
@@ -175,13 +346,15 @@ void AnimationList::UpdateSkeletonMatrixes(const Skeleton& skeleton, AnimationIt
     const auto& animationDataNodes = animation.GetAnimationData().GetNodes();
     assert(animationDataNodes.size() == iterator.nodeIterators.size());
 
+    // Sampled node by node with CalcLocal* so rotations are slerped (as they always have been for this function); SamplePose (used by UpdateSkeleton) nlerps.
     for (uint32_t animationNodeIndex =0; animationNodeIndex<(uint32_t)iterator.nodeIterators.size(); ++animationNodeIndex)
     {
         const auto& nodeId = animationDataNodes[animationNodeIndex].NodeId; // gltf/nodeMatrixs id/index
 
-        glm::mat4 Matrix = glm::translate(animation.CalcLocalTranslation(animationNodeIndex, time, iterator.nodeIterators[animationNodeIndex].frameIdx ));
-        Matrix = Matrix * glm::toMat4(animation.CalcLocalRotation(animationNodeIndex, time, iterator.nodeIterators[animationNodeIndex].frameIdx));
-        Matrix = Matrix * glm::scale(animation.CalcLocalScale(animationNodeIndex, time, iterator.nodeIterators[animationNodeIndex].frameIdx));
+        AnimationNodeIterator& nodeIterator = iterator.nodeIterators[animationNodeIndex];
+        glm::mat4 Matrix = glm::translate(animation.CalcLocalTranslation(animationNodeIndex, time, nodeIterator.translationKeyIdx));
+        Matrix = Matrix * glm::toMat4(animation.CalcLocalRotation(animationNodeIndex, time, nodeIterator.rotationKeyIdx));
+        Matrix = Matrix * glm::scale(animation.CalcLocalScale(animationNodeIndex, time, nodeIterator.scaleKeyIdx));
 
         nodeMatrixs[nodeId] = glm::transpose(Matrix);
 
@@ -198,3 +371,81 @@ void AnimationList::UpdateSkeletonMatrixes(const Skeleton& skeleton, AnimationIt
         }
     }
 }
+
+void AnimationList::UpdateSkeleton(Skeleton& skeleton, AnimationIterator& iterator)
+{
+    const Animation& animation = iterator.animation;
+    const auto& animationDataNodes = animation.GetAnimationData().GetNodes();
+    assert(animationDataNodes.size() == iterator.nodeIterators.size());
+
+    iterator.localTransforms.resize(animationDataNodes.size());
+    animation.SamplePose(iterator.time, iterator.localTransforms, iterator.nodeIterators);
+
+    for (size_t animationNodeIndex = 0; animationNodeIndex < animationDataNodes.size(); ++animationNodeIndex)
+    {
+        const AnimationLocalTransform& localTransform = iterator.localTransforms[animationNodeIndex];
+        skeleton.SetLocalTransform(animationDataNodes[animationNodeIndex].NodeId, localTransform.Translation, localTransform.Rotation, localTransform.Scale);
+    }
+    skeleton.UpdateWorldTransforms();
+}
+
+void AnimationList::UpdateInstance(AnimationInstance& instance, float elapsedTime)
+{
+    AnimationIterator& iterator = *instance.pIterator;
+    iterator.time = fmod(iterator.time + elapsedTime, iterator.animation.GetEndTime());
+
+    Skeleton& skeleton = *instance.pSkeleton;
+    UpdateSkeleton(skeleton, iterator);
+
+    if (instance.pSkin)
+        instance.pSkin->CalcPalette(skeleton, instance.palette);
+
+    if (!instance.nodeMatrixes.empty())
+    {
+        // World transforms are in the skeleton's flat order, nodeMatrixes are by nodeId.
+        const auto& worldTransforms = skeleton.GetTransforms();
+        const auto& flatNodeIds = skeleton.GetSkeletonData().GetFlatNodeIds();
+        assert(instance.nodeMatrixes.size() >= worldTransforms.size());
+        for (size_t flatIdx = 0; flatIdx < worldTransforms.size(); ++flatIdx)
+            instance.nodeMatrixes[flatNodeIds[flatIdx]] = glm::transpose(worldTransforms[flatIdx]);
+    }
+}
+
+void AnimationList::UpdateInstances(CWorker& worker, tcb::span<AnimationInstance> instances, float elapsedTime, uint32_t instancesPerJob)
+{
+    instancesPerJob = std::max(instancesPerJob, 1u);
+    if (worker.NumThreads() == 0 || instances.size() <= instancesPerJob)
+    {
+        // Not worth (or no threads available for) going wide, update on this thread.
+        for (auto& instance : instances)
+            UpdateInstance(instance, elapsedTime);
+        return;
+    }
+
+    struct Job
+    {
+        tcb::span<AnimationInstance> instances;
+        float               elapsedTime;
+        ReverseSemaphore*   pJobsRunning;
+    };
+    const size_t numJobs = (instances.size() + instancesPerJob - 1) / instancesPerJob;
+    std::vector<Job> jobs;
+    jobs.reserve(numJobs);
+    ReverseSemaphore jobsRunning(0);
+
+    for (size_t firstInstance = 0; firstInstance < instances.size(); firstInstance += instancesPerJob)
+    {
+        jobs.push_back(Job{ instances.subspan(firstInstance, std::min((size_t)instancesPerJob, instances.size() - firstInstance)), elapsedTime, &jobsRunning });
+        jobsRunning.Lock();
+        worker.DoWork([](void* pParam) {
+            const Job& job = *static_cast<const Job*>(pParam);
+            for (auto& instance : job.instances)
+                UpdateInstance(instance, job.elapsedTime);
+            job.pJobsRunning->Unlock();
+        }, &jobs.back(), 0);
+    }
+
+    // Wait for our jobs (only) to complete.
+    jobsRunning.WaitAndLock();
+    jobsRunning.Unlock();
+}
@@ -0,0 +1,172 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "animationBlend.hpp"
+#include "skeleton.hpp"
+#include "skeletonData.hpp"
+#include "system/os_common.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#ifdef GLM_FORCE_QUAT_DATA_WXYZ
+#error "code currently expects glm::quat to be xyzw"
+#endif
+
+
+static constexpr uint8_t cAnimatedThisEvaluate = 1;
+static constexpr uint8_t cAnimatedLastEvaluate = 2;
+
+// Decompose a (translate * rotate * scale) node matrix.
+static AnimationLocalTransform DecomposeTransform(const glm::mat4& matrix)
+{
+    AnimationLocalTransform result;
+    result.Translation = glm::vec3(matrix[3]);
+    result.Scale = glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])));
+    glm::mat3 rotation;
+    for (int c = 0; c < 3; ++c)
+        rotation[c] = result.Scale[c] > 0.0f ? glm::vec3(matrix[c]) / result.Scale[c] : glm::vec3(0.0f);
+    result.Rotation = glm::normalize(glm::quat_cast(rotation));
+    return result;
+}
+
+// Normalized lerp, taking the shortest path (same as Animation::SamplePose uses between keys).
+static glm::quat Nlerp(const glm::quat& a, const glm::quat& b, float mix)
+{
+    const float sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    const glm::quat q(a.w + (b.w * sign - a.w) * mix, a.x + (b.x * sign - a.x) * mix, a.y + (b.y * sign - a.y) * mix, a.z + (b.z * sign - a.z) * mix);
+    return glm::normalize(q);
+}
+
+
+AnimationBlender::AnimationBlender(const SkeletonData& skeletonData)
+{
+    const size_t numNodes = skeletonData.GetNumNodes();
+    m_RestPose.reserve(numNodes);
+    for (size_t nodeId = 0; nodeId < numNodes; ++nodeId)
+    {
+        // Node ids with no skeleton node (not part of the hierarchy) rest at the identity.
+        const SkeletonNodeData* pNode = skeletonData.GetNodeById((uint32_t)nodeId);
+        m_RestPose.push_back(pNode ? DecomposeTransform(pNode->LocalTransform()) : AnimationLocalTransform{ glm::vec3(0.0f), glm::identity<glm::quat>(), glm::vec3(1.0f) });
+    }
+    m_Pose.resize(numNodes);
+    m_Animated.resize(numNodes, 0);
+    // An animation animates each (skeleton) node at most once.
+    m_ReferencePose.resize(numNodes);
+}
+
+void AnimationBlender::EvaluatePose(tcb::span<const AnimationBlendLayer> layers)
+{
+    std::copy(m_RestPose.begin(), m_RestPose.end(), m_Pose.begin());
+    // Keep 'animated last evaluate' in bit 1
+    for (auto& animated : m_Animated)
+        animated = (animated & cAnimatedThisEvaluate) ? cAnimatedLastEvaluate : 0;
+
+    for (const AnimationBlendLayer& layer : layers)
+    {
+        if (layer.weight <= 0.0f)
+            continue;
+        AnimationIterator& iterator = *layer.pIterator;
+        const Animation& animation = iterator.animation;
+        const auto& animationDataNodes = animation.GetAnimationData().GetNodes();
+        assert(animationDataNodes.size() == iterator.nodeIterators.size());
+        if (!layer.mask.empty() && layer.mask.size() < m_Pose.size())
+        {
+            if (!std::exchange(m_LoggedLayerError, true))
+                LOGE("AnimationBlender: mask has %zu entries, skeleton has %zu nodes (layer ignored)", layer.mask.size(), m_Pose.size());
+            continue;
+        }
+        if (animationDataNodes.size() > m_ReferencePose.size())
+        {
+            if (!std::exchange(m_LoggedLayerError, true))
+                LOGE("AnimationBlender: animation has %zu nodes, skeleton has %zu nodes (layer ignored)", animationDataNodes.size(), m_Pose.size());
+            continue;
+        }
+
+        iterator.localTransforms.resize(animationDataNodes.size());   // no-op if created with MakeIterator
+        animation.SamplePose(iterator.time, iterator.localTransforms, iterator.nodeIterators);
+
+        if (layer.mode == AnimationBlendMode::Override)
+        {
+            for (size_t animationNodeIndex = 0; animationNodeIndex < animationDataNodes.size(); ++animationNodeIndex)
+            {
+                const uint32_t nodeId = animationDataNodes[animationNodeIndex].NodeId;
+                if (nodeId >= m_Pose.size())
+                {
+                    if (!std::exchange(m_LoggedLayerError, true))
+                        LOGE("AnimationBlender: animation targets node %u, skeleton has %zu nodes (node ignored)", nodeId, m_Pose.size());
+                    continue;
+                }
+                const float weight = layer.mask.empty() ? layer.weight : layer.weight * layer.mask[nodeId];
+                if (weight <= 0.0f)
+                    continue;
+                m_Animated[nodeId] |= cAnimatedThisEvaluate;
+                const AnimationLocalTransform& sampled = iterator.localTransforms[animationNodeIndex];
+                AnimationLocalTransform& pose = m_Pose[nodeId];
+                if (weight >= 1.0f)
+                {
+                    pose = sampled;
+                    continue;
+                }
+                pose.Translation += (sampled.Translation - pose.Translation) * weight;
+                pose.Rotation = Nlerp(pose.Rotation, sampled.Rotation, weight);
+                pose.Scale += (sampled.Scale - pose.Scale) * weight;
+            }
+        }
+        else
+        {
+            // Reference pose is sampled without key hints (binary search) so as not to disturb the iterator's hints.
+            animation.SamplePose(layer.referenceTime, m_ReferencePose);
+
+            const glm::quat identity = glm::identity<glm::quat>();
+            for (size_t animationNodeIndex = 0; animationNodeIndex < animationDataNodes.size(); ++animationNodeIndex)
+            {
+                const uint32_t nodeId = animationDataNodes[animationNodeIndex].NodeId;
+                if (nodeId >= m_Pose.size())
+                {
+                    if (!std::exchange(m_LoggedLayerError, true))
+                        LOGE("AnimationBlender: animation targets node %u, skeleton has %zu nodes (node ignored)", nodeId, m_Pose.size());
+                    continue;
+                }
+                const float weight = layer.mask.empty() ? layer.weight : layer.weight * layer.mask[nodeId];
+                if (weight <= 0.0f)
+                    continue;
+                m_Animated[nodeId] |= cAnimatedThisEvaluate;
+                const AnimationLocalTransform& sampled = iterator.localTransforms[animationNodeIndex];
+                const AnimationLocalTransform& reference = m_ReferencePose[animationNodeIndex];
+                AnimationLocalTransform& pose = m_Pose[nodeId];
+
+                pose.Translation += (sampled.Translation - reference.Translation) * weight;
+                const glm::quat deltaRotation = glm::conjugate(reference.Rotation) * sampled.Rotation;
+                pose.Rotation = glm::normalize(pose.Rotation * Nlerp(identity, deltaRotation, weight));
+                for (int c = 0; c < 3; ++c)
+                {
+                    const float deltaScale = reference.Scale[c] != 0.0f ? sampled.Scale[c] / reference.Scale[c] : 1.0f;
+                    pose.Scale[c] *= 1.0f + (deltaScale - 1.0f) * weight;
+                }
+            }
+        }
+    }
+}
+
+void AnimationBlender::Evaluate(Skeleton& skeleton, tcb::span<const AnimationBlendLayer> layers)
+{
+    assert(skeleton.GetSkeletonData().GetNumNodes() == m_Pose.size());
+    EvaluatePose(layers);
+
+    // Only nodes animated by a layer (this time or last time, in which case they return to the rest pose) need updating.
+    for (uint32_t nodeId = 0; nodeId < (uint32_t)m_Pose.size(); ++nodeId)
+    {
+        if (m_Animated[nodeId] == 0)
+            continue;
+        const AnimationLocalTransform& pose = m_Pose[nodeId];
+        skeleton.SetLocalTransform(nodeId, pose.Translation, pose.Rotation, pose.Scale);
+    }
+    skeleton.UpdateWorldTransforms();
+}
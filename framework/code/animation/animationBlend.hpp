@@ -0,0 +1,69 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "animation.hpp"
+#include "tcb/span.hpp"
+
+// forward declarations
+class Skeleton;
+class SkeletonData;
+
+
+/// How an @AnimationBlendLayer is combined with the pose built up by the layers before it.
+/// @ingroup Animation
+enum class AnimationBlendMode : uint8_t
+{
+    Override,   ///< interpolate from the current pose towards the layer's pose by the layer weight (crossfades, partial body overrides)
+    Additive    ///< add the difference between the layer's pose and its pose at referenceTime, scaled by the layer weight
+};
+
+/// One animation layer to be blended by @AnimationBlender::Evaluate.
+/// @ingroup Animation
+struct AnimationBlendLayer
+{
+    AnimationIterator*      pIterator = nullptr;    ///< animation (and time) to sample, iterator key hints and scratch are used (and updated)
+    float                   weight = 1.0f;
+    AnimationBlendMode      mode = AnimationBlendMode::Override;
+    tcb::span<const float>  mask;                   ///< optional per node weight multiplier (indexed by nodeId), empty to apply to all nodes.  Must have an entry for every skeleton node (layer is ignored otherwise)
+    float                   referenceTime = 0.0f;   ///< (Additive only) time of the pose the layer's animation is relative to
+};
+
+/// Blends any number of animation layers in to a single skeleton pose.
+/// Layers are applied in order on top of the skeleton's rest pose, so a crossfade is two Override layers (the second weighted by the fade amount) and upper-body or additive layers are stacked on top.
+/// Rotations are sampled (Animation::SamplePose) and blended with nlerp.  Animation nodes that are not in the skeleton are ignored (with an error).
+/// All scratch memory is allocated on construction; Evaluate does not allocate (as long as the layer iterators were created by @AnimationList::MakeIterator).
+/// @ingroup Animation
+class AnimationBlender
+{
+    AnimationBlender(const AnimationBlender&) = delete;
+    AnimationBlender& operator=(const AnimationBlender&) = delete;
+public:
+    AnimationBlender(const SkeletonData& skeletonData);
+    AnimationBlender(AnimationBlender&&) = default;
+
+    /// Sample and blend the layers, then set the blended local transforms on the skeleton and update its world transforms.
+    /// @param skeleton skeleton to pose, must have been created from the SkeletonData this blender was created with.
+    void Evaluate(Skeleton& skeleton, tcb::span<const AnimationBlendLayer> layers);
+
+    /// Sample and blend the layers in to the blended pose (GetPose) without touching a skeleton.
+    void EvaluatePose(tcb::span<const AnimationBlendLayer> layers);
+
+    /// @returns the last evaluated (local) pose, indexed by nodeId
+    const auto& GetPose() const { return m_Pose; }
+
+protected:
+    std::vector<AnimationLocalTransform>    m_RestPose;         ///< local transform of each node (by nodeId) from the skeleton data
+    std::vector<AnimationLocalTransform>    m_Pose;             ///< blended pose (by nodeId)
+    std::vector<AnimationLocalTransform>    m_ReferencePose;    ///< scratch for sampling additive layer reference poses (by animation node index)
+    std::vector<uint8_t>                    m_Animated;         ///< per nodeId flags, if the node was animated by a layer in this (and/or the previous) evaluate
+    bool                                    m_LoggedLayerError = false; ///< layers that do not match the skeleton are only reported once (Evaluate is called every frame)
+};
@@ -8,20 +8,97 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "system/glm_common.hpp"
 
-/// Data describing one frame of animation data for a single node.
+/// Rotation quaternion quantized to 48 bits using the 'smallest three' encoding.
+/// The largest magnitude component is dropped (and reconstructed from the unit length), the remaining three are stored as 15 bit values in the range +/- 1/sqrt(2).
+/// The index of the dropped component is stored in the top bit of Packed[0] and Packed[1] and its sign in the top bit of Packed[2] (so the quaternion is not negated, which cubic spline interpolation relies on).
 /// @ingroup Animation
-struct AnimationFrameData {
-    glm::vec3 Translation = { 0.0f,0.0f,0.0f };
-    glm::quat Rotation = glm::identity<glm::quat>();
-    glm::vec3 Scale = {1.0f,1.0f,1.0f};
-    float Timestamp;
+struct AnimationQuantizedQuat
+{
+    uint16_t Packed[3];
+
+    static AnimationQuantizedQuat Quantize(glm::quat q)
+    {
+        const float c[4] = { q.x, q.y, q.z, q.w };
+        uint32_t largestIdx = 0;
+        for (uint32_t i = 1; i < 4; ++i)
+            if (std::abs(c[i]) > std::abs(c[largestIdx]))
+                largestIdx = i;
+        // Store the components relative to a positive largest component (and the sign separately).
+        const float sign = c[largestIdx] < 0.0f ? -1.0f : 1.0f;
+        AnimationQuantizedQuat result;
+        for (uint32_t i = 0, outIdx = 0; i < 4; ++i)
+        {
+            if (i == largestIdx)
+                continue;
+            const float normalized = std::clamp(c[i] * sign * cSqrt2 * 0.5f + 0.5f, 0.0f, 1.0f);
+            result.Packed[outIdx++] = (uint16_t)(normalized * cMaxValue + 0.5f);
+        }
+        result.Packed[0] |= (uint16_t)((largestIdx & 1) << 15);
+        result.Packed[1] |= (uint16_t)((largestIdx >> 1) << 15);
+        result.Packed[2] |= (uint16_t)(sign < 0.0f ? 0x8000 : 0);
+        return result;
+    }
+
+    glm::quat Dequantize() const
+    {
+        const uint32_t largestIdx = (Packed[0] >> 15) | ((Packed[1] >> 15) << 1);
+        const float sign = (Packed[2] & 0x8000) ? -1.0f : 1.0f;
+        float c[4];
+        float sumSq = 0.0f;
+        for (uint32_t i = 0, inIdx = 0; i < 4; ++i)
+        {
+            if (i == largestIdx)
+                continue;
+            c[i] = (float(Packed[inIdx++] & cMaxValue) * (1.0f / cMaxValue) - 0.5f) * (2.0f / cSqrt2);
+            sumSq += c[i] * c[i];
+        }
+        c[largestIdx] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+        glm::quat result;
+        result.x = c[0] * sign;
+        result.y = c[1] * sign;
+        result.z = c[2] * sign;
+        result.w = c[3] * sign;
+        return result;
+    }
+
+private:
+    static constexpr float cSqrt2 = 1.41421356f;
+    static constexpr uint16_t cMaxValue = 0x7fff;
+};
+
+/// Interpolation between the keys of an animation channel (matches the gltf sampler interpolation modes).
+/// @ingroup Animation
+enum class AnimationInterpolation : uint8_t {
+    Linear,         ///< linear (slerp/nlerp for rotations)
+    Step,           ///< value holds until the next key
+    CubicSpline     ///< cubic Hermite spline using the per key in/out tangents
+};
+
+/// Keyframes for one channel (translation, rotation or scale) of a single node.
+/// Key times are quantized to 16 bits, in units of the owning AnimationData's time quantum (@AnimationData::GetTimeQuantum).
+/// @tparam T_TANGENT type of the cubic spline tangents (rotation tangents are not unit quaternions so are not stored quantized)
+/// @ingroup Animation
+template<typename T_VALUE, typename T_TANGENT = T_VALUE>
+struct AnimationChannelData
+{
+    AnimationInterpolation Interpolation = AnimationInterpolation::Linear;
+    std::vector<uint16_t> Times;        ///< Quantized key times (ascending)
+    std::vector<T_VALUE> Values;        ///< Key values (same count as Times)
+    std::vector<T_TANGENT> InTangents;  ///< Incoming tangent of each key (CubicSpline only, otherwise empty), in value units per second
+    std::vector<T_TANGENT> OutTangents; ///< Outgoing tangent of each key (CubicSpline only, otherwise empty)
+
+    size_t GetMemoryUsage() const { return Times.size() * sizeof(uint16_t) + Values.size() * sizeof(T_VALUE) + (InTangents.size() + OutTangents.size()) * sizeof(T_TANGENT); }
 };
 
 /// Animation node data container.  All the data needed to describe one nodes worth of data for a single skeletal animation.
+/// Each channel has its own keys (channels do not share a timeline) so a channel that does not change is a single key.
 /// @ingroup Animation
 struct AnimationNodeData
 {
@@ -30,8 +107,12 @@ struct AnimationNodeData
     AnimationNodeData(const AnimationNodeData&) = delete;
     AnimationNodeData& operator=(const AnimationNodeData&) = delete;
 
-    std::vector<AnimationFrameData> Frames;     ///< Frames of animation data associated with this node (for a single animation)
-    uint32_t NodeId;                            ///< gltf node index
+    AnimationChannelData<glm::vec3> Translation;                        ///< Translation keys associated with this node (for a single animation)
+    AnimationChannelData<AnimationQuantizedQuat, glm::vec4> Rotation;   ///< Rotation keys (tangents are xyzw)
+    AnimationChannelData<glm::vec3> Scale;                              ///< Scale keys
+    uint32_t NodeId;                                                    ///< gltf node index
+
+    size_t GetMemoryUsage() const { return Translation.GetMemoryUsage() + Rotation.GetMemoryUsage() + Scale.GetMemoryUsage(); }
 };
 
 /// Animation data container.  All the data needed to describe a single skeletal animation on a set of nodes.
@@ -41,13 +122,26 @@ class AnimationData
     AnimationData(const AnimationData&) = delete;
     AnimationData& operator=(const AnimationData&) = delete;
 public:
-    AnimationData(std::string name, std::vector<AnimationNodeData>&& nodes) : Name(std::move(name)), Nodes(std::move(nodes)) {}
+    /// @param timeQuantum time (in seconds) of one unit of the nodes' quantized key times.
+    AnimationData(std::string name, std::vector<AnimationNodeData>&& nodes, float timeQuantum) : Name(std::move(name)), Nodes(std::move(nodes)), TimeQuantum(timeQuantum) {}
     AnimationData(AnimationData&&) = default;
     AnimationData& operator=(AnimationData&&) = default;
 
+    const auto& GetName() const { return Name; }
     const auto& GetNodes() const { return Nodes; }
+    float GetTimeQuantum() const { return TimeQuantum; }
+
+    /// @returns memory used by the key data (in bytes)
+    size_t GetMemoryUsage() const
+    {
+        size_t size = 0;
+        for (const auto& node : Nodes)
+            size += node.GetMemoryUsage();
+        return size;
+    }
+
 protected:
     std::string Name;
     std::vector<AnimationNodeData> Nodes;
+    float TimeQuantum;
 };
-
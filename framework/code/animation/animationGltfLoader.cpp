@@ -11,6 +11,7 @@
 #include "mesh/meshLoader.hpp"
 #include "system/os_common.h"
 #include <algorithm>
+#include <cassert>
 
 #ifdef GLM_FORCE_QUAT_DATA_WXYZ
 #error "code currently expects glm::quat to be xyzw"
@@ -20,6 +21,192 @@ AnimationGltfProcessor::AnimationGltfProcessor() {}
 AnimationGltfProcessor::~AnimationGltfProcessor() {}
 
 
+/// Get a pointer to the time (input) data for an animation sampler; currently we are strict with how this data is expected to be formatted in the gltf binary.
+/// @returns nullptr if the data is not in the expected format
+static const float* GetSamplerTimeData(const tinygltf::Model& ModelData, const tinygltf::AnimationSampler& sampler)
+{
+    const tinygltf::Accessor& timeAccessorData = ModelData.accessors[sampler.input];
+    const auto& timeBuffer = ModelData.bufferViews[timeAccessorData.bufferView];
+    if ((timeBuffer.byteStride != 4 && timeBuffer.byteStride != 0/*packed/default*/) || (timeBuffer.byteOffset & 3) != 0)
+        return nullptr;
+    return (const float*)&ModelData.buffers[timeBuffer.buffer].data[timeBuffer.byteOffset + timeAccessorData.byteOffset];
+}
+
+
+/// Remove keys that can be recreated (to within the given tolerance) by interpolating between the neighbouring (kept) keys.
+/// First and last keys are always kept (unless the channel is constant, in which case it is reduced to a single key).
+/// @param lerp function to interpolate between two values: T_VALUE lerp(const T_VALUE&, const T_VALUE&, float)
+/// @param error function returning the error between two values: float error(const T_VALUE&, const T_VALUE&)
+template<typename T_VALUE, typename T_LERP, typename T_ERROR>
+static void ReduceKeys(std::vector<float>& times, std::vector<T_VALUE>& values, float tolerance, const T_LERP& lerp, const T_ERROR& error)
+{
+    if (times.size() <= 2)
+    {
+        if (times.size() == 2 && error(values[0], values[1]) <= tolerance)
+        {
+            times.resize(1);
+            values.resize(1);
+        }
+        return;
+    }
+
+    std::vector<float> keptTimes;
+    std::vector<T_VALUE> keptValues;
+    keptTimes.push_back(times[0]);
+    keptValues.push_back(values[0]);
+
+    const size_t lastIdx = times.size() - 1;
+    size_t segmentStartIdx = 0;
+    for (size_t keyIdx = 1; keyIdx < lastIdx; ++keyIdx)
+    {
+        // Can we drop this key (and all the keys since the last kept key), interpolating from the last kept key to the key after this one?
+        const size_t segmentEndIdx = keyIdx + 1;
+        const float segmentDt = times[segmentEndIdx] - times[segmentStartIdx];
+        bool canDrop = segmentDt > 0.0f;
+        for (size_t testIdx = segmentStartIdx + 1; canDrop && testIdx < segmentEndIdx; ++testIdx)
+        {
+            const float mix = (times[testIdx] - times[segmentStartIdx]) / segmentDt;
+            canDrop = error(lerp(values[segmentStartIdx], values[segmentEndIdx], mix), values[testIdx]) <= tolerance;
+        }
+        if (!canDrop)
+        {
+            keptTimes.push_back(times[keyIdx]);
+            keptValues.push_back(values[keyIdx]);
+            segmentStartIdx = keyIdx;
+        }
+    }
+    // Always keep the last key, unless the entire channel is constant.
+    if (keptTimes.size() > 1 || error(keptValues[0], values[lastIdx]) > tolerance)
+    {
+        keptTimes.push_back(times[lastIdx]);
+        keptValues.push_back(values[lastIdx]);
+    }
+
+    times = std::move(keptTimes);
+    values = std::move(keptValues);
+}
+
+
+/// Remove step keys that do not change the value (to within the given tolerance).
+template<typename T_VALUE, typename T_ERROR>
+static void ReduceStepKeys(std::vector<float>& times, std::vector<T_VALUE>& values, float tolerance, const T_ERROR& error)
+{
+    size_t keptCount = times.empty() ? 0 : 1;
+    for (size_t keyIdx = 1; keyIdx < times.size(); ++keyIdx)
+    {
+        if (error(values[keptCount - 1], values[keyIdx]) > tolerance)
+        {
+            times[keptCount] = times[keyIdx];
+            values[keptCount] = values[keyIdx];
+            ++keptCount;
+        }
+    }
+    times.resize(keptCount);
+    values.resize(keptCount);
+}
+
+
+/// Channel data as read from the gltf (before key reduction and quantization).
+template<typename T_VALUE, typename T_TANGENT>
+struct SourceChannelData
+{
+    AnimationInterpolation Interpolation = AnimationInterpolation::Linear;
+    std::vector<float> Times;
+    std::vector<T_VALUE> Values;
+    std::vector<T_TANGENT> InTangents;  // CubicSpline only
+    std::vector<T_TANGENT> OutTangents; // CubicSpline only
+};
+
+
+/// Read the keys of one animation sampler.
+/// CUBICSPLINE samplers have 3 output items per key (in tangent, value, out tangent).
+/// @param readValue function converting the source data of one item to T_VALUE: T_VALUE readValue(const uint8_t*)
+/// @param readTangent function converting the source data of one item to T_TANGENT: T_TANGENT readTangent(const uint8_t*)
+template<typename T_VALUE, typename T_TANGENT, typename T_READVALUE, typename T_READTANGENT>
+static bool ReadSamplerKeys(const tinygltf::Model& ModelData, const tinygltf::Animation& animation, const tinygltf::AnimationSampler& sampler, size_t dataItemSize, const T_READVALUE& readValue, const T_READTANGENT& readTangent, SourceChannelData<T_VALUE, T_TANGENT>& channel)
+{
+    static const std::string sStepInterpolationId("STEP");
+    static const std::string sCubicSplineInterpolationId("CUBICSPLINE");
+
+    channel.Interpolation = AnimationInterpolation::Linear;
+    if (sampler.interpolation == sStepInterpolationId)
+        channel.Interpolation = AnimationInterpolation::Step;
+    else if (sampler.interpolation == sCubicSplineInterpolationId)
+        channel.Interpolation = AnimationInterpolation::CubicSpline;
+    const size_t dataItemsPerKey = (channel.Interpolation == AnimationInterpolation::CubicSpline) ? 3 : 1;
+
+    const float* timeDataSrcPtr = GetSamplerTimeData(ModelData, sampler);
+    const size_t timeDataItemCount = ModelData.accessors[sampler.input].count;
+
+    // Grab the relevant animation channel data (rotation, translation, or scale) pointers and strides etc.
+    const tinygltf::Accessor& dataAccessorData = ModelData.accessors[sampler.output];
+    const auto& dataBuffer = ModelData.bufferViews[dataAccessorData.bufferView];
+    const size_t dataItemCount = dataAccessorData.count;
+    const uint8_t* dataSrcPtr = &ModelData.buffers[dataBuffer.buffer].data[dataBuffer.byteOffset + dataAccessorData.byteOffset];
+    const size_t dataSrcItemStride = dataBuffer.byteStride == 0 ? dataItemSize : dataBuffer.byteStride;
+
+    // Last sanity check
+    if (timeDataItemCount * dataItemsPerKey != dataItemCount)
+    {
+        LOGE("Error reading channel data for gltf animation \"%s\".  Different number of items in time/input (%zu) and value/output buffers (%zu)", animation.name.c_str(), timeDataItemCount, dataItemCount);
+        return false;
+    }
+    assert(dataItemCount <= dataBuffer.byteLength / dataSrcItemStride);
+
+    channel.Times.assign(timeDataSrcPtr, timeDataSrcPtr + timeDataItemCount);
+    channel.Values.resize(timeDataItemCount);
+    if (channel.Interpolation == AnimationInterpolation::CubicSpline)
+    {
+        channel.InTangents.resize(timeDataItemCount);
+        channel.OutTangents.resize(timeDataItemCount);
+        for (size_t i = 0; i < timeDataItemCount; ++i)
+        {
+            channel.InTangents[i] = readTangent(dataSrcPtr + dataSrcItemStride * (i * 3));
+            channel.Values[i] = readValue(dataSrcPtr + dataSrcItemStride * (i * 3 + 1));
+            channel.OutTangents[i] = readTangent(dataSrcPtr + dataSrcItemStride * (i * 3 + 2));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < timeDataItemCount; ++i)
+            channel.Values[i] = readValue(dataSrcPtr + dataSrcItemStride * i);
+    }
+    return true;
+}
+
+
+/// Reduce (linear and step channels only, cubic spline keys are kept as-is), quantize key times (to 16 bits, in units of timeQuantum) and store in to the output channel.
+/// Keys that quantize to the same time as the previous key are dropped.
+/// @param lerp, error functions for ReduceKeys
+/// @param convert function converting source values to the output channel's value type
+template<typename T_SRCVALUE, typename T_DSTVALUE, typename T_TANGENT, typename T_LERP, typename T_ERROR, typename T_CONVERT>
+static void BuildChannel(SourceChannelData<T_SRCVALUE, T_TANGENT>&& source, float tolerance, const T_LERP& lerp, const T_ERROR& error, float timeQuantum, const T_CONVERT& convert, AnimationChannelData<T_DSTVALUE, T_TANGENT>& channel)
+{
+    if (source.Interpolation == AnimationInterpolation::Linear)
+        ReduceKeys(source.Times, source.Values, tolerance, lerp, error);
+    else if (source.Interpolation == AnimationInterpolation::Step)
+        ReduceStepKeys(source.Times, source.Values, tolerance, error);
+
+    const bool hasTangents = source.Interpolation == AnimationInterpolation::CubicSpline;
+    channel.Interpolation = source.Interpolation;
+    channel.Times.reserve(source.Times.size());
+    channel.Values.reserve(source.Values.size());
+    for (size_t keyIdx = 0; keyIdx < source.Times.size(); ++keyIdx)
+    {
+        const uint16_t time = (uint16_t)std::clamp(source.Times[keyIdx] / timeQuantum + 0.5f, 0.0f, 65535.0f);
+        if (!channel.Times.empty() && channel.Times.back() == time)
+            continue;
+        channel.Times.push_back(time);
+        channel.Values.push_back(convert(source.Values[keyIdx]));
+        if (hasTangents)
+        {
+            channel.InTangents.push_back(source.InTangents[keyIdx]);
+            channel.OutTangents.push_back(source.OutTangents[keyIdx]);
+        }
+    }
+}
+
+
 bool AnimationGltfProcessor::operator()(const tinygltf::Model& ModelData)
 {
     //const tinygltf::Scene& SceneData = ModelData.scenes[ModelData.defaultScene];
@@ -42,29 +229,41 @@ bool AnimationGltfProcessor::operator()(const tinygltf::Model& ModelData)
             }
         }
 
+        // Find the animation length, which determines the time quantization (key times are stored in 16 bits).
+        float animationTotalTime = 0.0f;
+        for (const auto& channel : animation.channels)
+        {
+            const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
+            const float* timeDataSrcPtr = GetSamplerTimeData(ModelData, sampler);
+            if (timeDataSrcPtr == nullptr)
+            {
+                LOGE("Error reading time data for gltf animation \"%s\" (expecting contiguous array of aligned float data)", animation.name.c_str());
+                return false;
+            }
+            const size_t timeDataItemCount = ModelData.accessors[sampler.input].count;
+            if (timeDataItemCount > 0)
+                animationTotalTime = std::max(animationTotalTime, timeDataSrcPtr[timeDataItemCount - 1]);
+        }
+        const float timeQuantum = std::max(animationTotalTime, 1e-3f) / 65535.0f;
+
         std::vector<AnimationNodeData> animationNodes;
         animationNodes.reserve(targetNodeIdxs.size());
+        size_t mergedFramesMemoryUsage = 0;     // size the data would have been with all channels on a single (merged) timeline, for reporting.
 
-        // Each target gets a set of frame data
-        // Grab each channel for each unique target node (seperate channels for translation, rotation, scale)
+        // Each target gets a set of keys for each channel (seperate channels for translation, rotation, scale)
 
         for (int targetNodeIdx : targetNodeIdxs)
         {
-            const uint8_t* pTranslationChannelData = nullptr;
-            const uint8_t* pRotationChannelData = nullptr; // rotations as quaternion but in gltf order (wxyz)
-            const uint8_t* pScaleChannelData = nullptr;
-            size_t translationDataItemCount = 0;
-            size_t rotationDataItemCount = 0;
-            size_t scaleDataItemCount = 0;
-            size_t translationDataSrcItemStride = 0;
-            size_t rotationDataSrcItemStride = 0;
-            size_t scaleDataSrcItemStride = 0;
-            const float* pTranslationTimeData = nullptr;
-            const float* pRotationTimeData = nullptr;
-            const float* pScaleTimeData = nullptr;
+            SourceChannelData<glm::vec3, glm::vec3> translations;
+            SourceChannelData<glm::quat, glm::vec4> rotations;
+            SourceChannelData<glm::vec3, glm::vec3> scales;
 
             const auto& targetNode = ModelData.nodes[targetNodeIdx];
 
+            const auto readVec3 = [](const uint8_t* pData) { return *(const glm::vec3*)pData; };
+            const auto readVec4 = [](const uint8_t* pData) { return *(const glm::vec4*)pData; };
+            const auto readQuat = [](const uint8_t* pData) { const glm::vec4 data = *(const glm::vec4*)pData; return glm::quat(/*xyzw in gltf*/ data.w, data.x, data.y, data.z); };
+
             for (const auto& channel : animation.channels)
             {
                 if (targetNodeIdx == channel.target_node)
@@ -73,252 +272,77 @@ bool AnimationGltfProcessor::operator()(const tinygltf::Model& ModelData)
                     static const std::string sRotationTargetPathId("rotation");
                     static const std::string sScaleTargetPathId("scale");
 
-                    // Grab a pointer to the time data; currently we are strict with how this data is expected to be formatted in the gltf binary.
-                    const tinygltf::Accessor& timeAccessorData = ModelData.accessors[animation.samplers[channel.sampler].input];
-                    const size_t timeDataItemCount = timeAccessorData.count;
-                    const auto& timeBuffer = ModelData.bufferViews[timeAccessorData.bufferView];
-
-                    if ((timeBuffer.byteStride != 4 && timeBuffer.byteStride != 0/*packed/default*/) || (timeBuffer.byteOffset&3)!=0)
-                    {
-                        LOGE("Error reading time data for gltf animation \"%s\" (expecting contiguous array of aligned float data)", animation.name.c_str());
+                    const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
+                    bool success = true;
+                    if (channel.target_path == sTranslationTargetPathId)
+                        success = ReadSamplerKeys(ModelData, animation, sampler, sizeof(glm::vec3), readVec3, readVec3, translations);
+                    else if (channel.target_path == sRotationTargetPathId)
+                        success = ReadSamplerKeys(ModelData, animation, sampler, sizeof(glm::vec4), readQuat, readVec4, rotations);
+                    else if (channel.target_path == sScaleTargetPathId)
+                        success = ReadSamplerKeys(ModelData, animation, sampler, sizeof(glm::vec3), readVec3, readVec3, scales);
+                    if (!success)
                         return false;
-                    }
-                    const float* timeDataSrcPtr = (const float*) &ModelData.buffers[timeBuffer.buffer].data[timeBuffer.byteOffset + timeAccessorData.byteOffset];
-
-                    // Grab the relevant animation channel data (rotation, translation, or scale) pointers and strides etc.
-                    const tinygltf::Accessor& dataAccessorData = ModelData.accessors[animation.samplers[channel.sampler].output];
-                    const auto& dataBuffer = ModelData.bufferViews[dataAccessorData.bufferView];
-                    size_t dataDstItemSize = 0;
-                    const size_t dataItemCount = dataAccessorData.count;
-                    const uint8_t* dataSrcPtr = &ModelData.buffers[dataBuffer.buffer].data[dataBuffer.byteOffset + dataAccessorData.byteOffset];
-
-                    if (channel.target_path == sTranslationTargetPathId) {
-                        pTranslationTimeData = timeDataSrcPtr;
-                        pTranslationChannelData = dataSrcPtr;
-                        dataDstItemSize = sizeof(glm::vec3);
-                        translationDataSrcItemStride = dataBuffer.byteStride == 0 ? dataDstItemSize : dataBuffer.byteStride;
-                        translationDataItemCount = dataItemCount;
-                        assert(translationDataItemCount <= dataBuffer.byteLength / translationDataSrcItemStride);
-                    }
-                    else if (channel.target_path == sRotationTargetPathId) {
-                        pRotationTimeData = timeDataSrcPtr;
-                        pRotationChannelData = dataSrcPtr;
-                        dataDstItemSize = sizeof(glm::vec4);
-                        rotationDataSrcItemStride = dataBuffer.byteStride == 0 ? dataDstItemSize : dataBuffer.byteStride;
-                        rotationDataItemCount = dataItemCount;
-                        assert(rotationDataItemCount <= dataBuffer.byteLength / rotationDataSrcItemStride);
-                    }
-                    else if (channel.target_path == sScaleTargetPathId) {
-                        pScaleTimeData = timeDataSrcPtr;
-                        pScaleChannelData = dataSrcPtr;
-                        dataDstItemSize = sizeof(glm::vec3);
-                        scaleDataSrcItemStride = dataBuffer.byteStride == 0 ? dataDstItemSize : dataBuffer.byteStride;
-                        scaleDataItemCount = dataItemCount;
-                        assert(scaleDataItemCount <= dataBuffer.byteLength / scaleDataSrcItemStride);
-                    }
-
-                    // Last sanity check
-                    if (timeDataItemCount != dataItemCount)
-                    {
-                        LOGE("Error reading channel data for gltf animation \"%s\".  Different number of items in time/input (%zu) and value/output buffers (%zu)", animation.name.c_str(), timeDataItemCount, dataItemCount);
-                        return false;
-                    }
                 }
             }
 
-            // Combine all the channel data into animation 'frames'
-
-            std::vector< AnimationFrameData> frames;
+            // Channels not driven by the animation use the node's local transform (if it has one, otherwise the channel is left empty and samples as identity).
+            if (translations.Values.empty() && targetNode.translation.size() == 3)
             {
-                // Grab all the time values and sort them.
-                struct TimeAndIndex { float time; uint32_t channelMask; uint32_t index; glm::vec4 data; };
-                std::vector<TimeAndIndex> timesSorted;
-                timesSorted.reserve(translationDataItemCount + rotationDataItemCount + scaleDataItemCount);
-                for (uint32_t i = 0; i < (uint32_t)translationDataItemCount; ++i)
-                {
-                    timesSorted.push_back({ pTranslationTimeData[i], 1, i, glm::vec4( *(const glm::vec3*)(pTranslationChannelData + translationDataSrcItemStride * i), 0.0f) });
-                }
-                for (uint32_t i = 0; i < (uint32_t)rotationDataItemCount; ++i)
-                {
-                    timesSorted.push_back({ pRotationTimeData[i], 2, i, *(const glm::vec4*)(pRotationChannelData + rotationDataSrcItemStride * i) });
-                }
-                for (uint32_t i = 0; i < (uint32_t)scaleDataItemCount; ++i)
-                {
-                    timesSorted.push_back({ pScaleTimeData[i], 4, i, glm::vec4( *(const glm::vec3*)(pScaleChannelData + scaleDataSrcItemStride*i), 0.0f) });
-                }
-                std::sort(timesSorted.begin(), timesSorted.end(), [](auto& a, auto& b) { return (a.time < b.time); });
-
-                // Generate frame data for the known frames and merge identical timestamps
-                std::vector< uint8_t > frameChannels;   // For each output frame records the mask of valid channels (so we can later fill in the missing channels)
-                frames.reserve(timesSorted.size());
-                frameChannels.reserve(timesSorted.size());
-
-                AnimationFrameData frame{ };
-
-                // Setup the frame with local node transform incase parts of it (eg translation) are not overwritten by the animation
-                if (targetNode.translation.size() == 3)
-                {
-                    frame.Translation = glm::vec3(targetNode.translation[0], targetNode.translation[1], targetNode.translation[2]);
-                }
-                if (targetNode.rotation.size() == 4)
-                {
-                    frame.Rotation = glm::quat(/*xyzw in gltf*/ (float)targetNode.rotation[3], (float)targetNode.rotation[0], (float)targetNode.rotation[1], (float)targetNode.rotation[2]);
-                }
-                if (targetNode.scale.size() == 3)
-                {
-                    frame.Scale = glm::vec3(targetNode.scale[0], targetNode.scale[1], targetNode.scale[2]);
-                }
-
-                for (size_t i = 0, nexti = 0; nexti < timesSorted.size(); )
-                {
-                    if (timesSorted[i].time == timesSorted[nexti].time)
-                    {
-                        timesSorted[i].channelMask |= timesSorted[nexti].channelMask;
-                        switch (timesSorted[nexti].channelMask) {
-                        case 1:
-                            frame.Translation = timesSorted[nexti].data;
-                            break;
-                        case 2:
-                            frame.Rotation = glm::quat( timesSorted[nexti].data.w, timesSorted[nexti].data.x, timesSorted[nexti].data.y, timesSorted[nexti].data.z );
-                            break;
-                        case 4:
-                            frame.Scale = timesSorted[nexti].data;
-                            break;
-                        default:
-                            assert(0);
-                            break;
-                        }
-                        ++nexti;
-                    }
-                    else
-                    {
-                        // We have a new timestamp, save out the just merged frame and move to the new one.
-                        frame.Timestamp = timesSorted[i].time;
-                        frames.push_back(frame);
-                        frameChannels.push_back(timesSorted[i].channelMask);
-                        i = nexti;
-                    }
-                }
-
-                //
-                // Fill in any 'missing' values
-                glm::vec3 lastTranslation = frame.Translation;
-                glm::vec3 nextTranslation = lastTranslation;
-                float lastTranslationTime = 0.0f;
-                float translationTimeSpanInv = 0.0f;
-
-                glm::quat lastRotation = frame.Rotation;
-                glm::quat nextRotation = lastRotation;
-                float lastRotationTime = 0.0f;
-                float rotationTimeSpanInv = 0.0f;
-
-                glm::vec3 lastScale = frame.Scale;
-                glm::vec3 nextScale = lastScale;
-                float lastScaleTime = 0.0f;
-                float scaleTimeSpanInv = 0.0f;
-
-                const float animationTotalTime = timesSorted.back().time;
+                translations.Times.push_back(0.0f);
+                translations.Values.push_back(glm::vec3(targetNode.translation[0], targetNode.translation[1], targetNode.translation[2]));
+            }
+            if (rotations.Values.empty() && targetNode.rotation.size() == 4)
+            {
+                rotations.Times.push_back(0.0f);
+                rotations.Values.push_back(glm::quat(/*xyzw in gltf*/ (float)targetNode.rotation[3], (float)targetNode.rotation[0], (float)targetNode.rotation[1], (float)targetNode.rotation[2]));
+            }
+            if (scales.Values.empty() && targetNode.scale.size() == 3)
+            {
+                scales.Times.push_back(0.0f);
+                scales.Values.push_back(glm::vec3(targetNode.scale[0], targetNode.scale[1], targetNode.scale[2]));
+            }
 
-                for (size_t i = 0; i < frames.size(); ++i)
-                {
-                    // Translation
-                    if ((frameChannels[i] & 1) == 0)
-                    {
-                        // Generate this timestep's translation by linear interpolation
-                        frames[i].Translation = glm::mix(lastTranslation, nextTranslation, (frames[i].Timestamp - lastTranslationTime) * translationTimeSpanInv);
-                    }
-                    else
-                    {
-                        // Frame has a translation value, save it for interpolating missing values.
-                        lastTranslation = frames[i].Translation;
-                        lastTranslationTime = frames[i].Timestamp;
-                        nextTranslation = lastTranslation;
-                        translationTimeSpanInv = 0.0f;
-                        // See if there is a future keyframe that has a translation, search wraps around
-                        size_t j = 1, idx = i + 1;
-                        for (; j < frames.size(); ++j, ++idx)
-                        {
-                            idx = (idx < frames.size()) ? idx : 0;
-                            if (frameChannels[idx] & 1)
-                            {
-                                nextTranslation = frames[idx].Translation;
-                                float translationTimeSpan = frames[idx].Timestamp - frames[i].Timestamp;
-                                if (translationTimeSpan < 0.0f)
-                                    translationTimeSpan += animationTotalTime;
-                                translationTimeSpanInv = 1.0f / translationTimeSpan;
-                                break;
-                            }
-                        }
-                    }
-
-                    // rotation
-                    if ((frameChannels[i] & 2) == 0)
-                    {
-                        // Generate this timestep's rotation by linear interpolation
-                        frames[i].Rotation = glm::slerp(lastRotation, nextRotation, (frames[i].Timestamp - lastRotationTime) * rotationTimeSpanInv);
-                    }
-                    else
-                    {
-                        // Frame has a rotation value, save it for interpolating missing values.
-                        lastRotation = frames[i].Rotation;
-                        lastRotationTime = frames[i].Timestamp;
-                        nextRotation = lastRotation;
-                        rotationTimeSpanInv = 0.0f;
-                        // See if there is a future keyframe that has a rotation, search wraps around
-                        size_t j = 1, idx = i + 1;
-                        for (; j < frames.size(); ++j, ++idx)
-                        {
-                            if (idx >= frames.size())
-                            {
-                                idx = 0;
-                            }
-                            if (frameChannels[idx] & 2)
-                            {
-                                nextRotation = frames[idx].Rotation;
-                                float rotationTimeSpan = frames[idx].Timestamp - frames[i].Timestamp;
-                                if (rotationTimeSpan < 0.0f)
-                                    rotationTimeSpan += animationTotalTime;
-                                rotationTimeSpanInv = 1.0f / rotationTimeSpan;
-                                break;
-                            }
-                        }
-                    }
-                    // Scale
-                    if ((frameChannels[i] & 4) == 0)
-                    {
-                        // Generate this timestep's scale by linear interpolation
-                        frames[i].Scale = glm::mix(lastScale, nextScale, (frames[i].Timestamp - lastScaleTime) * scaleTimeSpanInv);
-                    }
-                    else
-                    {
-                        // Frame has a scale value, save it for interpolating missing values.
-                        lastScale = frames[i].Scale;
-                        lastScaleTime = frames[i].Timestamp;
-                        nextScale = lastScale;
-                        scaleTimeSpanInv = 0.0f;
-                        // See if there is a future keyframe that has a scale, search wraps around
-                        size_t j = 1, idx = i + 1;
-                        for (; j < frames.size(); ++j, ++idx)
-                        {
-                            idx = (idx < frames.size()) ? idx : 0;
-                            if (frameChannels[idx] & 2)
-                            {
-                                nextScale = frames[idx].Scale;
-                                float scaleTimeSpan = frames[idx].Timestamp - frames[i].Timestamp;
-                                if (scaleTimeSpan < 0.0f)
-                                    scaleTimeSpan += animationTotalTime;
-                                scaleTimeSpanInv = 1.0f / scaleTimeSpan;
-                                break;
-                            }
-                        }
-                    }
-                }
+            // Number of frames if all the channels were on one timeline
+            {
+                std::vector<float> mergedTimes;
+                mergedTimes.reserve(translations.Times.size() + rotations.Times.size() + scales.Times.size());
+                mergedTimes.insert(mergedTimes.end(), translations.Times.begin(), translations.Times.end());
+                mergedTimes.insert(mergedTimes.end(), rotations.Times.begin(), rotations.Times.end());
+                mergedTimes.insert(mergedTimes.end(), scales.Times.begin(), scales.Times.end());
+                std::sort(mergedTimes.begin(), mergedTimes.end());
+                const size_t mergedFrameCount = std::unique(mergedTimes.begin(), mergedTimes.end()) - mergedTimes.begin();
+                mergedFramesMemoryUsage += mergedFrameCount * (sizeof(glm::vec3) + sizeof(glm::quat) + sizeof(glm::vec3) + sizeof(float));
             }
 
-            animationNodes.emplace_back( AnimationNodeData { std::move( frames ), (uint32_t) targetNodeIdx } );
+            // Drop keys that are (within tolerance) recreated by interpolation and quantize.
+            const auto vec3Lerp = [](const glm::vec3& a, const glm::vec3& b, float mix) { return glm::mix(a, b, mix); };
+            const auto vec3Error = [](const glm::vec3& a, const glm::vec3& b) { const glm::vec3 d = glm::abs(a - b); return std::max(std::max(d.x, d.y), d.z); };
+            const auto vec3Copy = [](const glm::vec3& v) { return v; };
+
+            AnimationNodeData nodeData{ {}, {}, {}, (uint32_t)targetNodeIdx };
+            BuildChannel(std::move(translations), m_TranslationTolerance, vec3Lerp, vec3Error, timeQuantum, vec3Copy, nodeData.Translation);
+            BuildChannel(std::move(rotations), m_RotationTolerance,
+                [](const glm::quat& a, const glm::quat& b, float mix) {
+                    // Shortest path normalized lerp (matches Animation::SamplePose)
+                    const float sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+                    const glm::vec4 q(a.x + (sign * b.x - a.x) * mix, a.y + (sign * b.y - a.y) * mix, a.z + (sign * b.z - a.z) * mix, a.w + (sign * b.w - a.w) * mix);
+                    const float invLength = 1.0f / std::sqrt(glm::dot(q, q));
+                    return glm::quat(q.w * invLength, q.x * invLength, q.y * invLength, q.z * invLength);
+                },
+                [](const glm::quat& a, const glm::quat& b) {
+                    // Angle between the two rotations (|a-b| = 2*sin(angle/4), more precise than acos(dot) for small angles)
+                    const float sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+                    const glm::vec4 d(a.x - sign * b.x, a.y - sign * b.y, a.z - sign * b.z, a.w - sign * b.w);
+                    return 4.0f * std::asin(std::min(1.0f, 0.5f * std::sqrt(glm::dot(d, d))));
+                },
+                timeQuantum, [](const glm::quat& q) { return AnimationQuantizedQuat::Quantize(q); }, nodeData.Rotation);
+            BuildChannel(std::move(scales), m_ScaleTolerance, vec3Lerp, vec3Error, timeQuantum, vec3Copy, nodeData.Scale);
+
+            animationNodes.emplace_back(std::move(nodeData));
         }
 
-        m_animations.emplace_back(AnimationData{ animation.name, std::move(animationNodes) });
+        m_animations.emplace_back(AnimationData{ animation.name, std::move(animationNodes), timeQuantum });
+        LOGI("Animation \"%s\": %zu nodes, %zu bytes of keys (%zu bytes with merged uncompressed frames)", animation.name.c_str(), m_animations.back().GetNodes().size(), m_animations.back().GetMemoryUsage(), mergedFramesMemoryUsage);
     }
 
     return true;
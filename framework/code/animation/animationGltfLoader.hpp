@@ -29,4 +29,9 @@ public:
     ~AnimationGltfProcessor();
     bool operator()(const tinygltf::Model& ModelData);
     std::vector<AnimationData> m_animations;
+
+    /// Key reduction tolerances.  Keys that can be recreated by interpolating between their neighbouring keys (to within these tolerances) are dropped.  Set before loading.
+    float m_TranslationTolerance = 0.0001f; ///< maximum per-axis translation error (model units)
+    float m_RotationTolerance = 0.0005f;    ///< maximum rotation error (radians)
+    float m_ScaleTolerance = 0.0001f;       ///< maximum per-axis scale error
 };
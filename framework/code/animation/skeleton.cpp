@@ -8,32 +8,97 @@
 
 #include "skeleton.hpp"
 #include "skeletonData.hpp"
+#include "system/simd_common.hpp"
+#include <algorithm>
 
 Skeleton::Skeleton(const SkeletonData& skeletonData)
     : m_SkeletonData(skeletonData)
 {
+    const auto& flatNodeIds = m_SkeletonData.GetFlatNodeIds();
+    m_LocalTransforms.resize(flatNodeIds.size(), glm::identity<glm::mat4>());
+    m_WorldTransforms.resize(flatNodeIds.size(), glm::identity<glm::mat4>());
+    m_Dirty.resize(flatNodeIds.size(), 1);
+    m_AnyDirty = true;
 
-    m_WorldTransforms.resize( m_SkeletonData.m_NodesById.size(), glm::identity<glm::mat4>() );
-
-    // iterate through node hierarchy to calculate the world transforms.
-    for (const auto* rootNode : m_SkeletonData.m_RootNodes)
+    for (size_t flatIdx = 0; flatIdx < flatNodeIds.size(); ++flatIdx)
     {
-        const auto TransformTree = [this](auto& rootNode, const auto& ParentTransform) -> void {
-            auto TransformTreeImpl = [this](auto& rootNode, const auto& ParentTransform, auto& TransformTreeRef) -> void
-            {
-                auto WorldTransform = ParentTransform * rootNode.LocalTransform();
-                m_WorldTransforms[rootNode.NodeId()] = WorldTransform;
-                for (auto& child : rootNode.Children())
-                    TransformTreeRef(child, WorldTransform, TransformTreeRef);
-            };
-            TransformTreeImpl(rootNode, ParentTransform, TransformTreeImpl);
-        };
-        TransformTree(*rootNode, glm::identity<glm::mat4>());
+        if (const SkeletonNodeData* pNode = m_SkeletonData.GetNodeById(flatNodeIds[flatIdx]))
+            m_LocalTransforms[flatIdx] = pNode->LocalTransform();
     }
+
+    // Calculate the world transforms.
+    UpdateWorldTransforms();
 }
 
 Skeleton::~Skeleton()
 {
 }
 
+const glm::mat4& Skeleton::GetTransform(uint32_t nodeId) const
+{
+    return m_WorldTransforms[m_SkeletonData.GetFlatIndex(nodeId)];
+}
+
+void Skeleton::SetLocalTransform(uint32_t nodeId, const glm::mat4& localTransform)
+{
+    const uint32_t flatIdx = m_SkeletonData.GetFlatIndex(nodeId);
+    m_LocalTransforms[flatIdx] = localTransform;
+    m_Dirty[flatIdx] = 1;
+    m_AnyDirty = true;
+}
+
+void Skeleton::SetLocalTransform(uint32_t nodeId, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+    // translate * rotate * scale
+    const uint32_t flatIdx = m_SkeletonData.GetFlatIndex(nodeId);
+    glm::mat4& localTransform = m_LocalTransforms[flatIdx];
+    localTransform = glm::mat4_cast(rotation);
+    localTransform[0] *= scale.x;
+    localTransform[1] *= scale.y;
+    localTransform[2] *= scale.z;
+    localTransform[3] = glm::vec4(translation, 1.0f);
+    m_Dirty[flatIdx] = 1;
+    m_AnyDirty = true;
+}
+
+/// out = a * b (column major, out must not alias a)
+static void MultiplyTransform(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+    using namespace Simd;
+    const Float4 a0 = Load(&a[0][0]);
+    const Float4 a1 = Load(&a[1][0]);
+    const Float4 a2 = Load(&a[2][0]);
+    const Float4 a3 = Load(&a[3][0]);
+    for (int column = 0; column < 4; ++column)
+    {
+        const glm::vec4 bColumn = b[column];
+        Store(&out[column][0], MulAdd(a3, Set1(bColumn.w), MulAdd(a2, Set1(bColumn.z), MulAdd(a1, Set1(bColumn.y), Mul(a0, Set1(bColumn.x))))));
+    }
+}
+
+void Skeleton::UpdateWorldTransforms()
+{
+    if (!m_AnyDirty)
+        return;
 
+    // Transforms are in flat order (parents always before their children), so this is a single linear pass and dirty flags propagate down in the same pass.
+    const int* pParentIndices = m_SkeletonData.GetFlatParentIndices().data();
+    const size_t numNodes = m_WorldTransforms.size();
+    for (size_t flatIdx = 0; flatIdx < numNodes; ++flatIdx)
+    {
+        const int parentIdx = pParentIndices[flatIdx];
+        if (parentIdx < 0)
+        {
+            if (m_Dirty[flatIdx])
+                m_WorldTransforms[flatIdx] = m_LocalTransforms[flatIdx];
+        }
+        else
+        {
+            m_Dirty[flatIdx] |= m_Dirty[parentIdx];
+            if (m_Dirty[flatIdx])
+                MultiplyTransform(m_WorldTransforms[parentIdx], m_LocalTransforms[flatIdx], m_WorldTransforms[flatIdx]);
+        }
+    }
+    std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+    m_AnyDirty = false;
+}
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include "system/glm_common.hpp"
 
@@ -16,6 +17,8 @@ class SkeletonData;
 
 
 /// Skeleton class, contains the runtime representation of a skeleton
+/// World transforms are updated incrementally; set the local transforms of the (animated) nodes that changed and call UpdateWorldTransforms, only those nodes and their children are recalculated.
+/// Transforms are stored in the SkeletonData 'flat' order (parents before children) so the update is a single linear pass over contiguous arrays.
 /// @ingroup Animation
 class Skeleton
 {
@@ -25,10 +28,24 @@ public:
     Skeleton(const SkeletonData&);
     ~Skeleton();
 
-    const auto GetTransforms() const            { return m_WorldTransforms; }
-    const SkeletonData& GetSkeletonData() const { return m_SkeletonData; }
+    /// @returns the current world transforms (in SkeletonData::GetFlatNodeIds order, NOT by nodeId)
+    const std::vector<glm::mat4>& GetTransforms() const     { return m_WorldTransforms; }
+    /// @returns the current world transform of the given node
+    const glm::mat4& GetTransform(uint32_t nodeId) const;
+    const SkeletonData& GetSkeletonData() const             { return m_SkeletonData; }
+
+    /// Set the local (parent relative) transform of a node.  Marks the node (and its children) as needing their world transforms updating.
+    void SetLocalTransform(uint32_t nodeId, const glm::mat4& localTransform);
+    void SetLocalTransform(uint32_t nodeId, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+    /// Recalculate the world transforms of nodes whose local transform (or a parent's) changed since the last update.
+    /// Single linear pass over the flattened hierarchy.
+    void UpdateWorldTransforms();
 
 private:
     const SkeletonData&     m_SkeletonData; //NOT owned, do not delete before deleting this class!
-    std::vector<glm::mat4>  m_WorldTransforms;  // Current world transforms by nodeId order (same order as @SkeletonData::NodesById).
+    std::vector<glm::mat4>  m_LocalTransforms;  // Current local transforms (flat order, @SkeletonData::GetFlatNodeIds)
+    std::vector<glm::mat4>  m_WorldTransforms;  // Current world transforms (flat order)
+    std::vector<uint8_t>    m_Dirty;            // Per node (flat order), non zero if the world transform needs recalculating.
+    bool                    m_AnyDirty = false;
 };
@@ -10,4 +10,32 @@
 
 SkeletonData::SkeletonData(std::vector<SkeletonNodeData>&& Nodes, std::vector<const SkeletonNodeData*>&& NodesById, std::vector<const SkeletonNodeData*>&& rootNodes)
     : m_NodesById(std::move(NodesById)), m_RootNodes(std::move(rootNodes)), m_Nodes(std::move(Nodes))
-{}
+{
+    // Flatten the hierarchy, breadth first so every node's parent is earlier in the list (world transforms can then be calculated in a single linear pass).
+    const uint32_t cNotFlattened = ~0u;
+    m_FlatNodeIds.reserve(m_NodesById.size());
+    m_FlatParentIndices.reserve(m_NodesById.size());
+    m_FlatIndexByNodeId.resize(m_NodesById.size(), cNotFlattened);
+    std::vector<const SkeletonNodeData*> flatNodes;
+    flatNodes.reserve(m_NodesById.size());
+    flatNodes.insert(flatNodes.end(), m_RootNodes.begin(), m_RootNodes.end());
+    for (size_t flatIdx = 0; flatIdx < flatNodes.size(); ++flatIdx)
+    {
+        const SkeletonNodeData* pNode = flatNodes[flatIdx];
+        m_FlatIndexByNodeId[pNode->NodeId()] = (uint32_t)flatIdx;
+        m_FlatNodeIds.push_back((uint32_t)pNode->NodeId());
+        m_FlatParentIndices.push_back(pNode->Parent() ? (int)m_FlatIndexByNodeId[pNode->Parent()->NodeId()] : -1);
+        for (const auto& child : pNode->Children())
+            flatNodes.push_back(&child);
+    }
+
+    // Any nodes not reachable from the roots (gltf nodes that are not part of this hierarchy) go on the end as roots, so every nodeId has a (identity) transform.
+    for (uint32_t nodeId = 0; nodeId < (uint32_t)m_FlatIndexByNodeId.size(); ++nodeId)
+    {
+        if (m_FlatIndexByNodeId[nodeId] != cNotFlattened)
+            continue;
+        m_FlatIndexByNodeId[nodeId] = (uint32_t)m_FlatNodeIds.size();
+        m_FlatNodeIds.push_back(nodeId);
+        m_FlatParentIndices.push_back(-1);
+    }
+}
@@ -54,6 +54,14 @@ public:
     SkeletonData(std::vector<SkeletonNodeData>&& Nodes, std::vector<const SkeletonNodeData*>&& NodesById, std::vector<const SkeletonNodeData*>&& rootNodes);
 
     const SkeletonNodeData* GetNodeById(uint32_t nodeId) const { return m_NodesById[nodeId]; }
+    size_t GetNumNodes() const                                  { return m_NodesById.size(); }
+
+    /// @returns nodeIds of all the nodes in breadth-first order (every node comes after its parent).  This 'flat' order is the order Skeleton stores its transforms in.
+    const auto& GetFlatNodeIds() const                          { return m_FlatNodeIds; }
+    /// @returns flat index (in to GetFlatNodeIds) of the parent of each node in GetFlatNodeIds (-1 for root nodes).  Always less than the node's own flat index.
+    const auto& GetFlatParentIndices() const                    { return m_FlatParentIndices; }
+    /// @returns flat index (in to GetFlatNodeIds) of the given node.
+    uint32_t GetFlatIndex(uint32_t nodeId) const                { return m_FlatIndexByNodeId[nodeId]; }
 
 protected:
     friend class Skeleton;
@@ -61,4 +69,7 @@ protected:
     std::vector<const SkeletonNodeData*>        m_NodesById;     ///< nodes ordered by NodeId
     std::vector<const SkeletonNodeData*>        m_RootNodes;     ///< root nodes (no set order)
     std::vector<SkeletonNodeData>               m_Nodes;       ///< Node data hierarchy (lookup start node via NodesById)
+    std::vector<uint32_t>                       m_FlatNodeIds;          ///< flattened (breadth-first, parent before child) hierarchy; nodeId of each node
+    std::vector<int>                            m_FlatParentIndices;    ///< flattened hierarchy; flat index of each node's parent (-1 if root)
+    std::vector<uint32_t>                       m_FlatIndexByNodeId;    ///< flat index of each node (by nodeId)
 };
@@ -0,0 +1,78 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "skinData.hpp"
+#include "skeleton.hpp"
+#include <cassert>
+#include <cmath>
+
+
+SkinData::SkinData(std::vector<uint32_t>&& jointNodeIds, std::vector<glm::mat4>&& inverseBindMatrices, int skeletonRootNodeId)
+    : m_JointNodeIds(std::move(jointNodeIds))
+    , m_InverseBindMatrices(std::move(inverseBindMatrices))
+    , m_SkeletonRootNodeId(skeletonRootNodeId)
+{
+    // glTF allows inverse bind matrices to be omitted (all identity)
+    m_InverseBindMatrices.resize(m_JointNodeIds.size(), glm::identity<glm::mat4>());
+}
+
+void SkinData::CalcPalette(const Skeleton& skeleton, tcb::span<tPaletteMatrix> outPalette, const glm::mat4& inverseMeshWorldTransform) const
+{
+    assert(outPalette.size() >= m_JointNodeIds.size());
+    for (size_t jointIdx = 0; jointIdx < m_JointNodeIds.size(); ++jointIdx)
+    {
+        const glm::mat4 jointMatrix = inverseMeshWorldTransform * skeleton.GetTransform(m_JointNodeIds[jointIdx]) * m_InverseBindMatrices[jointIdx];
+        outPalette[jointIdx] = tPaletteMatrix(glm::transpose(jointMatrix));
+    }
+}
+
+void SkinData::SkinVertices(tcb::span<const tPaletteMatrix> palette, tcb::span<const MeshObjectIntermediate::FatVertex> srcVertices, tcb::span<MeshObjectIntermediate::FatVertex> dstVertices)
+{
+    assert(srcVertices.size() == dstVertices.size());
+
+    const auto TransformPoint = [](const glm::mat4& m, const float(&in)[3], float(&out)[3]) {
+        const glm::vec3 v = glm::vec3(m * glm::vec4(in[0], in[1], in[2], 1.0f));
+        out[0] = v.x; out[1] = v.y; out[2] = v.z;
+    };
+    const auto TransformVector = [](const glm::mat4& m, const float(&in)[3], float(&out)[3]) {
+        glm::vec3 v = glm::vec3(m * glm::vec4(in[0], in[1], in[2], 0.0f));
+        const float lengthSq = glm::dot(v, v);
+        if (lengthSq > 0.0f)
+            v = v * (1.0f / std::sqrt(lengthSq));
+        out[0] = v.x; out[1] = v.y; out[2] = v.z;
+    };
+
+    for (size_t vertIdx = 0; vertIdx < srcVertices.size(); ++vertIdx)
+    {
+        const auto& src = srcVertices[vertIdx];
+        auto& dst = dstVertices[vertIdx];
+        dst = src;
+
+        // Blend the (row major) joint matrices by the vertex weights (as the shader would).
+        glm::mat3x4 blended(0.0f);
+        float totalWeight = 0.0f;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const float weight = src.weights[i];
+            if (weight == 0.0f)
+                continue;
+            assert(src.joints[i] < palette.size());
+            blended += palette[src.joints[i]] * weight;
+            totalWeight += weight;
+        }
+        if (totalWeight <= 0.0f)
+            continue;   // not skinned
+
+        // Back to column major for the transform.  Normals/tangents use the blended matrix directly (exact for rigid joints and uniform scale).
+        const glm::mat4 skinMatrix = glm::transpose(glm::mat4(blended[0], blended[1], blended[2], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+        TransformPoint(skinMatrix, src.position, dst.position);
+        TransformVector(skinMatrix, src.normal, dst.normal);
+        TransformVector(skinMatrix, src.tangent, dst.tangent);
+        TransformVector(skinMatrix, src.bitangent, dst.bitangent);
+    }
+}
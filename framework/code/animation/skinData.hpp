@@ -0,0 +1,62 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "system/glm_common.hpp"
+#include "tcb/span.hpp"
+#include "mesh/meshObjectIntermediate.hpp"
+
+// forward declarations
+class Skeleton;
+
+
+/// Skin data container.  Describes the joints (skeleton nodes) that a skinned mesh's vertex joint indices reference, and the inverse bind matrix of each joint.
+/// @ingroup Animation
+class SkinData
+{
+public:
+    SkinData(const SkinData&) = delete;
+    SkinData& operator=(const SkinData&) = delete;
+    SkinData(SkinData&&) = default;
+    SkinData& operator=(SkinData&&) = default;
+    SkinData(std::vector<uint32_t>&& jointNodeIds, std::vector<glm::mat4>&& inverseBindMatrices, int skeletonRootNodeId = -1);
+
+    /// Palette entry (one per joint).
+    /// @note This is transposed (row major), same layout as @MeshObjectIntermediate::FatInstance::tInstanceTransform.
+    typedef glm::mat3x4 tPaletteMatrix;
+
+    size_t GetNumJoints() const                                 { return m_JointNodeIds.size(); }
+    /// @returns skeleton nodeId of each joint (vertex joint indices index in to this)
+    const auto& GetJointNodeIds() const                         { return m_JointNodeIds; }
+    const auto& GetInverseBindMatrices() const                  { return m_InverseBindMatrices; }
+    /// @returns nodeId of the skeleton root (common root of the joints), -1 if not specified.
+    int GetSkeletonRootNodeId() const                           { return m_SkeletonRootNodeId; }
+
+    /// Calculate the skinning matrix palette from the current skeleton world transforms (palette[i] = inverseMeshWorld * jointWorld[i] * inverseBind[i]).
+    /// Output can be written directly in to a (persistently mapped) per-frame uniform or storage buffer.
+    /// @param skeleton skeleton (with up-to-date world transforms) that the joint node ids reference
+    /// @param outPalette destination, must have at least GetNumJoints() entries
+    /// @param inverseMeshWorldTransform inverse of the world transform the skinned mesh is rendered with (identity if the mesh is rendered in skeleton world space, as glTF requires)
+    void CalcPalette(const Skeleton& skeleton, tcb::span<tPaletteMatrix> outPalette, const glm::mat4& inverseMeshWorldTransform = glm::identity<glm::mat4>()) const;
+
+    /// Reference (CPU) implementation of linear blend skinning, matches what a skinning vertex shader should output.
+    /// Skins position, normal, tangent and bitangent; vertices with no joint weights are copied unchanged.
+    /// Intended for verification (and headless use), not performance.
+    /// @param palette matrices calculated by CalcPalette
+    /// @param srcVertices bind pose vertices (with joints and weights)
+    /// @param dstVertices output vertices, must be the same size as srcVertices
+    static void SkinVertices(tcb::span<const tPaletteMatrix> palette, tcb::span<const MeshObjectIntermediate::FatVertex> srcVertices, tcb::span<MeshObjectIntermediate::FatVertex> dstVertices);
+
+protected:
+    std::vector<uint32_t>   m_JointNodeIds;         ///< skeleton nodeId of each joint
+    std::vector<glm::mat4>  m_InverseBindMatrices;  ///< inverse bind matrix of each joint (same order as m_JointNodeIds)
+    int                     m_SkeletonRootNodeId;   ///< nodeId of the skeleton root (or -1)
+};
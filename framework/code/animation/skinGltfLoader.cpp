@@ -0,0 +1,59 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "skinGltfLoader.hpp"
+#include "skinData.hpp"
+#include "mesh/meshLoader.hpp"
+#include "system/os_common.h"
+#include <cstring>
+
+SkinGltfProcessor::SkinGltfProcessor() {}
+SkinGltfProcessor::~SkinGltfProcessor() {}
+
+
+bool SkinGltfProcessor::operator()(const tinygltf::Model& ModelData)
+{
+    m_skins.reserve(ModelData.skins.size());
+
+    for (const tinygltf::Skin& SkinData : ModelData.skins)
+    {
+        std::vector<uint32_t> jointNodeIds;
+        jointNodeIds.reserve(SkinData.joints.size());
+        for (int jointNodeIdx : SkinData.joints)
+        {
+            if (jointNodeIdx < 0 || jointNodeIdx >= (int)ModelData.nodes.size())
+            {
+                LOGE("Skin \"%s\" references invalid joint node %d", SkinData.name.c_str(), jointNodeIdx);
+                return false;
+            }
+            jointNodeIds.push_back((uint32_t)jointNodeIdx);
+        }
+
+        std::vector<glm::mat4> inverseBindMatrices;
+        if (SkinData.inverseBindMatrices >= 0)
+        {
+            const tinygltf::Accessor& accessorData = ModelData.accessors[SkinData.inverseBindMatrices];
+            if (accessorData.type != TINYGLTF_TYPE_MAT4 || accessorData.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessorData.count < jointNodeIds.size())
+            {
+                LOGE("Skin \"%s\" has unsupported inverse bind matrix data", SkinData.name.c_str());
+                return false;
+            }
+            const auto& bufferView = ModelData.bufferViews[accessorData.bufferView];
+            const size_t srcStride = bufferView.byteStride == 0 ? sizeof(glm::mat4) : bufferView.byteStride;
+            const uint8_t* pSrc = &ModelData.buffers[bufferView.buffer].data[bufferView.byteOffset + accessorData.byteOffset];
+
+            // gltf matrices are column major (same as glm); copy (rather than cast) as the buffer data may not be aligned.
+            inverseBindMatrices.resize(jointNodeIds.size());
+            for (size_t jointIdx = 0; jointIdx < jointNodeIds.size(); ++jointIdx)
+                memcpy(&inverseBindMatrices[jointIdx], pSrc + jointIdx * srcStride, sizeof(glm::mat4));
+        }
+
+        m_skins.emplace_back(std::move(jointNodeIds), std::move(inverseBindMatrices), SkinData.skeleton);
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#pragma once
+
+#include <vector>
+
+// forward declarations
+class SkinData;
+
+namespace tinygltf {
+    class Model;
+};
+
+/// Gltf model processor for skin data (passed in to @MeshLoader::LoadGltf)
+/// Creates and populates a @SkinData for each skin inside the gltf model (in gltf skin index order, as referenced by @MeshObjectIntermediate::m_SkinId).
+/// @ingroup Animation
+class SkinGltfProcessor
+{
+    SkinGltfProcessor& operator=(const SkinGltfProcessor&) = delete;
+    SkinGltfProcessor(const SkinGltfProcessor&) = delete;
+public:
+    SkinGltfProcessor();
+    ~SkinGltfProcessor();
+    bool operator()(const tinygltf::Model& ModelData);
+    std::vector<SkinData> m_skins;
+};
@@ -8,6 +8,7 @@
 
 #include "camera.hpp"
 #include "cameraData.hpp"
+#include "mesh/octree.hpp"
 #include "system/math_common.hpp"
 
 Camera::Camera()
@@ -110,3 +111,9 @@ glm::mat4 Camera::GetProjectionWithJitter(const glm::vec3 jitter) const
     return jitteredProj;
 }
 
+//-----------------------------------------------------------------------------
+ViewFrustum Camera::CalcViewFrustum() const
+//-----------------------------------------------------------------------------
+{
+    return ViewFrustum( m_ProjectionMatrixNoJitter, m_ViewMatrix );
+}
@@ -15,6 +15,7 @@
 // Forward declarations
 class CameraController;
 struct CameraData;
+class ViewFrustum;
 
 /// Perspective camera.
 /// @ingroup Camera
@@ -56,6 +57,9 @@ public:
     /// Update camera matrices (based on current rotation/position)
     void UpdateMatrices();
 
+    /// Calculate the view frustum (for culling) from the current (unjittered) camera matrices
+    ViewFrustum CalcViewFrustum() const;
+
     // Accessors
     glm::vec3           Position() const { return m_CurrentCameraPos; }         ///<@returns the current camera postion
     glm::quat           Rotation() const { return m_CurrentCameraRot; }         ///<@returns the current camera rotation
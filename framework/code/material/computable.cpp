@@ -430,7 +430,8 @@ void Computable::DispatchPass(VkCommandBuffer cmdBuffer, const ComputablePass& c
     // Bind everything the shader needs
     const auto& descriptorSets = computablePass.GetVkDescriptorSets();
     VkDescriptorSet descriptorSet = descriptorSets.size() >= 1 ? descriptorSets[bufferIdx] : descriptorSets[0];
-    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computablePass.mPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    const auto dynamicOffsets = computablePass.mMaterialPass.GetDynamicOffsets(bufferIdx);
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computablePass.mPipelineLayout, 0, 1, &descriptorSet, (uint32_t)dynamicOffsets.size(), dynamicOffsets.data());
 
     // Dispatch the compute task
     vkCmdDispatch(cmdBuffer, computablePass.GetDispatchGroupCount()[0], computablePass.GetDispatchGroupCount()[1], computablePass.GetDispatchGroupCount()[2]);
@@ -19,6 +19,7 @@ class DescriptorSetDescription
 public:
     enum class DescriptorType {
         UniformBuffer,
+        UniformBufferDynamic,   ///< uniform buffer bound with a dynamic offset (eg a UniformRingBuffer allocation)
         StorageBuffer,
         ImageSampler,
         ImageStorage,
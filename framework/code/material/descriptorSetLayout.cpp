@@ -67,6 +67,10 @@ bool DescriptorSetLayout::Init(Vulkan& vulkan, const DescriptorSetDescription& d
             binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
             assert(readOnly);
             break;
+        case DescriptorSetDescription::DescriptorType::UniformBufferDynamic:
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            assert(readOnly);
+            break;
         case DescriptorSetDescription::DescriptorType::StorageBuffer:
             binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
             break;
@@ -12,6 +12,7 @@
 #include "shaderDescription.hpp"
 #include "shaderModule.hpp"
 #include "system/os_common.h"
+#include "memory/bufferUploader.hpp"
 #include "mesh/instanceGenerator.hpp"
 #include "vulkan/extensionHelpers.hpp"
 #include <cassert>
@@ -256,7 +257,13 @@ bool Drawable::ReInit( tcb::span<VkRenderPass> vkRenderPasses, const char* const
             {
                 const int bufferIdx = tmp[formatBindingIdx];
                 passVertexBufferLookup.push_back(bufferIdx);
-                if (bufferIdx >= 0)
+                if (bufferIdx >= 0 && mMeshObject.IsInGeometryArena())
+                {
+                    // Vertex rate data (ie the mesh) sub-allocated from the geometry arena's shared buffers (offset applied by the draw's firstVertex/vertexOffset)
+                    assert(bufferIdx < (int)mMeshObject.m_ArenaVertices.VkBuffers.size());
+                    passVertexBuffers.push_back(mMeshObject.m_ArenaVertices.VkBuffers[bufferIdx]);
+                }
+                else if (bufferIdx >= 0)
                 {
                     // Vertex rate data (ie the mesh)
                     passVertexBuffers.push_back(mMeshObject.m_VertexBuffers[bufferIdx].GetVkBuffer());
@@ -286,6 +293,14 @@ bool Drawable::ReInit( tcb::span<VkRenderPass> vkRenderPasses, const char* const
                 indexBufferType = mMeshObject.m_IndexBuffer->GetIndexType();
                 indexCount = mMeshObject.m_IndexBuffer->GetNumIndices();
             }
+            else if (mMeshObject.m_ArenaIndices)
+            {
+                indexBuffer = mMeshObject.m_ArenaIndices.IndexBuffer;
+                indexBufferType = mMeshObject.m_ArenaIndices.IndexType;
+                indexCount = mMeshObject.m_ArenaIndices.NumIndices;
+            }
+            const uint32_t firstVertex = mMeshObject.m_ArenaVertices.FirstVertex;
+            const uint32_t firstIndex = mMeshObject.m_ArenaIndices.FirstIndex;
 
             // Indirect Draw buffer is optional
             VkBuffer drawIndirectBuffer = mDrawIndirectBuffer.has_value() ? mDrawIndirectBuffer->GetVkBuffer() : VK_NULL_HANDLE;
@@ -314,6 +329,8 @@ bool Drawable::ReInit( tcb::span<VkRenderPass> vkRenderPasses, const char* const
                                                                     drawIndirectCountBuffer,
                                                                     (uint32_t)mMeshObject.m_NumVertices,
                                                                     (uint32_t)indexCount,
+                                                                    firstVertex,
+                                                                    firstIndex,
                                                                     (uint32_t)drawIndirectCount,
                                                                     (uint32_t)drawIndirectOffset,
                                                                     passIdx
@@ -374,14 +391,15 @@ void Drawable::DrawPass(VkCommandBuffer cmdBuffer, const DrawablePass& drawableP
     if (!drawablePass.mDescriptorSet.empty())
     {
         VkDescriptorSet vkDescriptorSet = drawablePass.mDescriptorSet.size() >= 1 ? drawablePass.mDescriptorSet[bufferIdx] : drawablePass.mDescriptorSet[0];
+        const auto dynamicOffsets = drawablePass.mMaterialPass.GetDynamicOffsets(bufferIdx);
         vkCmdBindDescriptorSets(cmdBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             drawablePass.mPipelineLayout,
             0,
             1,
             &vkDescriptorSet,
-            0,
-            NULL);
+            (uint32_t)dynamicOffsets.size(),
+            dynamicOffsets.data());
     }
 
     const auto& vertexBuffers = vertexBufferOverrides.empty() ? drawablePass.mVertexBuffers : vertexBufferOverrides[bufferIdx % vertexBufferOverrides.size()];
@@ -427,7 +445,7 @@ void Drawable::DrawPass(VkCommandBuffer cmdBuffer, const DrawablePass& drawableP
         else
         {
             // Everything is set up, draw the mesh
-            vkCmdDrawIndexed(cmdBuffer, drawablePass.mNumIndices, GetInstances() ? (uint32_t)GetInstances()->GetNumVertices() : 1, 0, 0, 0);
+            vkCmdDrawIndexed(cmdBuffer, drawablePass.mNumIndices, GetInstances() ? (uint32_t)GetInstances()->GetNumVertices() : 1, drawablePass.mFirstIndex, (int32_t)drawablePass.mFirstVertex, 0);
         }
     }
     else
@@ -448,12 +466,12 @@ void Drawable::DrawPass(VkCommandBuffer cmdBuffer, const DrawablePass& drawableP
         else
         {
             // Draw the mesh without index buffer
-            vkCmdDraw(cmdBuffer, drawablePass.mNumVertices, GetInstances() ? (uint32_t)GetInstances()->GetNumVertices() : 1, 0, 0);
+            vkCmdDraw(cmdBuffer, drawablePass.mNumVertices, GetInstances() ? (uint32_t)GetInstances()->GetNumVertices() : 1, drawablePass.mFirstVertex, 0);
         }
     }
 }
 
-bool DrawableLoader::LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::string& meshFilename, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, tcb::span<const uint32_t> renderPassSubpasses, const glm::vec3 globalScale)
+bool DrawableLoader::LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::string& meshFilename, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, tcb::span<const uint32_t> renderPassSubpasses, const glm::vec3 globalScale, GeometryArena* pGeometryArena)
 {
     LOGI("Loading Object mesh: %s...", meshFilename.c_str());
 
@@ -477,7 +495,7 @@ bool DrawableLoader::LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, t
     DrawableLoader::PrintStatistics(fatObjects);
 
     // Turn the intermediate mesh objects into Drawables (and load the materials)
-    if (!CreateDrawables(vulkan, std::move(fatObjects), vkRenderPasses, renderPassNames, materialLoader, drawables, renderPassMultisample, loaderFlags, renderPassSubpasses))
+    if (!CreateDrawables(vulkan, std::move(fatObjects), vkRenderPasses, renderPassNames, materialLoader, drawables, renderPassMultisample, loaderFlags, renderPassSubpasses, pGeometryArena))
     {
         LOGE("Error initializing Drawable: %s", meshFilename.c_str());
         return false;
@@ -485,12 +503,25 @@ bool DrawableLoader::LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, t
     return true;    // success
 }
 
-bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectIntermediate>&&intermediateMeshObjects, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>&materialLoader, std::vector<Drawable>&drawables, const tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, const tcb::span<const uint32_t> renderPassSubpasses)
+bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectIntermediate>&&intermediateMeshObjects, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>&materialLoader, std::vector<Drawable>&drawables, const tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, const tcb::span<const uint32_t> renderPassSubpasses, GeometryArena* pGeometryArena)
 {
     // See if we can find instances, we assume there is no instance information in the gltf!
     auto instancedFatObjects = (loaderFlags & LoaderFlags::FindInstances) ? MeshInstanceGenerator::FindInstances(std::move(intermediateMeshObjects)) : MeshInstanceGenerator::NullFindInstances(std::move(intermediateMeshObjects));
     intermediateMeshObjects.clear();
 
+    // Batch the mesh (including device local arena) and instance buffer uploads rather than writing each buffer as it is created.
+    // Submitted (without waiting) every cMaxPendingUploadBytes, so the gpu copies overlap with the cpu preparing the next meshes, and flushed before returning.
+    constexpr size_t cMaxPendingUploadBytes = 64 * 1024 * 1024;
+    BufferUploader uploader;
+    BufferUploader* pUploader = uploader.Initialize(&vulkan) ? &uploader : nullptr;
+    // Every error return goes through Fail, which flushes the uploads already recorded (and waits for them) while the buffers they write are still alive
+    // (it is evaluated before the loop's locals, eg meshObject, are destroyed).
+    const auto Fail = [pUploader]() {
+        if (pUploader)
+            pUploader->Flush();
+        return false;
+    };
+
     drawables.reserve(instancedFatObjects.size() );
     for (auto& [fatObject, instances] : instancedFatObjects)
     {
@@ -568,7 +599,10 @@ bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectInte
 
             MeshObject meshObject;
             const auto& vertexFormats = shader.m_shaderDescription->m_vertexFormats;
-            MeshObject::CreateMesh(&vulkan, fatObject, (uint32_t)pFirstPass->m_shaderPassDescription.m_vertexFormatBindings[0], vertexFormats, &meshObject);
+            if (pGeometryArena)
+                MeshObject::CreateMesh(*pGeometryArena, fatObject, vertexFormats, &meshObject, pUploader);
+            else
+                MeshObject::CreateMesh(&vulkan, fatObject, (uint32_t)pFirstPass->m_shaderPassDescription.m_vertexFormatBindings[0], vertexFormats, &meshObject, pUploader);
 
             // We are done with the FatObject here, Release it to save some memory earlier.
             fatObject.Release();
@@ -582,7 +616,7 @@ bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectInte
                 if (instanceFormatIt != vertexFormats.cbegin() && instanceFormatIt != vertexFormats.end()-1)
                 {
                     LOGE("  Drawable loader (currently) only suports shaders with instance rate 'vertex' buffers at the beginning or end of their vertex layout");
-                    return false;
+                    return Fail();
                 }
                 // Create the instance data
                 auto instancesSpan = tcb::make_span(instances);
@@ -590,14 +624,16 @@ bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectInte
                 {
                     // Even if we are not instancing there should be one instance per mesh
                     LOGE("  Drawable loader expected mesh to have (at least) one instance matrix");
-                    return false;
+                    return Fail();
                 }
 
                 const std::vector<uint32_t> formattedVertexData = MeshObjectIntermediate::CopyFatInstanceToFormattedBuffer(instancesSpan, *instanceFormatIt);
 
-                if (!vertexInstanceBuffer.emplace().Initialize(&vulkan.GetMemoryManager(), instanceFormatIt->span, instancesSpan.size(), formattedVertexData.data()))
+                const bool initialized = pUploader ? vertexInstanceBuffer.emplace().Initialize(*pUploader, instanceFormatIt->span, instancesSpan.size(), formattedVertexData.data())
+                                                   : vertexInstanceBuffer.emplace().Initialize(&vulkan.GetMemoryManager(), instanceFormatIt->span, instancesSpan.size(), formattedVertexData.data());
+                if (!initialized)
                 {
-                    return false;
+                    return Fail();
                 }
             }
             else
@@ -605,18 +641,23 @@ bool DrawableLoader::CreateDrawables(Vulkan & vulkan, std::vector<MeshObjectInte
                 if( instances.size() > 1)
                 {
                     LOGE("  Drawable loader found instances - expects shaders vertex layout to have instance data support");
-                    return false;
+                    return Fail();
                 }
             }
 
             // Create the drawable
             if (!drawables.emplace_back(vulkan, std::move(material.value())).Init(vkRenderPasses, renderPassNames, passMask, std::move(meshObject), std::move(vertexInstanceBuffer), std::nullopt, renderPassMultisample, renderPassSubpasses, nodeId))
             {
-                return false;
+                return Fail();
+            }
+
+            if (pUploader && pUploader->GetPendingBytes() >= cMaxPendingUploadBytes && pUploader->Submit() == 0)
+            {
+                return Fail();
             }
         }
     }
-    return true;
+    return !pUploader || pUploader->Flush();
 }
 
 DrawableLoader::MeshStatistics DrawableLoader::GatherStatistics(const tcb::span<MeshObjectIntermediate> meshObjects)
@@ -59,6 +59,8 @@ public:
     VkBuffer                        mDrawIndirectCountBuffer = VK_NULL_HANDLE;
     uint32_t                        mNumVertices;
     uint32_t                        mNumIndices;
+    uint32_t                        mFirstVertex;               // non zero if the mesh is sub-allocated from a GeometryArena (vertex buffers bound at offset 0)
+    uint32_t                        mFirstIndex;                // non zero if the mesh is sub-allocated from a GeometryArena (index buffer bound at offset 0)
     uint32_t                        mNumDrawIndirect;
     uint32_t                        mDrawIndirectOffset;        // if non zero offset mDrawIndirectBuffer by this
     uint32_t                        mPassIdx;                   // index of the bit in Drawable::m_passMask
@@ -140,8 +142,9 @@ public:
     /// @param loaderFlags loader feature enables
     /// @param renderPassSubpasses subpass indices for each render pass (0 for first subpass of if there are no subpasses).  If empty treat everything as using subpass 0
     /// @param globalScale global scale applied to every loaded Drawable object
+    /// @param pGeometryArena optional arena to sub-allocate the mesh vertex/index data from (nullptr to give each mesh its own buffers).  Must outlive the drawables.
     /// @return true on success
-    static bool LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::string& meshFilename, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*LoaderFlags*/uint32_t loaderFlags, tcb::span<const uint32_t> renderPassSubpasses, const glm::vec3 globalScale = glm::vec3(1.0f,1.0f,1.0f));
+    static bool LoadDrawables(Vulkan& vulkan, AssetManager& assetManager, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::string& meshFilename, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*LoaderFlags*/uint32_t loaderFlags, tcb::span<const uint32_t> renderPassSubpasses, const glm::vec3 globalScale = glm::vec3(1.0f,1.0f,1.0f), GeometryArena* pGeometryArena = nullptr);
 
     /// @brief Create @Drawable(s) for rendering a given vector of @MeshObjectIntermediate objects.
     /// This is the recommended way of creating meshes in the Framework Material system and is used by the LoadDrawables function.
@@ -154,8 +157,9 @@ public:
     /// @param renderPassMultisample optional multisample flags (if zero size assume no multisampling)
     /// @param loaderFlags loader feature enables
     /// @param RenderPassSubpasses subpass indices for each render pass (0 for first subpass of if there are no subpasses).  If empty treat everything as using subpass 0
+    /// @param pGeometryArena optional arena to sub-allocate the mesh vertex/index data from (nullptr to give each mesh its own buffers).  Must outlive the drawables.
     /// @return true on success
-    static bool CreateDrawables(Vulkan& vulkan, std::vector<MeshObjectIntermediate>&& intermediateMeshObjects, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, const tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, const tcb::span<const uint32_t> renderPassSubpasses);
+    static bool CreateDrawables(Vulkan& vulkan, std::vector<MeshObjectIntermediate>&& intermediateMeshObjects, tcb::span<VkRenderPass> vkRenderPasses, const char* const* renderPassNames, const std::function<std::optional<Material>(const MeshObjectIntermediate::MaterialDef&)>& materialLoader, std::vector<Drawable>& drawables, const tcb::span<const VkSampleCountFlagBits> renderPassMultisample, /*DrawableLoader::LoaderFlags*/uint32_t loaderFlags, const tcb::span<const uint32_t> renderPassSubpasses, GeometryArena* pGeometryArena = nullptr);
 
     /// @brief Print some combined statistics about the given meshObjects.
     /// @param meshObjects span of the objects we want to gather the statistics for.
@@ -9,8 +9,10 @@
 #include "material.hpp"
 #include "shader.hpp"
 #include "vulkan/vulkan.hpp"
+#include <algorithm>
 #include <array>
 #include "system/os_common.h"
+#include "memory/uniformRingBuffer.hpp"
 #include "vulkan/TextureFuncts.h"
 
 
@@ -28,6 +30,18 @@ MaterialPass::MaterialPass(Vulkan& vulkan, const ShaderPass& shaderPass, VkDescr
 		mDynamicPipelineLayout.Init(vulkan, mDynamicDescriptorSetLayouts);
 
 	descriptorPool = VK_NULL_HANDLE;	// we took owenership
+
+	// Dynamic offsets are passed to vkCmdBindDescriptorSets in binding order.
+	for (const auto& bufferBinding : mBufferBindings)
+	{
+		if (bufferBinding.second.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+		{
+			assert(!bufferBinding.second.isArray);	// arrays of dynamic buffers not supported (would need an offset per array element)
+			mDynamicBindingIndices.push_back(bufferBinding.second.index);
+		}
+	}
+	std::sort(mDynamicBindingIndices.begin(), mDynamicBindingIndices.end());
+	mDynamicOffsets.resize(mDescriptorSets.size() * mDynamicBindingIndices.size(), 0);
 }
 
 MaterialPass::MaterialPass(MaterialPass&& other) noexcept
@@ -40,6 +54,8 @@ MaterialPass::MaterialPass(MaterialPass&& other) noexcept
 	, mTextureBindings(std::move(other.mTextureBindings))
 	, mImageBindings(std::move(other.mImageBindings))
 	, mBufferBindings(std::move(other.mBufferBindings))
+	, mDynamicBindingIndices(std::move(other.mDynamicBindingIndices))
+	, mDynamicOffsets(std::move(other.mDynamicOffsets))
 {
 	other.mDescriptorPool = VK_NULL_HANDLE;
 }
@@ -235,7 +251,8 @@ bool MaterialPass::UpdateDescriptorSets(uint32_t bufferIdx)
 
 			bufferInfo[bufferInfoCount].buffer = bufferBinding.first[bufferIndex];
 			bufferInfo[bufferInfoCount].offset = 0;
-			bufferInfo[bufferInfoCount].range = VK_WHOLE_SIZE;
+			// Dynamic buffers need a fixed range (the dynamic offset is added on to the descriptor's offset when bound)
+			bufferInfo[bufferInfoCount].range = (bindingType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) ? cDynamicUniformBufferRange : VK_WHOLE_SIZE;
 		}
 
 		++writeInfoIdx;
@@ -290,6 +307,34 @@ bool MaterialPass::UpdateDescriptorSetBinding(uint32_t bufferIdx, const std::str
 	return true;
 }
 
+bool MaterialPass::SetDynamicOffset(uint32_t bufferIdx, const std::string& bindingName, uint32_t offset)
+{
+	const auto& passLayout = mShaderPass.GetDescriptorSetLayouts()[0];
+	const auto& nameToBinding = passLayout.GetNameToBinding();
+	const auto bindingIt = nameToBinding.find(bindingName);
+	if (bindingIt == nameToBinding.end())
+		return true;
+	if (bindingIt->second.type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+	{
+		LOGE("SetDynamicOffset: binding \"%s\" is not a UniformBufferDynamic", bindingName.c_str());
+		return false;
+	}
+
+	const auto dynamicIt = std::find(mDynamicBindingIndices.begin(), mDynamicBindingIndices.end(), bindingIt->second.index);
+	assert(dynamicIt != mDynamicBindingIndices.end());
+	const size_t setIdx = mDescriptorSets.size() > 1 ? bufferIdx : 0;
+	mDynamicOffsets[setIdx * mDynamicBindingIndices.size() + (dynamicIt - mDynamicBindingIndices.begin())] = offset;
+	return true;
+}
+
+tcb::span<const uint32_t> MaterialPass::GetDynamicOffsets(uint32_t bufferIdx) const
+{
+	if (mDynamicBindingIndices.empty())
+		return {};
+	const size_t setIdx = mDescriptorSets.size() > 1 ? bufferIdx : 0;
+	return { mDynamicOffsets.data() + setIdx * mDynamicBindingIndices.size(), mDynamicBindingIndices.size() };
+}
+
 
 //
 // Material class implementation
@@ -346,3 +391,13 @@ bool Material::UpdateDescriptorSetBinding(uint32_t bufferIdx, const std::string&
 	return success;
 }
 
+bool Material::SetDynamicOffset(uint32_t bufferIdx, const std::string& bindingName, uint32_t offset)
+{
+	bool success = true;
+	for (auto& materialPass : m_materialPasses)
+	{
+		success &= materialPass.SetDynamicOffset(bufferIdx, bindingName, offset);
+	}
+	return success;
+}
+
@@ -15,6 +15,7 @@
 #include <vulkan/vulkan.h>
 #include "descriptorSetLayout.hpp"
 #include "pipelineLayout.hpp"
+#include "tcb/span.hpp"
 
 // Forward declarations
 class Vulkan;
@@ -83,6 +84,13 @@ public:
     bool UpdateDescriptorSets(uint32_t bufferIdx);
     bool UpdateDescriptorSetBinding(uint32_t bufferIdx, const std::string& bindingName, const VulkanTexInfo& newTexture) const;
 
+    /// Set the offset used when binding a UniformBufferDynamic buffer (eg the dynamicOffset of a UniformRingBuffer allocation).
+    /// Command buffers record the offsets when the descriptor set is bound, so changing an offset requires the command buffers that draw with this material to be re-recorded.
+    /// @returns false if bindingName is not a dynamic uniform buffer (true if this pass does not have a binding with that name)
+    bool SetDynamicOffset(uint32_t bufferIdx, const std::string& bindingName, uint32_t offset);
+    /// @returns the dynamic offsets to pass to vkCmdBindDescriptorSets (one per UniformBufferDynamic binding, in binding order).  Empty if this pass has no dynamic bindings.
+    tcb::span<const uint32_t> GetDynamicOffsets(uint32_t bufferIdx) const;
+
     const ShaderPass& mShaderPass;
 protected:
     Vulkan& mVulkan;
@@ -96,6 +104,9 @@ protected:
     tTextureBindings mTextureBindings;              ///< Images (textures) (with sampler) considered readonly
     tImageBindings mImageBindings;                  ///< Images that may be bound as writable (or read/write).
     tBufferBindings mBufferBindings;
+
+    std::vector<uint32_t> mDynamicBindingIndices;   ///< binding index of each UniformBufferDynamic binding (ascending, the order Vulkan expects the dynamic offsets)
+    std::vector<uint32_t> mDynamicOffsets;          ///< mDynamicBindingIndices.size() offsets per descriptor set
 };
 
 
@@ -132,6 +143,10 @@ public:
     /// @return true on success
     bool UpdateDescriptorSetBinding(uint32_t bufferIdx, const std::string& bindingName, const VulkanTexInfo& newTexture) const;
 
+    /// @brief Set the dynamic offset of a UniformBufferDynamic binding (in all the passes that have it)
+    /// @return true on success
+    bool SetDynamicOffset(uint32_t bufferIdx, const std::string& bindingName, uint32_t offset);
+
     const Shader& m_shader;
 protected:
     std::map<std::string, uint32_t> m_materialPassNamesToIndex; /// pass name to index in m_materialPasses
@@ -101,6 +101,7 @@ MaterialPass MaterialManager::CreateMaterialPassInternal(
                 break;
             }
             case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
             case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
             {
                 MaterialPass::tPerFrameVkBuffer vkBuffers = bufferLoader(bindingName);	// Get the buffer(s) from the callback
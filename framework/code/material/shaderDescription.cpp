@@ -40,7 +40,8 @@ const static std::map<std::string, VertexFormat::Element::ElementType> cElementT
     {"Float16", VertexFormat::Element::ElementType::t::Float16},
     {"F16Vec2", VertexFormat::Element::ElementType::t::F16Vec2},
     {"F16Vec3", VertexFormat::Element::ElementType::t::F16Vec3},
-    {"F16Vec4", VertexFormat::Element::ElementType::t::F16Vec4}
+    {"F16Vec4", VertexFormat::Element::ElementType::t::F16Vec4},
+    {"UVec4", VertexFormat::Element::ElementType::t::UVec4}
 };
 const static std::map<std::string, VertexFormat::eInputRate> cBufferRateByName{
     {"Vertex", VertexFormat::eInputRate::Vertex},
@@ -54,6 +55,7 @@ struct DescriptorTypeAndReadOnly {
 const static std::map<std::string, DescriptorTypeAndReadOnly> cBufferTypeByName {
     {"ImageSampler",  {DescriptorSetDescription::DescriptorType::ImageSampler, true}},
     {"UniformBuffer", {DescriptorSetDescription::DescriptorType::UniformBuffer, true}},
+    {"UniformBufferDynamic", {DescriptorSetDescription::DescriptorType::UniformBufferDynamic, true}},
     {"StorageBuffer", {DescriptorSetDescription::DescriptorType::StorageBuffer, false}},
     {"ImageStorage",  {DescriptorSetDescription::DescriptorType::ImageStorage, false}},
     {"InputAttachment",  {DescriptorSetDescription::DescriptorType::InputAttachment, true}}
@@ -51,6 +51,8 @@ VkFormat VertexDescription::VkFormatFromElementType( const VertexFormat::Element
             return VK_FORMAT_R16G16B16_SFLOAT;
         case VertexFormat::Element::ElementType::t::F16Vec4:
             return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case VertexFormat::Element::ElementType::t::UVec4:
+            return VK_FORMAT_R32G32B32A32_UINT;
 
         default:
             assert(0);
@@ -33,7 +33,8 @@ public:
                 Float16,
                 F16Vec2,
                 F16Vec3,
-                F16Vec4
+                F16Vec4,
+                UVec4
             };
             constexpr ElementType(const t _type) : type(_type) {}
             constexpr operator t() const { return type; }
@@ -60,6 +61,8 @@ public:
                         return 6;
                     case t::F16Vec4:
                         return 8;
+                    case t::UVec4:
+                        return 16;
                 }
             }
         private:
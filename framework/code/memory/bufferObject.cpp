@@ -8,6 +8,7 @@
 
 #include "bufferObject.hpp"
 #include "memoryManager.hpp"
+#include "bufferUploader.hpp"
 #include <cassert>
 #include "tinyobjloader/tiny_obj_loader.h"
 
@@ -94,6 +95,28 @@ bool BufferObject::Initialize(MemoryManager* pManager, size_t size, VkBufferUsag
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool BufferObject::Initialize(BufferUploader& uploader, size_t size, VkBufferUsageFlags bufferUsageFlags, const void* initialData)
+{
+    if (!initialData || !uploader.UseDeviceLocal() || (bufferUsageFlags & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) != 0)
+    {
+        return Initialize(&uploader.GetMemoryManager(), size, bufferUsageFlags, initialData);
+    }
+
+    if (!Initialize(&uploader.GetMemoryManager(), size, bufferUsageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryManager::MemoryUsage::GpuExclusive))
+    {
+        return false;
+    }
+
+    if (!uploader.Upload(GetVkBuffer(), 0, initialData, size))
+    {
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void BufferObject::Destroy()
 {
     if (!mManager)
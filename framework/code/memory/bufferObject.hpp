@@ -14,6 +14,7 @@
 // Forward declarations
 struct AHardwareBuffer_Desc;
 struct AHardwareBuffer;
+class BufferUploader;
 
 /// Defines a simple base object for creating and holding Vulkan memory buffer objects.
 /// @ingroup Memory
@@ -32,6 +33,9 @@ public:
 
     bool Initialize(MemoryManager* pManager, size_t size, VkBufferUsageFlags bufferUsageFlags, const void* initialData);
 	bool Initialize(MemoryManager* pManager, size_t size, VkBufferUsageFlags bufferUsageFlags, MemoryManager::MemoryUsage memoryUsage);
+	/// Initialize with the initialData staged in to 'uploader' (buffer is device local and its contents are undefined until the uploader's next Submit/Flush has executed).
+	/// Falls back to the host visible (CpuToGpu) path above when the uploader prefers it (unified memory) or when the buffer has TRANSFER_SRC usage (needs to be cpu mappable for Copy).
+	bool Initialize(BufferUploader& uploader, size_t size, VkBufferUsageFlags bufferUsageFlags, const void* initialData);
 	//bool Initialize(MemoryManager* pManager, VkBufferUsageFlags usageFlags, const AHardwareBuffer_Desc& hardwareBufferDesc, const void* initialData);
     //bool Initialize(MemoryManager* pManagere, VkBufferUsageFlags usageFlags, const AHardwareBuffer* pAHardwareBuffer);
 
@@ -0,0 +1,273 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "bufferUploader.hpp"
+#include "vulkan/vulkan.hpp"
+#include "system/os_common.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+// Alignment of each upload in the staging buffers (vkCmdCopyBuffer has no alignment requirement, keeps the memcpy destinations aligned)
+static constexpr size_t cStagingAlignment = 16;
+
+///////////////////////////////////////////////////////////////////////////////
+
+BufferUploader::BufferUploader()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BufferUploader::~BufferUploader()
+{
+    Destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool BufferUploader::Initialize(Vulkan* pVulkan, size_t stagingBlockSize, bool forceDeviceLocal)
+{
+    Destroy();
+    if (!pVulkan || stagingBlockSize == 0)
+    {
+        return false;
+    }
+
+    m_pVulkan = pVulkan;
+    m_StagingBlockSize = stagingBlockSize;
+    m_UseDeviceLocal = forceDeviceLocal || PrefersDeviceLocal(*pVulkan);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool BufferUploader::PrefersDeviceLocal(const Vulkan& vulkan)
+{
+    // Discrete gpus read device local memory (over their own memory bus) much faster than host visible memory (over PCIe), worth the copy.
+    // Integrated (unified memory) gpus read host visible memory at the same speed so write the destination buffers directly.
+    const VkPhysicalDeviceType DeviceType = vulkan.GetGpuProperties().Base.properties.deviceType;
+    return DeviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU && DeviceType != VK_PHYSICAL_DEVICE_TYPE_CPU;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BufferUploader::Destroy()
+{
+    if (!m_pVulkan)
+    {
+        return;
+    }
+    if (!m_PendingCopies.empty())
+    {
+        LOGE("BufferUploader destroyed with %zu uploads that were not submitted", m_PendingCopies.size());
+        m_PendingCopies.clear();
+    }
+    m_PendingBytes = 0;
+
+    // Staging buffers may still be being read by the gpu.
+    m_pVulkan->WaitSetupSubmission(m_LastSubmissionId);
+    m_StagingBlocks.clear();
+    m_LargeStaging.clear();
+    m_LastSubmissionId = 0;
+    m_pVulkan = nullptr;
+    m_StagingBlockSize = 0;
+    m_Stats = {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryManager& BufferUploader::GetMemoryManager() const
+{
+    assert(m_pVulkan);
+    return m_pVulkan->GetMemoryManager();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BufferUploader::ReclaimStaging()
+{
+    for (auto& block : m_StagingBlocks)
+    {
+        if (block.SubmissionId != 0 && m_pVulkan->IsSetupSubmissionComplete(block.SubmissionId))
+        {
+            block.Buffer->Release(block.SubmittedHead);
+            block.SubmissionId = 0;
+        }
+    }
+    m_LargeStaging.erase(std::remove_if(m_LargeStaging.begin(), m_LargeStaging.end(), [this](const StagingBlock& block) {
+        return block.SubmissionId != 0 && m_pVulkan->IsSetupSubmissionComplete(block.SubmissionId);
+    }), m_LargeStaging.end());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRingBuffer::Allocation BufferUploader::AllocateStaging(size_t size)
+{
+    ReclaimStaging();
+
+    if (size > m_StagingBlockSize)
+    {
+        // Too big for the pool, give it a staging buffer of its own (freed once its submission completes).
+        auto& block = m_LargeStaging.emplace_back(StagingBlock{ std::make_unique<StagingRingBuffer>() });
+        if (!block.Buffer->Initialize(&GetMemoryManager(), size))
+        {
+            m_LargeStaging.pop_back();
+            return {};
+        }
+        return block.Buffer->Allocate(size, cStagingAlignment);
+    }
+
+    for (auto& block : m_StagingBlocks)
+    {
+        auto allocation = block.Buffer->Allocate(size, cStagingAlignment);
+        if (allocation)
+            return allocation;
+    }
+
+    auto& block = m_StagingBlocks.emplace_back(StagingBlock{ std::make_unique<StagingRingBuffer>() });
+    if (!block.Buffer->Initialize(&GetMemoryManager(), m_StagingBlockSize))
+    {
+        m_StagingBlocks.pop_back();
+        return {};
+    }
+    return block.Buffer->Allocate(size, cStagingAlignment);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool BufferUploader::Upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, size_t size)
+{
+    assert(m_pVulkan);
+    if (size == 0)
+    {
+        return true;
+    }
+    if (dstBuffer == VK_NULL_HANDLE || !pData)
+    {
+        return false;
+    }
+
+    auto staging = AllocateStaging(size);
+    if (!staging)
+    {
+        LOGE("BufferUploader unable to allocate %zu bytes of staging memory", size);
+        return false;
+    }
+    memcpy(staging.pData, pData, size);
+
+    m_PendingCopies.push_back({ staging.buffer, dstBuffer, { staging.offset, dstOffset, (VkDeviceSize)size } });
+    m_PendingBytes += size;
+    ++m_Stats.NumUploads;
+    m_Stats.BytesUploaded += size;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint64_t BufferUploader::Submit()
+{
+    assert(m_pVulkan);
+    if (m_PendingCopies.empty())
+    {
+        return 0;
+    }
+
+    uint64_t SubmissionId = 0;
+    VkCommandBuffer CmdBuffer = m_pVulkan->StartSetupCommandBuffer();
+    if (CmdBuffer != VK_NULL_HANDLE)
+    {
+        // One vkCmdCopyBuffer per source/destination buffer pair.
+        std::stable_sort(m_PendingCopies.begin(), m_PendingCopies.end(), [](const PendingCopy& a, const PendingCopy& b) {
+            return (a.SrcBuffer != b.SrcBuffer) ? (a.SrcBuffer < b.SrcBuffer) : (a.DstBuffer < b.DstBuffer);
+        });
+        std::vector<VkBufferCopy> Regions;
+        for (size_t First = 0; First < m_PendingCopies.size();)
+        {
+            const VkBuffer SrcBuffer = m_PendingCopies[First].SrcBuffer;
+            const VkBuffer DstBuffer = m_PendingCopies[First].DstBuffer;
+            Regions.clear();
+            size_t Last = First;
+            for (; Last < m_PendingCopies.size() && m_PendingCopies[Last].SrcBuffer == SrcBuffer && m_PendingCopies[Last].DstBuffer == DstBuffer; ++Last)
+                Regions.push_back(m_PendingCopies[Last].Region);
+            vkCmdCopyBuffer(CmdBuffer, SrcBuffer, DstBuffer, (uint32_t)Regions.size(), Regions.data());
+            First = Last;
+        }
+
+        // Make the copies visible to whatever the buffers are used for in later submissions.
+        VkMemoryBarrier MemoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        MemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        MemoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &MemoryBarrier, 0, nullptr, 0, nullptr);
+
+        SubmissionId = m_pVulkan->SubmitSetupCommandBuffer(CmdBuffer);
+    }
+    if (SubmissionId == 0)
+    {
+        LOGE("BufferUploader failed to submit %zu uploads", m_PendingCopies.size());
+    }
+
+    // Staging memory written since the last submission is released when this one completes (straight away if the copies were never submitted).
+    for (auto& block : m_StagingBlocks)
+    {
+        if (block.Buffer->GetHead() != block.SubmittedHead)
+        {
+            block.SubmittedHead = block.Buffer->GetHead();
+            block.SubmissionId = SubmissionId;
+            if (SubmissionId == 0)
+                block.Buffer->Release(block.SubmittedHead);
+        }
+    }
+    for (auto& block : m_LargeStaging)
+    {
+        if (block.SubmissionId == 0)
+            block.SubmissionId = SubmissionId;
+    }
+    if (SubmissionId == 0)
+    {
+        m_LargeStaging.erase(std::remove_if(m_LargeStaging.begin(), m_LargeStaging.end(), [](const StagingBlock& block) { return block.SubmissionId == 0; }), m_LargeStaging.end());
+    }
+    else
+    {
+        m_LastSubmissionId = SubmissionId;
+        ++m_Stats.NumSubmits;
+    }
+
+    m_PendingCopies.clear();
+    m_PendingBytes = 0;
+    return SubmissionId;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool BufferUploader::Flush()
+{
+    assert(m_pVulkan);
+    if (!m_PendingCopies.empty() && Submit() == 0)
+    {
+        return false;
+    }
+    if (!m_pVulkan->WaitSetupSubmission(m_LastSubmissionId))
+    {
+        return false;
+    }
+    ReclaimStaging();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BufferUploader::Stats BufferUploader::GetStats() const
+{
+    Stats stats = m_Stats;
+    stats.NumStagingBlocks = (uint32_t)m_StagingBlocks.size();
+    stats.StagingMemory = 0;
+    for (const auto& block : m_StagingBlocks)
+        stats.StagingMemory += block.Buffer->GetSize();
+    return stats;
+}
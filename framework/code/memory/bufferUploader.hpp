@@ -0,0 +1,106 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "memoryManager.hpp"
+#include "stagingRingBuffer.hpp"
+
+// Forward declarations
+class Vulkan;
+
+/// Batches the upload of initial data in to many buffers (eg the vertex and index buffers of every mesh in a scene).
+/// Data passed to Upload is copied straight away in to pooled (persistently mapped) staging buffers, so the caller's data can be freed.
+/// Submit records all the pending copies in to one setup command buffer (Vulkan::StartSetupCommandBuffer) and submits it without waiting; Flush also waits for it.
+/// The staging buffers are kept and reused once the submissions reading them have completed.
+/// Destination buffers must stay alive until the copies complete, and Submit (or Flush) must be called before the gpu uses them.  Not thread safe.
+/// @ingroup Memory
+class BufferUploader
+{
+    BufferUploader(const BufferUploader&) = delete;
+    BufferUploader& operator=(const BufferUploader&) = delete;
+public:
+    static constexpr size_t cDefaultStagingBlockSize = 4 * 1024 * 1024;
+
+    BufferUploader();
+    /// Discards (does not submit) any pending uploads, waits for submitted ones.
+    ~BufferUploader();
+
+    /// @param stagingBlockSize size of each pooled staging buffer (an upload larger than this gets a staging buffer of its own, freed once its copy completes)
+    /// @param forceDeviceLocal buffers initialized through this uploader are always device local (see UseDeviceLocal)
+    bool Initialize(Vulkan* pVulkan, size_t stagingBlockSize = cDefaultStagingBlockSize, bool forceDeviceLocal = false);
+    /// Wait for the submitted uploads and destroy the staging buffers.  Pending (not submitted) uploads are discarded (with an error).  Leaves in a state where it could be re-initialized.
+    void Destroy();
+
+    explicit operator bool() const { return m_pVulkan != nullptr; }
+
+    /// @returns true if buffers initialized through this uploader should be created in device local (MemoryUsage::GpuExclusive) memory and filled by a gpu copy.
+    /// False on gpus with unified memory (integrated gpus) where writing directly in to host visible memory avoids the copy for no loss in gpu read performance.
+    bool UseDeviceLocal() const { return m_UseDeviceLocal; }
+    /// @returns the UseDeviceLocal choice (without forceDeviceLocal) for the given device, for buffers created before/outside an uploader (eg GeometryArena blocks)
+    static bool PrefersDeviceLocal(const Vulkan& vulkan);
+    MemoryManager& GetMemoryManager() const;
+
+    /// Stage 'size' bytes of pData to be copied in to dstBuffer (at dstOffset) by the next Submit/Flush.  dstBuffer must have VK_BUFFER_USAGE_TRANSFER_DST_BIT usage.
+    bool Upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, size_t size);
+
+    /// Submit all the pending uploads (one command buffer) without waiting for them to complete.
+    /// Work submitted later to the Vulkan queue sees the uploaded data (vertex, index, indirect, uniform and shader reads).
+    /// @returns setup submission id (see Vulkan::WaitSetupSubmission), 0 on error or if there was nothing to submit
+    uint64_t Submit();
+    /// Submit all the pending uploads and wait for them (and any earlier submissions) to complete.
+    bool Flush();
+
+    bool HasPendingUploads() const { return !m_PendingCopies.empty(); }
+    /// @returns number of bytes staged since the last Submit (callers uploading a lot of data can Submit when this gets large, to bound the staging memory and overlap the copies with their cpu work)
+    size_t GetPendingBytes() const { return m_PendingBytes; }
+
+    struct Stats
+    {
+        uint32_t NumUploads = 0;            ///< Upload calls (all batches)
+        uint32_t NumSubmits = 0;            ///< batches submitted
+        size_t   BytesUploaded = 0;
+        uint32_t NumStagingBlocks = 0;      ///< pooled staging buffers (currently allocated)
+        size_t   StagingMemory = 0;         ///< bytes in the pooled staging buffers
+    };
+    Stats GetStats() const;
+
+protected:
+    struct PendingCopy
+    {
+        VkBuffer        SrcBuffer;
+        VkBuffer        DstBuffer;
+        VkBufferCopy    Region;
+    };
+
+    struct StagingBlock
+    {
+        std::unique_ptr<StagingRingBuffer>  Buffer;
+        uint64_t                            SubmissionId = 0;   ///< last submission reading from Buffer (0 if none in flight)
+        uint64_t                            SubmittedHead = 0;  ///< Buffer head at that submission (released when it completes)
+    };
+
+    /// Allocate staging memory from the pool, adding a staging buffer if no existing one has room.
+    StagingRingBuffer::Allocation AllocateStaging(size_t size);
+    /// Release the staging memory of completed submissions.
+    void ReclaimStaging();
+
+protected:
+    Vulkan*                     m_pVulkan = nullptr;
+    size_t                      m_StagingBlockSize = 0;
+    bool                        m_UseDeviceLocal = true;
+    std::vector<StagingBlock>   m_StagingBlocks;        ///< pooled (kept between submissions)
+    std::vector<StagingBlock>   m_LargeStaging;         ///< uploads bigger than a pool block (freed when their submission completes)
+    std::vector<PendingCopy>    m_PendingCopies;
+    size_t                      m_PendingBytes = 0;
+    uint64_t                    m_LastSubmissionId = 0;
+    Stats                       m_Stats;
+};
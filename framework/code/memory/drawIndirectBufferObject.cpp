@@ -55,6 +55,16 @@ bool DrawIndirectBufferObject::Initialize(MemoryManager* pManager, size_t numDra
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool DrawIndirectBufferObject::Initialize(BufferUploader& uploader, size_t numDraws, const void* initialData, const VkBufferUsageFlags usage, uint32_t prequelBytes)
+{
+    mNumDraws = numDraws;
+    mPrequelBytes = prequelBytes;
+
+    return BufferObject::Initialize(uploader, (VkDeviceSize)(GetDrawCommandBytes() * mNumDraws + mPrequelBytes), usage, initialData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void DrawIndirectBufferObject::Destroy()
 {
     mNumDraws = 0;
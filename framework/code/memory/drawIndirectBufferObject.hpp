@@ -25,6 +25,8 @@ public:
     /// Initialization
     template<typename T_DRAW, typename T_PREQUEL> bool Initialize(MemoryManager* pManager, size_t numDraws, const T_DRAW* initialData, const T_PREQUEL* initialPrequelData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
     template<typename T_DRAW> bool Initialize(MemoryManager* pManager, size_t numDraws, const T_DRAW* initialData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    /// Initialization with the initialData staged through 'uploader' (see BufferObject::Initialize(BufferUploader&, ...)), data is in the buffer once the uploader's next Submit/Flush has executed.
+    template<typename T_DRAW> bool Initialize(BufferUploader& uploader, size_t numDraws, const T_DRAW* initialData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
 
     /// destroy buffer and leave in a state where it could be re-initialized
     void Destroy();
@@ -46,6 +48,7 @@ public:
 protected:
     MapGuard<void> MapVoid();
     bool Initialize(MemoryManager* pManager, size_t numDraws, const void* initialData, const VkBufferUsageFlags usage, uint32_t prequelBytes);
+    bool Initialize(BufferUploader& uploader, size_t numDraws, const void* initialData, const VkBufferUsageFlags usage, uint32_t prequelBytes);
 
 private:
     size_t      mNumDraws = 0;
@@ -61,6 +64,13 @@ bool DrawIndirectBufferObject::Initialize(MemoryManager* pManager, size_t numDra
     return Initialize(pManager, numDraws, (const void*)initialData, usage, 0);
 }
 
+template<typename T>
+bool DrawIndirectBufferObject::Initialize(BufferUploader& uploader, size_t numDraws, const T* initialData, const VkBufferUsageFlags usage)
+{
+    assert(sizeof(T) == GetDrawCommandBytes());
+    return Initialize(uploader, numDraws, (const void*)initialData, usage, 0);
+}
+
 template<typename T_DRAW, typename T_PREQUEL>
 bool DrawIndirectBufferObject::Initialize(MemoryManager* pManager, size_t numDraws, const T_DRAW* initialData, const T_PREQUEL* prequelData, const VkBufferUsageFlags usage)
 {
@@ -0,0 +1,379 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "geometryArena.hpp"
+#include "bufferUploader.hpp"
+#include "system/os_common.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint32_t GetIndexTypeBytes(VkIndexType indexType)
+{
+    switch (indexType) {
+    case VK_INDEX_TYPE_UINT8_EXT: return 1;
+    case VK_INDEX_TYPE_UINT16: return 2;
+    case VK_INDEX_TYPE_UINT32: return 4;
+    default: return 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::GeometryArena()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::~GeometryArena()
+{
+    Destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::Initialize(MemoryManager* pManager, uint32_t verticesPerBlock, uint32_t indicesPerBlock, VkBufferUsageFlags additionalUsage, bool deviceLocal)
+{
+    Destroy();
+    if (!pManager || verticesPerBlock == 0 || indicesPerBlock == 0)
+    {
+        return false;
+    }
+    m_pManager = pManager;
+    m_VerticesPerBlock = verticesPerBlock;
+    m_IndicesPerBlock = indicesPerBlock;
+    m_AdditionalUsage = additionalUsage;
+    m_DeviceLocal = deviceLocal;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::Destroy()
+{
+    for (auto& pool : m_Pools)
+    {
+        for (auto& block : pool.Blocks)
+        {
+            if (block.NumAllocations != 0)
+            {
+                LOGE("GeometryArena destroyed with %u ranges still allocated", block.NumAllocations);
+            }
+            DestroyBlock(block);
+        }
+    }
+    m_Pools.clear();
+    m_VertexPoolLookup.clear();
+    m_IndexPoolLookup.clear();
+    m_pManager = nullptr;
+    m_DeviceLocal = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::VertexRange GeometryArena::AllocateVertices(const tcb::span<const uint32_t> streamSpans, uint32_t numVertices, const tcb::span<const void* const> initialData, BufferUploader* pUploader)
+{
+    assert(m_pManager);
+    if (streamSpans.empty() || numVertices == 0 || (!initialData.empty() && initialData.size() != streamSpans.size()))
+    {
+        return {};
+    }
+
+    // Find (or create) the pool for this vertex layout.
+    std::vector<uint32_t> spans{ streamSpans.begin(), streamSpans.end() };
+    auto [poolIt, newPool] = m_VertexPoolLookup.try_emplace(spans, (uint32_t)m_Pools.size());
+    if (newPool)
+    {
+        Pool& pool = m_Pools.emplace_back();
+        pool.ElementSizes = std::move(spans);
+        pool.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | m_AdditionalUsage;
+        pool.ElementsPerBlock = m_VerticesPerBlock;
+    }
+    const uint32_t poolIdx = poolIt->second;
+    Pool& pool = m_Pools[poolIdx];
+
+    VertexRange range;
+    if (!AllocateRange(pool, numVertices, range.BlockIdx, range.FirstVertex))
+    {
+        LOGE("GeometryArena unable to allocate %u vertices", numVertices);
+        return {};
+    }
+    range.PoolIdx = poolIdx;
+    range.NumVertices = numVertices;
+    const Block& block = pool.Blocks[range.BlockIdx];
+    range.VkBuffers.reserve(block.Buffers.size());
+    for (const auto& buffer : block.Buffers)
+    {
+        range.VkBuffers.push_back(buffer.GetVkBuffer());
+    }
+
+    for (uint32_t streamIdx = 0; streamIdx < (uint32_t)initialData.size(); ++streamIdx)
+    {
+        if (initialData[streamIdx] && !WriteVertices(range, streamIdx, 0, numVertices, initialData[streamIdx], pUploader))
+        {
+            Free(range);
+            return {};
+        }
+    }
+    return range;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::IndexRange GeometryArena::AllocateIndices(VkIndexType indexType, uint32_t numIndices, const void* initialData, BufferUploader* pUploader)
+{
+    assert(m_pManager);
+    const uint32_t indexBytes = GetIndexTypeBytes(indexType);
+    if (indexBytes == 0 || numIndices == 0)
+    {
+        return {};
+    }
+
+    // Find (or create) the pool for this index type.
+    auto [poolIt, newPool] = m_IndexPoolLookup.try_emplace(indexType, (uint32_t)m_Pools.size());
+    if (newPool)
+    {
+        Pool& pool = m_Pools.emplace_back();
+        pool.ElementSizes = { indexBytes };
+        pool.Usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | m_AdditionalUsage;
+        pool.ElementsPerBlock = m_IndicesPerBlock;
+    }
+    const uint32_t poolIdx = poolIt->second;
+    Pool& pool = m_Pools[poolIdx];
+
+    IndexRange range;
+    if (!AllocateRange(pool, numIndices, range.BlockIdx, range.FirstIndex))
+    {
+        LOGE("GeometryArena unable to allocate %u indices", numIndices);
+        return {};
+    }
+    range.PoolIdx = poolIdx;
+    range.NumIndices = numIndices;
+    range.IndexBuffer = pool.Blocks[range.BlockIdx].Buffers[0].GetVkBuffer();
+    range.IndexType = indexType;
+
+    if (initialData && !WriteIndices(range, 0, numIndices, initialData, pUploader))
+    {
+        Free(range);
+        return {};
+    }
+    return range;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::Free(VertexRange& range)
+{
+    if (range)
+    {
+        FreeRange(range.PoolIdx, range.BlockIdx, range.FirstVertex, range.NumVertices);
+    }
+    range = {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::Free(IndexRange& range)
+{
+    if (range)
+    {
+        FreeRange(range.PoolIdx, range.BlockIdx, range.FirstIndex, range.NumIndices);
+    }
+    range = {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::WriteVertices(const VertexRange& range, uint32_t streamIdx, uint32_t firstVertex, uint32_t numVertices, const void* pData, BufferUploader* pUploader)
+{
+    if (!range || firstVertex + numVertices > range.NumVertices)
+    {
+        return false;
+    }
+    return Write(m_Pools[range.PoolIdx], range.BlockIdx, streamIdx, range.FirstVertex + firstVertex, numVertices, pData, pUploader);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::WriteIndices(const IndexRange& range, uint32_t firstIndex, uint32_t numIndices, const void* pData, BufferUploader* pUploader)
+{
+    if (!range || firstIndex + numIndices > range.NumIndices)
+    {
+        return false;
+    }
+    return Write(m_Pools[range.PoolIdx], range.BlockIdx, 0, range.FirstIndex + firstIndex, numIndices, pData, pUploader);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t GeometryArena::ReleaseEmptyBlocks()
+{
+    uint32_t numReleased = 0;
+    for (auto& pool : m_Pools)
+    {
+        for (size_t blockIdx = 1; blockIdx < pool.Blocks.size(); ++blockIdx)
+        {
+            Block& block = pool.Blocks[blockIdx];
+            if (block.NumAllocations == 0 && !block.Buffers.empty())
+            {
+                DestroyBlock(block);
+                ++numReleased;
+            }
+        }
+    }
+    return numReleased;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::Stats GeometryArena::GetStats() const
+{
+    Stats stats;
+    stats.NumPools = (uint32_t)m_Pools.size();
+    for (const auto& pool : m_Pools)
+    {
+        size_t elementBytes = 0;
+        for (uint32_t elementSize : pool.ElementSizes)
+            elementBytes += elementSize;
+
+        for (const auto& block : pool.Blocks)
+        {
+            if (block.Buffers.empty())
+                continue;
+            ++stats.NumBlocks;
+            stats.NumAllocations += block.NumAllocations;
+            stats.BufferMemory += block.Allocator.GetSize() * elementBytes;
+            stats.MemoryUsed += (block.Allocator.GetSize() - block.Allocator.GetFreeSize()) * elementBytes;
+            stats.LargestFreeRange = std::max(stats.LargestFreeRange, block.Allocator.GetLargestFreeRange() * elementBytes);
+            stats.NumFreeRanges += (uint32_t)block.Allocator.GetNumFreeRanges();
+        }
+    }
+    return stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::AllocateRange(Pool& pool, uint32_t numElements, uint32_t& blockIdxOut, uint32_t& firstElementOut)
+{
+    // Try the existing blocks first (earliest first, so the later blocks empty out and can be released).
+    for (uint32_t blockIdx = 0; blockIdx < (uint32_t)pool.Blocks.size(); ++blockIdx)
+    {
+        Block& block = pool.Blocks[blockIdx];
+        if (block.Buffers.empty())
+            continue;
+        const size_t offset = block.Allocator.Allocate(numElements);
+        if (offset != RangeAllocator::cInvalidOffset)
+        {
+            ++block.NumAllocations;
+            blockIdxOut = blockIdx;
+            firstElementOut = (uint32_t)offset;
+            return true;
+        }
+    }
+
+    // Add a block (re-using the slot of a released block if there is one, so existing ranges' BlockIdx stay valid).
+    auto blockIt = std::find_if(pool.Blocks.begin(), pool.Blocks.end(), [](const Block& block) { return block.Buffers.empty(); });
+    if (blockIt == pool.Blocks.end())
+    {
+        blockIt = pool.Blocks.emplace(pool.Blocks.end());
+    }
+    Block& block = *blockIt;
+    if (!CreateBlock(pool, block, std::max(numElements, pool.ElementsPerBlock)))
+    {
+        return false;
+    }
+    const size_t offset = block.Allocator.Allocate(numElements);
+    assert(offset == 0);
+    ++block.NumAllocations;
+    blockIdxOut = (uint32_t)(blockIt - pool.Blocks.begin());
+    firstElementOut = (uint32_t)offset;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::CreateBlock(Pool& pool, Block& block, uint32_t numElements)
+{
+    assert(block.Buffers.empty());
+    block.Buffers.reserve(pool.ElementSizes.size());
+
+    // Device local blocks are filled by BufferUploader copies.  Host visible blocks are written directly, which is intended for unified memory (integrated) gpus
+    // where the gpu reads host visible memory as fast as device local (and we save the staging copy), the same choice as BufferUploader::UseDeviceLocal.
+    const VkBufferUsageFlags usage = pool.Usage | (m_DeviceLocal ? VK_BUFFER_USAGE_TRANSFER_DST_BIT : 0);
+    const auto memoryUsage = m_DeviceLocal ? MemoryManager::MemoryUsage::GpuExclusive : MemoryManager::MemoryUsage::CpuToGpu;
+    for (uint32_t elementSize : pool.ElementSizes)
+    {
+        auto buffer = m_pManager->CreateBuffer((size_t)elementSize * numElements, usage, memoryUsage, nullptr, MemoryCategory::Unspecified, "GeometryArena");
+        if (!buffer)
+        {
+            LOGE("GeometryArena unable to create %zu byte buffer", (size_t)elementSize * numElements);
+            DestroyBlock(block);
+            return false;
+        }
+        block.Buffers.push_back(std::move(buffer));
+    }
+    block.Allocator.Initialize(numElements);
+    block.NumAllocations = 0;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::DestroyBlock(Block& block)
+{
+    for (auto& buffer : block.Buffers)
+    {
+        m_pManager->Destroy(std::move(buffer));
+    }
+    block.Buffers.clear();
+    block.Allocator.Initialize(0);
+    block.NumAllocations = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::FreeRange(uint32_t poolIdx, uint32_t blockIdx, uint32_t firstElement, uint32_t numElements)
+{
+    assert(poolIdx < m_Pools.size());
+    Pool& pool = m_Pools[poolIdx];
+    assert(blockIdx < pool.Blocks.size());
+    Block& block = pool.Blocks[blockIdx];
+    assert(block.NumAllocations > 0);
+    block.Allocator.Free(firstElement, numElements);
+    --block.NumAllocations;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryArena::Write(Pool& pool, uint32_t blockIdx, uint32_t streamIdx, size_t firstElement, size_t numElements, const void* pData, BufferUploader* pUploader)
+{
+    if (!pData || streamIdx >= pool.ElementSizes.size())
+    {
+        return false;
+    }
+    auto& buffer = pool.Blocks[blockIdx].Buffers[streamIdx];
+    const size_t elementSize = pool.ElementSizes[streamIdx];
+
+    if (m_DeviceLocal)
+    {
+        if (!pUploader)
+        {
+            LOGE("GeometryArena is device local, writes need a BufferUploader");
+            return false;
+        }
+        return pUploader->Upload(buffer.GetVkBuffer(), (VkDeviceSize)(firstElement * elementSize), pData, numElements * elementSize);
+    }
+
+    auto mapped = m_pManager->Map<uint8_t>(buffer);
+    memcpy(mapped.data() + firstElement * elementSize, pData, numElements * elementSize);
+    m_pManager->Unmap(buffer, std::move(mapped));
+    return true;
+}
@@ -0,0 +1,148 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "tcb/span.hpp"
+#include "memoryMapped.hpp"
+#include "memoryManager.hpp"
+#include "system/rangeAllocator.hpp"
+
+// Forward declarations
+class BufferUploader;
+
+/// Vertex and index buffers shared between many meshes.
+/// Meshes with the same vertex layout (the spans of their vertex rate streams) are sub-allocated from the same set of buffers (a 'pool'), one VkBuffer per stream,
+/// with every stream of a mesh at the same vertex index.  Index data is sub-allocated from one pool per VkIndexType.
+/// Meshes from the same pool bind the same vertex/index buffers (at offset 0) and are drawn using firstVertex/vertexOffset and firstIndex,
+/// so a scene can be drawn with one set of buffer binds (and the ranges can be written directly in to VkDrawIndexedIndirectCommands for multi-draw indirect).
+/// Each pool grows by adding blocks (new buffers) when it is full; a range never spans blocks.
+/// Blocks are either device local (written through a BufferUploader, the caller Submits/Flushes it before drawing) or host visible (written directly), see Initialize.
+/// As with BufferObject::Destroy the caller must ensure freed ranges (and released blocks) are no longer in use by the gpu.  Not thread safe.
+/// @ingroup Memory
+class GeometryArena
+{
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+public:
+    GeometryArena();
+    ~GeometryArena();
+
+    /// @param verticesPerBlock number of vertices in each vertex buffer block (a mesh larger than this gets a block of its own)
+    /// @param indicesPerBlock number of indices in each index buffer block
+    /// @param additionalUsage usage flags added to every buffer (eg VK_BUFFER_USAGE_STORAGE_BUFFER_BIT to read the geometry from compute)
+    /// @param deviceLocal create the blocks in device local memory, all writes must then go through a BufferUploader (see BufferUploader::PrefersDeviceLocal)
+    bool Initialize(MemoryManager* pManager, uint32_t verticesPerBlock = 1024 * 1024, uint32_t indicesPerBlock = 4 * 1024 * 1024, VkBufferUsageFlags additionalUsage = 0, bool deviceLocal = false);
+    /// Destroy all the buffers (all ranges must have been freed, or not be used again).  Leaves in a state where it could be re-initialized.
+    void Destroy();
+
+    /// Range of vertices allocated from a vertex pool.
+    struct VertexRange
+    {
+        uint32_t                PoolIdx = UINT32_MAX;
+        uint32_t                BlockIdx = 0;
+        uint32_t                FirstVertex = 0;    ///< vertexOffset (vkCmdDrawIndexed) / firstVertex (vkCmdDraw)
+        uint32_t                NumVertices = 0;
+        std::vector<VkBuffer>   VkBuffers;          ///< one per vertex stream, bind at offset 0
+        explicit operator bool() const { return PoolIdx != UINT32_MAX; }
+    };
+
+    /// Range of indices allocated from an index pool.
+    struct IndexRange
+    {
+        uint32_t                PoolIdx = UINT32_MAX;
+        uint32_t                BlockIdx = 0;
+        uint32_t                FirstIndex = 0;     ///< firstIndex (vkCmdDrawIndexed)
+        uint32_t                NumIndices = 0;
+        VkBuffer                IndexBuffer = VK_NULL_HANDLE;   ///< bind at offset 0
+        VkIndexType             IndexType = VK_INDEX_TYPE_MAX_ENUM;
+        explicit operator bool() const { return PoolIdx != UINT32_MAX; }
+    };
+
+    /// Allocate numVertices vertices in the pool for the given vertex layout, copying in the initial data (if supplied).
+    /// @param streamSpans span (bytes per vertex) of each vertex stream
+    /// @param initialData data for each stream (streamSpans[i] * numVertices bytes), or empty to leave the vertex data uninitialized
+    /// @param pUploader uploader to stage the initial data through (required if the arena is device local)
+    /// @returns allocated range, empty range on failure
+    VertexRange AllocateVertices(const tcb::span<const uint32_t> streamSpans, uint32_t numVertices, const tcb::span<const void* const> initialData, BufferUploader* pUploader = nullptr);
+
+    /// Allocate numIndices indices of the given type, copying in the initial data (if supplied).
+    /// @param pUploader uploader to stage the initial data through (required if the arena is device local)
+    /// @returns allocated range, empty range on failure
+    IndexRange AllocateIndices(VkIndexType indexType, uint32_t numIndices, const void* initialData, BufferUploader* pUploader = nullptr);
+
+    /// Return the range to its pool (and clear it).
+    void Free(VertexRange& range);
+    /// Return the range to its pool (and clear it).
+    void Free(IndexRange& range);
+
+    /// Write vertex data in to (part of) an allocated range.
+    /// @param firstVertex offset (in vertices) from the start of the range
+    /// @param pUploader uploader to stage the data through (required if the arena is device local, ignored otherwise)
+    bool WriteVertices(const VertexRange& range, uint32_t streamIdx, uint32_t firstVertex, uint32_t numVertices, const void* pData, BufferUploader* pUploader = nullptr);
+    /// Write index data in to (part of) an allocated range.  Indices are relative to the range's FirstVertex.
+    /// @param firstIndex offset (in indices) from the start of the range
+    /// @param pUploader uploader to stage the data through (required if the arena is device local, ignored otherwise)
+    bool WriteIndices(const IndexRange& range, uint32_t firstIndex, uint32_t numIndices, const void* pData, BufferUploader* pUploader = nullptr);
+
+    /// @returns true if the blocks are in device local memory (and must be written through a BufferUploader)
+    bool IsDeviceLocal() const { return m_DeviceLocal; }
+
+    /// Destroy the buffers of blocks that have nothing allocated from them (the first block in each pool is kept).
+    /// @returns number of blocks released
+    uint32_t ReleaseEmptyBlocks();
+
+    struct Stats
+    {
+        uint32_t NumPools = 0;
+        uint32_t NumBlocks = 0;         ///< blocks with buffers
+        uint32_t NumAllocations = 0;
+        size_t   BufferMemory = 0;      ///< bytes in all the block buffers
+        size_t   MemoryUsed = 0;        ///< bytes allocated to ranges
+        size_t   LargestFreeRange = 0;  ///< bytes in the largest free range (in any block)
+        uint32_t NumFreeRanges = 0;     ///< free ranges across all blocks (a measure of fragmentation)
+    };
+    Stats GetStats() const;
+
+protected:
+    struct Block
+    {
+        std::vector<MemoryVmaAllocatedBuffer<VkBuffer>> Buffers;    ///< one per stream (empty if the block has been released)
+        RangeAllocator                                  Allocator;  ///< in elements (vertices or indices)
+        uint32_t                                        NumAllocations = 0;
+    };
+
+    struct Pool
+    {
+        std::vector<uint32_t>   ElementSizes;       ///< bytes per element in each stream's buffer
+        VkBufferUsageFlags      Usage = 0;
+        uint32_t                ElementsPerBlock = 0;
+        std::vector<Block>      Blocks;
+    };
+
+    /// Allocate numElements from the pool, adding a block if no existing block has room.
+    /// @returns false if a new block could not be created
+    bool AllocateRange(Pool& pool, uint32_t numElements, uint32_t& blockIdxOut, uint32_t& firstElementOut);
+    bool CreateBlock(Pool& pool, Block& block, uint32_t numElements);
+    void DestroyBlock(Block& block);
+    void FreeRange(uint32_t poolIdx, uint32_t blockIdx, uint32_t firstElement, uint32_t numElements);
+    bool Write(Pool& pool, uint32_t blockIdx, uint32_t streamIdx, size_t firstElement, size_t numElements, const void* pData, BufferUploader* pUploader);
+
+protected:
+    MemoryManager*                          m_pManager = nullptr;
+    uint32_t                                m_VerticesPerBlock = 0;
+    uint32_t                                m_IndicesPerBlock = 0;
+    VkBufferUsageFlags                      m_AdditionalUsage = 0;
+    bool                                    m_DeviceLocal = false;
+    std::vector<Pool>                       m_Pools;
+    std::map<std::vector<uint32_t>, uint32_t> m_VertexPoolLookup;     ///< stream spans -> index in to m_Pools
+    std::map<VkIndexType, uint32_t>         m_IndexPoolLookup;      ///< index type -> index in to m_Pools
+};
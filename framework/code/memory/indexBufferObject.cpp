@@ -63,6 +63,16 @@ bool IndexBufferObject::Initialize(MemoryManager* pManager, size_t numIndices, c
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool IndexBufferObject::Initialize(BufferUploader& uploader, size_t numIndices, const void* initialData, const VkBufferUsageFlags usage)
+{
+    mNumIndices = numIndices;
+    mDspUsable = false;
+
+    return BufferObject::Initialize(uploader, GetIndexTypeBytes() * mNumIndices, usage, initialData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void IndexBufferObject::Destroy()
 {
     mNumIndices = 0;
@@ -25,6 +25,9 @@ public:
     /// Initialization
     template<typename T> bool Initialize( MemoryManager* pManager, size_t numIndices, const T* initialData, const bool dspUsable = false, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT );
 
+    /// Initialization with the initialData staged through 'uploader' (see BufferObject::Initialize(BufferUploader&, ...)), data is in the buffer once the uploader's next Submit/Flush has executed.
+    template<typename T> bool Initialize( BufferUploader& uploader, size_t numIndices, const T* initialData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT );
+
     /// Initialization
     bool Initialize( MemoryManager* pManager, size_t numIndices, const bool dspUsable = false, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT );
 
@@ -50,6 +53,7 @@ public:
 protected:
     MapGuard<void> MapVoid();
     bool Initialize(MemoryManager* pManager, size_t numIndices, const void* initialData, const bool dspUsable, const VkBufferUsageFlags usage);
+    bool Initialize(BufferUploader& uploader, size_t numIndices, const void* initialData, const VkBufferUsageFlags usage);
 
 private:
     size_t mNumIndices = 0;
@@ -67,6 +71,13 @@ bool IndexBufferObject::Initialize(MemoryManager* pManager, size_t numIndices, c
     return Initialize(pManager, numIndices, (const void*)initialData, dspUsable, usage);
 }
 
+template<typename T>
+bool IndexBufferObject::Initialize(BufferUploader& uploader, size_t numIndices, const T* initialData, const VkBufferUsageFlags usage)
+{
+    assert(sizeof(T) == GetIndexTypeBytes());
+    return Initialize(uploader, numIndices, (const void*)initialData, usage);
+}
+
 inline bool IndexBufferObject::Initialize(MemoryManager* pManager, size_t numIndices, const bool dspUsable, const VkBufferUsageFlags usage)
 {
     return Initialize(pManager, numIndices, (const void*)nullptr, dspUsable, usage);
@@ -8,6 +8,9 @@
 
 #include "memoryManager.hpp"
 #include "vulkan/vulkan.hpp"
+#include "system/os_common.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
 #include <cassert>
 
 //
@@ -39,7 +42,7 @@ MemoryManager::~MemoryManager()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool MemoryManager::Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDevice, VkInstance vkInstance, bool EnableBufferDeviceAddress)
+bool MemoryManager::Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDevice, VkInstance vkInstance, bool EnableBufferDeviceAddress, bool EnableMemoryBudget)
 {
 	assert(!mVmaAllocator);
 	mGpuDevice = vkDevice;
@@ -49,6 +52,12 @@ bool MemoryManager::Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDev
 	allocatorInfo.device = vkDevice;
 	allocatorInfo.instance = vkInstance;
 	allocatorInfo.flags = EnableBufferDeviceAddress ? VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT : 0;
+	if (EnableMemoryBudget)
+	{
+		// VMA queries the budget with vkGetPhysicalDeviceMemoryProperties2, which is core in the Vulkan 1.1 instance we create.
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+		allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_1;
+	}
 
 	VkResult result = vmaCreateAllocator(&allocatorInfo, &mVmaAllocator);
 	if (result != VK_SUCCESS)
@@ -57,6 +66,23 @@ bool MemoryManager::Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDev
 		return false;
 	}
 
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		mHasMemoryBudgetExt = EnableMemoryBudget;
+		mTrackedAllocations.clear();
+		for (auto& categoryStats : mCategoryStats)
+			categoryStats = {};
+		const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+		vmaGetMemoryProperties(mVmaAllocator, &pMemoryProperties);
+		mHeapStats.clear();
+		mHeapStats.resize(pMemoryProperties->memoryHeapCount);
+		for (uint32_t heapIdx = 0; heapIdx < pMemoryProperties->memoryHeapCount; ++heapIdx)
+		{
+			mHeapStats[heapIdx].Size = pMemoryProperties->memoryHeaps[heapIdx].size;
+			mHeapStats[heapIdx].Flags = pMemoryProperties->memoryHeaps[heapIdx].flags;
+		}
+	}
+
 	if ((allocatorInfo.flags & VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT) != 0)
 	{
 		PFN_vkGetDeviceProcAddr fpGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr)vkGetInstanceProcAddr(vkInstance, "vkGetDeviceProcAddr");
@@ -79,13 +105,26 @@ bool MemoryManager::Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDev
 
 void MemoryManager::Destroy()
 {
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		if (!mTrackedAllocations.empty())
+		{
+			LOGE("MemoryManager destroyed with %zu allocations still live", mTrackedAllocations.size());
+			for (const auto& [vmaAllocation, tracked] : mTrackedAllocations)
+			{
+				LOGE("    %s: %zu bytes \"%s\"", GetCategoryName(tracked.Category), tracked.Size, tracked.DebugName.c_str());
+			}
+		}
+		mTrackedAllocations.clear();
+		mHeapStats.clear();
+	}
 	vmaDestroyAllocator(mVmaAllocator);	// safe to pass nullptr
 	mVmaAllocator = nullptr;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-MemoryVmaAllocatedBuffer<VkBuffer> MemoryManager::CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, MemoryManager::MemoryUsage memoryUsage, VkDescriptorBufferInfo* pDescriptorBufferInfo)
+MemoryVmaAllocatedBuffer<VkBuffer> MemoryManager::CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, MemoryManager::MemoryUsage memoryUsage, VkDescriptorBufferInfo* pDescriptorBufferInfo, MemoryCategory category, const char* pDebugName)
 {
 	assert(memoryUsage != MemoryUsage::Unknown);
 	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
@@ -94,6 +133,11 @@ MemoryVmaAllocatedBuffer<VkBuffer> MemoryManager::CreateBuffer(size_t size, VkBu
 
 	VmaAllocationCreateInfo allocInfo = {};
 	allocInfo.usage = static_cast<VmaMemoryUsage>(memoryUsage);
+	if (pDebugName)
+	{
+		allocInfo.flags |= VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+		allocInfo.pUserData = (void*)pDebugName;
+	}
 	
 	MemoryVmaAllocatedBuffer<VkBuffer> vmaAllocatedBuffer;
 	VmaAllocationInfo vmaAllocationInfo;
@@ -102,6 +146,7 @@ MemoryVmaAllocatedBuffer<VkBuffer> MemoryManager::CreateBuffer(size_t size, VkBu
 	{
 		return {};
 	}
+	TrackAllocation(vmaAllocatedBuffer.allocation.vmaAllocation, category == MemoryCategory::Unspecified ? CategoryFromUsage(bufferUsage) : category, pDebugName);
 	if (pDescriptorBufferInfo)
 	{
 		*pDescriptorBufferInfo = { vmaAllocatedBuffer.GetVkBuffer(), 0, size };
@@ -119,11 +164,16 @@ MemoryAbhAllocatedBuffer MemoryManager::CreateAndroidHardwareBuffer(size_t size,
 
 ///////////////////////////////////////////////////////////////////////////////
 
-MemoryVmaAllocatedBuffer<VkImage> MemoryManager::CreateImage(const VkImageCreateInfo& imageInfo, MemoryManager::MemoryUsage memoryUsage)
+MemoryVmaAllocatedBuffer<VkImage> MemoryManager::CreateImage(const VkImageCreateInfo& imageInfo, MemoryManager::MemoryUsage memoryUsage, MemoryCategory category, const char* pDebugName)
 {
 	assert(memoryUsage != MemoryUsage::Unknown);
 	VmaAllocationCreateInfo allocInfo = {};
 	allocInfo.usage = static_cast<VmaMemoryUsage>(memoryUsage);
+	if (pDebugName)
+	{
+		allocInfo.flags |= VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+		allocInfo.pUserData = (void*)pDebugName;
+	}
 
 	MemoryVmaAllocatedBuffer<VkImage> vmaAllocatedImage;
 	VkResult result = vmaCreateImage(mVmaAllocator, &imageInfo, &allocInfo, &vmaAllocatedImage.buffer, (VmaAllocation*)&vmaAllocatedImage.allocation.vmaAllocation, nullptr);
@@ -131,11 +181,44 @@ MemoryVmaAllocatedBuffer<VkImage> MemoryManager::CreateImage(const VkImageCreate
 	{
 		return {};
 	}
+	TrackAllocation(vmaAllocatedImage.allocation.vmaAllocation, category == MemoryCategory::Unspecified ? CategoryFromUsage(imageInfo) : category, pDebugName);
 	return vmaAllocatedImage;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+MemoryVmaAllocation MemoryManager::AllocateMemory(const VkMemoryRequirements& memoryRequirements, MemoryManager::MemoryUsage memoryUsage, MemoryCategory category, const char* pDebugName)
+{
+	assert(memoryUsage != MemoryUsage::Unknown);
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = static_cast<VmaMemoryUsage>(memoryUsage);
+	if (pDebugName)
+	{
+		allocInfo.flags |= VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+		allocInfo.pUserData = (void*)pDebugName;
+	}
+
+	MemoryVmaAllocation vmaAllocation;
+	VkResult result = vmaAllocateMemory(mVmaAllocator, &memoryRequirements, &allocInfo, (VmaAllocation*)&vmaAllocation.vmaAllocation, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		return {};
+	}
+	TrackAllocation(vmaAllocation.vmaAllocation, category, pDebugName);
+	return vmaAllocation;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MemoryManager::BindImage(VkImage image, const MemoryVmaAllocation& memory, VkDeviceSize offset)
+{
+	assert(mVmaAllocator && memory);
+	VkResult result = vmaBindImageMemory2(mVmaAllocator, static_cast<VmaAllocation>(memory.vmaAllocation), offset, image, nullptr);
+	return result == VK_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool MemoryManager::CopyData( VkCommandBuffer vkCommandBuffer, const MemoryVmaAllocatedBuffer<VkBuffer>& src, MemoryVmaAllocatedBuffer<VkBuffer>& dst, size_t copySize, size_t srcOffset, size_t dstOffset)
 {
     VkBufferCopy copyRegion {};
@@ -151,6 +234,7 @@ bool MemoryManager::CopyData( VkCommandBuffer vkCommandBuffer, const MemoryVmaAl
 void MemoryManager::Destroy(MemoryVmaAllocatedBuffer<VkBuffer> vmaAllocatedBuffer)
 {
 	assert(mVmaAllocator);
+	UntrackAllocation(vmaAllocatedBuffer.allocation.vmaAllocation);
 	vmaDestroyBuffer(mVmaAllocator, vmaAllocatedBuffer.buffer, static_cast<VmaAllocation>(vmaAllocatedBuffer.allocation.vmaAllocation));
 	// Set the allocated buffer to a clean (deletable) state.
 	vmaAllocatedBuffer.allocation.clear();
@@ -163,6 +247,7 @@ void MemoryManager::Destroy(MemoryVmaAllocatedBuffer<VkBuffer> vmaAllocatedBuffe
 void MemoryManager::Destroy(MemoryVmaAllocatedBuffer<VkImage> vmaAllocatedImage)
 {
 	assert(mVmaAllocator);
+	UntrackAllocation(vmaAllocatedImage.allocation.vmaAllocation);
 	vmaDestroyImage(mVmaAllocator, vmaAllocatedImage.buffer, static_cast<VmaAllocation>(vmaAllocatedImage.allocation.vmaAllocation));
 	// Set the allocated buffer to a clean (deletable) state.
 	vmaAllocatedImage.allocation.clear();
@@ -172,6 +257,38 @@ void MemoryManager::Destroy(MemoryVmaAllocatedBuffer<VkImage> vmaAllocatedImage)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void MemoryManager::Destroy(MemoryVmaAllocation vmaAllocation)
+{
+	assert(mVmaAllocator);
+	if (!vmaAllocation)
+		return;
+	UntrackAllocation(vmaAllocation.vmaAllocation);
+	vmaFreeMemory(mVmaAllocator, static_cast<VmaAllocation>(vmaAllocation.vmaAllocation));
+	vmaAllocation.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MemoryManager::IsLazilyAllocated(const MemoryVmaAllocatedBuffer<VkImage>& image, VkDeviceSize* pAllocationSize) const
+{
+	if (pAllocationSize)
+		*pAllocationSize = 0;
+	if (!image)
+		return false;
+	assert(mVmaAllocator);
+
+	VmaAllocationInfo vmaAllocationInfo;
+	vmaGetAllocationInfo(mVmaAllocator, static_cast<VmaAllocation>(image.allocation.vmaAllocation), &vmaAllocationInfo);
+	const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+	vmaGetMemoryProperties(mVmaAllocator, &pMemoryProperties);
+
+	if (pAllocationSize)
+		*pAllocationSize = vmaAllocationInfo.size;
+	return (pMemoryProperties->memoryTypes[vmaAllocationInfo.memoryType].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 VkDeviceAddress MemoryManager::GetBufferDeviceAddressInternal(VkBuffer buffer) const
 {
 	assert(mFpGetBufferDeviceAddress != nullptr);	// need EnableBufferDeviceAddress parameter to be set on Initialize
@@ -203,3 +320,245 @@ void MemoryManager::UnmapInternal(void* vmaAllocation, void* cpuLocation)
 	assert(cpuLocation);
 	vmaUnmapMemory(mVmaAllocator, static_cast<VmaAllocation>(vmaAllocation));
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryManager::TrackAllocation(void* vmaAllocation, MemoryCategory category, const char* pDebugName)
+{
+	assert(vmaAllocation);
+	assert(category != MemoryCategory::Unspecified && category < MemoryCategory::Count);
+
+	VmaAllocationInfo vmaAllocationInfo;
+	vmaGetAllocationInfo(mVmaAllocator, static_cast<VmaAllocation>(vmaAllocation), &vmaAllocationInfo);
+	const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+	vmaGetMemoryProperties(mVmaAllocator, &pMemoryProperties);
+
+	TrackedAllocation tracked;
+	tracked.Size = (size_t)vmaAllocationInfo.size;
+	tracked.HeapIndex = pMemoryProperties->memoryTypes[vmaAllocationInfo.memoryType].heapIndex;
+	tracked.Category = category;
+	if (pDebugName)
+		tracked.DebugName = pDebugName;
+
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	CategoryStats& categoryStats = mCategoryStats[(size_t)category];
+	const bool wasWithinBudget = categoryStats.Budget == 0 || categoryStats.LiveBytes <= categoryStats.Budget;
+	categoryStats.LiveBytes += tracked.Size;
+	categoryStats.PeakBytes = std::max(categoryStats.PeakBytes, categoryStats.LiveBytes);
+	++categoryStats.LiveAllocations;
+	++categoryStats.TotalAllocations;
+	if (wasWithinBudget && categoryStats.Budget != 0 && categoryStats.LiveBytes > categoryStats.Budget)
+	{
+		LOGE("MemoryManager %s allocations (%zu bytes) are over budget (%zu bytes)", GetCategoryName(category), categoryStats.LiveBytes, categoryStats.Budget);
+	}
+
+	HeapStats& heapStats = mHeapStats[tracked.HeapIndex];
+	heapStats.LiveBytes += tracked.Size;
+	heapStats.PeakBytes = std::max(heapStats.PeakBytes, heapStats.LiveBytes);
+
+	mTrackedAllocations.emplace(vmaAllocation, std::move(tracked));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryManager::UntrackAllocation(void* vmaAllocation)
+{
+	if (!vmaAllocation)
+		return;	// destroying an empty buffer is valid
+
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	auto it = mTrackedAllocations.find(vmaAllocation);
+	if (it == mTrackedAllocations.end())
+	{
+		assert(0 && "destroying an allocation the MemoryManager did not make");
+		return;
+	}
+	const TrackedAllocation& tracked = it->second;
+	CategoryStats& categoryStats = mCategoryStats[(size_t)tracked.Category];
+	categoryStats.LiveBytes -= tracked.Size;
+	--categoryStats.LiveAllocations;
+	mHeapStats[tracked.HeapIndex].LiveBytes -= tracked.Size;
+	mTrackedAllocations.erase(it);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryCategory MemoryManager::CategoryFromUsage(VkBufferUsageFlags bufferUsage)
+{
+	if (bufferUsage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+		return MemoryCategory::IndirectBuffer;
+	if (bufferUsage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+		return MemoryCategory::IndexBuffer;
+	if (bufferUsage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+		return MemoryCategory::VertexBuffer;
+	if (bufferUsage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		return MemoryCategory::UniformBuffer;
+	if (bufferUsage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		return MemoryCategory::StorageBuffer;
+	if (bufferUsage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+		return MemoryCategory::Staging;
+	return MemoryCategory::Other;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryCategory MemoryManager::CategoryFromUsage(const VkImageCreateInfo& imageInfo)
+{
+	const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	return (imageInfo.usage & attachmentUsage) != 0 ? MemoryCategory::RenderTarget : MemoryCategory::Texture;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* MemoryManager::GetCategoryName(MemoryCategory category)
+{
+	switch (category) {
+	case MemoryCategory::Unspecified: return "Unspecified";
+	case MemoryCategory::Texture: return "Texture";
+	case MemoryCategory::RenderTarget: return "RenderTarget";
+	case MemoryCategory::VertexBuffer: return "VertexBuffer";
+	case MemoryCategory::IndexBuffer: return "IndexBuffer";
+	case MemoryCategory::UniformBuffer: return "UniformBuffer";
+	case MemoryCategory::StorageBuffer: return "StorageBuffer";
+	case MemoryCategory::IndirectBuffer: return "IndirectBuffer";
+	case MemoryCategory::Staging: return "Staging";
+	case MemoryCategory::Other: return "Other";
+	case MemoryCategory::Count: break;
+	}
+	return "Invalid";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryManager::Stats MemoryManager::GetStats() const
+{
+	Stats stats;
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		stats.Categories = mCategoryStats;
+		stats.Heaps = mHeapStats;
+		stats.HasMemoryBudgetExt = mHasMemoryBudgetExt;
+	}
+	if (mVmaAllocator)
+	{
+		// Usage and budget for every heap (from VK_EXT_memory_budget when enabled, otherwise VMA's estimate).
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+		vmaGetBudget(mVmaAllocator, budgets);
+		for (size_t heapIdx = 0; heapIdx < stats.Heaps.size(); ++heapIdx)
+		{
+			stats.Heaps[heapIdx].Usage = budgets[heapIdx].usage;
+			stats.Heaps[heapIdx].Budget = budgets[heapIdx].budget;
+		}
+	}
+	return stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryManager::SetCategoryBudget(MemoryCategory category, size_t budget)
+{
+	assert(category < MemoryCategory::Count);
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	mCategoryStats[(size_t)category].Budget = budget;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MemoryManager::IsWithinBudget(MemoryCategory category, size_t additionalBytes) const
+{
+	assert(category < MemoryCategory::Count);
+	const Stats stats = GetStats();
+	const CategoryStats& categoryStats = stats.Categories[(size_t)category];
+	if (categoryStats.Budget != 0 && categoryStats.LiveBytes + additionalBytes > categoryStats.Budget)
+	{
+		return false;
+	}
+	for (const auto& heapStats : stats.Heaps)
+	{
+		if ((heapStats.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0 && heapStats.Budget != 0 && heapStats.Usage + additionalBytes > heapStats.Budget)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::string MemoryManager::GetStatsJson() const
+{
+	const Stats stats = GetStats();
+	using json = nlohmann::json;
+
+	json categories = json::object();
+	for (size_t categoryIdx = 1/*skip Unspecified*/; categoryIdx < stats.Categories.size(); ++categoryIdx)
+	{
+		const CategoryStats& categoryStats = stats.Categories[categoryIdx];
+		categories[GetCategoryName((MemoryCategory)categoryIdx)] = {
+			{ "LiveBytes", categoryStats.LiveBytes },
+			{ "PeakBytes", categoryStats.PeakBytes },
+			{ "LiveAllocations", categoryStats.LiveAllocations },
+			{ "TotalAllocations", categoryStats.TotalAllocations },
+			{ "Budget", categoryStats.Budget } };
+	}
+
+	json heaps = json::array();
+	for (const auto& heapStats : stats.Heaps)
+	{
+		heaps.push_back( {
+			{ "Size", heapStats.Size },
+			{ "DeviceLocal", (heapStats.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0 },
+			{ "LiveBytes", heapStats.LiveBytes },
+			{ "PeakBytes", heapStats.PeakBytes },
+			{ "Usage", heapStats.Usage },
+			{ "Budget", heapStats.Budget } } );
+	}
+
+	// Largest live allocations (names are only available for allocations created with a pDebugName).
+	static constexpr size_t cNumLargestAllocations = 16;
+	json largest = json::array();
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		std::vector<const TrackedAllocation*> sorted;
+		sorted.reserve(mTrackedAllocations.size());
+		for (const auto& [vmaAllocation, tracked] : mTrackedAllocations)
+			sorted.push_back(&tracked);
+		const size_t numLargest = std::min(sorted.size(), cNumLargestAllocations);
+		std::partial_sort(sorted.begin(), sorted.begin() + numLargest, sorted.end(), [](const TrackedAllocation* a, const TrackedAllocation* b) { return a->Size > b->Size; });
+		for (size_t i = 0; i < numLargest; ++i)
+		{
+			largest.push_back( {
+				{ "Name", sorted[i]->DebugName },
+				{ "Category", GetCategoryName(sorted[i]->Category) },
+				{ "Heap", sorted[i]->HeapIndex },
+				{ "Size", sorted[i]->Size } } );
+		}
+	}
+
+	json root = {
+		{ "MemoryBudgetExt", stats.HasMemoryBudgetExt },
+		{ "Categories", std::move(categories) },
+		{ "Heaps", std::move(heaps) },
+		{ "LargestAllocations", std::move(largest) } };
+	return root.dump(2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryManager::LogStats() const
+{
+	const Stats stats = GetStats();
+	LOGI("Memory statistics (%s heap budgets):", stats.HasMemoryBudgetExt ? "VK_EXT_memory_budget" : "estimated");
+	for (size_t categoryIdx = 1/*skip Unspecified*/; categoryIdx < stats.Categories.size(); ++categoryIdx)
+	{
+		const CategoryStats& categoryStats = stats.Categories[categoryIdx];
+		if (categoryStats.TotalAllocations == 0)
+			continue;
+		LOGI("    %-14s %10zu bytes in %5u allocations (peak %zu bytes)", GetCategoryName((MemoryCategory)categoryIdx), categoryStats.LiveBytes, categoryStats.LiveAllocations, categoryStats.PeakBytes);
+	}
+	for (size_t heapIdx = 0; heapIdx < stats.Heaps.size(); ++heapIdx)
+	{
+		const HeapStats& heapStats = stats.Heaps[heapIdx];
+		LOGI("    Heap %zu%s: %zu bytes allocated (peak %zu), process usage %llu of %llu budget (heap size %llu)", heapIdx, (heapStats.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "", heapStats.LiveBytes, heapStats.PeakBytes, (unsigned long long)heapStats.Usage, (unsigned long long)heapStats.Budget, (unsigned long long)heapStats.Size);
+	}
+}
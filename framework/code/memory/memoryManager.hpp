@@ -14,7 +14,12 @@
 /// (deliberately not #included in any headers since it is a very large header-only library)
 
 
+#include <array>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <cassert>
 #include <vulkan/vulkan.h>
 #ifdef OS_WINDOWS
@@ -48,6 +53,23 @@ private:
 
 
 
+/// What an allocation is used for (the buckets MemoryManager statistics are gathered in).
+/// @ingroup Memory
+enum class MemoryCategory : uint32_t {
+	Unspecified = 0,	///< infer from the buffer/image usage flags
+	Texture,
+	RenderTarget,
+	VertexBuffer,
+	IndexBuffer,
+	UniformBuffer,
+	StorageBuffer,
+	IndirectBuffer,
+	Staging,
+	Other,
+	Count
+};
+
+
 /// Top level API for allocating memory buffers for use by Vulkan
 /// @ingroup Memory
 class MemoryManager
@@ -70,20 +92,33 @@ public:
 
 	/// Initialize the memory manager (must be initialized before using CreateBuffer etc)
 	/// @param EnableBufferDeviceAddress enable ability to call GetBufferDeviceAddress
+	/// @param EnableMemoryBudget VK_EXT_memory_budget is loaded on the device (heap usage/budget is then reported by the driver rather than estimated)
 	/// @return true if successfully initialized
-	bool Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDevice, VkInstance vkInstance, bool EnableBufferDeviceAddress);
+	bool Initialize(VkPhysicalDevice vkPhysicalDevice, VkDevice vkDevice, VkInstance vkInstance, bool EnableBufferDeviceAddress, bool EnableMemoryBudget = false);
 	/// Destroy the memory manager (do before you destroy the Vulkan device)
 	void Destroy();
 
 	/// Create buffer in memory and create the associated Vulkan objects
-	MemoryVmaAllocatedBuffer<VkBuffer> CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, MemoryUsage memoryUsage, VkDescriptorBufferInfo* /*output, optional*/ = nullptr);
+	/// @param category statistics bucket (Unspecified to infer from bufferUsage)
+	/// @param pDebugName optional name, shown in the statistics dump and attached to the VMA allocation
+	MemoryVmaAllocatedBuffer<VkBuffer> CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, MemoryUsage memoryUsage, VkDescriptorBufferInfo* /*output, optional*/ = nullptr, MemoryCategory category = MemoryCategory::Unspecified, const char* pDebugName = nullptr);
 	/// Create image in memory and create the associated Vulkan objects
-	MemoryVmaAllocatedBuffer<VkImage> CreateImage(const VkImageCreateInfo& imageInfo, MemoryUsage memoryUsage);
+	/// @param category statistics bucket (Unspecified to infer from imageInfo.usage)
+	/// @param pDebugName optional name, shown in the statistics dump and attached to the VMA allocation
+	MemoryVmaAllocatedBuffer<VkImage> CreateImage(const VkImageCreateInfo& imageInfo, MemoryUsage memoryUsage, MemoryCategory category = MemoryCategory::Unspecified, const char* pDebugName = nullptr);
+
+	/// Allocate memory that is not tied to a single buffer or image.  Images are placed in it with BindImage, eg several images whose lifetimes do not overlap aliasing the same memory.
+	/// @param category statistics bucket (must not be Unspecified)
+	MemoryVmaAllocation AllocateMemory(const VkMemoryRequirements& memoryRequirements, MemoryUsage memoryUsage, MemoryCategory category, const char* pDebugName = nullptr);
+	/// Bind an image (created by the caller with vkCreateImage) to memory from AllocateMemory at the given offset.  Caller owns the image and must destroy it before the memory is destroyed.
+	bool BindImage(VkImage image, const MemoryVmaAllocation& memory, VkDeviceSize offset);
 
 	/// Destruction of created buffer
 	void Destroy(MemoryVmaAllocatedBuffer<VkBuffer>);
 	/// Destruction of created image
 	void Destroy(MemoryVmaAllocatedBuffer<VkImage>);
+	/// Destruction of memory from AllocateMemory
+	void Destroy(MemoryVmaAllocation);
 
 	// Creation of Android Hardware buffer (with a Vulkan object)
 	MemoryAbhAllocatedBuffer CreateAndroidHardwareBuffer(size_t size, VkBufferUsageFlags bufferUsage, MemoryUsage memoryUsage);
@@ -99,19 +134,81 @@ public:
     /// Copy data in one buffer into another.  Assumes buffers created with appropriate VK_BUFFER_USAGE_TRANSFER_SRC_BIT and VK_BUFFER_USAGE_TRANSFER_DST_BIT
     bool CopyData(VkCommandBuffer vkCommandBuffer, const MemoryVmaAllocatedBuffer<VkBuffer>& src, MemoryVmaAllocatedBuffer<VkBuffer>& dst, size_t copySize, size_t srcOffset = 0, size_t dstOffset = 0);
 
+	/// Query if an image was placed in lazily allocated memory (VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT), ie memory the driver only commits if the gpu needs it (tile based gpus typically never commit memory for transient attachments).
+	/// @param pAllocationSize (optional, output) size of the image's allocation
+	bool IsLazilyAllocated(const MemoryVmaAllocatedBuffer<VkImage>& image, VkDeviceSize* pAllocationSize = nullptr) const;
+
 	/// Query the device address (assuming that Vulkan extension was enabled)
 	VkDeviceAddress GetBufferDeviceAddress(VkBuffer b) const { return GetBufferDeviceAddressInternal(b); }
 	/// Query the device address (assuming that Vulkan extension was enabled)
 	template<typename T>
 	VkDeviceAddress GetBufferDeviceAddress(const T& b) const { return GetBufferDeviceAddress(b.GetVkBuffer()); }
 
+	/// Statistics for allocations in one MemoryCategory
+	struct CategoryStats
+	{
+		size_t   LiveBytes = 0;
+		size_t   PeakBytes = 0;
+		uint32_t LiveAllocations = 0;
+		uint64_t TotalAllocations = 0;	///< allocations made since Initialize
+		size_t   Budget = 0;			///< from SetCategoryBudget (0 for no budget)
+	};
+	/// Statistics for one Vulkan memory heap
+	struct HeapStats
+	{
+		VkDeviceSize      Size = 0;
+		VkMemoryHeapFlags Flags = 0;
+		size_t            LiveBytes = 0;	///< bytes allocated through this MemoryManager
+		size_t            PeakBytes = 0;
+		VkDeviceSize      Usage = 0;		///< bytes used by this process (all allocations, from VK_EXT_memory_budget if available, otherwise VMA's estimate)
+		VkDeviceSize      Budget = 0;		///< bytes this process can use before allocations may fail or hurt performance (from VK_EXT_memory_budget if available, otherwise estimated from the heap size)
+	};
+	struct Stats
+	{
+		std::array<CategoryStats, (size_t)MemoryCategory::Count> Categories;	///< indexed by MemoryCategory (Unspecified is always empty)
+		std::vector<HeapStats> Heaps;
+		bool HasMemoryBudgetExt = false;	///< Heaps Usage/Budget are reported by the driver
+	};
+	/// @returns current allocation statistics (and heap budgets).  Thread safe.
+	Stats GetStats() const;
+	/// @returns statistics (and the largest live allocations) as a json formatted string.  Thread safe.
+	std::string GetStatsJson() const;
+	/// Log the statistics (LOGI).  Thread safe.
+	void LogStats() const;
+	/// @returns printable name for the category
+	static const char* GetCategoryName(MemoryCategory category);
+
+	/// Set a budget (bytes) for a category, 0 for no budget.  Budgets are not enforced by the MemoryManager (allocations still succeed, with an error logged when a category goes over budget);
+	/// callers that can trade quality for memory (eg texture streaming) should check IsWithinBudget before allocating.
+	void SetCategoryBudget(MemoryCategory category, size_t budget);
+	/// @returns true if allocating additionalBytes more in the category would stay within its budget, and within the budget of every device local heap.  Thread safe.
+	bool IsWithinBudget(MemoryCategory category, size_t additionalBytes) const;
+
 protected:
 	MemoryCpuMappedUntyped MapInt(MemoryVmaAllocation allocation);
 private:
 	VkDeviceAddress GetBufferDeviceAddressInternal(VkBuffer buffer) const;
 	void MapInternal(void* vmaAllocation, void** outCpuLocation);
 	void UnmapInternal(void* vmaAllocation, void* cpuLocation);
+	void TrackAllocation(void* vmaAllocation, MemoryCategory category, const char* pDebugName);
+	void UntrackAllocation(void* vmaAllocation);
+	static MemoryCategory CategoryFromUsage(VkBufferUsageFlags bufferUsage);
+	static MemoryCategory CategoryFromUsage(const VkImageCreateInfo& imageInfo);
 private:
+	/// Allocation as recorded for the statistics.
+	struct TrackedAllocation
+	{
+		size_t         Size = 0;
+		uint32_t       HeapIndex = 0;
+		MemoryCategory Category = MemoryCategory::Other;
+		std::string    DebugName;
+	};
+	mutable std::mutex				mStatsMutex;	// guards everything below (allocations can be made from worker threads)
+	std::unordered_map<void*, TrackedAllocation> mTrackedAllocations;	// key is the VmaAllocation
+	std::array<CategoryStats, (size_t)MemoryCategory::Count> mCategoryStats;
+	std::vector<HeapStats>			mHeapStats;		// LiveBytes/PeakBytes (Usage/Budget are filled in by GetStats)
+	bool							mHasMemoryBudgetExt = false;
+
 	VmaAllocator_T*					mVmaAllocator = nullptr;
 	VkDevice						mGpuDevice = VK_NULL_HANDLE;
 #if VK_KHR_buffer_device_address
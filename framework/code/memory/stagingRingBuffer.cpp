@@ -0,0 +1,124 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "stagingRingBuffer.hpp"
+#include <cassert>
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRingBuffer::StagingRingBuffer()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRingBuffer::~StagingRingBuffer()
+{
+    Destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool StagingRingBuffer::Initialize(MemoryManager* pManager, size_t size)
+{
+    Destroy();
+    if (!pManager || size == 0)
+    {
+        return false;
+    }
+
+    m_VmaBuffer = pManager->CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryManager::MemoryUsage::CpuToGpu, nullptr, MemoryCategory::Staging, "StagingRingBuffer");
+    if (!m_VmaBuffer)
+    {
+        return false;
+    }
+    m_pManager = pManager;
+
+    // Stays mapped until Destroy.
+    m_Mapped.emplace(m_pManager->Map<uint8_t>(m_VmaBuffer));
+    m_pMappedData = m_Mapped->data();
+    if (!m_pMappedData)
+    {
+        Destroy();
+        return false;
+    }
+    m_Size = size;
+    m_Head = 0;
+    m_Tail = 0;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRingBuffer::Destroy()
+{
+    if (!m_pManager)
+    {
+        assert(!m_VmaBuffer);    // ensure we don't have an orphaned buffer (somehow)
+        return;
+    }
+    if (m_Mapped)
+    {
+        m_pManager->Unmap(m_VmaBuffer, std::move(*m_Mapped));
+        m_Mapped.reset();
+    }
+    m_pManager->Destroy(std::move(m_VmaBuffer));
+    m_pManager = nullptr;
+    m_pMappedData = nullptr;
+    m_Size = 0;
+    m_Head = 0;
+    m_Tail = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRingBuffer::Allocation StagingRingBuffer::Allocate(size_t size, size_t alignment)
+{
+    if (!m_pMappedData || size > m_Size)
+    {
+        return {};
+    }
+    if (alignment == 0)
+    {
+        alignment = 1;
+    }
+    if (m_Head == m_Tail)
+    {
+        // Empty, restart at the beginning of the buffer so all of it is available in one contiguous block.
+        m_Head = m_Tail = ((m_Head + m_Size - 1) / m_Size) * m_Size;
+    }
+
+    // Align the offset in to the buffer (not m_Head, which is not necessarily a multiple of the alignment when the ring wraps).
+    const size_t headOffset = (size_t)(m_Head % m_Size);
+    size_t offset = ((headOffset + alignment - 1) / alignment) * alignment;
+    uint64_t start = m_Head + (offset - headOffset);
+    if (offset + size > m_Size)
+    {
+        // Does not fit before the end of the buffer, skip to the beginning (the skipped bytes are released along with this allocation).
+        offset = 0;
+        start = m_Head + (m_Size - headOffset);
+    }
+    const uint64_t end = start + size;
+    if (end - m_Tail > m_Size)
+    {
+        return {};  // would overwrite data that has not been released
+    }
+    m_Head = end;
+    return { m_VmaBuffer.GetVkBuffer(), (VkDeviceSize)offset, m_pMappedData + offset, size };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRingBuffer::Release(uint64_t head)
+{
+    assert(head <= m_Head);
+    if (head > m_Tail)
+    {
+        m_Tail = head;
+    }
+}
@@ -0,0 +1,68 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <optional>
+#include "memoryMapped.hpp"
+#include "memoryManager.hpp"
+
+/// Cpu visible buffer that is kept persistently mapped and sub-allocated in ring (FIFO) order.
+/// Used as the source of transfer commands (eg vkCmdCopyBufferToImage) rather than creating and mapping a staging buffer (or linear image) per upload.
+/// Allocations are released in the order they were made; the owner takes GetHead() after recording the commands that read the allocations and passes it to Release once those commands have completed on the gpu.
+/// @ingroup Memory
+class StagingRingBuffer
+{
+    StagingRingBuffer(const StagingRingBuffer&) = delete;
+    StagingRingBuffer& operator=(const StagingRingBuffer&) = delete;
+public:
+    StagingRingBuffer();
+    ~StagingRingBuffer();
+
+    /// Create and map the buffer.  Destroys any existing buffer (which must not be in use by the gpu).
+    bool Initialize(MemoryManager* pManager, size_t size);
+    /// Unmap and destroy the buffer.  Leaves in a state where it could be re-initialized.
+    void Destroy();
+
+    explicit operator bool() const { return m_pMappedData != nullptr; }
+
+    /// Sub-allocation of the ring buffer.
+    struct Allocation
+    {
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        VkDeviceSize    offset = 0;         ///< offset of the allocation in to buffer
+        uint8_t*        pData = nullptr;    ///< cpu address of the allocation (mapped)
+        size_t          size = 0;
+        explicit operator bool() const { return pData != nullptr; }
+    };
+
+    /// Allocate 'size' bytes from the ring.
+    /// @param alignment alignment of the returned offset (does not have to be a power of 2, eg may be a texel size of 3 bytes)
+    /// @returns empty Allocation if there is not enough (contiguous) unreleased space
+    Allocation Allocate(size_t size, size_t alignment);
+
+    /// @returns position of the ring head; everything allocated so far is before this position.
+    uint64_t GetHead() const { return m_Head; }
+    /// Release all the allocations made before the given head position (as returned by GetHead)
+    void Release(uint64_t head);
+    /// Release all the allocations.
+    void ReleaseAll() { m_Tail = m_Head; }
+
+    size_t GetSize() const { return m_Size; }
+    VkBuffer GetVkBuffer() const { return m_VmaBuffer.GetVkBuffer(); }
+
+private:
+    MemoryManager*                          m_pManager = nullptr;
+    MemoryVmaAllocatedBuffer<VkBuffer>      m_VmaBuffer;
+    std::optional<MemoryCpuMapped<uint8_t>> m_Mapped;               ///< persistent mapping (owns the buffer's memory allocation until Destroy)
+    uint8_t*                                m_pMappedData = nullptr;
+    size_t                                  m_Size = 0;
+    uint64_t                                m_Head = 0;             ///< total bytes allocated (never wraps, offset in to the buffer is m_Head % m_Size)
+    uint64_t                                m_Tail = 0;             ///< total bytes released
+};
@@ -0,0 +1,126 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "uniformRingBuffer.hpp"
+#include "system/os_common.h"
+#include <cassert>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+UniformRingBuffer::UniformRingBuffer()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+    Destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool UniformRingBuffer::Initialize(MemoryManager* pManager, size_t frameSize, uint32_t numFrames, size_t minAlignment)
+{
+    Destroy();
+    if (!pManager || frameSize == 0 || numFrames == 0)
+    {
+        return false;
+    }
+
+    m_Alignment = minAlignment > 0 ? minAlignment : 1;
+    m_FrameSize = GetAlignedSize(frameSize);
+    m_NumFrames = numFrames;
+
+    // Descriptors are written with a fixed range, so pad the end of the buffer so the last allocation's offset + range is still inside the buffer.
+    const size_t bufferSize = m_FrameSize * numFrames + cDynamicUniformBufferRange;
+    m_VmaBuffer = pManager->CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryManager::MemoryUsage::CpuToGpu, nullptr, MemoryCategory::UniformBuffer, "UniformRingBuffer");
+    if (!m_VmaBuffer)
+    {
+        return false;
+    }
+    m_pManager = pManager;
+
+    // Stays mapped until Destroy.
+    m_Mapped.emplace(m_pManager->Map<uint8_t>(m_VmaBuffer));
+    m_pMappedData = m_Mapped->data();
+    if (!m_pMappedData)
+    {
+        Destroy();
+        return false;
+    }
+    m_CurrentFrame = 0;
+    m_FrameHead = 0;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void UniformRingBuffer::Destroy()
+{
+    if (!m_pManager)
+    {
+        assert(!m_VmaBuffer);    // ensure we don't have an orphaned buffer (somehow)
+        return;
+    }
+    if (m_Mapped)
+    {
+        m_pManager->Unmap(m_VmaBuffer, std::move(*m_Mapped));
+        m_Mapped.reset();
+    }
+    m_pManager->Destroy(std::move(m_VmaBuffer));
+    m_pManager = nullptr;
+    m_pMappedData = nullptr;
+    m_FrameSize = 0;
+    m_NumFrames = 0;
+    m_CurrentFrame = 0;
+    m_FrameHead = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void UniformRingBuffer::BeginFrame(uint32_t bufferIdx)
+{
+    assert(bufferIdx < m_NumFrames);
+    m_CurrentFrame = bufferIdx;
+    m_FrameHead = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+UniformRingBuffer::Allocation UniformRingBuffer::Allocate(size_t size)
+{
+    if (!m_pMappedData || size == 0 || size > cDynamicUniformBufferRange)
+    {
+        return {};
+    }
+    const size_t alignedSize = GetAlignedSize(size);
+    if (m_FrameHead + alignedSize > m_FrameSize)
+    {
+        LOGE("UniformRingBuffer frame region full (%zu of %zu bytes used, %zu requested)", m_FrameHead, m_FrameSize, size);
+        return {};
+    }
+
+    const size_t offset = m_CurrentFrame * m_FrameSize + m_FrameHead;
+    m_FrameHead += alignedSize;
+    return { m_pMappedData + offset, (uint32_t)offset };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t UniformRingBuffer::Write(const void* pData, size_t size)
+{
+    Allocation allocation = Allocate(size);
+    if (!allocation)
+    {
+        return UINT32_MAX;
+    }
+    memcpy(allocation.pData, pData, size);
+    return allocation.dynamicOffset;
+}
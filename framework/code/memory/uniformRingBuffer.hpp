@@ -0,0 +1,85 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <optional>
+#include "memoryMapped.hpp"
+#include "memoryManager.hpp"
+
+/// Range (bytes) written in to VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptors (the minimum maxUniformBufferRange Vulkan guarantees).
+/// Uniform structures accessed through a dynamic uniform buffer binding must be no larger than this.
+/// @ingroup Memory
+static constexpr uint32_t cDynamicUniformBufferRange = 16384;
+
+/// Uniform buffer that is kept persistently mapped and linearly sub-allocated each frame.
+/// The buffer is split in to one region per frame buffer (eg NUM_VULKAN_BUFFERS); BeginFrame resets the region for the frame being built and Allocate/Write hand out consecutive (aligned) slices of it.
+/// Slices are bound with VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptors (written once, with offset 0 and range cDynamicUniformBufferRange) and the returned dynamic offset,
+/// so updating a uniform is a memcpy in to mapped memory rather than a Map/memcpy/Unmap of its own buffer.
+/// Allocations made in the same order (and with the same sizes) each frame get the same offset within their frame region, so command buffers can be recorded once per frame buffer.
+/// @ingroup Memory
+class UniformRingBuffer
+{
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+public:
+    UniformRingBuffer();
+    ~UniformRingBuffer();
+
+    /// Create and map the buffer.  Destroys any existing buffer (which must not be in use by the gpu).
+    /// @param frameSize bytes available for allocations in each frame
+    /// @param numFrames number of frame regions (frames that can be in flight)
+    /// @param minAlignment VkPhysicalDeviceLimits::minUniformBufferOffsetAlignment
+    bool Initialize(MemoryManager* pManager, size_t frameSize, uint32_t numFrames, size_t minAlignment);
+    /// Unmap and destroy the buffer.  Leaves in a state where it could be re-initialized.
+    void Destroy();
+
+    explicit operator bool() const { return m_pMappedData != nullptr; }
+
+    /// Sub-allocation of the ring buffer.
+    struct Allocation
+    {
+        uint8_t*        pData = nullptr;        ///< cpu address of the allocation (mapped)
+        uint32_t        dynamicOffset = 0;      ///< offset of the allocation in to the buffer (pass to vkCmdBindDescriptorSets)
+        explicit operator bool() const { return pData != nullptr; }
+    };
+
+    /// Start allocating from the region for the given frame buffer.  Everything previously allocated in this region must no longer be in use by the gpu.
+    void BeginFrame(uint32_t bufferIdx);
+
+    /// Allocate 'size' bytes from the current frame's region.
+    /// @returns empty Allocation if the region is full (or size is larger than cDynamicUniformBufferRange)
+    Allocation Allocate(size_t size);
+
+    /// Allocate and copy in the given data.
+    /// @returns dynamic offset of the data, or UINT32_MAX if the region is full
+    uint32_t Write(const void* pData, size_t size);
+    template<typename T>
+    uint32_t Write(const T& data) { return Write(&data, sizeof(T)); }
+
+    /// @returns offset of the start of the given frame buffer's region (the dynamic offset of the first allocation made after BeginFrame(bufferIdx))
+    uint32_t GetFrameOffset(uint32_t bufferIdx) const { return (uint32_t)(bufferIdx * m_FrameSize); }
+    /// @returns size the given allocation size is rounded up to (the amount of the region each allocation uses)
+    size_t GetAlignedSize(size_t size) const { return (size + m_Alignment - 1) / m_Alignment * m_Alignment; }
+    /// @returns bytes allocated in the current frame
+    size_t GetFrameUsed() const { return m_FrameHead; }
+    size_t GetFrameSize() const { return m_FrameSize; }
+    VkBuffer GetVkBuffer() const { return m_VmaBuffer.GetVkBuffer(); }
+
+private:
+    MemoryManager*                          m_pManager = nullptr;
+    MemoryVmaAllocatedBuffer<VkBuffer>      m_VmaBuffer;
+    std::optional<MemoryCpuMapped<uint8_t>> m_Mapped;               ///< persistent mapping (owns the buffer's memory allocation until Destroy)
+    uint8_t*                                m_pMappedData = nullptr;
+    size_t                                  m_FrameSize = 0;        ///< size of each frame region (multiple of m_Alignment)
+    uint32_t                                m_NumFrames = 0;
+    size_t                                  m_Alignment = 1;
+    uint32_t                                m_CurrentFrame = 0;
+    size_t                                  m_FrameHead = 0;        ///< bytes allocated from the current frame's region
+};
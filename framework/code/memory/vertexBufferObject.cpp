@@ -75,6 +75,17 @@ bool VertexBufferObject::Initialize(MemoryManager* pManager, size_t span, size_t
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool VertexBufferObject::Initialize(BufferUploader& uploader, size_t span, size_t numVerts, const void* initialData, const VkBufferUsageFlags usage )
+{
+    mNumVertices = numVerts;
+    mSpan = span;
+    mDspUsable = false;
+
+    return BufferObject::Initialize(uploader, (VkDeviceSize) (mSpan * mNumVertices), usage, initialData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void VertexBufferObject::Destroy()
 {
     mBindings.clear();
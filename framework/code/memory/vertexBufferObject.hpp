@@ -28,6 +28,10 @@ public:
     bool Initialize(MemoryManager* pManager, size_t span, size_t numVerts, const void* initialData, const bool dspUsable = false, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
     template<typename T>
     bool Initialize(MemoryManager* pManager, size_t numVerts, const T* initialData, const bool dspUsable = false, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
+    /// Initialization with the initialData staged through 'uploader' (see BufferObject::Initialize(BufferUploader&, ...)), data is in the buffer once the uploader's next Submit/Flush has executed.
+    bool Initialize(BufferUploader& uploader, size_t span, size_t numVerts, const void* initialData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
+    template<typename T>
+    bool Initialize(BufferUploader& uploader, size_t numVerts, const T* initialData, const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
 
     /// destroy buffer and leave in a state where it could be re-initialized
     virtual void Destroy() override;
@@ -78,3 +82,9 @@ bool VertexBufferObject::Initialize(MemoryManager* pManager, size_t numVerts, co
 {
     return Initialize(pManager, sizeof(T), numVerts, initialData, dspUsable, usage);
 }
+
+template<typename T>
+bool VertexBufferObject::Initialize(BufferUploader& uploader, size_t numVerts, const T* initialData, const VkBufferUsageFlags usage )
+{
+    return Initialize(uploader, sizeof(T), numVerts, initialData, usage);
+}
@@ -0,0 +1,416 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "octree.hpp"
+#include "tcb/span.hpp"
+
+/// Loose octree class.
+/// Designed for culling of dynamic (moving) geometry, eg animated nodes.  Use alongside Octree (which holds the static geometry) so static queries run at full speed.
+///
+/// Each cell's bounds are 'loose' (twice the size of the regular octree cell) so an object's cell only depends on its center and size, never on the cell boundaries it straddles.
+/// Objects are referenced by handle; add, remove and move are all O(depth) (and a move that stays within the same cell is O(1)).
+/// Nodes are allocated from a pool and freed when they become empty.
+///
+/// @tparam T_OBJECT object contained in the octree.
+/// @tparam T_MAXDEPTH maximum depth (levels of nodes).
+/// @ingroup Mesh
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+class LooseOctree : public OctreeBase
+{
+    static constexpr uint32_t cInvalidIdx = ~0u;
+
+    struct Node
+    {
+        std::array<uint32_t, 8>     Children;       ///< index of child node for each cell (or cInvalidIdx)
+        uint32_t                    Parent;         ///< index of parent node (or cInvalidIdx for the root)
+        uint32_t                    Cell;           ///< cell index (0-7) of this node within the parent
+        uint32_t                    Depth;
+        uint32_t                    SubtreeObjectCount; ///< objects in this node and all the nodes below it
+        glm::vec4                   Center;
+        std::vector<uint32_t>       Objects;        ///< handles of the objects in this node
+    };
+
+    struct ObjectSlot
+    {
+        T_OBJECT    Object;
+        uint32_t    NodeIdx;        ///< node containing this object (cInvalidIdx if slot is free)
+        uint32_t    IndexInNode;    ///< index in to Node::Objects
+    };
+
+public:
+    typedef T_OBJECT tObject;
+    typedef uint32_t tObjectHandle;
+
+    /// Object move request (for MoveObjects)
+    struct ObjectMove
+    {
+        tObjectHandle   Handle;
+        glm::vec4       Position;
+        glm::vec4       Size;       ///< NOT a half size
+    };
+
+    /// Constructor
+    /// @param center Center position of the octree
+    /// @param octreeSize Dimensions of octree (not halfsize).  Objects outside of the octree are allowed but are always returned by queries.
+    /// @param maxObjects Number of objects to reserve space for
+    LooseOctree( const glm::vec3 center, const glm::vec3 octreeSize, uint32_t maxObjects ) : m_Center( center, 1.0f ), m_HalfSize( octreeSize * 0.5f, 0.0f )
+    {
+        m_Objects.reserve( maxObjects );
+        m_Nodes.push_back( MakeNode( cInvalidIdx, 0, 0, m_Center ) );
+    }
+
+    /// Add object to the octree.
+    /// @returns handle used to move or remove the object.
+    tObjectHandle AddObject( const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/, T_OBJECT&& object );
+
+    /// Remove object from the octree.  Handle is invalid after this call (and may be reused by a subsequent AddObject).
+    void RemoveObject( tObjectHandle handle );
+
+    /// Update the position/size of an object already in the octree.
+    void MoveObject( tObjectHandle handle, const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/ );
+
+    /// Move a batch of objects.
+    /// More efficient than individual MoveObject calls when many objects move each frame; objects staying in their cell are updated first and empty nodes are only freed once, at the end.
+    void MoveObjects( const tcb::span<const ObjectMove> moves );
+
+    T_OBJECT& GetObject( tObjectHandle handle )                 { return m_Objects[handle].Object; }
+    const T_OBJECT& GetObject( tObjectHandle handle ) const     { return m_Objects[handle].Object; }
+    uint32_t GetNumObjects() const                              { return m_Nodes[0].SubtreeObjectCount; }
+
+    /// Query against this octree and output all contained objects.
+    /// Same test/output functors as Octree::Query (testFn is passed the cell's loose bounds).
+    template<typename T_TEST, typename T_OUTPUT>
+    void Query( const T_TEST& testFn, T_OUTPUT&& outputFn ) const;
+
+private:
+    static Node MakeNode( uint32_t parent, uint32_t cell, uint32_t depth, const glm::vec4& center )
+    {
+        Node node{};
+        node.Children.fill( cInvalidIdx );
+        node.Parent = parent;
+        node.Cell = cell;
+        node.Depth = depth;
+        node.SubtreeObjectCount = 0;
+        node.Center = center;
+        return node;
+    }
+
+    // Half size of the (tight) cell at the given depth.
+    glm::vec4 CalcHalfSize( uint32_t depth ) const
+    {
+        return m_HalfSize * (1.0f / float( 1u << depth ));
+    }
+
+    // Depth an object of the given size should live at; the deepest level where the object's half size fits inside the (tight) cell half size.
+    uint32_t CalcDepth( const glm::vec4& objectSize ) const;
+
+    // Is the object's center outside the octree bounds (such objects live in the root)?
+    bool IsOutsideBounds( const glm::vec4& objectPosition ) const
+    {
+        const glm::vec4 offset = objectPosition - m_Center;
+        return std::abs( offset.x ) > m_HalfSize.x || std::abs( offset.y ) > m_HalfSize.y || std::abs( offset.z ) > m_HalfSize.z;
+    }
+
+    // Find (or create) the node an object should live in.
+    uint32_t FindOrCreateNode( const glm::vec4& objectPosition, const glm::vec4& objectSize );
+
+    // Is the object (still) in the correct node?
+    bool IsInNode( const Node& node, const glm::vec4& objectPosition, const glm::vec4& objectSize ) const;
+
+    void AttachObject( tObjectHandle handle, uint32_t nodeIdx );
+    void DetachObject( tObjectHandle handle );
+    void PruneNode( uint32_t nodeIdx );
+
+    template<typename T_OUTPUT>
+    void OutputSubtree( uint32_t nodeIdx, T_OUTPUT&& outputFn ) const;
+    template<typename T_TEST, typename T_OUTPUT>
+    void Query( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, const glm::vec4& halfSize ) const;
+
+private:
+    std::vector<Node>       m_Nodes;
+    std::vector<uint32_t>   m_FreeNodes;
+    std::vector<ObjectSlot> m_Objects;
+    std::vector<uint32_t>   m_FreeObjects;
+    std::vector<uint32_t>   m_VacatedNodes;     // MoveObjects scratch (kept to avoid re-allocating every call)
+
+    glm::vec4               m_Center;
+    glm::vec4               m_HalfSize;     // size (width, height, depth) of the octree (halved)
+};
+
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+typename LooseOctree<T_OBJECT, T_MAXDEPTH>::tObjectHandle LooseOctree<T_OBJECT, T_MAXDEPTH>::AddObject( const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/, T_OBJECT&& object )
+{
+    tObjectHandle handle;
+    if( !m_FreeObjects.empty() )
+    {
+        handle = m_FreeObjects.back();
+        m_FreeObjects.pop_back();
+        m_Objects[handle].Object = std::move( object );
+    }
+    else
+    {
+        handle = (tObjectHandle) m_Objects.size();
+        m_Objects.push_back( ObjectSlot{ std::move( object ), cInvalidIdx, 0 } );
+    }
+
+    AttachObject( handle, FindOrCreateNode( objectPosition, objectSize ) );
+    return handle;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::RemoveObject( tObjectHandle handle )
+{
+    const uint32_t nodeIdx = m_Objects[handle].NodeIdx;
+    assert( nodeIdx != cInvalidIdx );
+    DetachObject( handle );
+    PruneNode( nodeIdx );
+    m_FreeObjects.push_back( handle );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::MoveObject( tObjectHandle handle, const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/ )
+{
+    const uint32_t nodeIdx = m_Objects[handle].NodeIdx;
+    assert( nodeIdx != cInvalidIdx );
+    if( IsInNode( m_Nodes[nodeIdx], objectPosition, objectSize ) )
+    {
+        return; // nothing to do, still in the same cell.
+    }
+    DetachObject( handle );
+    AttachObject( handle, FindOrCreateNode( objectPosition, objectSize ) );
+    PruneNode( nodeIdx );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::MoveObjects( const tcb::span<const ObjectMove> moves )
+{
+    // Move everything that changes cell, keeping a note of the nodes that were moved out of.
+    // Pruning is deferred so nodes emptied by one move can be filled by another without being freed and re-created.
+    std::vector<uint32_t>& vacatedNodes = m_VacatedNodes;
+    vacatedNodes.clear();
+    for( const ObjectMove& move : moves )
+    {
+        const uint32_t nodeIdx = m_Objects[move.Handle].NodeIdx;
+        assert( nodeIdx != cInvalidIdx );
+        if( !IsInNode( m_Nodes[nodeIdx], move.Position, move.Size ) )
+        {
+            DetachObject( move.Handle );
+            AttachObject( move.Handle, FindOrCreateNode( move.Position, move.Size ) );
+            vacatedNodes.push_back( nodeIdx );
+        }
+    }
+
+    // Prune deepest nodes first so parents see their children already freed.
+    std::sort( vacatedNodes.begin(), vacatedNodes.end(), [this]( uint32_t a, uint32_t b ) { return m_Nodes[a].Depth > m_Nodes[b].Depth; } );
+    for( uint32_t nodeIdx : vacatedNodes )
+    {
+        PruneNode( nodeIdx );
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+uint32_t LooseOctree<T_OBJECT, T_MAXDEPTH>::CalcDepth( const glm::vec4& objectSize ) const
+{
+    uint32_t depth = 0;
+    glm::vec4 cellHalfSize = m_HalfSize * 0.5f;
+    const glm::vec4 objectHalfSize = objectSize * 0.5f;
+    while( depth < T_MAXDEPTH && objectHalfSize.x <= cellHalfSize.x && objectHalfSize.y <= cellHalfSize.y && objectHalfSize.z <= cellHalfSize.z )
+    {
+        ++depth;
+        cellHalfSize *= 0.5f;
+    }
+    return depth;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+bool LooseOctree<T_OBJECT, T_MAXDEPTH>::IsInNode( const Node& node, const glm::vec4& objectPosition, const glm::vec4& objectSize ) const
+{
+    if( node.Depth == 0 )
+    {
+        // Root holds everything too big for a cell and everything outside the octree bounds (whatever its size).
+        // Objects outside the bounds are kept on the root rather than growing the root, so an object moving around outside the bounds stays put (is not detached and re-attached every move).
+        return CalcDepth( objectSize ) == 0 || IsOutsideBounds( objectPosition );
+    }
+    if( node.Depth != CalcDepth( objectSize ) )
+    {
+        return false;
+    }
+    // Object center must be inside the (tight) bounds of the cell.
+    const glm::vec4 halfSize = CalcHalfSize( node.Depth );
+    const glm::vec4 offset = objectPosition - node.Center;
+    return offset.x >= -halfSize.x && offset.x < halfSize.x && offset.y >= -halfSize.y && offset.y < halfSize.y && offset.z >= -halfSize.z && offset.z < halfSize.z;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+uint32_t LooseOctree<T_OBJECT, T_MAXDEPTH>::FindOrCreateNode( const glm::vec4& objectPosition, const glm::vec4& objectSize )
+{
+    if( IsOutsideBounds( objectPosition ) )
+    {
+        return 0;   // Outside the octree, stays in the root.
+    }
+
+    const uint32_t targetDepth = CalcDepth( objectSize );
+    uint32_t nodeIdx = 0;
+    glm::vec4 halfSize = m_HalfSize;
+    for( uint32_t depth = 0; depth < targetDepth; ++depth )
+    {
+        halfSize *= 0.5f;
+        const glm::vec4 nodeCenter = m_Nodes[nodeIdx].Center;
+        const glm::vec4 relativePosition = objectPosition - nodeCenter;
+        const uint32_t cell = (relativePosition.x >= 0.0f ? 1 : 0) | (relativePosition.y >= 0.0f ? 2 : 0) | (relativePosition.z >= 0.0f ? 4 : 0);
+
+        uint32_t childIdx = m_Nodes[nodeIdx].Children[cell];
+        if( childIdx == cInvalidIdx )
+        {
+            Node child = MakeNode( nodeIdx, cell, depth + 1, nodeCenter + sCellOffsets[cell] * halfSize );
+            if( !m_FreeNodes.empty() )
+            {
+                childIdx = m_FreeNodes.back();
+                m_FreeNodes.pop_back();
+                m_Nodes[childIdx] = std::move( child );
+            }
+            else
+            {
+                childIdx = (uint32_t) m_Nodes.size();
+                m_Nodes.push_back( std::move( child ) );
+            }
+            m_Nodes[nodeIdx].Children[cell] = childIdx;
+        }
+        nodeIdx = childIdx;
+    }
+    return nodeIdx;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::AttachObject( tObjectHandle handle, uint32_t nodeIdx )
+{
+    ObjectSlot& slot = m_Objects[handle];
+    Node& node = m_Nodes[nodeIdx];
+    slot.NodeIdx = nodeIdx;
+    slot.IndexInNode = (uint32_t) node.Objects.size();
+    node.Objects.push_back( handle );
+
+    for( uint32_t idx = nodeIdx; idx != cInvalidIdx; idx = m_Nodes[idx].Parent )
+    {
+        ++m_Nodes[idx].SubtreeObjectCount;
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::DetachObject( tObjectHandle handle )
+{
+    ObjectSlot& slot = m_Objects[handle];
+    Node& node = m_Nodes[slot.NodeIdx];
+
+    // Swap with the last object in the node (so removal is O(1))
+    const tObjectHandle lastHandle = node.Objects.back();
+    node.Objects[slot.IndexInNode] = lastHandle;
+    m_Objects[lastHandle].IndexInNode = slot.IndexInNode;
+    node.Objects.pop_back();
+
+    for( uint32_t idx = slot.NodeIdx; idx != cInvalidIdx; idx = m_Nodes[idx].Parent )
+    {
+        --m_Nodes[idx].SubtreeObjectCount;
+    }
+    slot.NodeIdx = cInvalidIdx;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::PruneNode( uint32_t nodeIdx )
+{
+    // Free this node (and any parents) that no longer contain anything.  Never frees the root.
+    while( nodeIdx != 0 && m_Nodes[nodeIdx].SubtreeObjectCount == 0 && m_Nodes[nodeIdx].Parent != cInvalidIdx )
+    {
+        Node& node = m_Nodes[nodeIdx];
+        const uint32_t parentIdx = node.Parent;
+        m_Nodes[parentIdx].Children[node.Cell] = cInvalidIdx;
+        node.Parent = cInvalidIdx;  // marks node as free (in case it is in the MoveObjects vacated list more than once)
+        node.Objects.clear();
+        m_FreeNodes.push_back( nodeIdx );
+        nodeIdx = parentIdx;
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::Query( const T_TEST& testFn, T_OUTPUT&& outputFn ) const
+{
+    // Objects at the root are always output (too big for any cell or outside the octree bounds).
+    for( tObjectHandle handle : m_Nodes[0].Objects )
+    {
+        outputFn( m_Objects[handle].Object );
+    }
+    Query( testFn, outputFn, 0, m_HalfSize );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::Query( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, const glm::vec4& halfSize ) const
+{
+    const glm::vec4 childHalfSize = halfSize * 0.5f;
+    const glm::vec4 childLooseHalfSize = halfSize;  // loose bounds are double the size of the (tight) cell
+    const Node& node = m_Nodes[nodeIdx];
+
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        const uint32_t childIdx = node.Children[cell];
+        if( childIdx == cInvalidIdx )
+        {
+            continue;
+        }
+        const Node& child = m_Nodes[childIdx];
+
+        switch( testFn( child.Center, childLooseHalfSize ) )
+        {
+        case eQueryResult::Inside:
+            OutputSubtree( childIdx, outputFn );
+            break;
+        case eQueryResult::Partial:
+            for( tObjectHandle handle : child.Objects )
+            {
+                outputFn( m_Objects[handle].Object );
+            }
+            if( child.SubtreeObjectCount != child.Objects.size() )
+            {
+                Query( testFn, outputFn, childIdx, childHalfSize );
+            }
+            break;
+        case eQueryResult::Outside:
+            break;
+        }
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_OUTPUT>
+void LooseOctree<T_OBJECT, T_MAXDEPTH>::OutputSubtree( uint32_t nodeIdx, T_OUTPUT&& outputFn ) const
+{
+    const Node& node = m_Nodes[nodeIdx];
+    for( tObjectHandle handle : node.Objects )
+    {
+        outputFn( m_Objects[handle].Object );
+    }
+    if( node.SubtreeObjectCount != node.Objects.size() )
+    {
+        for( uint32_t childIdx : node.Children )
+        {
+            if( childIdx != cInvalidIdx )
+            {
+                OutputSubtree( childIdx, outputFn );
+            }
+        }
+    }
+}
@@ -50,6 +50,9 @@ typedef struct _gltfAttribInfo
     // Total number of bytes
     size_t          BytesTotal = 0;
 
+    // Accessor component type (TINYGLTF_COMPONENT_TYPE_*)
+    int             ComponentType = -1;
+
     // Pointer to data within the glTF buffer
     void*           pData = nullptr;
 
@@ -498,6 +501,8 @@ std::vector<uint32_t> MeshObjectIntermediate::CopyFatVertexToFormattedBuffer(con
     int colorIndex = -1;
     int tangentIndex = -1;
     int bitangentIndex = -1;
+    int jointsIndex = -1;
+    int weightsIndex = -1;
     for (int i = 0; i < vertexFormat.elementIds.size(); ++i)
     {
         const std::string& elementId = vertexFormat.elementIds[i];
@@ -525,6 +530,14 @@ std::vector<uint32_t> MeshObjectIntermediate::CopyFatVertexToFormattedBuffer(con
         {
             bitangentIndex = i;
         }
+        else if (elementId == "Joints")
+        {
+            jointsIndex = i;
+        }
+        else if (elementId == "Weights")
+        {
+            weightsIndex = i;
+        }
         else
         {
             LOGE("Cannot map vertex elementId %s to the mesh data", elementId.c_str());
@@ -543,7 +556,9 @@ std::vector<uint32_t> MeshObjectIntermediate::CopyFatVertexToFormattedBuffer(con
         std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, color) / 4, colorIndex),
         std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, uv0) / 4, uv0Index),
         std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, tangent) / 4, tangentIndex),
-        std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, bitangent) / 4, bitangentIndex) })
+        std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, bitangent) / 4, bitangentIndex),
+        std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, joints) / 4, jointsIndex),
+        std::pair<uint32_t, int>((uint32_t)offsetof(MeshObjectIntermediate::FatVertex, weights) / 4, weightsIndex) })
     {
         int destIndex = srcOffset_DestIndex.second;
         if (destIndex != -1)
@@ -807,6 +822,7 @@ bool MeshObjectIntermediateGltfProcessor::operator()(const tinygltf::Model& Mode
                         AttribInfo[WhichAttrib].BytesPerElem = Stride;
                         AttribInfo[WhichAttrib].BytesTotal = ViewData.byteLength;
                         AttribInfo[WhichAttrib].Count = (uint32_t) AccessorData.count;
+                        AttribInfo[WhichAttrib].ComponentType = AccessorData.componentType;
 
                         const tinygltf::Buffer& BufferData = ModelData.buffers[ViewData.buffer];
                         AttribInfo[WhichAttrib].pData = (void*)(&BufferData.data.at(ViewData.byteOffset + AccessorData.byteOffset));
@@ -854,6 +870,8 @@ bool MeshObjectIntermediateGltfProcessor::operator()(const tinygltf::Model& Mode
                 meshObject.m_Transform = m_ignoreTransforms ? glm::mat4{1.0f} : Transform;
                 meshObject.m_Transform[3] *= glm::vec4(m_globalScale, 1.0f);// Transform position needs scale applying, dont scale entire transform as the vertex data is scaled independantly (below).
                 meshObject.m_NodeId = (int)NodeIdx;
+                if (AttribInfo[ATTRIB_JOINTS_0].pData != nullptr && AttribInfo[ATTRIB_WEIGHTS_0].pData != nullptr)
+                    meshObject.m_SkinId = NodeData.skin;
 
                 if (materialIdx >= 0)/*-1 is valid*/
                 {
@@ -1051,6 +1069,41 @@ bool MeshObjectIntermediateGltfProcessor::operator()(const tinygltf::Model& Mode
                         vertex.bitangent[2] = bitangent[2];
                     }
 
+                    // Skinning joints (unsigned byte or short) and weights (float or normalized unsigned byte/short).
+                    if (AttribInfo[ATTRIB_JOINTS_0].pData != nullptr && AttribInfo[ATTRIB_WEIGHTS_0].pData != nullptr)
+                    {
+                        const uint8_t* pJoints = (const uint8_t*)AttribInfo[ATTRIB_JOINTS_0].pData + WhichVert * AttribInfo[ATTRIB_JOINTS_0].BytesPerElem;
+                        const uint8_t* pWeights = (const uint8_t*)AttribInfo[ATTRIB_WEIGHTS_0].pData + WhichVert * AttribInfo[ATTRIB_WEIGHTS_0].BytesPerElem;
+                        for (uint32_t i = 0; i < 4; ++i)
+                        {
+                            switch (AttribInfo[ATTRIB_JOINTS_0].ComponentType) {
+                            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                                vertex.joints[i] = pJoints[i];
+                                break;
+                            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                                vertex.joints[i] = ((const uint16_t*)pJoints)[i];
+                                break;
+                            default:
+                                printf("\nError loading %s: Mesh has invalid component type (%d) for joints", m_filename.c_str(), AttribInfo[ATTRIB_JOINTS_0].ComponentType);
+                                return false;
+                            }
+                            switch (AttribInfo[ATTRIB_WEIGHTS_0].ComponentType) {
+                            case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                                vertex.weights[i] = ((const float*)pWeights)[i];
+                                break;
+                            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                                vertex.weights[i] = (float)pWeights[i] / 255.0f;
+                                break;
+                            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                                vertex.weights[i] = (float)((const uint16_t*)pWeights)[i] / 65535.0f;
+                                break;
+                            default:
+                                printf("\nError loading %s: Mesh has invalid component type (%d) for weights", m_filename.c_str(), AttribInfo[ATTRIB_WEIGHTS_0].ComponentType);
+                                return false;
+                            }
+                        }
+                    }
+
                     vertex.material = materialIdx;
                     meshObject.m_VertexBuffer.push_back(vertex);
                 }
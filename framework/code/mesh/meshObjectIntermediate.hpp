@@ -71,6 +71,8 @@ public:
         float uv0[2];
         float tangent[3];
         float bitangent[3];
+        uint32_t joints[4]; ///< skinning joint indices (in to the skin's joint list, see @SkinData)
+        float weights[4];   ///< skinning joint weights (all zero if not skinned)
         int   material;     ///< indexc in to m_Materials
     };
 
@@ -124,6 +126,8 @@ public:
     glm::mat4                   m_Transform = glm::identity<glm::mat4>();
     /// Node id (child node that this node is attached to) from gltf, can be used to lookup animations on this node (non skinned animation)
     int                         m_NodeId = -1;
+    /// Skin id (index of the gltf skin) that this mesh's vertex joints/weights reference (-1 if not skinned)
+    int                         m_SkinId = -1;
 };
 
 
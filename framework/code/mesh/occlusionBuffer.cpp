@@ -0,0 +1,233 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "occlusionBuffer.hpp"
+#include "meshObjectIntermediate.hpp"
+#include "system/simd_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Clip space w below which a vertex is treated as being on/behind the near plane.
+static constexpr float cMinClipW = 1e-5f;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+    : m_Width((width + 3) & ~3u)
+    , m_Height(height)
+    , m_ViewProjection(1.0f)
+{
+    // Level 0 is the full resolution depth buffer.  Each subsequent level halves the dimensions until we get to a single pixel.
+    uint32_t levelWidth = m_Width;
+    uint32_t levelHeight = m_Height;
+    while (true)
+    {
+        m_HiZLevels.push_back({ levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f) });
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = std::max(1u, (levelWidth + 1) / 2);
+        levelHeight = std::max(1u, (levelHeight + 1) / 2);
+    }
+}
+
+void OcclusionBuffer::Clear()
+{
+    for (auto& level : m_HiZLevels)
+        std::fill(level.Depth.begin(), level.Depth.end(), 1.0f);
+}
+
+template<typename T_INDEX>
+void OcclusionBuffer::RasterizeClipTriangles(const tcb::span<const T_INDEX> indices)
+{
+    if (indices.empty())
+    {
+        for (size_t i = 0; i + 2 < m_ClipPositions.size(); i += 3)
+            RasterizeTriangle(m_ClipPositions[i], m_ClipPositions[i + 1], m_ClipPositions[i + 2]);
+    }
+    else
+    {
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            RasterizeTriangle(m_ClipPositions[indices[i]], m_ClipPositions[indices[i + 1]], m_ClipPositions[indices[i + 2]]);
+    }
+}
+
+void OcclusionBuffer::RasterizeOccluder(const tcb::span<const glm::vec3> positions, const tcb::span<const uint32_t> indices, const glm::mat4& transform)
+{
+    const glm::mat4 objectToClip = m_ViewProjection * transform;
+
+    m_ClipPositions.clear();
+    m_ClipPositions.reserve(positions.size());
+    for (const glm::vec3& position : positions)
+        m_ClipPositions.push_back(objectToClip * glm::vec4(position, 1.0f));
+
+    RasterizeClipTriangles(indices);
+}
+
+void OcclusionBuffer::RasterizeOccluder(const MeshObjectIntermediate& mesh)
+{
+    const glm::mat4 objectToClip = m_ViewProjection * mesh.m_Transform;
+
+    m_ClipPositions.clear();
+    m_ClipPositions.reserve(mesh.m_VertexBuffer.size());
+    for (const auto& vertex : mesh.m_VertexBuffer)
+        m_ClipPositions.push_back(objectToClip * glm::vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0f));
+
+    if (const auto* pIndices16 = std::get_if<std::vector<uint16_t>>(&mesh.m_IndexBuffer))
+        RasterizeClipTriangles(tcb::span<const uint16_t>(*pIndices16));
+    else if (const auto* pIndices32 = std::get_if<std::vector<uint32_t>>(&mesh.m_IndexBuffer))
+        RasterizeClipTriangles(tcb::span<const uint32_t>(*pIndices32));
+    else
+        RasterizeClipTriangles(tcb::span<const uint32_t>());
+}
+
+void OcclusionBuffer::RasterizeTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2)
+{
+    if (clip0.w < cMinClipW || clip1.w < cMinClipW || clip2.w < cMinClipW)
+        return; // crosses the near plane (no clipping, just dont use as an occluder)
+
+    // Screen space (pixel) positions and depth.
+    const float halfWidth = 0.5f * float(m_Width);
+    const float halfHeight = 0.5f * float(m_Height);
+    const auto ToScreen = [halfWidth, halfHeight](const glm::vec4& clip) -> glm::vec3 {
+        const float invW = 1.0f / clip.w;
+        return glm::vec3((clip.x * invW + 1.0f) * halfWidth, (clip.y * invW + 1.0f) * halfHeight, clip.z * invW);
+    };
+    glm::vec3 v0 = ToScreen(clip0);
+    glm::vec3 v1 = ToScreen(clip1);
+    glm::vec3 v2 = ToScreen(clip2);
+
+    // Occluders are rasterized regardless of facing; make the winding consistent.
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+    if (area < 1e-8f)
+        return; // degenerate
+
+    // Pixel bounds (clamped to the buffer).  Min x aligned to 4 pixels for the vectorized loop.
+    const float triMinX = std::min({ v0.x, v1.x, v2.x });
+    const float triMaxX = std::max({ v0.x, v1.x, v2.x });
+    const float triMinY = std::min({ v0.y, v1.y, v2.y });
+    const float triMaxY = std::max({ v0.y, v1.y, v2.y });
+    if (triMaxX < 0.0f || triMinX > float(m_Width) || triMaxY < 0.0f || triMinY > float(m_Height))
+        return; // off screen
+    const int minX = (int)std::floor(std::max(triMinX, 0.0f)) & ~3;
+    const int maxX = (int)std::ceil(std::min(triMaxX, float(m_Width - 1)));
+    const int minY = (int)std::floor(std::max(triMinY, 0.0f));
+    const int maxY = (int)std::ceil(std::min(triMaxY, float(m_Height - 1)));
+
+    // Edge functions (E(x,y) = A*x + B*y + C, positive inside) and depth plane (interpolated z/w is linear in screen space).
+    const auto EdgeSetup = [](const glm::vec3& a, const glm::vec3& b, float& A, float& B, float& C) {
+        A = a.y - b.y;
+        B = b.x - a.x;
+        C = -(A * a.x + B * a.y);
+    };
+    float A0, B0, C0, A1, B1, C1, A2, B2, C2;
+    EdgeSetup(v1, v2, A0, B0, C0);  // weight of v0
+    EdgeSetup(v2, v0, A1, B1, C1);  // weight of v1
+    EdgeSetup(v0, v1, A2, B2, C2);  // weight of v2
+    const float invArea = 1.0f / area;
+    const float zA = (A0 * v0.z + A1 * v1.z + A2 * v2.z) * invArea;
+    const float zB = (B0 * v0.z + B1 * v1.z + B2 * v2.z) * invArea;
+    const float zC = (C0 * v0.z + C1 * v1.z + C2 * v2.z) * invArea;
+
+    using namespace Simd;
+    const Float4 zero = Set1(0.0f);
+    const Float4 laneOffset = Set(0.5f, 1.5f, 2.5f, 3.5f);    // pixel centers
+    const Float4 stepA0 = Set1(A0 * 4.0f), stepA1 = Set1(A1 * 4.0f), stepA2 = Set1(A2 * 4.0f), stepZ = Set1(zA * 4.0f);
+
+    float* pDepthRow = m_HiZLevels[0].Depth.data() + minY * m_Width;
+    for (int y = minY; y <= maxY; ++y, pDepthRow += m_Width)
+    {
+        const float py = float(y) + 0.5f;
+        const Float4 px = Add(Set1(float(minX)), laneOffset);
+        Float4 e0 = MulAdd(Set1(A0), px, Set1(B0 * py + C0));
+        Float4 e1 = MulAdd(Set1(A1), px, Set1(B1 * py + C1));
+        Float4 e2 = MulAdd(Set1(A2), px, Set1(B2 * py + C2));
+        Float4 z = MulAdd(Set1(zA), px, Set1(zB * py + zC));
+
+        for (int x = minX; x <= maxX; x += 4)
+        {
+            const Mask4 outside = Or(Or(CmpLt(e0, zero), CmpLt(e1, zero)), CmpLt(e2, zero));
+            if (MoveMask(outside) != 0xf)
+            {
+                const Float4 depth = Load(pDepthRow + x);
+                Store(pDepthRow + x, Select(outside, depth, Min(depth, z)));
+            }
+            e0 = Add(e0, stepA0);
+            e1 = Add(e1, stepA1);
+            e2 = Add(e2, stepA2);
+            z = Add(z, stepZ);
+        }
+    }
+}
+
+void OcclusionBuffer::BuildHiZ()
+{
+    // Each texel of a level is the farthest depth of the (up to) 4 texels it covers in the previous level.
+    for (size_t levelIdx = 1; levelIdx < m_HiZLevels.size(); ++levelIdx)
+    {
+        const HiZLevel& src = m_HiZLevels[levelIdx - 1];
+        HiZLevel& dst = m_HiZLevels[levelIdx];
+        for (uint32_t y = 0; y < dst.Height; ++y)
+        {
+            const uint32_t srcY0 = y * 2;
+            const uint32_t srcY1 = std::min(srcY0 + 1, src.Height - 1);
+            for (uint32_t x = 0; x < dst.Width; ++x)
+            {
+                const uint32_t srcX0 = x * 2;
+                const uint32_t srcX1 = std::min(srcX0 + 1, src.Width - 1);
+                dst.Depth[y * dst.Width + x] = std::max(std::max(src.Depth[srcY0 * src.Width + srcX0], src.Depth[srcY0 * src.Width + srcX1]),
+                                                        std::max(src.Depth[srcY1 * src.Width + srcX0], src.Depth[srcY1 * src.Width + srcX1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::IsBoxVisible(const glm::vec3& center, const glm::vec3& halfSize) const
+{
+    // Project the 8 box corners to get the screen space bounds and nearest depth.
+    glm::vec3 screenMin(std::numeric_limits<float>::max());
+    glm::vec3 screenMax(-std::numeric_limits<float>::max());
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 cornerOffset((corner & 1) ? halfSize.x : -halfSize.x, (corner & 2) ? halfSize.y : -halfSize.y, (corner & 4) ? halfSize.z : -halfSize.z);
+        const glm::vec4 clip = m_ViewProjection * glm::vec4(center + cornerOffset, 1.0f);
+        if (clip.w < cMinClipW)
+            return true;    // box crosses the near plane, cannot be occluded.
+        const glm::vec3 ndc = glm::vec3(clip) * (1.0f / clip.w);
+        screenMin = glm::min(screenMin, ndc);
+        screenMax = glm::max(screenMax, ndc);
+    }
+
+    if (screenMax.x < -1.0f || screenMin.x > 1.0f || screenMax.y < -1.0f || screenMin.y > 1.0f || screenMin.z > 1.0f)
+        return false;   // off screen (or beyond the far plane)
+
+    // Pixel rectangle covered by the box.
+    const auto ToPixel = [](float ndc, uint32_t size) -> int {
+        return std::min((int)std::floor((std::clamp(ndc, -1.0f, 1.0f) + 1.0f) * 0.5f * float(size)), (int)size - 1);
+    };
+    const int x0 = ToPixel(screenMin.x, m_Width);
+    const int x1 = ToPixel(screenMax.x, m_Width);
+    const int y0 = ToPixel(screenMin.y, m_Height);
+    const int y1 = ToPixel(screenMax.y, m_Height);
+
+    // Pick the level where the rectangle covers at most 4x4 texels (coarser levels are cheaper to test but more conservative).
+    uint32_t levelIdx = 0;
+    while (levelIdx + 1 < m_HiZLevels.size() && (((x1 >> levelIdx) - (x0 >> levelIdx)) > 3 || ((y1 >> levelIdx) - (y0 >> levelIdx)) > 3))
+        ++levelIdx;
+
+    // Visible if the nearest point of the box is in front of the farthest occluder depth of any covered texel.
+    const HiZLevel& level = m_HiZLevels[levelIdx];
+    for (int y = y0 >> levelIdx; y <= (y1 >> levelIdx); ++y)
+        for (int x = x0 >> levelIdx; x <= (x1 >> levelIdx); ++x)
+            if (screenMin.z <= level.Depth[y * level.Width + x])
+                return true;
+    return false;
+}
@@ -0,0 +1,111 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "system/glm_common.hpp"
+#include "tcb/span.hpp"
+#include "octree.hpp"
+
+// Forward declarations
+class MeshObjectIntermediate;
+
+
+/// Software (CPU) occlusion buffer.
+/// Low resolution depth buffer that occluder triangles are rasterized in to (vectorized, 4 pixels at a time) followed by a hierarchical (max) Z-buffer that boxes can be quickly tested against.
+/// Allows hidden objects/octree cells to be rejected before any Vulkan commands are recorded.  Has no GPU dependency.
+///
+/// Usage each frame: Clear, SetViewProjection, RasterizeOccluder (for each occluder), BuildHiZ, then IsBoxVisible (or OcclusionTest with Octree::Query).
+/// Depth is expected to be 0 (near) to 1 (far), as output by the framework's projection matrices.
+/// @ingroup Mesh
+class OcclusionBuffer
+{
+    OcclusionBuffer(const OcclusionBuffer&) = delete;
+    OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+public:
+    /// @param width of depth buffer (rounded up to a multiple of 4)
+    /// @param height of depth buffer
+    OcclusionBuffer(uint32_t width, uint32_t height);
+
+    /// Clear the depth buffer to 'far'
+    void Clear();
+
+    /// Set the (world to clip space) matrix used for subsequent RasterizeOccluder and IsBoxVisible calls
+    void SetViewProjection(const glm::mat4& viewProjection) { m_ViewProjection = viewProjection; }
+
+    /// Rasterize occluder triangles in to the depth buffer.
+    /// Each vertex is transformed once (in to a scratch buffer kept between calls) and the triangles read from that.
+    /// Triangles crossing the near plane are skipped (they do not occlude anything, which is conservative).
+    /// @param positions vertex positions (object space)
+    /// @param indices triangle list indices in to positions (if empty every 3 positions are a triangle)
+    /// @param transform object to world space transform
+    void RasterizeOccluder(const tcb::span<const glm::vec3> positions, const tcb::span<const uint32_t> indices, const glm::mat4& transform);
+
+    /// Rasterize the triangles of a mesh (eg a simplified version of a render mesh) in to the depth buffer.  Uses the mesh's m_Transform.
+    /// Reads the mesh's vertex and (16 or 32 bit) index data in place, nothing is copied.
+    void RasterizeOccluder(const MeshObjectIntermediate& mesh);
+
+    /// Build the hierarchical Z levels from the rasterized depth buffer.  Call after all the occluders are rasterized and before testing.
+    void BuildHiZ();
+
+    /// Test a (world space) axis aligned box against the hierarchical Z-buffer.
+    /// @returns false if the box is completely hidden behind occluders (or off screen), true if it may be visible.
+    bool IsBoxVisible(const glm::vec3& center, const glm::vec3& halfSize) const;
+
+    uint32_t GetWidth() const                               { return m_Width; }
+    uint32_t GetHeight() const                              { return m_Height; }
+    /// @returns the full resolution depth buffer (eg for debug display)
+    const std::vector<float>& GetDepth() const              { return m_HiZLevels[0].Depth; }
+
+protected:
+    void RasterizeTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2);
+    /// Rasterize the triangles in m_ClipPositions (every 3 positions if indices is empty).
+    template<typename T_INDEX>
+    void RasterizeClipTriangles(const tcb::span<const T_INDEX> indices);
+
+    struct HiZLevel
+    {
+        uint32_t            Width;
+        uint32_t            Height;
+        std::vector<float>  Depth;  ///< farthest depth of the covered pixels (level 0 is the rasterized depth buffer)
+    };
+
+    uint32_t                m_Width;
+    uint32_t                m_Height;
+    glm::mat4               m_ViewProjection;
+    std::vector<HiZLevel>   m_HiZLevels;
+    std::vector<glm::vec4>  m_ClipPositions;    ///< RasterizeOccluder scratch (occluder vertices in clip space)
+};
+
+
+/// Helper occlusion test functor
+/// Use with Octree (or LooseOctree) to reject cells that are hidden in an OcclusionBuffer.
+/// Cells are first tested with the wrapped test (eg PackedFrustumTest); cells passing that are tested against the occlusion buffer.
+/// Never returns 'Inside' (so the query keeps refining visible cells).
+/// @ingroup Mesh
+template<typename T_TEST>
+struct OcclusionTest
+{
+    /// @param cellExpansion scale applied to cell size before testing occlusion; Octree allows objects to overhang their cell by up to half the cell size (use 1.0 for LooseOctree which passes the loose bounds).
+    OcclusionTest(const OcclusionBuffer& occlusionBuffer, const T_TEST& test, float cellExpansion = 1.5f) : m_OcclusionBuffer(occlusionBuffer), m_Test(test), m_CellExpansion(cellExpansion) {
+    }
+
+    OctreeBase::eQueryResult operator()(const glm::vec4& center, const glm::vec4& halfSize) const
+    {
+        if (m_Test(center, halfSize) == OctreeBase::eQueryResult::Outside)
+            return OctreeBase::eQueryResult::Outside;
+        if (!m_OcclusionBuffer.IsBoxVisible(glm::vec3(center), glm::vec3(halfSize) * m_CellExpansion))
+            return OctreeBase::eQueryResult::Outside;
+        return OctreeBase::eQueryResult::Partial;
+    }
+
+    const OcclusionBuffer&  m_OcclusionBuffer;
+    const T_TEST&           m_Test;
+    const float             m_CellExpansion;
+};
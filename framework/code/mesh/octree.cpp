@@ -9,4 +9,45 @@
 #include "octree.hpp"
 
 #include "system/os_common.h"
+#include "system/Worker.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool OctreeBase::RunCellJobs( CWorker& worker, uint32_t cellMask, void (*jobFn)( void* pParam, uint32_t cell ), void* pParam )
+{
+    if( worker.NumThreads() == 0 )
+    {
+        return false;
+    }
+
+    struct Job
+    {
+        void                (*pJobFn)( void*, uint32_t );
+        void*               pParam;
+        uint32_t            cell;
+        ReverseSemaphore*   pJobsRunning;
+    };
+    std::array<Job, 8> jobs;
+    ReverseSemaphore jobsRunning( 0 );
+
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        if( (cellMask & (1u << cell)) == 0 )
+        {
+            continue;
+        }
+        jobs[cell] = Job{ jobFn, pParam, cell, &jobsRunning };
+        jobsRunning.Lock();
+        worker.DoWork( []( void* pJobParam ) {
+            const Job& job = *static_cast<const Job*>(pJobParam);
+            job.pJobFn( job.pParam, job.cell );
+            job.pJobsRunning->Unlock();
+        }, &jobs[cell], 0 );
+    }
+
+    // Wait for our jobs (only) to complete.
+    jobsRunning.WaitAndLock();
+    jobsRunning.Unlock();
+    return true;
+}
 
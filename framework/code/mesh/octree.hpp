@@ -7,10 +7,19 @@
 //============================================================================================================
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cassert>
 #include <cstdint>
 #include <array>
+#include <utility>
 #include <vector>
 #include <glm/glm.hpp>
+#include "system/simd_common.hpp"
+#include "tcb/span.hpp"
+
+// Forward declarations
+class CWorker;
 
 const static glm::vec4 sCellOffsets[8] = {
     {-1.f,-1.f, -1.f, 0.f}, {1.f,-1.f,-1.f, 0.f}, {-1.f,1.f,-1.f, 0.f}, {1.f,1.f,-1.f, 0.f},
@@ -24,16 +33,22 @@ public:
     {
         Inside, Outside, Partial
     };
+
+protected:
+    /// Run jobFn( pParam, cell ) for each cell with its bit set in cellMask, as seperate jobs on the worker's threads, and wait for them to complete.
+    /// Implemented in octree.cpp (keeps the threading out of this header).
+    /// @returns false (without running anything) if the worker has no threads
+    static bool RunCellJobs( CWorker& worker, uint32_t cellMask, void (*jobFn)( void* pParam, uint32_t cell ), void* pParam );
 };
 
 
 /// Simple octree class.
-/// Designed for culling of (mostly) static geometry.
+/// Designed for culling of (mostly) static geometry.  Moving objects should go in a LooseOctree.
 /// 
 /// Should give very good query and traversal performance (nodes are stored linearly in memory and ordered such that every node under a single octree node can be traversed linearly).
 /// 
 /// Has APALLING add/insert performance, potentially an add will cause all data in the octree to be moved.
-/// Could be improved 
+/// When all the objects are known up-front use Build, which creates the same node/object layout in one (sorted) pass.
 ///
 /// @tparam T_OBJECT object contained in the octree.  Keep small as these will be copied (a lot) on insertion.
 /// @tparam T_MAXDEPTH maximum depth (levels of nodes).  If 5 or less the octree will use less memory (16bit node indices)
@@ -55,6 +70,14 @@ class Octree : public OctreeBase
 public:
     typedef T_OBJECT tObject;
 
+    /// Object (and its bounds) to be added by Build.
+    struct BuildObject
+    {
+        glm::vec4   Position;
+        glm::vec4   Size;       ///< NOT a half size
+        T_OBJECT    Object;
+    };
+
     /// Constructor
     /// @param center Center position of the octree (nodes will split in 3 dimensions around this center)
     /// @param octreeSize Dimensions of octree (not halfsize)
@@ -68,14 +91,44 @@ public:
     /// @note SLOW
     void AddObject( const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/, T_OBJECT&& object );
 
+    /// Build the octree from the given objects, replacing any existing contents.
+    /// O(n log n); calculates the octree cell 'path' of each object (as a Morton style key), sorts and then emits the nodes and objects linearly.
+    /// Resulting layout is identical to calling AddObject for each object in turn (in the order given).
+    void Build( std::vector<BuildObject>&& objects );
+
     /// Query against this octree and output all contained objects. 
     template<typename T_TEST, typename T_OUTPUT>
     void Query( const T_TEST& testFn, T_OUTPUT&& outputFn ) const;
 
+    /// Query against this octree and output all contained objects.
+    /// Same results as Query but the test function is called once per octree node and tests all 8 cells of the node in one batch (so the test can be vectorized, eg PackedFrustumTest).
+    /// @tparam T_TEST must provide void TestCells( const glm::vec4& nodeCenter, const glm::vec4& cellHalfSize, std::array<eQueryResult, 8>& results ) const
+    template<typename T_TEST, typename T_OUTPUT>
+    void QueryCells( const T_TEST& testFn, T_OUTPUT&& outputFn ) const;
+
+    /// Buffers used by QueryParallel (one per top level cell).  Can be kept by the caller between queries to avoid re-allocating.
+    typedef std::array<std::vector<T_OBJECT>, 8> tParallelQueryBuffers;
+
+    /// Query against this octree using the worker threads and append all contained objects to 'output'.
+    /// Each top level cell is queried as a seperate job (in to its own buffer), buffers are then merged so the output order is the same as Query (deterministic).
+    /// Waits for the jobs to complete before returning.  Must not be called from one of the worker's threads (may deadlock).
+    /// @param testFn must be safe to call from multiple threads at once.
+    template<typename T_TEST>
+    void QueryParallel( CWorker& worker, const T_TEST& testFn, std::vector<T_OBJECT>& output ) const;
+    template<typename T_TEST>
+    void QueryParallel( CWorker& worker, const T_TEST& testFn, std::vector<T_OBJECT>& output, tParallelQueryBuffers& buffers ) const;
+
+    /// Query against multiple test functions (eg main view, shadow cascades, reflection) in a single traversal of the octree.
+    /// Cells are only tested against the tests where the parent cell was 'partial'.
+    /// @param testFns up to 32 test functions
+    /// @param outputFn called once for each object visible to any of the tests, as outputFn( const T_OBJECT&, uint32_t testMask ) where bit n of testMask is set if the object passed testFns[n].
+    template<typename T_TEST, typename T_OUTPUT>
+    void QueryMulti( const tcb::span<const T_TEST> testFns, T_OUTPUT&& outputFn ) const;
+
 private:
 
     // Gives the cell 'index' (octant) based upon the sign of the 3 axis.  Returns 0-7 (inclusive).
-    uint8_t CalcCellIndex( const glm::vec4& pos )
+    static uint8_t CalcCellIndex( const glm::vec4& pos )
     {
         uint8_t cellIndex = 0;
         if( pos.x >= 0.0f )
@@ -96,9 +149,38 @@ private:
     // Internal (recurive) implementations
     uint32_t AddObject( uint32_t nodeIdx, uint32_t objectIdx, int depth, const glm::vec4& relativePosition, const glm::vec4& scaledObjectSize/* doubled as we go down each level!*/, T_OBJECT&& object );
 
+    // Build helpers.
+    // Build key is 4 bits per octree level (most significant bits are the top level), each 4 bits is the cell index (0-7) the object goes in to at that level or cBuildKeyNoCell if the object does not go down to that level.
+    // Sorting on the key gives the (depth first) object ordering that Query expects.
+    static constexpr uint64_t cBuildKeyNoCell = 0xf;
+    static constexpr uint32_t BuildKeyShift( uint32_t depth ) { return 60 - depth * 4; }
+    static uint32_t BuildKeyCell( uint64_t key, uint32_t depth ) { return (uint32_t) ((key >> BuildKeyShift( depth )) & cBuildKeyNoCell); }
+    uint64_t CalcBuildKey( const glm::vec4& objectPosition, const glm::vec4& objectSize ) const;
+    tNodeCount BuildNode( uint32_t nodeIdx, uint32_t depth, const std::vector<uint64_t>& sortedKeys, uint32_t objectIdx, uint32_t objectEndIdx );
+
     template<typename T_TEST, typename T_OUTPUT>
     void Query( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t objectEndIdx/*index of end of m_Object span for this node and all the nodes below*/, glm::vec4 center, glm::vec4 halfSize ) const;
 
+    template<typename T_TEST, typename T_OUTPUT>
+    void QueryCell( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t cell, glm::vec4 center, glm::vec4 halfSize ) const;
+
+    template<typename T_TEST, typename T_OUTPUT>
+    void QueryMulti( const tcb::span<const T_TEST> testFns, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t objectEndIdx, glm::vec4 center, glm::vec4 halfSize, uint32_t partialMask, uint32_t insideMask ) const;
+
+    static uint32_t CountTrailingZeros( uint32_t v )
+    {
+        uint32_t count = 0;
+        while( (v & 1) == 0 )
+        {
+            v >>= 1;
+            ++count;
+        }
+        return count;
+    }
+
+    template<typename T_TEST, typename T_OUTPUT>
+    void QueryCells( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t objectEndIdx, glm::vec4 center, glm::vec4 halfSize ) const;
+
 private:
     std::vector<Node>       m_Nodes;
     std::vector<T_OBJECT>   m_Objects;
@@ -192,6 +274,99 @@ uint32_t Octree<T_OBJECT, T_MAXDEPTH>::AddObject(uint32_t nodeIdx, uint32_t obje
     return numNewNodes;
 }
 
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+void Octree<T_OBJECT, T_MAXDEPTH>::Build( std::vector<BuildObject>&& objects )
+{
+    static_assert(T_MAXDEPTH < 16, "Octree::Build key only has space for 16 levels of cells");
+
+    // Calculate the key for every object.  Key is paired with the object index so the sort is stable (objects in the same cell stay in the order they were passed in, same as AddObject).
+    std::vector<std::pair<uint64_t, uint32_t>> keysAndIndices;
+    keysAndIndices.reserve( objects.size() );
+    for( uint32_t i = 0; i < (uint32_t) objects.size(); ++i )
+    {
+        keysAndIndices.push_back( {CalcBuildKey( objects[i].Position, objects[i].Size ), i} );
+    }
+    std::sort( keysAndIndices.begin(), keysAndIndices.end() );
+
+    // Objects go in to m_Objects in key order.
+    std::vector<uint64_t> sortedKeys;
+    sortedKeys.reserve( keysAndIndices.size() );
+    m_Objects.clear();
+    m_Objects.reserve( std::max( m_Objects.capacity(), objects.size() ) );
+    for( const auto& keyAndIndex : keysAndIndices )
+    {
+        sortedKeys.push_back( keyAndIndex.first );
+        m_Objects.push_back( std::move( objects[keyAndIndex.second].Object ) );
+    }
+
+    // Emit the nodes (depth first, parent before children).
+    m_Nodes.clear();
+    m_Nodes.push_back( Node{} );
+    BuildNode( 0, 0, sortedKeys, 0, (uint32_t) m_Objects.size() );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+uint64_t Octree<T_OBJECT, T_MAXDEPTH>::CalcBuildKey( const glm::vec4& objectPosition, const glm::vec4& objectSize/*NOT a half size*/ ) const
+{
+    uint64_t key = ~0ull;   // all levels 'no cell'
+
+    if( objectSize.x < m_HalfSize.x && objectSize.y < m_HalfSize.y && objectSize.z < m_HalfSize.z )
+    {
+        // Follows the same path down the octree as AddObject (so the resulting layout matches).
+        glm::vec4 relativePosition = objectPosition - m_Center;
+        glm::vec4 scaledObjectSize = objectSize * 2.0f;
+        for( uint32_t depth = 0; ; ++depth )
+        {
+            const uint8_t cellIndex = CalcCellIndex( relativePosition );
+            key &= ~(cBuildKeyNoCell << BuildKeyShift( depth ));
+            key |= (uint64_t) cellIndex << BuildKeyShift( depth );
+
+            if( depth >= T_MAXDEPTH || !(scaledObjectSize.x < m_HalfSize.x && scaledObjectSize.y < m_HalfSize.y && scaledObjectSize.z < m_HalfSize.z) )
+            {
+                break;
+            }
+            relativePosition = 2.0f * relativePosition - m_HalfSize * sCellOffsets[cellIndex];
+            scaledObjectSize *= 2.0f;
+        }
+    }
+    // else object too big to go in to any cells (key left as 'no cell' so it sorts to the very end of m_Objects, same as AddObject).
+    return key;
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+typename Octree<T_OBJECT, T_MAXDEPTH>::tNodeCount Octree<T_OBJECT, T_MAXDEPTH>::BuildNode( uint32_t nodeIdx, uint32_t depth, const std::vector<uint64_t>& sortedKeys, uint32_t objectIdx, uint32_t objectEndIdx )
+{
+    // Build in to a local as m_Nodes may be reallocated by the recursion.
+    Node node{};
+    tNodeCount nodeCount = 0;
+    uint32_t cellObjectEndIdx = objectIdx;
+
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        const uint32_t cellObjectIdx = cellObjectEndIdx;
+        while( cellObjectEndIdx < objectEndIdx && BuildKeyCell( sortedKeys[cellObjectEndIdx], depth ) == cell )
+        {
+            ++cellObjectEndIdx;
+        }
+
+        // Keys are sorted so if any object in this cell goes down another level the first one does.
+        if( cellObjectIdx != cellObjectEndIdx && depth < T_MAXDEPTH && BuildKeyCell( sortedKeys[cellObjectIdx], depth + 1 ) != cBuildKeyNoCell )
+        {
+            const uint32_t childNodeIdx = (uint32_t) m_Nodes.size();
+            assert( childNodeIdx == nodeIdx + 1 + nodeCount );
+            m_Nodes.push_back( Node{} );
+            nodeCount += 1 + BuildNode( childNodeIdx, depth + 1, sortedKeys, cellObjectIdx, cellObjectEndIdx );
+        }
+
+        node.ChildObjectCountTotal[cell] = cellObjectEndIdx - objectIdx;
+        node.ChildNodeCountTotal[cell] = nodeCount;
+    }
+    // Anything remaining (cellObjectEndIdx to objectEndIdx) sits at this node's level.
+
+    m_Nodes[nodeIdx] = node;
+    return nodeCount;
+}
+
 template<typename T_OBJECT, uint32_t T_MAXDEPTH>
 template<typename T_TEST, typename T_OUTPUT>
 void Octree<T_OBJECT, T_MAXDEPTH>::Query(const T_TEST& testFn, T_OUTPUT&& outputFn) const
@@ -208,65 +383,266 @@ void Octree<T_OBJECT, T_MAXDEPTH>::Query(const T_TEST& testFn, T_OUTPUT&& output
 
     for( uint32_t cell = 0; cell < 8; ++cell )
     {
-        const uint32_t childObjectOffset = (cell>0) ? node.ChildObjectCountTotal[cell-1] : 0;
-        uint32_t childObjectIdx = objectIdx + childObjectOffset;
-        const uint32_t childObjectEndIdx = objectIdx + node.ChildObjectCountTotal[cell];//end of m_Objects range for the child.  Exclusive.
+        QueryCell( testFn, outputFn, nodeIdx, objectIdx, cell, center, halfSize );
+    }
 
-        if( childObjectIdx == childObjectEndIdx )
+    // output everything that is at the current node level (ie not at a lower level).
+    // These objects are after any objects in child nodes.
+    uint32_t childObjectIdx = objectIdx + node.ChildObjectCountTotal[7];
+    while( childObjectIdx < objectEndIdx )
+    {
+        outputFn( m_Objects[childObjectIdx] );
+        ++childObjectIdx;
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryCell( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t cell, glm::vec4 center, glm::vec4 halfSize/*of the cell*/ ) const
+{
+    const Node& node = m_Nodes[nodeIdx];
+
+    const uint32_t childObjectOffset = (cell>0) ? node.ChildObjectCountTotal[cell-1] : 0;
+    uint32_t childObjectIdx = objectIdx + childObjectOffset;
+    const uint32_t childObjectEndIdx = objectIdx + node.ChildObjectCountTotal[cell];//end of m_Objects range for the child.  Exclusive.
+
+    if( childObjectIdx == childObjectEndIdx )
+    {
+        // No need to test anything if there are no objects in this cell.
+        return;
+    }
+
+    // Get the center co-ordinates of this cell.
+    const auto cellCenter = center + sCellOffsets[cell] * halfSize;
+
+    // Call our user supplied 'test' function for this cell.
+    switch( testFn( cellCenter, halfSize ) )
+    {
+    case eQueryResult::Inside:  // The cell is completely 'inside' the test area.
+    {
+        // Output everything under this node!
+        while( childObjectIdx < childObjectEndIdx )
         {
-            // No need to test anything if there are no objects in this cell.
-            continue;
+            outputFn( m_Objects[childObjectIdx] );
+            ++childObjectIdx;
         }
+        break;
+    }
+    case eQueryResult::Partial: // The cell is 'partially' inside the test area.
+    {
+        // Recurse down a level to see if we can reject some of the smaller cells.
+        uint32_t childNodeOffset = (cell > 0) ? node.ChildNodeCountTotal[cell - 1] : 0;
+        const uint32_t childNodeCount = node.ChildNodeCountTotal[cell] - childNodeOffset;
+        const uint32_t childNodeIdx = nodeIdx + 1/*skip the node we are processing*/ + childNodeOffset;
 
-        // Get the center co-ordinates of this cell.
-        const auto cellCenter = center + sCellOffsets[cell] * halfSize;
-
-        // Call our user supplied 'test' function for this cell.
-        switch( testFn( cellCenter, halfSize ) )
+        if( childNodeCount != 0 )
         {
-        case eQueryResult::Inside:  // The cell is completely 'inside' the test area.
+            // Recurse in to this cell's child node.
+            Query( testFn, outputFn, childNodeIdx, childObjectIdx, childObjectEndIdx, cellCenter, halfSize );
+        }
+        else
         {
-            // Output everything under this node!
+            // No nodes below this.  Output all the objects for this cell.
             while( childObjectIdx < childObjectEndIdx )
             {
                 outputFn( m_Objects[childObjectIdx] );
                 ++childObjectIdx;
             }
-            break;
         }
-        case eQueryResult::Partial: // The cell is 'partially' inside the test area.
+        break;
+    }
+    case eQueryResult::Outside: // The cell is completely outside the test area.
+    {
+        // Reject everything!
+        break;
+    }
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryParallel( CWorker& worker, const T_TEST& testFn, std::vector<T_OBJECT>& output ) const
+{
+    tParallelQueryBuffers buffers;
+    QueryParallel( worker, testFn, output, buffers );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryParallel( CWorker& worker, const T_TEST& testFn, std::vector<T_OBJECT>& output, tParallelQueryBuffers& buffers ) const
+{
+    // One job per (non empty) top level cell.  Each job writes to its own buffer.
+    const Node& rootNode = m_Nodes[0];
+    uint32_t cellMask = 0;
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        buffers[cell].clear();
+        const uint32_t childObjectOffset = (cell > 0) ? rootNode.ChildObjectCountTotal[cell - 1] : 0;
+        if( rootNode.ChildObjectCountTotal[cell] != childObjectOffset )
         {
-            // Recurse down a level to see if we can reject some of the smaller cells.
-            uint32_t childNodeOffset = (cell > 0) ? node.ChildNodeCountTotal[cell - 1] : 0;
-            const uint32_t childNodeCount = node.ChildNodeCountTotal[cell] - childNodeOffset;
-            const uint32_t childNodeIdx = nodeIdx + 1/*skip the node we are processing*/ + childNodeOffset;
+            cellMask |= 1u << cell;
+        }
+    }
 
-            if( childNodeCount != 0 )
+    struct JobParams
+    {
+        const Octree*           pOctree;
+        const T_TEST*           pTestFn;
+        tParallelQueryBuffers*  pBuffers;
+    } jobParams{ this, &testFn, &buffers };
+
+    if( !RunCellJobs( worker, cellMask, []( void* pParam, uint32_t cell ) {
+            const JobParams& params = *static_cast<const JobParams*>(pParam);
+            std::vector<T_OBJECT>& jobOutput = (*params.pBuffers)[cell];
+            params.pOctree->QueryCell( *params.pTestFn, [&jobOutput]( const T_OBJECT& object ) { jobOutput.push_back( object ); }, 0, 0, cell, params.pOctree->m_Center, params.pOctree->m_HalfSize * 0.5f );
+        }, &jobParams ) )
+    {
+        // No threads to run on, do the query on this thread.
+        Query( testFn, [&output]( const T_OBJECT& object ) { output.push_back( object ); } );
+        return;
+    }
+
+    // Merge in cell order, followed by the top level objects (same order as Query)
+    const uint32_t topLevelObjectIdx = rootNode.ChildObjectCountTotal[7];
+    size_t outputSize = output.size() + (m_Objects.size() - topLevelObjectIdx);
+    for( const auto& buffer : buffers )
+    {
+        outputSize += buffer.size();
+    }
+    output.reserve( outputSize );
+    for( const auto& buffer : buffers )
+    {
+        output.insert( output.end(), buffer.begin(), buffer.end() );
+    }
+    output.insert( output.end(), m_Objects.begin() + topLevelObjectIdx, m_Objects.end() );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryMulti( const tcb::span<const T_TEST> testFns, T_OUTPUT&& outputFn ) const
+{
+    assert( testFns.size() <= 32 );
+    const uint32_t allTestsMask = testFns.size() >= 32 ? ~0u : ((1u << testFns.size()) - 1);
+    QueryMulti( testFns, outputFn, 0, 0, (uint32_t) m_Objects.size(), m_Center, m_HalfSize, allTestsMask, 0 );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryMulti( const tcb::span<const T_TEST> testFns, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t objectEndIdx, glm::vec4 center, glm::vec4 halfSize, uint32_t partialMask, uint32_t insideMask ) const
+{
+    halfSize *= 0.5f;
+    const Node& node = m_Nodes[nodeIdx];
+
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        const uint32_t childObjectOffset = (cell > 0) ? node.ChildObjectCountTotal[cell - 1] : 0;
+        uint32_t childObjectIdx = objectIdx + childObjectOffset;
+        const uint32_t childObjectEndIdx = objectIdx + node.ChildObjectCountTotal[cell];
+
+        if( childObjectIdx == childObjectEndIdx )
+        {
+            continue;
+        }
+
+        const auto cellCenter = center + sCellOffsets[cell] * halfSize;
+
+        // Only the tests that were 'partial' for the parent need to test this cell (parent inside means child inside, parent outside means child outside).
+        uint32_t cellPartialMask = 0;
+        uint32_t cellInsideMask = insideMask;
+        for( uint32_t testMask = partialMask; testMask != 0; testMask &= testMask - 1 )
+        {
+            const uint32_t testIdx = CountTrailingZeros( testMask );
+            switch( testFns[testIdx]( cellCenter, halfSize ) )
             {
-                // Recurse in to this cell's child node.
-                Query( testFn, outputFn, nodeIdx + 1 + childNodeOffset, childObjectIdx, childObjectEndIdx, cellCenter, halfSize );
+            case eQueryResult::Inside:
+                cellInsideMask |= 1u << testIdx;
+                break;
+            case eQueryResult::Partial:
+                cellPartialMask |= 1u << testIdx;
+                break;
+            case eQueryResult::Outside:
+                break;
             }
-            else
+        }
+
+        const uint32_t childNodeOffset = (cell > 0) ? node.ChildNodeCountTotal[cell - 1] : 0;
+        const uint32_t childNodeCount = node.ChildNodeCountTotal[cell] - childNodeOffset;
+
+        if( cellPartialMask != 0 && childNodeCount != 0 )
+        {
+            // Recurse in to this cell's child node.
+            QueryMulti( testFns, outputFn, nodeIdx + 1 + childNodeOffset, childObjectIdx, childObjectEndIdx, cellCenter, halfSize, cellPartialMask, cellInsideMask );
+        }
+        else if( (cellPartialMask | cellInsideMask) != 0 )
+        {
+            // Output everything in this cell
+            const uint32_t cellMask = cellPartialMask | cellInsideMask;
+            while( childObjectIdx < childObjectEndIdx )
             {
-                // No nodes below this.  Output all the objects for this cell.
-                while( childObjectIdx < childObjectEndIdx )
-                {
-                    outputFn( m_Objects[childObjectIdx] );
-                    ++childObjectIdx;
-                }
+                outputFn( m_Objects[childObjectIdx], cellMask );
+                ++childObjectIdx;
             }
-            break;
         }
-        case eQueryResult::Outside: // The cell is completely outside the test area.
+    }
+
+    // output everything that is at the current node level (ie not at a lower level).
+    uint32_t childObjectIdx = objectIdx + node.ChildObjectCountTotal[7];
+    while( childObjectIdx < objectEndIdx )
+    {
+        outputFn( m_Objects[childObjectIdx], partialMask | insideMask );
+        ++childObjectIdx;
+    }
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryCells( const T_TEST& testFn, T_OUTPUT&& outputFn ) const
+{
+    QueryCells( testFn, outputFn, 0, 0, (uint32_t) m_Objects.size(), m_Center, m_HalfSize );
+}
+
+template<typename T_OBJECT, uint32_t T_MAXDEPTH>
+template<typename T_TEST, typename T_OUTPUT>
+void Octree<T_OBJECT, T_MAXDEPTH>::QueryCells( const T_TEST& testFn, T_OUTPUT&& outputFn, uint32_t nodeIdx, uint32_t objectIdx, uint32_t objectEndIdx/*index of end of m_Object span for this node and all the nodes below*/, glm::vec4 center, glm::vec4 halfSize ) const
+{
+    halfSize *= 0.5f;
+    const Node& node = m_Nodes[nodeIdx];
+
+    // Test all 8 cells in one go (even the empty ones, cheaper than branching when vectorized).
+    std::array<eQueryResult, 8> cellResults;
+    testFn.TestCells( center, halfSize, cellResults );
+
+    for( uint32_t cell = 0; cell < 8; ++cell )
+    {
+        const uint32_t childObjectOffset = (cell > 0) ? node.ChildObjectCountTotal[cell - 1] : 0;
+        uint32_t childObjectIdx = objectIdx + childObjectOffset;
+        const uint32_t childObjectEndIdx = objectIdx + node.ChildObjectCountTotal[cell];
+
+        if( childObjectIdx == childObjectEndIdx || cellResults[cell] == eQueryResult::Outside )
         {
-            // Reject everything!
-            break;
+            continue;
         }
+
+        const uint32_t childNodeOffset = (cell > 0) ? node.ChildNodeCountTotal[cell - 1] : 0;
+        const uint32_t childNodeCount = node.ChildNodeCountTotal[cell] - childNodeOffset;
+
+        if( cellResults[cell] == eQueryResult::Partial && childNodeCount != 0 )
+        {
+            // Recurse in to this cell's child node.
+            QueryCells( testFn, outputFn, nodeIdx + 1 + childNodeOffset, childObjectIdx, childObjectEndIdx, center + sCellOffsets[cell] * halfSize, halfSize );
+        }
+        else
+        {
+            // Cell is inside (or partially inside with nothing below to test) output everything.
+            while( childObjectIdx < childObjectEndIdx )
+            {
+                outputFn( m_Objects[childObjectIdx] );
+                ++childObjectIdx;
+            }
         }
     }
 
     // output everything that is at the current node level (ie not at a lower level).
-    // These objects are after any objects in child nodes.
     uint32_t childObjectIdx = objectIdx + node.ChildObjectCountTotal[7];
     while( childObjectIdx < objectEndIdx )
     {
@@ -514,3 +890,91 @@ struct FrustumTest
 
     const ViewFrustum& m_Frustum;
 };
+
+
+/// Helper frustum test functor, vectorized (SSE/NEON) version of FrustumTest.
+/// Frustum planes are stored packed (one array per plane component) so a single plane can be tested against 4 cells at once.
+/// Works with Octree::Query (one cell per call) and Octree::QueryCells (all 8 cells of a node per call).
+/// Each box is tested in center/extent form (distance of the center from the plane +/- the box extent projected on to the plane normal) rather than FrustumTest's 8 corners.
+/// The test is conservative, not identical to FrustumTest: like FrustumTest it only rejects boxes entirely outside one plane (so boxes near the frustum corners can be Partial when they are outside),
+/// and boxes touching a plane (eg at the near plane) can be classified differently from FrustumTest because the distances are rounded differently.
+/// @ingroup Mesh
+class PackedFrustumTest
+{
+public:
+    PackedFrustumTest( const ViewFrustum& frustum )
+    {
+        const auto& planes = frustum.GetPlanes();
+        for( uint32_t i = 0; i < cNumPlanes; ++i )
+        {
+            m_PlaneX[i] = planes[i].x;
+            m_PlaneY[i] = planes[i].y;
+            m_PlaneZ[i] = planes[i].z;
+            m_PlaneW[i] = planes[i].w;
+        }
+    }
+
+    /// Test a single box (cell)
+    OctreeBase::eQueryResult operator()( const glm::vec4& center, const glm::vec4& halfSize ) const
+    {
+        bool partial = false;
+        for( uint32_t i = 0; i < cNumPlanes; ++i )
+        {
+            // Distance of the box center from the plane and the 'radius' of the box projected on to the plane normal.
+            const float dist = m_PlaneX[i] * center.x + m_PlaneY[i] * center.y + m_PlaneZ[i] * center.z + m_PlaneW[i];
+            const float radius = std::abs( m_PlaneX[i] ) * halfSize.x + std::abs( m_PlaneY[i] ) * halfSize.y + std::abs( m_PlaneZ[i] ) * halfSize.z;
+            if( dist + radius < 0.0f )
+                return OctreeBase::eQueryResult::Outside;   // every corner is outside this plane
+            if( dist - radius < 0.0f )
+                partial = true;
+        }
+        return partial ? OctreeBase::eQueryResult::Partial : OctreeBase::eQueryResult::Inside;
+    }
+
+    /// Test the 8 cells (2x2x2 grid, in sCellOffsets order) making up an octree node.
+    /// @param nodeCenter center of the octree node
+    /// @param cellHalfSize half size of each of the 8 cells (ie quarter size of the node)
+    void TestCells( const glm::vec4& nodeCenter, const glm::vec4& cellHalfSize, std::array<OctreeBase::eQueryResult, 8>& results ) const
+    {
+        using namespace Simd;
+        const Float4 zero = Set1( 0.0f );
+
+        // Cells 0-3 are at -z, cells 4-7 at +z; x and y are the same pattern for both halves.
+        const Float4 cellX = MulAdd( Set( -1.0f, 1.0f, -1.0f, 1.0f ), Set1( cellHalfSize.x ), Set1( nodeCenter.x ) );
+        const Float4 cellY = MulAdd( Set( -1.0f, -1.0f, 1.0f, 1.0f ), Set1( cellHalfSize.y ), Set1( nodeCenter.y ) );
+        const float cellZLo = nodeCenter.z - cellHalfSize.z;
+        const float cellZHi = nodeCenter.z + cellHalfSize.z;
+
+        Mask4 outsideLo = CmpLt( zero, zero ), outsideHi = outsideLo;
+        Mask4 partialLo = outsideLo, partialHi = outsideLo;
+
+        for( uint32_t i = 0; i < cNumPlanes; ++i )
+        {
+            const Float4 distXY = MulAdd( Set1( m_PlaneX[i] ), cellX, MulAdd( Set1( m_PlaneY[i] ), cellY, Set1( m_PlaneW[i] ) ) );
+            const Float4 distLo = Add( distXY, Set1( m_PlaneZ[i] * cellZLo ) );
+            const Float4 distHi = Add( distXY, Set1( m_PlaneZ[i] * cellZHi ) );
+            // All cells are the same size so the projected radius is the same for all of them.
+            const Float4 radius = Set1( std::abs( m_PlaneX[i] ) * cellHalfSize.x + std::abs( m_PlaneY[i] ) * cellHalfSize.y + std::abs( m_PlaneZ[i] ) * cellHalfSize.z );
+
+            outsideLo = Or( outsideLo, CmpLt( Add( distLo, radius ), zero ) );
+            outsideHi = Or( outsideHi, CmpLt( Add( distHi, radius ), zero ) );
+            partialLo = Or( partialLo, CmpLt( Sub( distLo, radius ), zero ) );
+            partialHi = Or( partialHi, CmpLt( Sub( distHi, radius ), zero ) );
+        }
+
+        const uint32_t outsideBits = MoveMask( outsideLo ) | (MoveMask( outsideHi ) << 4);
+        const uint32_t partialBits = MoveMask( partialLo ) | (MoveMask( partialHi ) << 4);
+        for( uint32_t cell = 0; cell < 8; ++cell )
+        {
+            const uint32_t cellBit = 1 << cell;
+            results[cell] = (outsideBits & cellBit) ? OctreeBase::eQueryResult::Outside : ((partialBits & cellBit) ? OctreeBase::eQueryResult::Partial : OctreeBase::eQueryResult::Inside);
+        }
+    }
+
+private:
+    static constexpr uint32_t cNumPlanes = 6;
+    float m_PlaneX[cNumPlanes];
+    float m_PlaneY[cNumPlanes];
+    float m_PlaneZ[cNumPlanes];
+    float m_PlaneW[cNumPlanes];
+};
@@ -11,7 +11,10 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <queue>
+#include <string>
+#include <tuple>
 #include <cassert>
 
 #if !defined(MAX_CPU_CORES)
@@ -0,0 +1,117 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "rangeAllocator.hpp"
+#include <cassert>
+#include <iterator>
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::Initialize(size_t size)
+{
+    m_FreeByOffset.clear();
+    m_FreeBySize.clear();
+    m_Size = size;
+    m_FreeSize = 0;
+    if (size > 0)
+    {
+        AddFreeRange(0, size);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t RangeAllocator::Allocate(size_t size)
+{
+    if (size == 0)
+    {
+        return cInvalidOffset;
+    }
+    auto sizeIt = m_FreeBySize.lower_bound(size);
+    if (sizeIt == m_FreeBySize.end())
+    {
+        return cInvalidOffset;
+    }
+    const size_t freeOffset = sizeIt->second;
+    const size_t freeSize = sizeIt->first;
+
+    RemoveFreeRange(m_FreeByOffset.find(freeOffset));
+    if (freeSize > size)
+    {
+        // Leftover from the end of the range goes back on the free list.
+        AddFreeRange(freeOffset + size, freeSize - size);
+    }
+    return freeOffset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+    if (size == 0 || offset == cInvalidOffset)
+    {
+        return;
+    }
+    assert(offset + size <= m_Size);
+
+    // Merge with the free range after this one
+    auto nextIt = m_FreeByOffset.lower_bound(offset);
+    assert(nextIt == m_FreeByOffset.end() || nextIt->first >= offset + size);    // freeing a range that is (partially) already free
+    if (nextIt != m_FreeByOffset.end() && nextIt->first == offset + size)
+    {
+        size += nextIt->second;
+        auto eraseIt = nextIt++;
+        RemoveFreeRange(eraseIt);
+    }
+
+    // Merge with the free range before this one
+    if (nextIt != m_FreeByOffset.begin())
+    {
+        auto prevIt = std::prev(nextIt);
+        assert(prevIt->first + prevIt->second <= offset);
+        if (prevIt->first + prevIt->second == offset)
+        {
+            offset = prevIt->first;
+            size += prevIt->second;
+            RemoveFreeRange(prevIt);
+        }
+    }
+
+    AddFreeRange(offset, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::AddFreeRange(size_t offset, size_t size)
+{
+    m_FreeByOffset.emplace(offset, size);
+    m_FreeBySize.emplace(size, offset);
+    m_FreeSize += size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::RemoveFreeRange(std::map<size_t, size_t>::iterator offsetIt)
+{
+    assert(offsetIt != m_FreeByOffset.end());
+    const size_t offset = offsetIt->first;
+    const size_t size = offsetIt->second;
+
+    // Find the matching size entry (ranges of the same size are adjacent in the multimap).
+    auto [sizeBegin, sizeEnd] = m_FreeBySize.equal_range(size);
+    for (auto sizeIt = sizeBegin; sizeIt != sizeEnd; ++sizeIt)
+    {
+        if (sizeIt->second == offset)
+        {
+            m_FreeBySize.erase(sizeIt);
+            break;
+        }
+    }
+    m_FreeByOffset.erase(offsetIt);
+    m_FreeSize -= size;
+}
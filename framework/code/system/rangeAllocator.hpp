@@ -0,0 +1,55 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+/// Free-list allocator of ranges within a fixed size (abstract) space, eg elements of a buffer.
+/// Allocations are best fit (smallest free range that is large enough) and freed ranges are merged with their free neighbours.
+/// Only tracks offsets; owns no memory.  Not thread safe.
+class RangeAllocator
+{
+public:
+    static constexpr size_t cInvalidOffset = SIZE_MAX;
+
+    RangeAllocator() = default;
+    explicit RangeAllocator(size_t size) { Initialize(size); }
+
+    /// (Re)initialize the allocator with one free range covering [0, size).  Forgets any existing allocations.
+    void Initialize(size_t size);
+
+    /// Allocate a range of the given size.
+    /// @returns offset of the start of the range, cInvalidOffset if there is no free range large enough (or size is 0)
+    size_t Allocate(size_t size);
+
+    /// Return a range (offset and size as passed to/returned from Allocate) to the free list.
+    void Free(size_t offset, size_t size);
+
+    /// @returns total size being managed
+    size_t GetSize() const { return m_Size; }
+    /// @returns total size of all the free ranges
+    size_t GetFreeSize() const { return m_FreeSize; }
+    /// @returns size of the largest free range (the largest allocation that would currently succeed)
+    size_t GetLargestFreeRange() const { return m_FreeBySize.empty() ? 0 : m_FreeBySize.rbegin()->first; }
+    /// @returns number of free ranges (a measure of fragmentation)
+    size_t GetNumFreeRanges() const { return m_FreeByOffset.size(); }
+    /// @returns true if nothing is allocated
+    bool IsEmpty() const { return m_FreeSize == m_Size; }
+
+protected:
+    void AddFreeRange(size_t offset, size_t size);
+    void RemoveFreeRange(std::map<size_t, size_t>::iterator offsetIt);
+
+protected:
+    std::map<size_t, size_t>        m_FreeByOffset;     ///< free range offset -> size (for merging neighbours)
+    std::multimap<size_t, size_t>   m_FreeBySize;       ///< free range size -> offset (for best fit)
+    size_t                          m_Size = 0;
+    size_t                          m_FreeSize = 0;
+};
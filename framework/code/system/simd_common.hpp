@@ -0,0 +1,147 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+//
+/// @file simd_common.hpp
+/// @ingroup System
+// Minimal 4 wide float SIMD wrapper.
+// Uses NEON on ARM (Android), SSE2 on x86/x64 (Windows) and falls back to scalar code elsewhere.
+// Only contains the operations the framework needs; not intended as a general purpose vector library (use glm for that).
+//
+
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON_A64 1
+#endif
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#define SIMD_SCALAR 1
+#include <cmath>
+#endif
+
+namespace Simd
+{
+
+#if defined(SIMD_NEON)
+
+typedef float32x4_t Float4;
+typedef uint32x4_t  Mask4;
+
+inline Float4   Load( const float* p )                          { return vld1q_f32( p ); }
+inline void     Store( float* p, Float4 a )                     { vst1q_f32( p, a ); }
+inline Float4   Set1( float a )                                 { return vdupq_n_f32( a ); }
+inline Float4   Set( float a, float b, float c, float d )       { const float v[4] = {a, b, c, d}; return vld1q_f32( v ); }
+inline Float4   Add( Float4 a, Float4 b )                       { return vaddq_f32( a, b ); }
+inline Float4   Sub( Float4 a, Float4 b )                       { return vsubq_f32( a, b ); }
+inline Float4   Mul( Float4 a, Float4 b )                       { return vmulq_f32( a, b ); }
+inline Float4   MulAdd( Float4 a, Float4 b, Float4 c )          { return vmlaq_f32( c, a, b ); }  ///< a*b+c
+inline Float4   Min( Float4 a, Float4 b )                       { return vminq_f32( a, b ); }
+inline Float4   Max( Float4 a, Float4 b )                       { return vmaxq_f32( a, b ); }
+inline Float4   Abs( Float4 a )                                 { return vabsq_f32( a ); }
+inline Float4   Select( Mask4 m, Float4 a, Float4 b )           { return vbslq_f32( m, a, b ); }  ///< m ? a : b
+inline Mask4    CmpLt( Float4 a, Float4 b )                     { return vcltq_f32( a, b ); }
+inline Mask4    CmpLe( Float4 a, Float4 b )                     { return vcleq_f32( a, b ); }
+inline Mask4    CmpGt( Float4 a, Float4 b )                     { return vcgtq_f32( a, b ); }
+inline Mask4    Or( Mask4 a, Mask4 b )                          { return vorrq_u32( a, b ); }
+inline Mask4    And( Mask4 a, Mask4 b )                         { return vandq_u32( a, b ); }
+inline Mask4    AndNot( Mask4 a, Mask4 b )                      { return vbicq_u32( b, a ); }     ///< ~a & b
+/// @returns 4 bit mask with bit n set if lane n of the mask is set.
+inline uint32_t MoveMask( Mask4 m )
+{
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vandq_u32( m, vld1q_u32( laneBits ) );
+    return vgetq_lane_u32( bits, 0 ) | vgetq_lane_u32( bits, 1 ) | vgetq_lane_u32( bits, 2 ) | vgetq_lane_u32( bits, 3 );
+}
+#if defined(SIMD_NEON_A64)
+inline Float4   Div( Float4 a, Float4 b )                       { return vdivq_f32( a, b ); }
+inline Float4   Sqrt( Float4 a )                                { return vsqrtq_f32( a ); }
+#else
+inline Float4   Div( Float4 a, Float4 b )
+{
+    // Reciprocal estimate with 2 Newton-Raphson steps (no divide on 32bit NEON)
+    Float4 r = vrecpeq_f32( b );
+    r = vmulq_f32( vrecpsq_f32( b, r ), r );
+    r = vmulq_f32( vrecpsq_f32( b, r ), r );
+    return vmulq_f32( a, r );
+}
+inline Float4   Sqrt( Float4 a )
+{
+    Float4 r = vrsqrteq_f32( a );
+    r = vmulq_f32( vrsqrtsq_f32( vmulq_f32( a, r ), r ), r );
+    r = vmulq_f32( vrsqrtsq_f32( vmulq_f32( a, r ), r ), r );
+    return vbslq_f32( vceqq_f32( a, vdupq_n_f32( 0.0f ) ), a, vmulq_f32( a, r ) );
+}
+#endif
+
+#elif defined(SIMD_SSE)
+
+typedef __m128      Float4;
+typedef __m128      Mask4;
+
+inline Float4   Load( const float* p )                          { return _mm_loadu_ps( p ); }
+inline void     Store( float* p, Float4 a )                     { _mm_storeu_ps( p, a ); }
+inline Float4   Set1( float a )                                 { return _mm_set1_ps( a ); }
+inline Float4   Set( float a, float b, float c, float d )       { return _mm_setr_ps( a, b, c, d ); }
+inline Float4   Add( Float4 a, Float4 b )                       { return _mm_add_ps( a, b ); }
+inline Float4   Sub( Float4 a, Float4 b )                       { return _mm_sub_ps( a, b ); }
+inline Float4   Mul( Float4 a, Float4 b )                       { return _mm_mul_ps( a, b ); }
+inline Float4   MulAdd( Float4 a, Float4 b, Float4 c )          { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }  ///< a*b+c
+inline Float4   Div( Float4 a, Float4 b )                       { return _mm_div_ps( a, b ); }
+inline Float4   Sqrt( Float4 a )                                { return _mm_sqrt_ps( a ); }
+inline Float4   Min( Float4 a, Float4 b )                       { return _mm_min_ps( a, b ); }
+inline Float4   Max( Float4 a, Float4 b )                       { return _mm_max_ps( a, b ); }
+inline Float4   Abs( Float4 a )                                 { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+inline Float4   Select( Mask4 m, Float4 a, Float4 b )           { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }  ///< m ? a : b
+inline Mask4    CmpLt( Float4 a, Float4 b )                     { return _mm_cmplt_ps( a, b ); }
+inline Mask4    CmpLe( Float4 a, Float4 b )                     { return _mm_cmple_ps( a, b ); }
+inline Mask4    CmpGt( Float4 a, Float4 b )                     { return _mm_cmpgt_ps( a, b ); }
+inline Mask4    Or( Mask4 a, Mask4 b )                          { return _mm_or_ps( a, b ); }
+inline Mask4    And( Mask4 a, Mask4 b )                         { return _mm_and_ps( a, b ); }
+inline Mask4    AndNot( Mask4 a, Mask4 b )                      { return _mm_andnot_ps( a, b ); }  ///< ~a & b
+/// @returns 4 bit mask with bit n set if lane n of the mask is set.
+inline uint32_t MoveMask( Mask4 m )                             { return (uint32_t) _mm_movemask_ps( m ); }
+
+#else // SIMD_SCALAR
+
+struct Float4 { float v[4]; };
+struct Mask4 { uint32_t v[4]; };
+
+#define SIMD_SCALAR_OP(RET, EXPR) RET r; for( int i = 0; i < 4; ++i ) { r.v[i] = (EXPR); } return r;
+inline Float4   Load( const float* p )                          { SIMD_SCALAR_OP( Float4, p[i] ) }
+inline void     Store( float* p, Float4 a )                     { for( int i = 0; i < 4; ++i ) p[i] = a.v[i]; }
+inline Float4   Set1( float a )                                 { return Float4{ {a, a, a, a} }; }
+inline Float4   Set( float a, float b, float c, float d )       { return Float4{ {a, b, c, d} }; }
+inline Float4   Add( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] + b.v[i] ) }
+inline Float4   Sub( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] - b.v[i] ) }
+inline Float4   Mul( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] * b.v[i] ) }
+inline Float4   MulAdd( Float4 a, Float4 b, Float4 c )          { SIMD_SCALAR_OP( Float4, a.v[i] * b.v[i] + c.v[i] ) }
+inline Float4   Div( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] / b.v[i] ) }
+inline Float4   Sqrt( Float4 a )                                { SIMD_SCALAR_OP( Float4, std::sqrt( a.v[i] ) ) }
+inline Float4   Min( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] < b.v[i] ? a.v[i] : b.v[i] ) }
+inline Float4   Max( Float4 a, Float4 b )                       { SIMD_SCALAR_OP( Float4, a.v[i] > b.v[i] ? a.v[i] : b.v[i] ) }
+inline Float4   Abs( Float4 a )                                 { SIMD_SCALAR_OP( Float4, std::fabs( a.v[i] ) ) }
+inline Float4   Select( Mask4 m, Float4 a, Float4 b )           { SIMD_SCALAR_OP( Float4, m.v[i] ? a.v[i] : b.v[i] ) }
+inline Mask4    CmpLt( Float4 a, Float4 b )                     { SIMD_SCALAR_OP( Mask4, a.v[i] < b.v[i] ? ~0u : 0u ) }
+inline Mask4    CmpLe( Float4 a, Float4 b )                     { SIMD_SCALAR_OP( Mask4, a.v[i] <= b.v[i] ? ~0u : 0u ) }
+inline Mask4    CmpGt( Float4 a, Float4 b )                     { SIMD_SCALAR_OP( Mask4, a.v[i] > b.v[i] ? ~0u : 0u ) }
+inline Mask4    Or( Mask4 a, Mask4 b )                          { SIMD_SCALAR_OP( Mask4, a.v[i] | b.v[i] ) }
+inline Mask4    And( Mask4 a, Mask4 b )                         { SIMD_SCALAR_OP( Mask4, a.v[i] & b.v[i] ) }
+inline Mask4    AndNot( Mask4 a, Mask4 b )                      { SIMD_SCALAR_OP( Mask4, ~a.v[i] & b.v[i] ) }
+inline uint32_t MoveMask( Mask4 m )                             { return (m.v[0] ? 1u : 0u) | (m.v[1] ? 2u : 0u) | (m.v[2] ? 4u : 0u) | (m.v[3] ? 8u : 0u); }
+#undef SIMD_SCALAR_OP
+
+#endif
+
+} // namespace Simd
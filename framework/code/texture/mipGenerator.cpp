@@ -0,0 +1,317 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "mipGenerator.hpp"
+#include "system/simd_common.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+
+// Kaiser filter: taps per output texel (in each direction), half width of the window (in output texels) and window shape.
+static constexpr int cKaiserTaps = 8;
+static constexpr float cKaiserHalfWidth = 2.0f;
+static constexpr float cKaiserAlpha = 4.0f;
+
+// Size of the linear to sRGB lookup table (linear values are quantized to this many steps).
+static constexpr uint32_t cLinearToSrgbTableSize = 4096;
+
+// Largest scale applied to a mip level's alpha when preserving alpha coverage.
+static constexpr float cMaxAlphaCoverageScale = 16.0f;
+
+namespace
+{
+    // Rgba floating point image, one 4 float texel per SIMD vector (unused channels are zero).
+    struct FloatImage
+    {
+        uint32_t            Width = 0;
+        uint32_t            Height = 0;
+        std::vector<float>  Texels;
+        float* Row(uint32_t y) { return Texels.data() + size_t(y) * Width * 4; }
+        const float* Row(uint32_t y) const { return Texels.data() + size_t(y) * Width * 4; }
+    };
+
+    const std::array<float, 256>& SrgbToLinearTable()
+    {
+        static const std::array<float, 256> table = []() {
+            std::array<float, 256> t;
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                const float c = float(i) / 255.0f;
+                t[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    const std::array<uint8_t, cLinearToSrgbTableSize>& LinearToSrgbTable()
+    {
+        static const std::array<uint8_t, cLinearToSrgbTableSize> table = []() {
+            std::array<uint8_t, cLinearToSrgbTableSize> t;
+            for (uint32_t i = 0; i < cLinearToSrgbTableSize; ++i)
+            {
+                const float l = float(i) / float(cLinearToSrgbTableSize - 1);
+                const float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                t[i] = (uint8_t)std::clamp(int(c * 255.0f + 0.5f), 0, 255);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    // Modified Bessel function of the first kind (order 0), for the Kaiser window.
+    float BesselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        const float halfX2 = 0.25f * x * x;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= halfX2 / float(k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Weights for the source texels (2*x - cKaiserTaps/2 + 1) ... (2*x + cKaiserTaps/2) contributing to output texel x.  Normalized.
+    const std::array<float, cKaiserTaps>& KaiserWeights()
+    {
+        static const std::array<float, cKaiserTaps> weights = []() {
+            std::array<float, cKaiserTaps> w;
+            float total = 0.0f;
+            for (int tap = 0; tap < cKaiserTaps; ++tap)
+            {
+                // Distance (in output texels) from the output texel center to the source texel center.
+                const float d = (float(tap - cKaiserTaps / 2 + 1) - 0.5f) * 0.5f;
+                const float pd = 3.14159265f * d;
+                const float sinc = (std::abs(d) < 1e-6f) ? 1.0f : std::sin(pd) / pd;
+                const float r = d / cKaiserHalfWidth;
+                const float window = (std::abs(r) >= 1.0f) ? 0.0f : BesselI0(cKaiserAlpha * std::sqrt(1.0f - r * r)) / BesselI0(cKaiserAlpha);
+                w[tap] = sinc * window;
+                total += w[tap];
+            }
+            for (auto& weight : w)
+                weight /= total;
+            return w;
+        }();
+        return weights;
+    }
+
+    FloatImage DownsampleBox(const FloatImage& src)
+    {
+        using namespace Simd;
+        FloatImage dst;
+        dst.Width = std::max(1u, src.Width / 2);
+        dst.Height = std::max(1u, src.Height / 2);
+        dst.Texels.resize(size_t(dst.Width) * dst.Height * 4);
+
+        const Float4 quarter = Set1(0.25f);
+        for (uint32_t y = 0; y < dst.Height; ++y)
+        {
+            const float* pRow0 = src.Row(std::min(y * 2, src.Height - 1));
+            const float* pRow1 = src.Row(std::min(y * 2 + 1, src.Height - 1));
+            float* pDst = dst.Row(y);
+            for (uint32_t x = 0; x < dst.Width; ++x)
+            {
+                const size_t x0 = size_t(std::min(x * 2, src.Width - 1)) * 4;
+                const size_t x1 = size_t(std::min(x * 2 + 1, src.Width - 1)) * 4;
+                const Float4 sum = Add(Add(Load(pRow0 + x0), Load(pRow0 + x1)), Add(Load(pRow1 + x0), Load(pRow1 + x1)));
+                Store(pDst + x * 4, Mul(sum, quarter));
+            }
+        }
+        return dst;
+    }
+
+    FloatImage DownsampleKaiser(const FloatImage& src)
+    {
+        using namespace Simd;
+        const auto& weights = KaiserWeights();
+
+        // Horizontal pass (src.Width -> dst.Width) in to a temporary, then vertical (src.Height -> dst.Height).
+        FloatImage horizontal;
+        horizontal.Width = std::max(1u, src.Width / 2);
+        horizontal.Height = src.Height;
+        horizontal.Texels.resize(size_t(horizontal.Width) * horizontal.Height * 4);
+
+        const auto ClampIndex = [](int i, uint32_t size) -> size_t {
+            return size_t(std::clamp(i, 0, int(size) - 1));
+        };
+
+        for (uint32_t y = 0; y < src.Height; ++y)
+        {
+            const float* pSrc = src.Row(y);
+            float* pDst = horizontal.Row(y);
+            for (uint32_t x = 0; x < horizontal.Width; ++x)
+            {
+                const int first = int(x * 2) - cKaiserTaps / 2 + 1;
+                Float4 acc = Set1(0.0f);
+                for (int tap = 0; tap < cKaiserTaps; ++tap)
+                    acc = MulAdd(Load(pSrc + ClampIndex(first + tap, src.Width) * 4), Set1(weights[tap]), acc);
+                Store(pDst + x * 4, acc);
+            }
+        }
+
+        FloatImage dst;
+        dst.Width = horizontal.Width;
+        dst.Height = std::max(1u, src.Height / 2);
+        dst.Texels.resize(size_t(dst.Width) * dst.Height * 4);
+
+        const Float4 zero = Set1(0.0f);
+        const Float4 one = Set1(1.0f);
+        for (uint32_t y = 0; y < dst.Height; ++y)
+        {
+            const int first = int(y * 2) - cKaiserTaps / 2 + 1;
+            const float* pSrcRows[cKaiserTaps];
+            for (int tap = 0; tap < cKaiserTaps; ++tap)
+                pSrcRows[tap] = horizontal.Row((uint32_t)ClampIndex(first + tap, horizontal.Height));
+            float* pDst = dst.Row(y);
+            for (uint32_t x = 0; x < dst.Width; ++x)
+            {
+                Float4 acc = Set1(0.0f);
+                for (int tap = 0; tap < cKaiserTaps; ++tap)
+                    acc = MulAdd(Load(pSrcRows[tap] + x * 4), Set1(weights[tap]), acc);
+                // Negative lobes can ring outside of the valid range; clamp so it does not accumulate down the chain.
+                Store(pDst + x * 4, Min(Max(acc, zero), one));
+            }
+        }
+        return dst;
+    }
+
+    // Fraction of texels with (scaled) alpha passing the alpha test (alpha >= cutoff, ie 'discard if alpha < cutoff').
+    float CalcAlphaCoverage(const FloatImage& image, float cutoff, float alphaScale)
+    {
+        const size_t numTexels = size_t(image.Width) * image.Height;
+        size_t covered = 0;
+        for (size_t i = 0; i < numTexels; ++i)
+            if (image.Texels[i * 4 + 3] * alphaScale >= cutoff)
+                ++covered;
+        return float(covered) / float(numTexels);
+    }
+
+    // Find the alpha scale that gives the closest coverage to targetCoverage.
+    // Coverage is a step function of the scale so rather than searching, scale so the texel at the target coverage quantile lands exactly on the cutoff.
+    float FindAlphaCoverageScale(const FloatImage& image, float cutoff, float targetCoverage)
+    {
+        const size_t numTexels = size_t(image.Width) * image.Height;
+        const size_t numCovered = std::min(numTexels, size_t(targetCoverage * float(numTexels) + 0.5f));
+        if (numCovered == 0)
+            return cutoff > 0.0f ? 0.0f : 1.0f;
+
+        std::vector<float> alphas(numTexels);
+        for (size_t i = 0; i < numTexels; ++i)
+            alphas[i] = image.Texels[i * 4 + 3];
+        // numCovered'th largest alpha.
+        auto nth = alphas.begin() + (numCovered - 1);
+        std::nth_element(alphas.begin(), nth, alphas.end(), std::greater<float>());
+        const float nthAlpha = *nth;
+
+        // Texels with the same alpha all pass (or fail) together; if excluding them gets closer to the target then put the cutoff on the next larger alpha.
+        size_t numGreater = 0;
+        size_t numEqual = 0;
+        float nextAlpha = 0.0f;
+        for (float alpha : alphas)
+        {
+            if (alpha > nthAlpha)
+            {
+                nextAlpha = (numGreater == 0) ? alpha : std::min(nextAlpha, alpha);
+                ++numGreater;
+            }
+            else if (alpha == nthAlpha)
+                ++numEqual;
+        }
+        const float targetCount = targetCoverage * float(numTexels);
+        const float thresholdAlpha = (numGreater > 0 && std::abs(float(numGreater) - targetCount) < std::abs(float(numGreater + numEqual) - targetCount)) ? nextAlpha : nthAlpha;
+        if (thresholdAlpha <= 0.0f)
+            return cMaxAlphaCoverageScale;
+        return std::min(cutoff / thresholdAlpha, cMaxAlphaCoverageScale);
+    }
+
+    MipLevelData ToMipLevel(const FloatImage& image, uint32_t channels, bool srgb, float alphaScale)
+    {
+        using namespace Simd;
+        const auto& linearToSrgb = LinearToSrgbTable();
+        const uint32_t numColorChannels = (channels == 4 || channels == 2) ? channels - 1 : channels;   // 2 channel images are treated as luminance/alpha
+
+        MipLevelData level;
+        level.Width = image.Width;
+        level.Height = image.Height;
+        level.Data.resize(size_t(image.Width) * image.Height * channels);
+
+        const Float4 zero = Set1(0.0f);
+        const Float4 one = Set1(1.0f);
+        const Float4 scale = (channels == 4) ? Set(1.0f, 1.0f, 1.0f, alphaScale) : one;
+        const size_t numTexels = size_t(image.Width) * image.Height;
+        uint8_t* pDst = level.Data.data();
+        for (size_t i = 0; i < numTexels; ++i)
+        {
+            float texel[4];
+            Store(texel, Min(Max(Mul(Load(image.Texels.data() + i * 4), scale), zero), one));
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                if (srgb && c < numColorChannels)
+                    *pDst++ = linearToSrgb[uint32_t(texel[c] * float(cLinearToSrgbTableSize - 1) + 0.5f)];
+                else
+                    *pDst++ = (uint8_t)(texel[c] * 255.0f + 0.5f);
+            }
+        }
+        return level;
+    }
+}
+
+uint32_t CalcMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+std::vector<MipLevelData> GenerateMipChain(const uint8_t* pData, uint32_t width, uint32_t height, uint32_t channels, const MipGenerationSettings& settings)
+{
+    if (pData == nullptr || width == 0 || height == 0 || channels < 1 || channels > 4)
+        return {};
+    const uint32_t numLevels = std::min(CalcMipLevelCount(width, height), settings.MaxMipLevels);
+    if (numLevels <= 1)
+        return {};
+
+    // Expand level 0 to linear rgba floats.
+    const auto& srgbToLinear = SrgbToLinearTable();
+    const uint32_t numColorChannels = (channels == 4 || channels == 2) ? channels - 1 : channels;
+    FloatImage image;
+    image.Width = width;
+    image.Height = height;
+    image.Texels.resize(size_t(width) * height * 4, 0.0f);
+    const size_t numTexels = size_t(width) * height;
+    for (size_t i = 0; i < numTexels; ++i)
+    {
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            const uint8_t value = pData[i * channels + c];
+            image.Texels[i * 4 + c] = (settings.Srgb && c < numColorChannels) ? srgbToLinear[value] : float(value) * (1.0f / 255.0f);
+        }
+    }
+
+    const bool preserveCoverage = channels == 4 && settings.AlphaCoverageCutoff >= 0.0f;
+    const float targetCoverage = preserveCoverage ? CalcAlphaCoverage(image, settings.AlphaCoverageCutoff, 1.0f) : 0.0f;
+
+    std::vector<MipLevelData> levels;
+    levels.reserve(numLevels - 1);
+    for (uint32_t level = 1; level < numLevels; ++level)
+    {
+        // Each level is filtered from the previous (unquantized and unscaled) level.
+        image = (settings.Filter == MipFilter::Kaiser) ? DownsampleKaiser(image) : DownsampleBox(image);
+        const float alphaScale = preserveCoverage ? FindAlphaCoverageScale(image, settings.AlphaCoverageCutoff, targetCoverage) : 1.0f;
+        levels.push_back(ToMipLevel(image, channels, settings.Srgb, alphaScale));
+    }
+    return levels;
+}
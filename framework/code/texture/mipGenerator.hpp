@@ -0,0 +1,53 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+/// @defgroup Texture
+/// Cpu side texture processing (no graphics api calls, safe to use from worker threads and testable without a device).
+
+#include <cstdint>
+#include <vector>
+
+/// Filter used when downsampling to the next mip level.
+/// @ingroup Texture
+enum class MipFilter
+{
+    Box,        ///< 2x2 average (fast)
+    Kaiser,     ///< Kaiser windowed sinc, 8 taps in each direction (sharper, less aliasing)
+};
+
+/// Settings for @GenerateMipChain
+/// @ingroup Texture
+struct MipGenerationSettings
+{
+    MipFilter   Filter = MipFilter::Box;
+    bool        Srgb = false;                   ///< color channels are sRGB encoded (filtered in linear space).  Alpha (4th channel) is always linear.
+    float       AlphaCoverageCutoff = -1.0f;    ///< if >= 0 scale each mip's alpha so the fraction of texels passing an alpha test (alpha >= cutoff) matches level 0 (eg 0.5 for alphaCutout materials).  4 channel images only.
+    uint32_t    MaxMipLevels = 0xffffffff;      ///< maximum levels in the chain (including level 0)
+};
+
+/// One mip level of 8 bit per channel texel data (tightly packed)
+/// @ingroup Texture
+struct MipLevelData
+{
+    uint32_t                Width = 0;
+    uint32_t                Height = 0;
+    std::vector<uint8_t>    Data;
+};
+
+/// @returns number of levels in a full mip chain (down to 1x1) for the given level 0 dimensions
+/// @ingroup Texture
+uint32_t CalcMipLevelCount(uint32_t width, uint32_t height);
+
+/// Generate the mip chain for an 8 bit per channel image.
+/// Each level is filtered from the (floating point) previous level, with one texel per SIMD vector.  Mip dimensions are halved (rounding down, minimum 1) each level.
+/// @param pData level 0 texels (tightly packed)
+/// @param channels number of 8 bit channels per texel (1 to 4)
+/// @returns mip levels 1 onwards (level 0 is not copied), empty if the image has no mips or the parameters are invalid
+/// @ingroup Texture
+std::vector<MipLevelData> GenerateMipChain(const uint8_t* pData, uint32_t width, uint32_t height, uint32_t channels, const MipGenerationSettings& settings);
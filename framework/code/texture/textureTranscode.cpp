@@ -0,0 +1,792 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "textureTranscode.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Block decoders.  Each decodes a 4x4 block to 16 rgba texels (row major).
+    typedef uint8_t tBlockTexels[16][4];
+
+    enum class BlockCodec
+    {
+        None,           // not block compressed (rgb expanded to rgba)
+        Bc1Rgb,
+        Bc1Rgba,
+        Bc2,
+        Bc3,
+        Bc4,
+        Bc5,
+        Etc2Rgb,
+        Etc2RgbA1,
+        Etc2Rgba,
+    };
+
+    struct TranscodeDesc
+    {
+        BlockCodec  Codec = BlockCodec::None;
+        uint32_t    SourceBytes = 0;        // bytes per block (or per texel if not block compressed)
+        VkFormat    Target = VK_FORMAT_UNDEFINED;
+        uint32_t    TargetChannels = 0;
+        VkFormat    BlockTarget = VK_FORMAT_UNDEFINED;  // block compressed format it can be re-encoded to (if any)
+    };
+
+    TranscodeDesc GetTranscodeDesc(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8G8B8_UNORM:            return { BlockCodec::None, 3, VK_FORMAT_R8G8B8A8_UNORM, 4 };
+        case VK_FORMAT_R8G8B8_SRGB:             return { BlockCodec::None, 3, VK_FORMAT_R8G8B8A8_SRGB, 4 };
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:     return { BlockCodec::Bc1Rgb, 8, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK };
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:      return { BlockCodec::Bc1Rgb, 8, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK };
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:    return { BlockCodec::Bc1Rgba, 8, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK };
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:     return { BlockCodec::Bc1Rgba, 8, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK };
+        case VK_FORMAT_BC2_UNORM_BLOCK:         return { BlockCodec::Bc2, 16, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK };
+        case VK_FORMAT_BC2_SRGB_BLOCK:          return { BlockCodec::Bc2, 16, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK };
+        case VK_FORMAT_BC3_UNORM_BLOCK:         return { BlockCodec::Bc3, 16, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK };
+        case VK_FORMAT_BC3_SRGB_BLOCK:          return { BlockCodec::Bc3, 16, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK };
+        case VK_FORMAT_BC4_UNORM_BLOCK:         return { BlockCodec::Bc4, 8, VK_FORMAT_R8_UNORM, 1 };
+        case VK_FORMAT_BC5_UNORM_BLOCK:         return { BlockCodec::Bc5, 16, VK_FORMAT_R8G8_UNORM, 2 };
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:     return { BlockCodec::Etc2Rgb, 8, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_BC1_RGB_UNORM_BLOCK };
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:      return { BlockCodec::Etc2Rgb, 8, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_BC1_RGB_SRGB_BLOCK };
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:   return { BlockCodec::Etc2RgbA1, 8, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_BC3_UNORM_BLOCK };
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:    return { BlockCodec::Etc2RgbA1, 8, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_BC3_SRGB_BLOCK };
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:   return { BlockCodec::Etc2Rgba, 16, VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_BC3_UNORM_BLOCK };
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:    return { BlockCodec::Etc2Rgba, 16, VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_BC3_SRGB_BLOCK };
+        default:
+            return {};
+        }
+    }
+
+    uint8_t Clamp255(int value)
+    {
+        return (uint8_t)std::clamp(value, 0, 255);
+    }
+
+    void SetTexel(uint8_t* pTexel, int r, int g, int b, int a)
+    {
+        pTexel[0] = Clamp255(r);
+        pTexel[1] = Clamp255(g);
+        pTexel[2] = Clamp255(b);
+        pTexel[3] = Clamp255(a);
+    }
+
+    //
+    // BC (S3TC/RGTC)
+    //
+
+    void Decode565(uint16_t color, int* pRgb)
+    {
+        const int r = (color >> 11) & 31;
+        const int g = (color >> 5) & 63;
+        const int b = color & 31;
+        pRgb[0] = (r << 3) | (r >> 2);
+        pRgb[1] = (g << 2) | (g >> 4);
+        pRgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 color block (also the color part of BC2 and BC3, which always use the 4 color mode).
+    void DecodeBc1Color(const uint8_t* pBlock, BlockCodec codec, tBlockTexels& texels)
+    {
+        const uint16_t c0 = uint16_t(pBlock[0] | (pBlock[1] << 8));
+        const uint16_t c1 = uint16_t(pBlock[2] | (pBlock[3] << 8));
+        int colors[4][4];
+        Decode565(c0, colors[0]);
+        Decode565(c1, colors[1]);
+        colors[0][3] = colors[1][3] = colors[2][3] = colors[3][3] = 255;
+        const bool fourColor = c0 > c1 || (codec != BlockCodec::Bc1Rgb && codec != BlockCodec::Bc1Rgba);
+        for (int c = 0; c < 3; ++c)
+        {
+            if (fourColor)
+            {
+                colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+                colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+            }
+            else
+            {
+                colors[2][c] = (colors[0][c] + colors[1][c]) / 2;
+                colors[3][c] = 0;
+            }
+        }
+        if (!fourColor && codec == BlockCodec::Bc1Rgba)
+            colors[3][3] = 0;   // transparent black
+
+        const uint32_t indices = pBlock[4] | (pBlock[5] << 8) | (pBlock[6] << 16) | (uint32_t(pBlock[7]) << 24);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const int* pColor = colors[(indices >> (i * 2)) & 3];
+            SetTexel(texels[i], pColor[0], pColor[1], pColor[2], pColor[3]);
+        }
+    }
+
+    // BC3 alpha / BC4 / BC5 channel block (8 bytes) in to the given channel of each texel.
+    void DecodeBc4Channel(const uint8_t* pBlock, uint32_t channel, tBlockTexels& texels)
+    {
+        const int a0 = pBlock[0];
+        const int a1 = pBlock[1];
+        int values[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int k = 1; k < 7; ++k)
+                values[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+        }
+        else
+        {
+            for (int k = 1; k < 5; ++k)
+                values[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+            values[6] = 0;
+            values[7] = 255;
+        }
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i)
+            indices |= uint64_t(pBlock[2 + i]) << (i * 8);
+        for (uint32_t i = 0; i < 16; ++i)
+            texels[i][channel] = (uint8_t)values[(indices >> (i * 3)) & 7];
+    }
+
+    // BC2 explicit 4 bit alpha
+    void DecodeBc2Alpha(const uint8_t* pBlock, tBlockTexels& texels)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t alpha = (pBlock[i / 2] >> ((i & 1) * 4)) & 15;
+            texels[i][3] = (uint8_t)(alpha * 17);
+        }
+    }
+
+    //
+    // ETC2 / EAC
+    // Texel indices are stored column major (texel x,y is bit x*4+y) and multi byte fields are big endian.
+    //
+
+    static constexpr int cEtcModifiers[8][2] = { {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183} };
+    static constexpr int cEtcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+    static constexpr int cEacModifiers[16][8] = {
+        {-3, -6, -9, -15, 2, 5, 8, 14},
+        {-3, -7, -10, -13, 2, 6, 9, 12},
+        {-2, -5, -8, -13, 1, 4, 7, 12},
+        {-2, -4, -6, -13, 1, 3, 5, 12},
+        {-3, -6, -8, -12, 2, 5, 7, 11},
+        {-3, -7, -9, -11, 2, 6, 8, 10},
+        {-4, -7, -8, -11, 3, 6, 7, 10},
+        {-3, -5, -8, -11, 2, 4, 7, 10},
+        {-2, -6, -8, -10, 1, 5, 7, 9},
+        {-2, -5, -8, -10, 1, 4, 7, 9},
+        {-2, -4, -8, -10, 1, 3, 7, 9},
+        {-2, -5, -7, -10, 1, 4, 6, 9},
+        {-3, -4, -7, -10, 2, 3, 6, 9},
+        {-1, -2, -3, -10, 0, 1, 2, 9},
+        {-4, -6, -8, -9, 3, 5, 7, 8},
+        {-3, -5, -7, -9, 2, 4, 6, 8},
+    };
+
+    int Extend4(int value) { return value * 17; }
+    int Extend5(int value) { return (value << 3) | (value >> 2); }
+    int Extend6(int value) { return (value << 2) | (value >> 4); }
+    int Extend7(int value) { return (value << 1) | (value >> 6); }
+    int SignExtend3(int value) { return (value & 4) ? value - 8 : value; }
+
+    // ETC1/ETC2 color block.  punchThrough for ETC2 RGB8A1 (where the 'diff' bit is the opaque flag and there is no individual mode).
+    void DecodeEtc2Color(const uint8_t* pBlock, bool punchThrough, tBlockTexels& texels)
+    {
+        const uint32_t indexBits = (uint32_t(pBlock[4]) << 24) | (pBlock[5] << 16) | (pBlock[6] << 8) | pBlock[7];
+        const auto TexelIndex = [indexBits](uint32_t x, uint32_t y) -> uint32_t {
+            const uint32_t bit = x * 4 + y;
+            return (((indexBits >> (bit + 16)) & 1) << 1) | ((indexBits >> bit) & 1);
+        };
+        const bool diffBit = (pBlock[3] & 2) != 0;
+        const bool opaque = !punchThrough || diffBit;
+
+        // T and H modes: each texel index picks one of 4 'paint' colors.
+        const auto PaintTexels = [&](const int (&paint)[4][3]) {
+            for (uint32_t y = 0; y < 4; ++y)
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t index = TexelIndex(x, y);
+                    if (!opaque && index == 2)
+                        SetTexel(texels[y * 4 + x], 0, 0, 0, 0);
+                    else
+                        SetTexel(texels[y * 4 + x], paint[index][0], paint[index][1], paint[index][2], 255);
+                }
+        };
+
+        int base[2][3];
+        if (!punchThrough && !diffBit)
+        {
+            // Individual mode (two 444 base colors)
+            for (int c = 0; c < 3; ++c)
+            {
+                base[0][c] = Extend4(pBlock[c] >> 4);
+                base[1][c] = Extend4(pBlock[c] & 15);
+            }
+        }
+        else
+        {
+            const int r = pBlock[0] >> 3, r2 = r + SignExtend3(pBlock[0] & 7);
+            const int g = pBlock[1] >> 3, g2 = g + SignExtend3(pBlock[1] & 7);
+            const int b = pBlock[2] >> 3, b2 = b + SignExtend3(pBlock[2] & 7);
+            if (r2 < 0 || r2 > 31)
+            {
+                // T mode
+                const int c0[3] = { Extend4((((pBlock[0] >> 3) & 3) << 2) | (pBlock[0] & 3)), Extend4(pBlock[1] >> 4), Extend4(pBlock[1] & 15) };
+                const int c1[3] = { Extend4(pBlock[2] >> 4), Extend4(pBlock[2] & 15), Extend4(pBlock[3] >> 4) };
+                const int distance = cEtcDistances[(((pBlock[3] >> 2) & 3) << 1) | (pBlock[3] & 1)];
+                int paint[4][3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    paint[0][c] = c0[c];
+                    paint[1][c] = c1[c] + distance;
+                    paint[2][c] = c1[c];
+                    paint[3][c] = c1[c] - distance;
+                }
+                PaintTexels(paint);
+                return;
+            }
+            if (g2 < 0 || g2 > 31)
+            {
+                // H mode
+                const int c0Packed[3] = { (pBlock[0] >> 3) & 15, ((pBlock[0] & 7) << 1) | ((pBlock[1] >> 4) & 1), (pBlock[1] & 8) | ((pBlock[1] & 3) << 1) | (pBlock[2] >> 7) };
+                const int c1Packed[3] = { (pBlock[2] >> 3) & 15, ((pBlock[2] & 7) << 1) | (pBlock[3] >> 7), (pBlock[3] >> 3) & 15 };
+                const int order = ((c0Packed[0] << 8) | (c0Packed[1] << 4) | c0Packed[2]) >= ((c1Packed[0] << 8) | (c1Packed[1] << 4) | c1Packed[2]) ? 1 : 0;
+                const int distance = cEtcDistances[(pBlock[3] & 4) | ((pBlock[3] & 1) << 1) | order];
+                int paint[4][3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    paint[0][c] = Extend4(c0Packed[c]) + distance;
+                    paint[1][c] = Extend4(c0Packed[c]) - distance;
+                    paint[2][c] = Extend4(c1Packed[c]) + distance;
+                    paint[3][c] = Extend4(c1Packed[c]) - distance;
+                }
+                PaintTexels(paint);
+                return;
+            }
+            if (b2 < 0 || b2 > 31)
+            {
+                // Planar mode (always opaque)
+                const int origin[3] = {
+                    Extend6((pBlock[0] >> 1) & 63),
+                    Extend7(((pBlock[0] & 1) << 6) | ((pBlock[1] >> 1) & 63)),
+                    Extend6(((pBlock[1] & 1) << 5) | (((pBlock[2] >> 3) & 3) << 3) | ((pBlock[2] & 3) << 1) | (pBlock[3] >> 7)) };
+                const int horizontal[3] = {
+                    Extend6((((pBlock[3] >> 2) & 31) << 1) | (pBlock[3] & 1)),
+                    Extend7(pBlock[4] >> 1),
+                    Extend6(((pBlock[4] & 1) << 5) | (pBlock[5] >> 3)) };
+                const int vertical[3] = {
+                    Extend6(((pBlock[5] & 7) << 3) | (pBlock[6] >> 5)),
+                    Extend7(((pBlock[6] & 31) << 2) | (pBlock[7] >> 6)),
+                    Extend6(pBlock[7] & 63) };
+                for (int y = 0; y < 4; ++y)
+                    for (int x = 0; x < 4; ++x)
+                    {
+                        int rgb[3];
+                        for (int c = 0; c < 3; ++c)
+                            rgb[c] = (x * (horizontal[c] - origin[c]) + y * (vertical[c] - origin[c]) + 4 * origin[c] + 2) >> 2;
+                        SetTexel(texels[y * 4 + x], rgb[0], rgb[1], rgb[2], 255);
+                    }
+                return;
+            }
+            // Differential mode (555 base color and 333 delta)
+            base[0][0] = Extend5(r); base[0][1] = Extend5(g); base[0][2] = Extend5(b);
+            base[1][0] = Extend5(r2); base[1][1] = Extend5(g2); base[1][2] = Extend5(b2);
+        }
+
+        // Individual and differential modes: two sub blocks (2x4 side by side, or 4x2 stacked if the flip bit is set) each with a base color and modifier table.
+        const bool flip = (pBlock[3] & 1) != 0;
+        const int tables[2] = { pBlock[3] >> 5, (pBlock[3] >> 2) & 7 };
+        for (uint32_t y = 0; y < 4; ++y)
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                const uint32_t subBlock = flip ? (y >= 2 ? 1 : 0) : (x >= 2 ? 1 : 0);
+                const uint32_t index = TexelIndex(x, y);
+                const int* pModifiers = cEtcModifiers[tables[subBlock]];
+                int modifier = (index & 1) ? pModifiers[1] : pModifiers[0];
+                if (index & 2)
+                    modifier = -modifier;
+                if (!opaque)
+                {
+                    if (index == 2)
+                    {
+                        SetTexel(texels[y * 4 + x], 0, 0, 0, 0);
+                        continue;
+                    }
+                    if (index == 0)
+                        modifier = 0;
+                }
+                const int* pBase = base[subBlock];
+                SetTexel(texels[y * 4 + x], pBase[0] + modifier, pBase[1] + modifier, pBase[2] + modifier, 255);
+            }
+    }
+
+    // EAC 8 bit alpha block (the first half of ETC2 RGBA8)
+    void DecodeEacAlpha(const uint8_t* pBlock, tBlockTexels& texels)
+    {
+        const int base = pBlock[0];
+        const int multiplier = pBlock[1] >> 4;
+        const int* pModifiers = cEacModifiers[pBlock[1] & 15];
+        uint64_t indices = 0;
+        for (int i = 2; i < 8; ++i)
+            indices = (indices << 8) | pBlock[i];
+        for (uint32_t x = 0; x < 4; ++x)
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                // First texel in the most significant bits.
+                const uint32_t bit = 45 - (x * 4 + y) * 3;
+                const int index = int((indices >> bit) & 7);
+                texels[y * 4 + x][3] = Clamp255(base + pModifiers[index] * multiplier);
+            }
+    }
+
+    void DecodeBlock(BlockCodec codec, const uint8_t* pBlock, tBlockTexels& texels)
+    {
+        switch (codec)
+        {
+        case BlockCodec::Bc1Rgb:
+        case BlockCodec::Bc1Rgba:
+            DecodeBc1Color(pBlock, codec, texels);
+            break;
+        case BlockCodec::Bc2:
+            DecodeBc1Color(pBlock + 8, codec, texels);
+            DecodeBc2Alpha(pBlock, texels);
+            break;
+        case BlockCodec::Bc3:
+            DecodeBc1Color(pBlock + 8, codec, texels);
+            DecodeBc4Channel(pBlock, 3, texels);
+            break;
+        case BlockCodec::Bc4:
+            DecodeBc4Channel(pBlock, 0, texels);
+            break;
+        case BlockCodec::Bc5:
+            DecodeBc4Channel(pBlock, 0, texels);
+            DecodeBc4Channel(pBlock + 8, 1, texels);
+            break;
+        case BlockCodec::Etc2Rgb:
+            DecodeEtc2Color(pBlock, false, texels);
+            break;
+        case BlockCodec::Etc2RgbA1:
+            DecodeEtc2Color(pBlock, true, texels);
+            break;
+        case BlockCodec::Etc2Rgba:
+            DecodeEtc2Color(pBlock + 8, false, texels);
+            DecodeEacAlpha(pBlock, texels);
+            break;
+        case BlockCodec::None:
+            break;
+        }
+    }
+
+    //
+    // Block encoders, for re-encoding a block format the device does not support in to one it does (decoded texels are 4-8x bigger in gpu memory).
+    // Simple and fast (fit to the block's color/alpha range), quality is below an offline compressor.
+    //
+
+    int ColorError(const uint8_t* pTexel, int r, int g, int b)
+    {
+        const int dr = pTexel[0] - r;
+        const int dg = pTexel[1] - g;
+        const int db = pTexel[2] - b;
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // BC1 color block, always 4 color mode (c0 > c1) so it is also valid as the color part of BC3.
+    // Fully transparent texels (eg ETC2 punch through) do not contribute to the endpoints, unless every texel is transparent.
+    void EncodeBc1Color(const tBlockTexels& texels, uint8_t* pBlock)
+    {
+        const bool anyVisible = std::any_of(std::begin(texels), std::end(texels), [](const uint8_t (&texel)[4]) { return texel[3] != 0; });
+        int minRgb[3] = { 255, 255, 255 };
+        int maxRgb[3] = { 0, 0, 0 };
+        for (const auto& texel : texels)
+        {
+            if (anyVisible && texel[3] == 0)
+                continue;
+            for (int c = 0; c < 3; ++c)
+            {
+                minRgb[c] = std::min(minRgb[c], int(texel[c]));
+                maxRgb[c] = std::max(maxRgb[c], int(texel[c]));
+            }
+        }
+
+        // Endpoints are the bounding box corners, inset a little (reduces the error of the interpolated colors).
+        uint16_t endpoints[2];
+        for (int e = 0; e < 2; ++e)
+        {
+            int rgb[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                const int inset = (maxRgb[c] - minRgb[c]) / 16;
+                rgb[c] = (e == 0) ? (maxRgb[c] - inset) : (minRgb[c] + inset);
+            }
+            endpoints[e] = uint16_t((((rgb[0] * 31 + 127) / 255) << 11) | (((rgb[1] * 63 + 127) / 255) << 5) | ((rgb[2] * 31 + 127) / 255));
+        }
+        const uint16_t c0 = std::max(endpoints[0], endpoints[1]);
+        const uint16_t c1 = std::min(endpoints[0], endpoints[1]);
+
+        uint32_t indices = 0;
+        if (c0 != c1)   // otherwise every texel is c0 (index 0)
+        {
+            int colors[4][3];
+            Decode565(c0, colors[0]);
+            Decode565(c1, colors[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+                colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+            }
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t bestIndex = 0;
+                int bestError = INT32_MAX;
+                for (uint32_t index = 0; index < 4; ++index)
+                {
+                    const int error = ColorError(texels[i], colors[index][0], colors[index][1], colors[index][2]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestIndex = index;
+                    }
+                }
+                indices |= bestIndex << (i * 2);
+            }
+        }
+        pBlock[0] = uint8_t(c0);
+        pBlock[1] = uint8_t(c0 >> 8);
+        pBlock[2] = uint8_t(c1);
+        pBlock[3] = uint8_t(c1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            pBlock[4 + i] = uint8_t(indices >> (i * 8));
+    }
+
+    // BC3 alpha / BC4 channel block (8 bytes) from the given channel of each texel.  Always 8 value mode (a0 > a1, or a0 == a1 where index 0 is exact).
+    void EncodeBc4Channel(const tBlockTexels& texels, uint32_t channel, uint8_t* pBlock)
+    {
+        int a0 = 0;
+        int a1 = 255;
+        for (const auto& texel : texels)
+        {
+            a0 = std::max(a0, int(texel[channel]));
+            a1 = std::min(a1, int(texel[channel]));
+        }
+        int values[8] = { a0, a1 };
+        for (int k = 1; k < 7; ++k)
+            values[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint64_t bestIndex = 0;
+            int bestError = INT32_MAX;
+            for (uint32_t index = 0; index < 8; ++index)
+            {
+                const int error = std::abs(int(texels[i][channel]) - values[index]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (i * 3);
+        }
+        pBlock[0] = uint8_t(a0);
+        pBlock[1] = uint8_t(a1);
+        for (int i = 0; i < 6; ++i)
+            pBlock[2 + i] = uint8_t(indices >> (i * 8));
+    }
+
+    // ETC1 color block (individual or differential mode), valid for ETC2 RGB8 and as the color part of ETC2 RGBA8.
+    // Tries both sub block orientations, with the sub block average colors as the base colors, and picks the best modifier table for each sub block.
+    void EncodeEtc2Color(const tBlockTexels& texels, uint8_t* pBlock)
+    {
+        uint64_t bestError = UINT64_MAX;
+        for (uint32_t flip = 0; flip < 2; ++flip)
+        {
+            const auto SubBlock = [flip](uint32_t x, uint32_t y) -> uint32_t { return flip ? (y >= 2 ? 1 : 0) : (x >= 2 ? 1 : 0); };
+
+            int average[2][3] = {};
+            for (uint32_t y = 0; y < 4; ++y)
+                for (uint32_t x = 0; x < 4; ++x)
+                    for (int c = 0; c < 3; ++c)
+                        average[SubBlock(x, y)][c] += texels[y * 4 + x][c];
+
+            // Differential mode (555 base and 333 delta) if the two averages are close enough, otherwise individual mode (two 444 bases).
+            int quantized[2][3];
+            bool differential = true;
+            for (int c = 0; c < 3; ++c)
+            {
+                for (int s = 0; s < 2; ++s)
+                {
+                    average[s][c] = (average[s][c] + 4) / 8;
+                    quantized[s][c] = (average[s][c] * 31 + 127) / 255;
+                }
+                const int delta = quantized[1][c] - quantized[0][c];
+                differential = differential && delta >= -4 && delta <= 3;
+            }
+            int base[2][3];
+            for (int s = 0; s < 2; ++s)
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (!differential)
+                        quantized[s][c] = (average[s][c] * 15 + 127) / 255;
+                    base[s][c] = differential ? Extend5(quantized[s][c]) : Extend4(quantized[s][c]);
+                }
+
+            uint64_t error = 0;
+            uint32_t indexBits = 0;
+            int tables[2] = {};
+            for (uint32_t s = 0; s < 2; ++s)
+            {
+                uint64_t bestSubError = UINT64_MAX;
+                uint32_t bestSubIndexBits = 0;
+                for (int table = 0; table < 8; ++table)
+                {
+                    uint64_t subError = 0;
+                    uint32_t subIndexBits = 0;
+                    for (uint32_t y = 0; y < 4; ++y)
+                        for (uint32_t x = 0; x < 4; ++x)
+                        {
+                            if (SubBlock(x, y) != s)
+                                continue;
+                            uint32_t bestIndex = 0;
+                            int bestTexelError = INT32_MAX;
+                            for (uint32_t index = 0; index < 4; ++index)
+                            {
+                                int modifier = cEtcModifiers[table][index & 1];
+                                if (index & 2)
+                                    modifier = -modifier;
+                                const int texelError = ColorError(texels[y * 4 + x], Clamp255(base[s][0] + modifier), Clamp255(base[s][1] + modifier), Clamp255(base[s][2] + modifier));
+                                if (texelError < bestTexelError)
+                                {
+                                    bestTexelError = texelError;
+                                    bestIndex = index;
+                                }
+                            }
+                            const uint32_t bit = x * 4 + y;
+                            subIndexBits |= ((bestIndex >> 1) << (bit + 16)) | ((bestIndex & 1) << bit);
+                            subError += bestTexelError;
+                        }
+                    if (subError < bestSubError)
+                    {
+                        bestSubError = subError;
+                        bestSubIndexBits = subIndexBits;
+                        tables[s] = table;
+                    }
+                }
+                indexBits |= bestSubIndexBits;
+                error += bestSubError;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (differential)
+                        pBlock[c] = uint8_t((quantized[0][c] << 3) | ((quantized[1][c] - quantized[0][c]) & 7));
+                    else
+                        pBlock[c] = uint8_t((quantized[0][c] << 4) | quantized[1][c]);
+                }
+                pBlock[3] = uint8_t((tables[0] << 5) | (tables[1] << 2) | (differential ? 2 : 0) | flip);
+                pBlock[4] = uint8_t(indexBits >> 24);
+                pBlock[5] = uint8_t(indexBits >> 16);
+                pBlock[6] = uint8_t(indexBits >> 8);
+                pBlock[7] = uint8_t(indexBits);
+            }
+        }
+    }
+
+    // EAC 8 bit alpha block (the first half of ETC2 RGBA8).  Fits the base and multiplier to the block's alpha range for each modifier table.
+    void EncodeEacAlpha(const tBlockTexels& texels, uint8_t* pBlock)
+    {
+        int minAlpha = 255;
+        int maxAlpha = 0;
+        int sumAlpha = 0;
+        for (const auto& texel : texels)
+        {
+            minAlpha = std::min(minAlpha, int(texel[3]));
+            maxAlpha = std::max(maxAlpha, int(texel[3]));
+            sumAlpha += texel[3];
+        }
+
+        uint64_t bestError = UINT64_MAX;
+        for (int table = 0; table < 16; ++table)
+        {
+            const int* pModifiers = cEacModifiers[table];
+            const int lowest = pModifiers[3];
+            const int highest = pModifiers[7];
+            const int idealMultiplier = (maxAlpha - minAlpha + (highest - lowest) / 2) / (highest - lowest);
+            for (int multiplier = std::max(1, idealMultiplier - 1); multiplier <= std::min(15, idealMultiplier + 1); ++multiplier)
+            {
+                const int bases[3] = { minAlpha - lowest * multiplier, (minAlpha + maxAlpha + 1) / 2, (sumAlpha + 8) / 16 };
+                for (int base : bases)
+                {
+                    base = std::clamp(base, 0, 255);
+                    uint64_t error = 0;
+                    uint64_t indices = 0;
+                    for (uint32_t x = 0; x < 4; ++x)
+                        for (uint32_t y = 0; y < 4; ++y)
+                        {
+                            uint64_t bestIndex = 0;
+                            int bestTexelError = INT32_MAX;
+                            for (uint32_t index = 0; index < 8; ++index)
+                            {
+                                const int texelError = std::abs(int(texels[y * 4 + x][3]) - int(Clamp255(base + pModifiers[index] * multiplier)));
+                                if (texelError < bestTexelError)
+                                {
+                                    bestTexelError = texelError;
+                                    bestIndex = index;
+                                }
+                            }
+                            indices |= bestIndex << (45 - (x * 4 + y) * 3);
+                            error += uint64_t(bestTexelError) * bestTexelError;
+                        }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        pBlock[0] = uint8_t(base);
+                        pBlock[1] = uint8_t((multiplier << 4) | table);
+                        for (int i = 0; i < 6; ++i)
+                            pBlock[2 + i] = uint8_t(indices >> (40 - i * 8));
+                    }
+                }
+            }
+        }
+    }
+
+    struct BlockTargetDesc
+    {
+        BlockCodec  Codec = BlockCodec::None;
+        uint32_t    Bytes = 0;      // bytes per block
+    };
+
+    BlockTargetDesc GetBlockTargetDesc(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:          return { BlockCodec::Bc1Rgb, 8 };
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:              return { BlockCodec::Bc3, 16 };
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:      return { BlockCodec::Etc2Rgb, 8 };
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:    return { BlockCodec::Etc2Rgba, 16 };
+        default:
+            return {};
+        }
+    }
+
+    void EncodeBlock(BlockCodec codec, const tBlockTexels& texels, uint8_t* pBlock)
+    {
+        switch (codec)
+        {
+        case BlockCodec::Bc1Rgb:
+            EncodeBc1Color(texels, pBlock);
+            break;
+        case BlockCodec::Bc3:
+            EncodeBc4Channel(texels, 3, pBlock);
+            EncodeBc1Color(texels, pBlock + 8);
+            break;
+        case BlockCodec::Etc2Rgb:
+            EncodeEtc2Color(texels, pBlock);
+            break;
+        case BlockCodec::Etc2Rgba:
+            EncodeEacAlpha(texels, pBlock);
+            EncodeEtc2Color(texels, pBlock + 8);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+VkFormat SelectTranscodeFormat(VkFormat sourceFormat, const std::function<bool(VkFormat)>& isFormatSupported, bool allowBlockReencode)
+{
+    if (isFormatSupported(sourceFormat))
+        return sourceFormat;
+    const TranscodeDesc desc = GetTranscodeDesc(sourceFormat);
+    if (allowBlockReencode && desc.BlockTarget != VK_FORMAT_UNDEFINED && isFormatSupported(desc.BlockTarget))
+        return desc.BlockTarget;
+    if (desc.Target != VK_FORMAT_UNDEFINED && isFormatSupported(desc.Target))
+        return desc.Target;
+    return VK_FORMAT_UNDEFINED;
+}
+
+bool TranscodeImage(VkFormat sourceFormat, VkFormat targetFormat, const uint8_t* pData, size_t dataSize, uint32_t width, uint32_t height, size_t sourceRowPitch, std::vector<uint8_t>& output)
+{
+    const TranscodeDesc desc = GetTranscodeDesc(sourceFormat);
+    if (desc.Target == VK_FORMAT_UNDEFINED || (desc.Target != targetFormat && desc.BlockTarget != targetFormat) || pData == nullptr || width == 0 || height == 0)
+        return false;
+
+    if (desc.Codec == BlockCodec::None)
+    {
+        // Expand rgb to rgba (opaque).  Source rows may be padded (KTX1 pads uncompressed rows to 4 bytes).
+        const size_t rowBytes = size_t(width) * desc.SourceBytes;
+        const size_t rowPitch = sourceRowPitch ? sourceRowPitch : rowBytes;
+        if (rowPitch < rowBytes || dataSize < rowPitch * (height - 1) + rowBytes)
+            return false;
+        output.resize(size_t(width) * height * desc.TargetChannels);
+        uint8_t* pDst = output.data();
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint8_t* pSrc = pData + y * rowPitch;
+            for (uint32_t x = 0; x < width; ++x, pSrc += 3, pDst += 4)
+            {
+                pDst[0] = pSrc[0];
+                pDst[1] = pSrc[1];
+                pDst[2] = pSrc[2];
+                pDst[3] = 255;
+            }
+        }
+        return true;
+    }
+
+    const uint32_t blocksWide = (width + 3) / 4;
+    const uint32_t blocksHigh = (height + 3) / 4;
+    if (dataSize < size_t(blocksWide) * blocksHigh * desc.SourceBytes)
+        return false;
+
+    tBlockTexels texels;
+    if (targetFormat == desc.BlockTarget)
+    {
+        // Decode each block and re-encode it in the target block format (same 4x4 block grid).
+        const BlockTargetDesc target = GetBlockTargetDesc(targetFormat);
+        output.resize(size_t(blocksWide) * blocksHigh * target.Bytes);
+        const uint8_t* pBlock = pData;
+        uint8_t* pDst = output.data();
+        for (size_t i = 0; i < size_t(blocksWide) * blocksHigh; ++i, pBlock += desc.SourceBytes, pDst += target.Bytes)
+        {
+            memset(texels, 0, sizeof(texels));
+            DecodeBlock(desc.Codec, pBlock, texels);
+            EncodeBlock(target.Codec, texels, pDst);
+        }
+        return true;
+    }
+
+    output.resize(size_t(width) * height * desc.TargetChannels);
+    const uint8_t* pBlock = pData;
+    for (uint32_t blockY = 0; blockY < blocksHigh; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksWide; ++blockX, pBlock += desc.SourceBytes)
+        {
+            memset(texels, 0, sizeof(texels));
+            DecodeBlock(desc.Codec, pBlock, texels);
+
+            // Copy the texels inside the image (edge blocks may be partially outside).
+            const uint32_t blockWidth = std::min(4u, width - blockX * 4);
+            const uint32_t blockHeight = std::min(4u, height - blockY * 4);
+            for (uint32_t y = 0; y < blockHeight; ++y)
+            {
+                uint8_t* pDst = output.data() + ((size_t(blockY) * 4 + y) * width + blockX * 4) * desc.TargetChannels;
+                for (uint32_t x = 0; x < blockWidth; ++x, pDst += desc.TargetChannels)
+                    memcpy(pDst, texels[y * 4 + x], desc.TargetChannels);
+            }
+        }
+    }
+    return true;
+}
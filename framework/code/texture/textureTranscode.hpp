@@ -0,0 +1,32 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// Pick the format to upload a texture stored in sourceFormat as.
+/// Returns sourceFormat if the device supports it, otherwise the best supported format TranscodeImage can convert sourceFormat to:
+/// - BC1-3 re-encode to ETC2 (rgb or rgba) and ETC2 to BC1 (rgb) or BC3 (alpha), if allowBlockReencode and the device supports it (keeps the texture block compressed in gpu memory, at some quality cost).
+/// - Otherwise BC1-3 and ETC2 (rgb, punch through alpha, rgba) decode to R8G8B8A8 (UNORM or SRGB to match the source), BC4/BC5 to R8/R8G8 and R8G8B8 expands to R8G8B8A8.
+/// ASTC is never chosen: there is no ASTC encoder or decoder, so an unsupported ASTC source returns VK_FORMAT_UNDEFINED and no source is transcoded to ASTC.
+/// Only handles texel data, KTX2 supercompression is dealt with by the loader before this (none and zlib are supported, zstd and BasisLZ files are rejected).
+/// Does not make any Vulkan calls (isFormatSupported is expected to wrap Vulkan::IsTextureFormatSupported).
+/// @returns VK_FORMAT_UNDEFINED if there is no supported format the texture can be transcoded to
+/// @ingroup Texture
+VkFormat SelectTranscodeFormat(VkFormat sourceFormat, const std::function<bool(VkFormat)>& isFormatSupported, bool allowBlockReencode = true);
+
+/// Convert one 2d image (eg one mip level of one face) from sourceFormat to targetFormat (as chosen by SelectTranscodeFormat).
+/// @param pData source texels (block compressed, or uncompressed rows sourceRowPitch bytes apart)
+/// @param sourceRowPitch bytes from the start of one source row to the next (0 for tightly packed), ignored for block compressed sources
+/// @param output targetFormat blocks, or tightly packed targetFormat texels
+/// @returns false if the conversion is not supported or dataSize is too small for the given dimensions
+/// @ingroup Texture
+bool TranscodeImage(VkFormat sourceFormat, VkFormat targetFormat, const uint8_t* pData, size_t dataSize, uint32_t width, uint32_t height, size_t sourceRowPitch, std::vector<uint8_t>& output);
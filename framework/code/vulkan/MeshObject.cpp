@@ -10,6 +10,7 @@
 #include "MeshObject.h"
 #include "material/vertexFormat.hpp"
 #include "memory/vertexBufferObject.hpp"
+#include "memory/bufferUploader.hpp"
 #include "mesh/meshObjectIntermediate.hpp"
 #include "system/assetManager.hpp"
 
@@ -42,10 +43,17 @@ MeshObject& MeshObject::operator=(MeshObject&& other) noexcept
 {
     if (this != &other)
     {
+        Destroy();
         m_VertexBuffers = std::move(other.m_VertexBuffers);
         m_IndexBuffer = std::move(other.m_IndexBuffer);
         m_NumVertices = other.m_NumVertices;
         other.m_NumVertices = 0;
+        m_pGeometryArena = other.m_pGeometryArena;
+        other.m_pGeometryArena = nullptr;
+        m_ArenaVertices = std::move(other.m_ArenaVertices);
+        other.m_ArenaVertices = {};
+        m_ArenaIndices = other.m_ArenaIndices;
+        other.m_ArenaIndices = {};
     }
     return *this;
 }
@@ -71,6 +79,12 @@ bool MeshObject::Destroy()
     m_NumVertices = 0;
     m_VertexBuffers.clear();
     m_IndexBuffer.reset();
+    if (m_pGeometryArena)
+    {
+        m_pGeometryArena->Free(m_ArenaVertices);
+        m_pGeometryArena->Free(m_ArenaIndices);
+        m_pGeometryArena = nullptr;
+    }
     return true;
 }
 
@@ -187,7 +201,7 @@ bool MeshObject::CreateScreenSpaceMesh(Vulkan* pVulkan, glm::vec4 PosLLRadius, g
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool MeshObject::CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshObject, uint32_t bindingIndex, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut)
+bool MeshObject::CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshObject, uint32_t bindingIndex, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut, BufferUploader* pUploader)
 {
     assert(pVulkan);
     assert(meshObjectOut);
@@ -212,7 +226,10 @@ bool MeshObject::CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshO
         {
             const std::vector<uint32_t> formattedVertexData = MeshObjectIntermediate::CopyFatVertexToFormattedBuffer(meshObject.m_VertexBuffer, pVertexFormat[vertexBufferIdx]);
 
-            if (!meshObjectOut->m_VertexBuffers.emplace_back().Initialize(&memoryManager, vertexFormat.span, numVertices, formattedVertexData.data()))
+            auto& vertexBuffer = meshObjectOut->m_VertexBuffers.emplace_back();
+            const bool initialized = pUploader ? vertexBuffer.Initialize(*pUploader, vertexFormat.span, numVertices, formattedVertexData.data())
+                                               : vertexBuffer.Initialize(&memoryManager, vertexFormat.span, numVertices, formattedVertexData.data());
+            if (!initialized)
             {
                 LOGE("Cannot Initialize vertex buffer %d", vertexBufferIdx);
                 return false;
@@ -222,7 +239,54 @@ bool MeshObject::CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshO
     }
 
     // Create the index buffer (with an appropriate VkIndexType index type, IF the meshObject has index data).
-    if (!CreateIndexBuffer(memoryManager, meshObject, meshObjectOut->m_IndexBuffer))
+    if (!CreateIndexBuffer(memoryManager, meshObject, meshObjectOut->m_IndexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, pUploader))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MeshObject::CreateMesh(GeometryArena& geometryArena, const MeshObjectIntermediate& meshObject, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut, BufferUploader* pUploader)
+{
+    assert(meshObjectOut);
+    meshObjectOut->Destroy();
+    meshObjectOut->m_pGeometryArena = &geometryArena;
+
+    const size_t numVertices = meshObject.m_VertexBuffer.size();
+    meshObjectOut->m_NumVertices = (uint32_t)numVertices;
+
+    // Convert the 'fat' vertex data to each (vertex rate) stream's format; all the streams are allocated together so they share the same FirstVertex.
+    std::vector<uint32_t> streamSpans;
+    std::vector<std::vector<uint32_t>> formattedVertexData;
+    for (const auto& vertexFormat : pVertexFormat)
+    {
+        if (vertexFormat.inputRate == VertexFormat::eInputRate::Vertex)
+        {
+            streamSpans.push_back(vertexFormat.span);
+            formattedVertexData.push_back(MeshObjectIntermediate::CopyFatVertexToFormattedBuffer(meshObject.m_VertexBuffer, vertexFormat));
+        }
+    }
+
+    if (!streamSpans.empty() && numVertices > 0)
+    {
+        std::vector<const void*> initialData;
+        initialData.reserve(formattedVertexData.size());
+        for (const auto& data : formattedVertexData)
+            initialData.push_back(data.data());
+
+        meshObjectOut->m_ArenaVertices = geometryArena.AllocateVertices(streamSpans, (uint32_t)numVertices, initialData, pUploader);
+        if (!meshObjectOut->m_ArenaVertices)
+        {
+            LOGE("Cannot allocate %zu vertices from the geometry arena", numVertices);
+            return false;
+        }
+    }
+
+    // Allocate the index range (IF the meshObject has index data).
+    if (!CreateIndexBuffer(geometryArena, meshObject, meshObjectOut->m_ArenaIndices, pUploader))
     {
         return false;
     }
@@ -232,18 +296,43 @@ bool MeshObject::CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshO
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool MeshObject::CreateIndexBuffer(MemoryManager& memoryManager, const MeshObjectIntermediate& meshObject, std::optional<IndexBufferObject>& indexBufferOut, VkBufferUsageFlags usage)
+bool MeshObject::CreateIndexBuffer(GeometryArena& geometryArena, const MeshObjectIntermediate& meshObject, GeometryArena::IndexRange& indexRangeOut, BufferUploader* pUploader)
+{
+    if (!std::visit(
+        [&geometryArena, &indexRangeOut, pUploader](auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::vector<uint32_t>>) {
+                indexRangeOut = geometryArena.AllocateIndices(VK_INDEX_TYPE_UINT32, (uint32_t)v.size(), v.data(), pUploader);
+                return v.empty() || !!indexRangeOut;
+            }
+            else if constexpr (std::is_same_v<T, std::vector<uint16_t>>) {
+                indexRangeOut = geometryArena.AllocateIndices(VK_INDEX_TYPE_UINT16, (uint32_t)v.size(), v.data(), pUploader);
+                return v.empty() || !!indexRangeOut;
+            }
+            return true;
+        },
+        meshObject.m_IndexBuffer))
+    {
+        LOGE("Cannot allocate index buffer from the geometry arena");
+        return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MeshObject::CreateIndexBuffer(MemoryManager& memoryManager, const MeshObjectIntermediate& meshObject, std::optional<IndexBufferObject>& indexBufferOut, VkBufferUsageFlags usage, BufferUploader* pUploader)
 {
     //
     // If the source has an index buffer then copy the data in to a Vulkan buffer
     //
     if (!std::visit(
-        [&meshObject, &indexBufferOut, &memoryManager, usage](auto& v) {
+        [&meshObject, &indexBufferOut, &memoryManager, usage, pUploader](auto& v) {
             using T = std::decay_t<decltype(v)>;
             if constexpr (std::is_same_v<T, std::vector<uint32_t>>) {
                 auto& indexBuffer = indexBufferOut.emplace(VK_INDEX_TYPE_UINT32);
                 const auto& vec32 = std::get<std::vector<uint32_t>>(meshObject.m_IndexBuffer);
-                if (!indexBuffer.Initialize(&memoryManager, vec32.size(), vec32.data(), false, usage))
+                if (pUploader ? !indexBuffer.Initialize(*pUploader, vec32.size(), vec32.data(), usage) : !indexBuffer.Initialize(&memoryManager, vec32.size(), vec32.data(), false, usage))
                 {
                     return false;
                 }
@@ -251,7 +340,7 @@ bool MeshObject::CreateIndexBuffer(MemoryManager& memoryManager, const MeshObjec
             else if constexpr (std::is_same_v<T, std::vector<uint16_t>>) {
                 auto& indexBuffer = indexBufferOut.emplace(VK_INDEX_TYPE_UINT16);
                 const auto& vec16 = std::get<std::vector<uint16_t>>(meshObject.m_IndexBuffer);
-                if (!indexBuffer.Initialize(&memoryManager, vec16.size(), vec16.data(), false, usage))
+                if (pUploader ? !indexBuffer.Initialize(*pUploader, vec16.size(), vec16.data(), usage) : !indexBuffer.Initialize(&memoryManager, vec16.size(), vec16.data(), false, usage))
                 {
                     return false;
                 }
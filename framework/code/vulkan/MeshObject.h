@@ -13,6 +13,7 @@
 #include "vulkan/vulkan.hpp"
 #include "system/glm_common.hpp"
 #include "memory/indexBufferObject.hpp"
+#include "memory/geometryArena.hpp"
 
 // Forward declarations
 class VertexFormat;
@@ -20,6 +21,7 @@ class MeshObject;
 class AssetManager;
 class VertexBufferObject;
 class MeshObjectIntermediate;
+class BufferUploader;
 
 /// Defines a simple object for creating and holding Vulkan state corresponding to a single mesh.
 class MeshObject
@@ -51,14 +53,39 @@ public:
     /// Create a MeshObject from a 'fat' MeshObjectIntermediate object, rearranging the vertex data to match the supplied vertex format(s).
     /// Can have multiple VertexFormats, which will create multiple vertex buffers (eg if we want to split vertex position data away from other vertex attributes)
     /// @param pVertexFormat format of the vertex data being output
+    /// @param pUploader optional; stage the vertex/index data through this uploader (buffer contents are valid once its next Submit/Flush has executed) rather than writing each buffer directly
     /// @returns true on success
-    static bool CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshObject, uint32_t binding, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut);
+    static bool CreateMesh(Vulkan* pVulkan, const MeshObjectIntermediate& meshObject, uint32_t binding, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut, BufferUploader* pUploader = nullptr);
+
+    /// Create a MeshObject from a 'fat' MeshObjectIntermediate object with its vertex (and index) data sub-allocated from the given GeometryArena (rather than in buffers of its own).
+    /// Output MeshObject has empty m_VertexBuffers and m_IndexBuffer; the data is described by m_ArenaVertices and m_ArenaIndices instead.
+    /// The arena must outlive the MeshObject.
+    /// @param pVertexFormat format of the vertex data being output (instance rate formats are skipped, as with the non arena CreateMesh)
+    /// @param pUploader stage the vertex/index data through this uploader (required if the arena is device local, data is valid once its next Submit/Flush has executed)
+    /// @returns true on success
+    static bool CreateMesh(GeometryArena& geometryArena, const MeshObjectIntermediate& meshObject, const tcb::span<const VertexFormat> pVertexFormat, MeshObject* meshObjectOut, BufferUploader* pUploader = nullptr);
 
     virtual bool Destroy();
 
     /// Helper to create a IndexBufferObject, IF the mesh object has index buffer data.
+    /// @param pUploader optional; stage the index data through this uploader (buffer contents are valid once its next Submit/Flush has executed)
     /// @returns true for success (including no index buffer data existing in IndexBufferObject), false on error.
-    static bool CreateIndexBuffer(MemoryManager& memoryManager, const MeshObjectIntermediate& meshObject, std::optional<IndexBufferObject>& indexBufferOut, VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    static bool CreateIndexBuffer(MemoryManager& memoryManager, const MeshObjectIntermediate& meshObject, std::optional<IndexBufferObject>& indexBufferOut, VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT, BufferUploader* pUploader = nullptr);
+
+    /// Helper to allocate a GeometryArena index range, IF the mesh object has index buffer data.
+    /// @param pUploader stage the index data through this uploader (required if the arena is device local)
+    /// @returns true for success (including no index buffer data existing in MeshObjectIntermediate), false on error.
+    static bool CreateIndexBuffer(GeometryArena& geometryArena, const MeshObjectIntermediate& meshObject, GeometryArena::IndexRange& indexRangeOut, BufferUploader* pUploader = nullptr);
+
+    /// @returns true if the vertex/index data is sub-allocated from a GeometryArena (m_ArenaVertices/m_ArenaIndices) rather than in m_VertexBuffers/m_IndexBuffer
+    bool IsInGeometryArena() const { return m_pGeometryArena != nullptr; }
+
+    /// @returns indirect draw command for this (arena allocated, indexed) mesh, for use with the index/vertex buffers of its arena pool bound at offset 0.
+    VkDrawIndexedIndirectCommand GetDrawIndexedIndirectCommand(uint32_t instanceCount = 1, uint32_t firstInstance = 0) const
+    {
+        assert(IsInGeometryArena() && m_ArenaIndices);
+        return { m_ArenaIndices.NumIndices, instanceCount, m_ArenaIndices.FirstIndex, (int32_t)m_ArenaVertices.FirstVertex, firstInstance };
+    }
 
     // These MUST match the order of the attrib locations and sFormat must reflect the layout of this struct too!
     struct vertex_layout
@@ -76,4 +103,7 @@ public:
     uint32_t                        m_NumVertices;
     std::vector<VertexBufferObject> m_VertexBuffers;
     std::optional<IndexBufferObject>m_IndexBuffer;
+    GeometryArena*                  m_pGeometryArena = nullptr;     ///< arena m_ArenaVertices/m_ArenaIndices are allocated from (nullptr if the mesh owns its buffers)
+    GeometryArena::VertexRange      m_ArenaVertices;
+    GeometryArena::IndexRange       m_ArenaIndices;
 };
@@ -14,6 +14,11 @@
 #include "memory/memoryManager.hpp"
 #include "vulkan_support.hpp"
 #include "TextureFuncts.h"
+#include "textureUploader.hpp"
+#include "system/Worker.h"
+#include "texture/textureTranscode.hpp"
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <map>
 #define STB_IMAGE_IMPLEMENTATION
@@ -26,6 +31,13 @@ constexpr uint32_t KTX_ENDIAN_REF = 0x04030201;     // Big Endian
 constexpr uint32_t KTX_ENDIAN_REF_REV = 0x01020304; // Little Endian
 constexpr uint32_t KTX_HEADER_SIZE = 64;
 
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+constexpr std::array<unsigned char, 12> KTX2_IDENTIFIER_REF = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+constexpr uint32_t KTX2_SUPERCOMPRESSION_NONE = 0;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_BASISLZ = 1;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZSTD = 2;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZLIB = 3;
+
 #if !defined(FLT_MAX)
 #define FLT_MAX          3.402823466e+38f
 #endif // !defined(FLT_MAX)
@@ -53,6 +65,34 @@ typedef struct _KTXHeader
     uint32_t  bytesOfKeyValueData;
 } KTXHeader;
 
+typedef struct _KTX2Header
+{
+    uint8_t   identifier[12];
+    uint32_t  vkFormat;
+    uint32_t  typeSize;
+    uint32_t  pixelWidth;
+    uint32_t  pixelHeight;
+    uint32_t  pixelDepth;
+    uint32_t  layerCount;
+    uint32_t  faceCount;
+    uint32_t  levelCount;
+    uint32_t  supercompressionScheme;
+    // Index
+    uint32_t  dfdByteOffset;
+    uint32_t  dfdByteLength;
+    uint32_t  kvdByteOffset;
+    uint32_t  kvdByteLength;
+    uint64_t  sgdByteOffset;
+    uint64_t  sgdByteLength;
+} KTX2Header;
+
+typedef struct _KTX2LevelIndex
+{
+    uint64_t  byteOffset;
+    uint64_t  byteLength;
+    uint64_t  uncompressedByteLength;
+} KTX2LevelIndex;
+
 // This is not a class.  It is up to caller to release any objects in this structure
 typedef struct _MipTexData
 {
@@ -83,6 +123,8 @@ typedef struct _VulkanTexData
 
     uint32_t        NumFaces;
     FaceTexData*    pFaceData;
+
+    uint32_t        Depth;          // > 1 for 3d textures (single face and mip level), 0 or 1 for 2d
 } VulkanTexData;
 
 
@@ -466,6 +508,201 @@ static bool L_ParseKTXBuffer(const char* pFileName, void* pKTXBuffer, uint32_t B
     return true;
 }
 
+//-----------------------------------------------------------------------------
+static bool L_ParseKTX2Buffer(const char* pFileName, const void* pKTXBuffer, size_t BufferLength, VulkanTexData* pTexData)
+//-----------------------------------------------------------------------------
+{
+    if (pTexData == NULL)
+        return false;
+
+    // Make sure starting from a clean place
+    L_FreeTexData(pTexData);
+
+    KTX2Header Header;
+    if (BufferLength < sizeof(KTX2Header))
+    {
+        LOGE("KTX2 file is too small: %s", pFileName);
+        return false;
+    }
+    memcpy(&Header, pKTXBuffer, sizeof(KTX2Header));
+
+    if (memcmp(Header.identifier, KTX2_IDENTIFIER_REF.data(), KTX2_IDENTIFIER_REF.size()) != 0)
+    {
+        LOGE("KTX2 file has invalid header: %s", pFileName);
+        return false;
+    }
+    if (Header.vkFormat == VK_FORMAT_UNDEFINED || Header.supercompressionScheme == KTX2_SUPERCOMPRESSION_BASISLZ)
+    {
+        LOGE("KTX2 file is Basis Universal encoded (not supported): %s", pFileName);
+        return false;
+    }
+    if (Header.supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE && Header.supercompressionScheme != KTX2_SUPERCOMPRESSION_ZLIB)
+    {
+        // Zstandard needs a decoder we do not currently have (zlib uses the one in stb_image)
+        LOGE("KTX2 file supercompression scheme (%u) not supported: %s", Header.supercompressionScheme, pFileName);
+        return false;
+    }
+    if (Header.pixelDepth > 1)
+    {
+        LOGE("KTX2 file is a 3d texture (not supported): %s", pFileName);
+        return false;
+    }
+
+    // Zero counts mean 'not an array' and 'generate the mips' (we upload just the one level we have).
+    const uint32_t NumLayers = std::max(1u, Header.layerCount);
+    const uint32_t NumFaces = std::max(1u, Header.faceCount);
+    const uint32_t NumMipLevels = std::max(1u, Header.levelCount);
+
+    if (BufferLength < sizeof(KTX2Header) + NumMipLevels * sizeof(KTX2LevelIndex))
+    {
+        LOGE("KTX2 file is too small for its level index: %s", pFileName);
+        return false;
+    }
+    std::vector<KTX2LevelIndex> LevelIndex(NumMipLevels);
+    memcpy(LevelIndex.data(), (const uint8_t*)pKTXBuffer + sizeof(KTX2Header), NumMipLevels * sizeof(KTX2LevelIndex));
+
+    // ********************************
+    // Memory Allocation
+    // ********************************
+    // Allocated with calloc so L_FreeTexData can clean up a partially filled structure.
+    pTexData->pFaceData = (FaceTexData*)calloc(NumFaces, sizeof(FaceTexData));
+    if (pTexData->pFaceData == NULL)
+    {
+        LOGE("Unable to allocate memory for %d faces: %s", NumFaces, pFileName);
+        return false;
+    }
+    pTexData->NumFaces = NumFaces;
+    pTexData->VulkanFormat = (VkFormat)Header.vkFormat;
+
+    for (uint32_t WhichFace = 0; WhichFace < NumFaces; WhichFace++)
+    {
+        FaceTexData& FaceData = pTexData->pFaceData[WhichFace];
+        FaceData.pLayerData = (LayerTexData*)calloc(NumLayers, sizeof(LayerTexData));
+        if (FaceData.pLayerData == NULL)
+        {
+            LOGE("Unable to allocate memory for %d layers: %s", NumLayers, pFileName);
+            L_FreeTexData(pTexData);
+            return false;
+        }
+        FaceData.NumLayers = NumLayers;
+        for (uint32_t WhichLayer = 0; WhichLayer < NumLayers; WhichLayer++)
+        {
+            LayerTexData& LayerData = FaceData.pLayerData[WhichLayer];
+            LayerData.pMipData = (MipTexData*)calloc(NumMipLevels, sizeof(MipTexData));
+            if (LayerData.pMipData == NULL)
+            {
+                LOGE("Unable to allocate memory for %d mip levels: %s", NumMipLevels, pFileName);
+                L_FreeTexData(pTexData);
+                return false;
+            }
+            LayerData.NumMipLevels = NumMipLevels;
+        }
+    }
+
+    // ********************************
+    // Allocate and fill mip levels
+    // ********************************
+    // Each level contains all the layers, each layer contains all the faces.  Images are tightly packed (no row padding) and the whole level is supercompressed as one.
+    std::vector<uint8_t> Uncompressed;
+    for (uint32_t WhichMipLevel = 0; WhichMipLevel < NumMipLevels; WhichMipLevel++)
+    {
+        const KTX2LevelIndex& Level = LevelIndex[WhichMipLevel];
+        if (Level.byteOffset > BufferLength || Level.byteLength > BufferLength - Level.byteOffset)
+        {
+            LOGE("KTX2 file mip level %u is outside of the file: %s", WhichMipLevel, pFileName);
+            L_FreeTexData(pTexData);
+            return false;
+        }
+        const uint8_t* pLevelData = (const uint8_t*)pKTXBuffer + Level.byteOffset;
+        size_t LevelSize = (size_t)Level.byteLength;
+
+        if (Header.supercompressionScheme == KTX2_SUPERCOMPRESSION_ZLIB)
+        {
+            Uncompressed.resize((size_t)Level.uncompressedByteLength);
+            const int DecodedSize = stbi_zlib_decode_buffer((char*)Uncompressed.data(), (int)Uncompressed.size(), (const char*)pLevelData, (int)LevelSize);
+            if (DecodedSize != (int)Uncompressed.size())
+            {
+                LOGE("KTX2 file mip level %u failed to decompress: %s", WhichMipLevel, pFileName);
+                L_FreeTexData(pTexData);
+                return false;
+            }
+            pLevelData = Uncompressed.data();
+            LevelSize = Uncompressed.size();
+        }
+
+        const size_t ImageSize = LevelSize / (size_t(NumLayers) * NumFaces);
+        const uint32_t uiMipWidth = std::max(1u, Header.pixelWidth >> WhichMipLevel);
+        const uint32_t uiMipHeight = std::max(1u, Header.pixelHeight >> WhichMipLevel);
+        for (uint32_t WhichLayer = 0; WhichLayer < NumLayers; WhichLayer++)
+        {
+            for (uint32_t WhichFace = 0; WhichFace < NumFaces; WhichFace++)
+            {
+                void* pTempData = malloc(ImageSize);
+                if (pTempData == NULL)
+                {
+                    LOGE("Unable to allocate %zu bytes of memory for mip level: %s", ImageSize, pFileName);
+                    L_FreeTexData(pTexData);
+                    return false;
+                }
+                memcpy(pTempData, pLevelData + (size_t(WhichLayer) * NumFaces + WhichFace) * ImageSize, ImageSize);
+
+                MipTexData& MipData = pTexData->pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[WhichMipLevel];
+                MipData.Width = uiMipWidth;
+                MipData.Height = uiMipHeight;
+                MipData.Size = (uint32_t)ImageSize;
+                MipData.pData = pTempData;
+            }   // Which Face
+        }   // Which Layer
+    }   // Which MipLevel
+
+    // Everything worked out
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static bool L_TranscodeTexData(const char* pFileName, VulkanTexData* pTexData, const Vulkan& vulkan)
+//-----------------------------------------------------------------------------
+{
+    // Convert the texture data to a format the device supports (if it does not support the format the data is in).
+    const VkFormat SourceFormat = pTexData->VulkanFormat;
+    const VkFormat TargetFormat = SelectTranscodeFormat(SourceFormat, [&vulkan](VkFormat Format) { return vulkan.IsTextureFormatSupported(Format); });
+    if (TargetFormat == SourceFormat || TargetFormat == VK_FORMAT_UNDEFINED)
+        return true;    // nothing to do (or nothing we can do, caller handles the unsupported format)
+
+    LOGI("Transcoding texture from format %d to %d: %s", int(SourceFormat), int(TargetFormat), pFileName);
+    std::vector<uint8_t> Transcoded;
+    for (uint32_t WhichFace = 0; WhichFace < pTexData->NumFaces; WhichFace++)
+    {
+        for (uint32_t WhichLayer = 0; WhichLayer < pTexData->pFaceData[WhichFace].NumLayers; WhichLayer++)
+        {
+            LayerTexData& LayerData = pTexData->pFaceData[WhichFace].pLayerData[WhichLayer];
+            for (uint32_t WhichMipLevel = 0; WhichMipLevel < LayerData.NumMipLevels; WhichMipLevel++)
+            {
+                MipTexData& MipData = LayerData.pMipData[WhichMipLevel];
+                // KTX1 pads uncompressed rows to 4 bytes (same row pitch as RecordImageUpload works out).
+                const size_t SourceRowPitch = MipData.Height ? MipData.Size / MipData.Height : 0;
+                if (!TranscodeImage(SourceFormat, TargetFormat, (const uint8_t*)MipData.pData, MipData.Size, MipData.Width, MipData.Height, SourceRowPitch, Transcoded))
+                {
+                    LOGE("Error transcoding texture from format %d to %d: %s", int(SourceFormat), int(TargetFormat), pFileName);
+                    return false;
+                }
+                void* pTempData = malloc(Transcoded.size());
+                if (pTempData == NULL)
+                {
+                    LOGE("Unable to allocate %zu bytes of memory for mip level: %s", Transcoded.size(), pFileName);
+                    return false;
+                }
+                memcpy(pTempData, Transcoded.data(), Transcoded.size());
+                free(MipData.pData);
+                MipData.pData = pTempData;
+                MipData.Size = (uint32_t)Transcoded.size();
+            }
+        }
+    }
+    pTexData->VulkanFormat = TargetFormat;
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 static bool L_ParsePNGBuffer( const char* pFileName, void* pPNGBuffer, uint32_t BufferLength, VulkanTexData* pTexData )
 //-----------------------------------------------------------------------------
@@ -476,26 +713,20 @@ static bool L_ParsePNGBuffer( const char* pFileName, void* pPNGBuffer, uint32_t
     // Make sure starting from a clean place
     L_FreeTexData( pTexData );
     int width = 0, height = 0, componentsPerPixel = 0;
-    unsigned char* data = stbi_load_from_memory( static_cast<const unsigned char*>(pPNGBuffer), BufferLength, &width, &height, &componentsPerPixel, 0/*forced components per pixel*/);
+    if (!stbi_info_from_memory( static_cast<const unsigned char*>(pPNGBuffer), BufferLength, &width, &height, &componentsPerPixel ))
+        return false;
+    // RGB formats not supported, have stb expand to RGBA as it decodes.
+    const int forcedComponentsPerPixel = (componentsPerPixel == 3) ? 4 : 0;
+    unsigned char* data = stbi_load_from_memory( static_cast<const unsigned char*>(pPNGBuffer), BufferLength, &width, &height, &componentsPerPixel, forcedComponentsPerPixel );
+    if (data == nullptr)
+        return false;
+    if (forcedComponentsPerPixel != 0)
+        componentsPerPixel = forcedComponentsPerPixel;
     uint32_t dataSize = width * height * componentsPerPixel;
     if (dataSize <= 0)
-        return false;
-    if (componentsPerPixel == 3)
     {
-        // RGB formats not supported, shuffle to RGBA.
-        uint8_t* dataRGBA = new uint8_t[width*height*4];
-        uint8_t* pOutRGBA = dataRGBA;
-        const uint8_t* pInRGB = (const uint8_t*)data;
-        for (int i = 0; i < width * height; ++i)
-        {
-            *pOutRGBA++ = *pInRGB++;
-            *pOutRGBA++ = *pInRGB++;
-            *pOutRGBA++ = *pInRGB++;
-            *pOutRGBA++ = 255;
-        }
         STBI_FREE( data );
-        data = dataRGBA;
-        componentsPerPixel = 4;
+        return false;
     }
 
     pTexData->NumFaces = 1;
@@ -591,225 +822,348 @@ static bool CreateSampler(Vulkan* pVulkan, VkSamplerAddressMode SamplerMode, VkF
 }
 
 //-----------------------------------------------------------------------------
-VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias)
+static bool L_GenerateCpuMips(const char* pFileName, VulkanTexData* pTexData, const TextureMipGeneration& MipGeneration)
 //-----------------------------------------------------------------------------
 {
-    // Texture Convert Command Line: simpletextureconverter hud.tga hud.ktx -format R8G8B8A8Unorm -flipY
-
-    VkResult RetVal;
-
-    uint32_t uiWidth = 0;
-    uint32_t uiHeight = 0;
-    uint32_t uiFaces = 0;
-    uint32_t uiMipLevels = 0;
-    uint32_t uiMipOffset = 0;
-    VkFormat VulkanFormat = VK_FORMAT_UNDEFINED;
-    bool forceLinearTiling = false;
-
-    VkFormatProperties formatProperties = {};
-
-    VulkanTexData TexData = {};
+    // Replaces a single mip level with a full (cpu generated) mip chain.  Leaves textures that already have mips (or that we cannot filter) untouched.
+    uint32_t Channels = 0;
+    switch (pTexData->VulkanFormat)
+    {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SRGB:
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        Channels = Vulkan::FormatBytesPerBlock(pTexData->VulkanFormat);
+        break;
+    default:
+        LOGI("Texture format (%d) not supported by cpu mip generation: %s", int(pTexData->VulkanFormat), pFileName);
+        return true;
+    }
 
-    LOGI("Loading KTX texture: %s", pFileName);
+    LayerTexData& LayerData = pTexData->pFaceData[0].pLayerData[0];
+    if (pTexData->NumFaces != 1 || pTexData->pFaceData[0].NumLayers != 1 || LayerData.NumMipLevels != 1 || pTexData->Depth > 1)
+        return true;
 
+    const MipTexData& BaseMip = LayerData.pMipData[0];
+    if (BaseMip.Size != BaseMip.Width * BaseMip.Height * Channels)
     {
-        std::vector<char> fileData;
-        if (!assetManager.LoadFileIntoMemory(pFileName, fileData))
-        {
-            LOGE("Error reading texture file: %s", pFileName);
-            return {};
-        }
-
-        size_t filenameLength = strlen( pFileName );
-        if (filenameLength > 4 && strcmp( pFileName + filenameLength - 4, ".ktx" ) == 0)
-        {
-            if (!L_ParseKTXBuffer(pFileName, fileData.data(), (uint32_t)fileData.size(), &TexData))
-            {
-                LOGE("Error parsing texture file: %s", pFileName);
-                return {};
-            }
-        }
-        else
-        {
-            if (!L_ParsePNGBuffer( pFileName, fileData.data(), (uint32_t) fileData.size(), &TexData ))
-            {
-                LOGE( "Error parsing texture file: %s", pFileName );
-                return {};
-            }
-        }
+        LOGE("Texture has padded rows, not supported by cpu mip generation: %s", pFileName);
+        return true;
     }
 
+    MipGenerationSettings Settings;
+    Settings.Filter = MipGeneration.Filter;
+    Settings.Srgb = Vulkan::FormatIsSrgb(pTexData->VulkanFormat);
+    Settings.AlphaCoverageCutoff = MipGeneration.AlphaCoverageCutoff;
+    auto Mips = GenerateMipChain((const uint8_t*)BaseMip.pData, BaseMip.Width, BaseMip.Height, Channels, Settings);
+    if (Mips.empty())
+        return true;
 
-    uiWidth = TexData.pFaceData[0].pLayerData[0].pMipData[0].Width;
-    uiHeight = TexData.pFaceData[0].pLayerData[0].pMipData[0].Height;
-    uiFaces = TexData.NumFaces;
-    uiMipLevels = TexData.pFaceData[0].pLayerData[0].NumMipLevels;
-    VulkanFormat = TexData.VulkanFormat;
-
-    if (NumMipsToLoad < (int32_t)uiMipLevels)
+    MipTexData* pMipData = (MipTexData*)realloc(LayerData.pMipData, sizeof(MipTexData) * (1 + Mips.size()));
+    if (pMipData == NULL)
     {
-        // Reset the "starting" mip so allocated texture memory is correct.
-        uiMipOffset = uiMipLevels - (uint32_t)NumMipsToLoad;
-
-        uiWidth = TexData.pFaceData[0].pLayerData[0].pMipData[uiMipOffset].Width;
-        uiHeight = TexData.pFaceData[0].pLayerData[0].pMipData[uiMipOffset].Height;
-        uiMipLevels = NumMipsToLoad;
+        LOGE("Unable to allocate memory for texture mips: %s", pFileName);
+        return false;
     }
-
-    // Check that the device supports this format
-    if (!pVulkan->IsTextureFormatSupported(VulkanFormat))
+    LayerData.pMipData = pMipData;
+    for (const auto& Mip : Mips)
     {
-        // Potentially fallback to loading a .win.ktx file
-        size_t filenameLength = strlen(pFileName);
-        if ((filenameLength < 8 || strcmp(pFileName + filenameLength - 8, ".win.ktx") != 0) && (filenameLength>4 && strcmp(pFileName + filenameLength - 4, ".ktx") == 0))
+        MipTexData& MipData = LayerData.pMipData[LayerData.NumMipLevels];
+        MipData.Width = Mip.Width;
+        MipData.Height = Mip.Height;
+        MipData.Size = (uint32_t)Mip.Data.size();
+        MipData.pData = malloc(Mip.Data.size());
+        if (MipData.pData == NULL)
         {
-            std::string fallbackFilename(pFileName, filenameLength - 4);
-            fallbackFilename.append(".win.ktx");
-            auto fallback = LoadKTXTexture(pVulkan, assetManager, fallbackFilename.c_str(), SamplerMode);
-            if (!fallback.IsEmpty())
-                return fallback;
+            LOGE("Unable to allocate memory for texture mips: %s", pFileName);
+            return false;
         }
-
-        LOGE("Error, texture format (%d) not supported by device: %s", int(VulkanFormat), pFileName);
-        return {};
+        memcpy(MipData.pData, Mip.Data.data(), Mip.Data.size());
+        ++LayerData.NumMipLevels;
     }
+    return true;
+}
 
-	// Get device properites for the requested texture format
-	vkGetPhysicalDeviceFormatProperties(pVulkan->m_VulkanGpu, VulkanFormat, &formatProperties);
-	bool useStaging = !(formatProperties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
-
-	// Image creation info.  Will change below based on need
-    VkImageCreateInfo ImageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-	ImageInfo.flags = 0;
-	ImageInfo.imageType = VK_IMAGE_TYPE_2D;
-	ImageInfo.format = VulkanFormat;
-	ImageInfo.extent.width = uiWidth;
-	ImageInfo.extent.height = uiHeight;
-    ImageInfo.extent.depth = 1; // Spec says for VK_IMAGE_TYPE_2D depth must be 1
-	ImageInfo.mipLevels = 1;	// Set to 1 since making each level.  Later will be set to MipLevels;
-	ImageInfo.arrayLayers = 1;  // Set to 6 for cube maps.
-	ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	ImageInfo.tiling = VK_IMAGE_TILING_LINEAR;
-	ImageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-	ImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	ImageInfo.queueFamilyIndexCount = 0;
-	ImageInfo.pQueueFamilyIndices = NULL;
-    ImageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;   // VK_IMAGE_LAYOUT_UNDEFINED says data not guaranteed to be preserved when changing state
-
-	struct CubeFace
-	{
-        CubeFace(uint32_t uiFaces) : mipImages(uiFaces) {}
-        std::vector<Wrap_VkImage> mipImages;
-	};
+//-----------------------------------------------------------------------------
+static bool L_ParsePPMBuffer(const char* pFileName, const tcb::span<const char> FileData, VulkanTexData* pTexData)
+//-----------------------------------------------------------------------------
+{
+    if (pTexData == NULL)
+        return false;
 
-    // Allocate the cube face and mips for each face
-    std::vector<CubeFace> cubeFaces;
-    cubeFaces.reserve(uiFaces);
+    // Make sure starting from a clean place
+    L_FreeTexData(pTexData);
 
-    for (uint32_t WhichFace = 0; WhichFace < uiFaces; WhichFace++)
+    if (FileData.size() < 20)
+        return false;
+    auto fileDataIt = FileData.begin();
+    if (*fileDataIt++ != 'P' || *fileDataIt++ != '6' || !isspace(*fileDataIt++))
+        return false;
+    while (isspace(*fileDataIt))
+        ++fileDataIt;
+    uint32_t width = 0, height = 0, maxColor = 0;
+    while (isdigit(*fileDataIt))
+        width = width * 10 + uint32_t(*fileDataIt++ - '0');
+    while (isspace(*fileDataIt))
+        ++fileDataIt;
+    while (isdigit(*fileDataIt))
+        height = height * 10 + uint32_t(*fileDataIt++ - '0');
+    while (isspace(*fileDataIt))
+        ++fileDataIt;
+    while (isdigit(*fileDataIt))
+        maxColor = maxColor * 10 + uint32_t(*fileDataIt++ - '0');
+    uint32_t bytesPerPPMPixel = maxColor < 256 ? 1 : 2;
+    if (!isspace(*fileDataIt++))
+        return false;
+    // Images follow.
+    size_t singleImageBytes = size_t(width) * height * 3 * bytesPerPPMPixel;
+    if (singleImageBytes == 0)
+        return false;
+    // If there are multiple images treat this as a 3d texture.
+    size_t dataOffset = fileDataIt - FileData.begin();
+    size_t dataBytes = FileData.size() - dataOffset;
+    uint32_t depth = (uint32_t)(dataBytes / singleImageBytes);
+    if (depth == 0)
     {
-        cubeFaces.emplace_back(uiMipLevels);
+        LOGE("PPM file has no (complete) image data: %s", pFileName);
+        return false;
     }
 
+    // Copy the red and green channels of the image data in to the texture format.
+    const size_t dataSize = size_t(width) * height * depth * 2;
+    uint8_t* pData = (uint8_t*)malloc(dataSize);
+    if (pData == NULL)
+    {
+        LOGE("Unable to allocate %zu bytes of memory for texture: %s", dataSize, pFileName);
+        return false;
+    }
+    uint8_t* pTarget = pData;
+    for (size_t i = 0; i < size_t(width) * height * depth; ++i)
+    {
+        *pTarget++ = (uint8_t)fileDataIt[0];
+        *pTarget++ = (uint8_t)fileDataIt[1];
+        fileDataIt += 3;
+    }
 
-	// Create and copy mip levels
+    pTexData->VulkanFormat = VK_FORMAT_R8G8_UNORM;
+    pTexData->Depth = depth;
+    pTexData->NumFaces = 1;
+    pTexData->pFaceData = (FaceTexData*)malloc(pTexData->NumFaces * sizeof(FaceTexData));
+    pTexData->pFaceData->NumLayers = 1;
+    pTexData->pFaceData->pLayerData = (LayerTexData*)malloc(pTexData->pFaceData->NumLayers * sizeof(LayerTexData));
+    pTexData->pFaceData->pLayerData->NumMipLevels = 1;
+    pTexData->pFaceData->pLayerData->pMipData = (MipTexData*)malloc(pTexData->pFaceData->pLayerData->NumMipLevels * sizeof(MipTexData));
+    pTexData->pFaceData->pLayerData->pMipData->Width = width;
+    pTexData->pFaceData->pLayerData->pMipData->Height = height;
+    pTexData->pFaceData->pLayerData->pMipData->Size = (uint32_t)dataSize;
+    pTexData->pFaceData->pLayerData->pMipData->pData = pData;
+    return true;
+}
 
-    // Need the setup command buffer for loading images
-    VkCommandBuffer SetupCmdBuffer = pVulkan->StartSetupCommandBuffer();
+//-----------------------------------------------------------------------------
+static bool L_ParseTexData(const Vulkan& vulkan, const char* pFileName, const tcb::span<const char> FileData, VulkanTexData* pTexData, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Decodes the file contents in to cpu memory only (no Vulkan calls) so is safe to call from worker threads.
+    // Parsers take a non const buffer (they do not modify it).
+    void* pFileData = const_cast<char*>(FileData.data());
 
-	// Load separate cube map faces into linear tiled textures
-    for (uint32_t WhichFace = 0; WhichFace < uiFaces; WhichFace++)
+    size_t filenameLength = strlen( pFileName );
+    if (filenameLength > 5 && strcmp( pFileName + filenameLength - 5, ".ktx2" ) == 0)
     {
-        for (uint32_t WhichMip = 0; WhichMip < uiMipLevels; WhichMip++)
+        if (!L_ParseKTX2Buffer(pFileName, pFileData, FileData.size(), pTexData))
         {
-            // TODO: Layers are not supported
-            uint32_t WhichLayer = 0;
+            LOGE("Error parsing texture file: %s", pFileName);
+            return false;
+        }
+    }
+    else if (filenameLength > 4 && strcmp( pFileName + filenameLength - 4, ".ktx" ) == 0)
+    {
+        if (!L_ParseKTXBuffer(pFileName, pFileData, (uint32_t)FileData.size(), pTexData))
+        {
+            LOGE("Error parsing texture file: %s", pFileName);
+            return false;
+        }
+    }
+    else if (filenameLength > 4 && strcmp( pFileName + filenameLength - 4, ".ppm" ) == 0)
+    {
+        if (!L_ParsePPMBuffer(pFileName, FileData, pTexData))
+        {
+            LOGE("Error parsing texture file: %s", pFileName);
+            return false;
+        }
+    }
+    else
+    {
+        if (!L_ParsePNGBuffer( pFileName, pFileData, (uint32_t) FileData.size(), pTexData ))
+        {
+            LOGE( "Error parsing texture file: %s", pFileName );
+            return false;
+        }
+    }
 
-            uint32_t TexDataMip = WhichMip + uiMipOffset;
+    // Transcode before generating mips (so compressed data the device cannot use can still get cpu generated mips)
+    if (!L_TranscodeTexData(pFileName, pTexData, vulkan))
+    {
+        L_FreeTexData(pTexData);
+        return false;
+    }
 
-            ImageInfo.extent.width = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Width;
-            ImageInfo.extent.height = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Height;
+    if (MipGeneration.Generate == TextureMipGeneration::Mode::Cpu && !L_GenerateCpuMips(pFileName, pTexData, MipGeneration))
+    {
+        L_FreeTexData(pTexData);
+        return false;
+    }
+    return true;
+}
 
-            char szName[256];
-            memset(szName, 0, sizeof(szName));
-            sprintf(szName, "%s: Face %d; Mip %d", pFileName, WhichFace, WhichMip);
-            if (!cubeFaces[WhichFace].mipImages[WhichMip].Initialize(pVulkan, ImageInfo, MemoryManager::MemoryUsage::CpuToGpu))
-            {
-                LOGE("Unable to initialize mip %d of face %d (%s)", WhichMip + 1, WhichFace + 1, pFileName);
-                return {};
-            }
+//-----------------------------------------------------------------------------
+static bool L_LoadTexData(const Vulkan& vulkan, AssetManager& assetManager, const char* pFileName, VulkanTexData* pTexData, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Reads and decodes the file in to cpu memory only (no Vulkan calls) so is safe to call from worker threads.
+    std::vector<char> fileData;
+    if (!assetManager.LoadFileIntoMemory(pFileName, fileData))
+    {
+        LOGE("Error reading texture file: %s", pFileName);
+        return false;
+    }
+    return L_ParseTexData(vulkan, pFileName, fileData, pTexData, MipGeneration);
+}
 
-            // ... copy texture data into the image
-            VkImageSubresource SubresInfo {};
-            SubresInfo.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            SubresInfo.mipLevel = 0;    // This is always 0 since dealing with temporary images
-            SubresInfo.arrayLayer = 0;  // TODO: Adjust this as we support 3D/array textures
+//-----------------------------------------------------------------------------
+static VulkanTexInfo L_LoadFallbackKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, VkFormat VulkanFormat, VkSamplerAddressMode SamplerMode, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Potentially fallback to loading a .win.ktx file
+    size_t filenameLength = strlen(pFileName);
+    if ((filenameLength < 8 || strcmp(pFileName + filenameLength - 8, ".win.ktx") != 0) && (filenameLength>4 && strcmp(pFileName + filenameLength - 4, ".ktx") == 0))
+    {
+        std::string fallbackFilename(pFileName, filenameLength - 4);
+        fallbackFilename.append(".win.ktx");
+        auto fallback = LoadKTXTexture(pVulkan, assetManager, fallbackFilename.c_str(), SamplerMode, 0x7fffffff, mipBias, MipGeneration);
+        if (!fallback.IsEmpty())
+            return fallback;
+    }
 
-            VkSubresourceLayout SubResLayout {};
-            auto& faceImage = cubeFaces[WhichFace].mipImages[WhichMip].m_VmaImage;
-            vkGetImageSubresourceLayout(pVulkan->m_VulkanDevice, faceImage.GetVkBuffer(), &SubresInfo, &SubResLayout);
+    LOGE("Error, texture format (%d) not supported by device: %s", int(VulkanFormat), pFileName);
+    return {};
+}
 
-            {
-                // account for SubResLayout.offset too?
-                MemoryManager& memorymanager = pVulkan->GetMemoryManager();
-                auto mappedMemory = memorymanager.Map<void>(faceImage);
-                uint8_t* pDst = (uint8_t*)mappedMemory.data();
-                uint8_t* pSrc = (uint8_t*)TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].pData;
-                if (Vulkan::FormatIsCompressed(VulkanFormat) || SubResLayout.rowPitch * ImageInfo.extent.height == TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Size)
-                {
-                    // Block sizes match, copy entire mip level.
-                    memcpy(pDst, pSrc, TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Size);
-                }
-                else
-                {
-                    // Pitch is such that we need to copy line by line - can happen on non power-2 textures and when texture size gets very small (depending on GPU memory alignment requirements)
-                    size_t srcRowPitch = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Size / ImageInfo.extent.height;
-                    for (uint32_t y = 0; y < ImageInfo.extent.height; ++y)
-                    {
-                        memcpy(pDst, pSrc, srcRowPitch);
-                        pDst += SubResLayout.rowPitch;
-                        pSrc += srcRowPitch;
-                    }
-                }
-                memorymanager.Unmap(faceImage, std::move(mappedMemory));
-            }
+//-----------------------------------------------------------------------------
+static bool L_CanBlitMips(Vulkan* pVulkan, VkFormat Format)
+//-----------------------------------------------------------------------------
+{
+    VkFormatProperties FormatProps;
+    vkGetPhysicalDeviceFormatProperties(pVulkan->m_VulkanGpu, Format, &FormatProps);
+    const VkFormatFeatureFlags RequiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (FormatProps.optimalTilingFeatures & RequiredFeatures) == RequiredFeatures;
+}
 
-            // Image barrier for linear image (base)
-            // Linear image will be used as a source for the copy
-            VkPipelineStageFlags srcMask = 0;
-            VkPipelineStageFlags dstMask = 1;
-            uint32_t baseMipLevel = 0;
-            uint32_t mipLevelCount = 1;
-
-            pVulkan->SetImageLayout(cubeFaces[WhichFace].mipImages[WhichMip].m_VmaImage.GetVkBuffer(), 
-                SetupCmdBuffer, 
-                VK_IMAGE_ASPECT_COLOR_BIT, 
-                VK_IMAGE_LAYOUT_PREINITIALIZED, 
-                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
-                srcMask,
-                dstMask,
-                baseMipLevel,
-                mipLevelCount);
-        }   // Each mipmap in each face
-    }   // Each Face
-
-    // Transfer cube map faces to optimal tiling
-
-    // Now that creating the whole thing we need the correct size
-    ImageInfo.extent.width = uiWidth;
-    ImageInfo.extent.height = uiHeight;
+//-----------------------------------------------------------------------------
+static void L_RecordMipBlits(Vulkan* pVulkan, VkCommandBuffer CmdBuffer, VkImage Image, uint32_t Width, uint32_t Height, uint32_t MipLevels, uint32_t ArrayLayers, VkImageLayout FinalLayout)
+//-----------------------------------------------------------------------------
+{
+    // Expects mip 0 to be uploaded and all the levels to be in TRANSFER_DST layout.
+    // Each level is (linear) blitted from the previous level, which is first transitioned to TRANSFER_SRC (waiting for it to be written).
+    for (uint32_t WhichMip = 1; WhichMip < MipLevels; WhichMip++)
+    {
+        pVulkan->SetImageLayout(Image, CmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, WhichMip - 1, 1, 0, ArrayLayers);
+
+        VkImageBlit Blit {};
+        Blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        Blit.srcSubresource.mipLevel = WhichMip - 1;
+        Blit.srcSubresource.baseArrayLayer = 0;
+        Blit.srcSubresource.layerCount = ArrayLayers;
+        Blit.srcOffsets[1] = { (int32_t)std::max(1u, Width >> (WhichMip - 1)), (int32_t)std::max(1u, Height >> (WhichMip - 1)), 1 };
+        Blit.dstSubresource = Blit.srcSubresource;
+        Blit.dstSubresource.mipLevel = WhichMip;
+        Blit.dstOffsets[1] = { (int32_t)std::max(1u, Width >> WhichMip), (int32_t)std::max(1u, Height >> WhichMip), 1 };
+        vkCmdBlitImage(CmdBuffer, Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Blit, VK_FILTER_LINEAR);
+    }
 
-    // Now that we are done creating single images, need to create all mip levels
-    ImageInfo.mipLevels = uiMipLevels;
+    // All but the last level are now blit sources, the last level is still the blit destination.
+    if (MipLevels > 1)
+        pVulkan->SetImageLayout(Image, CmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, FinalLayout, 0, 1, 0, MipLevels - 1, 0, ArrayLayers);
+    pVulkan->SetImageLayout(Image, CmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, FinalLayout, 0, 1, MipLevels - 1, 1, 0, ArrayLayers);
+}
 
-	// Setup texture as blit target with optimal tiling
-	ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	ImageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+//-----------------------------------------------------------------------------
+static VulkanTexInfo L_CreateTextureFromTexData(TextureUploader& Uploader, const VulkanTexData& TexData, const char* pFileName, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Creates the texture and records the upload with the Uploader (which the caller submits).
+    Vulkan* pVulkan = Uploader.GetVulkan();
+    VkResult RetVal;
 
-    if (uiFaces == 6)
-        ImageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    uint32_t uiWidth = TexData.pFaceData[0].pLayerData[0].pMipData[0].Width;
+    uint32_t uiHeight = TexData.pFaceData[0].pLayerData[0].pMipData[0].Height;
+    uint32_t uiDepth = std::max(TexData.Depth, 1u);
+    uint32_t uiFaces = TexData.NumFaces;
+    uint32_t uiMipLevels = TexData.pFaceData[0].pLayerData[0].NumMipLevels;
+    uint32_t uiMipOffset = 0;
+    VkFormat VulkanFormat = TexData.VulkanFormat;
+
+    if (uiDepth > 1 && (uiFaces != 1 || uiMipLevels != 1))
+    {
+        LOGE("3d textures must have a single face and mip level (%s)", pFileName);
+        return {};
+    }
+
+    if (NumMipsToLoad < (int32_t)uiMipLevels)
+    {
+        // Reset the "starting" mip so allocated texture memory is correct.
+        uiMipOffset = uiMipLevels - (uint32_t)NumMipsToLoad;
 
+        uiWidth = TexData.pFaceData[0].pLayerData[0].pMipData[uiMipOffset].Width;
+        uiHeight = TexData.pFaceData[0].pLayerData[0].pMipData[uiMipOffset].Height;
+        uiMipLevels = NumMipsToLoad;
+    }
+
+    // Check that the device supports this format (caller is expected to have handled any fallback)
+    if (!pVulkan->IsTextureFormatSupported(VulkanFormat))
+    {
+        LOGE("Error, texture format (%d) not supported by device: %s", int(VulkanFormat), pFileName);
+        return {};
+    }
+
+    // Generate the mip chain on the gpu (from the one level we have) if requested and the format can be blitted.
+    uint32_t uiUploadMipLevels = uiMipLevels;
+    bool BlitMips = false;
+    if (MipGeneration.Generate == TextureMipGeneration::Mode::GpuBlit && uiMipLevels == 1 && uiDepth == 1)
+    {
+        if (L_CanBlitMips(pVulkan, VulkanFormat))
+        {
+            BlitMips = true;
+            uiMipLevels = CalcMipLevelCount(uiWidth, uiHeight);
+        }
+        else
+        {
+            LOGI("Texture format (%d) does not support linear blits, not generating mips: %s", int(VulkanFormat), pFileName);
+        }
+    }
+
+    // Setup texture as copy target with optimal tiling
+    VkImageCreateInfo ImageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    ImageInfo.flags = (uiFaces == 6) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+    ImageInfo.imageType = (uiDepth > 1) ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+    ImageInfo.format = VulkanFormat;
+    ImageInfo.extent.width = uiWidth;
+    ImageInfo.extent.height = uiHeight;
+    ImageInfo.extent.depth = uiDepth; // Spec says for VK_IMAGE_TYPE_2D depth must be 1
+    ImageInfo.mipLevels = uiMipLevels;
     ImageInfo.arrayLayers = uiFaces;
+    ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ImageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (BlitMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+    ImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ImageInfo.queueFamilyIndexCount = 0;
+    ImageInfo.pQueueFamilyIndices = NULL;
+    ImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
     // Need the return image
     Wrap_VkImage RetImage;
@@ -819,97 +1173,20 @@ VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const
         return {};
     }
 
-    // Image barrier for optimal image (target)
-	// Optimal image will be used as destination for the copy
-    VkPipelineStageFlags srcMask = 0;
-    VkPipelineStageFlags dstMask = 1;
-    uint32_t baseMipLevel = 0;
-    uint32_t mipLevelCount = uiMipLevels;
-    uint32_t baseLayer = 0;
-    uint32_t layerCount = uiFaces;
-
-    pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(),
-        SetupCmdBuffer,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        VK_IMAGE_LAYOUT_PREINITIALIZED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        srcMask,
-        dstMask,
-        baseMipLevel,
-        mipLevelCount,
-        baseLayer,
-        layerCount);
-
-    // Copy cube map faces one by one
-    // Vulkan spec says the order is +X, -X, +Y, -Y, +Z, -Z
+    // Gather the mip levels of each face
+    std::vector<TextureSubresourceData> Subresources;
+    Subresources.reserve(uiFaces * uiUploadMipLevels);
     for (uint32_t WhichFace = 0; WhichFace < uiFaces; WhichFace++)
     {
-        for (uint32_t WhichMip = 0; WhichMip < uiMipLevels; WhichMip++)
+        for (uint32_t WhichMip = 0; WhichMip < uiUploadMipLevels; WhichMip++)
         {
             // TODO: Layers are not supported
             uint32_t WhichLayer = 0;
 
-            uint32_t TexDataMip = WhichMip + uiMipOffset;
-
-            // Copy region for image blit
-		    VkImageCopy copyRegion = {};
-
-            // Source is always base level because we have an image for each face and each mip
-		    copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		    copyRegion.srcSubresource.baseArrayLayer = 0;
-		    copyRegion.srcSubresource.mipLevel = 0;
-		    copyRegion.srcSubresource.layerCount = 1;
-		    copyRegion.srcOffset.x = 0;
-            copyRegion.srcOffset.y = 0;
-            copyRegion.srcOffset.z = 0;
-
-            // Source is the section of the main image
-		    copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		    copyRegion.dstSubresource.baseArrayLayer = WhichFace;
-		    copyRegion.dstSubresource.mipLevel = WhichMip;
-		    copyRegion.dstSubresource.layerCount = 1;
-		    copyRegion.dstOffset.x = 0;
-            copyRegion.dstOffset.y = 0;
-            copyRegion.dstOffset.z = 0;
-
-            // Size is the size of this mip
-            copyRegion.extent.width = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Width;
-            copyRegion.extent.height = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[TexDataMip].Height;
-
-		    copyRegion.extent.depth = 1;
-
-            // Put image copy into command buffer
-		     vkCmdCopyImage(
-                 SetupCmdBuffer,
-                 cubeFaces[WhichFace].mipImages[WhichMip].m_VmaImage.GetVkBuffer(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                 RetImage.m_VmaImage.GetVkBuffer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			     1, &copyRegion);
-        }   // Each mipmap in each face
-    }   // Each Face
-
-    // No longer need the texture data
-    L_FreeTexData(&TexData);
-
-    // Change texture image layout to shader read after the copy
-    VkImageLayout RetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-    srcMask = 0;
-    dstMask = 1;
-    baseMipLevel = 0;
-    mipLevelCount = uiMipLevels;
-    baseLayer = 0;
-    layerCount = uiFaces;
-
-    pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, RetImageLayout,
-        srcMask,
-        dstMask,
-        baseMipLevel,
-        mipLevelCount,
-        baseLayer,
-        layerCount);
-
-    // Submit the command buffer we have been working on
-    pVulkan->FinishSetupCommandBuffer(SetupCmdBuffer);
+            const MipTexData& MipData = TexData.pFaceData[WhichFace].pLayerData[WhichLayer].pMipData[WhichMip + uiMipOffset];
+            Subresources.push_back({ (const uint8_t*)MipData.pData, MipData.Size, MipData.Width, MipData.Height, uiDepth, WhichMip, WhichFace });
+        }
+    }
 
 	// Need a sampler...
     VkSampler RetSampler;
@@ -924,6 +1201,8 @@ VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const
 	ImageViewInfo.image = RetImage.m_VmaImage.GetVkBuffer();
     if (uiFaces == 6)
         ImageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+    else if (uiDepth > 1)
+        ImageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
     else
         ImageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 
@@ -933,10 +1212,9 @@ VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const
 	ImageViewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
 	ImageViewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
 	ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	ImageViewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	ImageViewInfo.subresourceRange.baseMipLevel = 0;
     ImageViewInfo.subresourceRange.levelCount = uiMipLevels;
 	ImageViewInfo.subresourceRange.baseArrayLayer = 0;
-	ImageViewInfo.subresourceRange.layerCount = 1;
     if (uiFaces == 6)
         ImageViewInfo.subresourceRange.layerCount = 6;
     else
@@ -946,21 +1224,228 @@ VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const
 	RetVal = vkCreateImageView(pVulkan->m_VulkanDevice, &ImageViewInfo, NULL, &RetImageView);
 	if (!CheckVkError("vkCreateImageView()", RetVal))
 	{
+        vkDestroySampler(pVulkan->m_VulkanDevice, RetSampler, NULL);
         return {};
 	}
 
-    // LOGI("vkCreateImageView: %s -> %p", pFileName, RetImageView);
+    // Record the upload last, once nothing else can fail (RetImage is destroyed on the failure paths above, so must not be referenced by recorded commands).
+    VkImageLayout RetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (!RecordImageUpload(Uploader, RetImage.m_VmaImage.GetVkBuffer(), VulkanFormat, Subresources, uiMipLevels, uiFaces, BlitMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : RetImageLayout))
+    {
+        // Nothing referencing RetImage was recorded (staging allocation failed before any commands).
+        LOGE("Unable to upload texture image (%s)", pFileName);
+        vkDestroyImageView(pVulkan->m_VulkanDevice, RetImageView, NULL);
+        vkDestroySampler(pVulkan->m_VulkanDevice, RetSampler, NULL);
+        return {};
+    }
+    if (BlitMips)
+    {
+        // Same command buffer as the upload (get it after RecordImageUpload, which may have started a new one)
+        L_RecordMipBlits(pVulkan, Uploader.GetCommandBuffer(), RetImage.m_VmaImage.GetVkBuffer(), uiWidth, uiHeight, uiMipLevels, uiFaces, RetImageLayout);
+    }
 
+    // Set the return values
+    return VulkanTexInfo{ uiWidth, uiHeight, uiDepth, uiMipLevels, ImageInfo.format, RetImageLayout, std::move(RetImage.m_VmaImage), RetSampler, RetImageView };
+}
 
-	// Cleanup
-    cubeFaces.clear();
+//-----------------------------------------------------------------------------
+static VulkanTexInfo L_CreateTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, VulkanTexData& TexData, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Frees TexData
+    if (!pVulkan->IsTextureFormatSupported(TexData.VulkanFormat))
+    {
+        const VkFormat VulkanFormat = TexData.VulkanFormat;
+        L_FreeTexData(&TexData);
+        return L_LoadFallbackKTXTexture(pVulkan, assetManager, pFileName, VulkanFormat, SamplerMode, mipBias, MipGeneration);
+    }
 
+    // Upload using the setup command buffer
+    TextureUploader Uploader(pVulkan);
+    VulkanTexInfo RetTex = L_CreateTextureFromTexData(Uploader, TexData, pFileName, SamplerMode, NumMipsToLoad, mipBias, MipGeneration);
 
-	// ****************************************************
-	// ****************************************************
+    // Submit the command buffer we have been working on
+    RetTex.SetupSubmissionId = Uploader.Finish();
 
-    // Set the return values
-    return VulkanTexInfo{ uiWidth, uiHeight, 1, uiMipLevels, ImageInfo.format, RetImageLayout, std::move(RetImage.m_VmaImage), RetSampler, RetImageView };
+    // No longer need the texture data
+    L_FreeTexData(&TexData);
+
+    return RetTex;
+}
+
+//-----------------------------------------------------------------------------
+VulkanTexInfo LoadKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    // Texture Convert Command Line: simpletextureconverter hud.tga hud.ktx -format R8G8B8A8Unorm -flipY
+
+    LOGI("Loading KTX texture: %s", pFileName);
+
+    VulkanTexData TexData = {};
+    if (!L_LoadTexData(*pVulkan, assetManager, pFileName, &TexData, MipGeneration))
+    {
+        return {};
+    }
+    return L_CreateTexture(pVulkan, assetManager, pFileName, TexData, SamplerMode, NumMipsToLoad, mipBias, MipGeneration);
+}
+
+//-----------------------------------------------------------------------------
+void DecodedKTXTexture::TexDataDeleter::operator()(VulkanTexData* pTexData) const
+//-----------------------------------------------------------------------------
+{
+    L_FreeTexData(pTexData);
+    delete pTexData;
+}
+
+//-----------------------------------------------------------------------------
+bool DecodeKTXTexture(const Vulkan& vulkan, const char* pFileName, const tcb::span<const char> FileData, DecodedKTXTexture* pDecoded, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    pDecoded->m_pTexData.reset();
+    std::unique_ptr<VulkanTexData, DecodedKTXTexture::TexDataDeleter> pTexData{ new VulkanTexData{} };
+    if (!L_ParseTexData(vulkan, pFileName, FileData, pTexData.get(), MipGeneration))
+    {
+        return false;
+    }
+    pDecoded->m_pTexData = std::move(pTexData);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+VulkanTexInfo CreateDecodedKTXTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, DecodedKTXTexture& Decoded, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    if (Decoded.IsEmpty())
+    {
+        LOGE("CreateDecodedKTXTexture: no decoded data for %s", pFileName);
+        return {};
+    }
+    // Frees the decoded data
+    auto pTexData = std::move(Decoded.m_pTexData);
+    return L_CreateTexture(pVulkan, assetManager, pFileName, *pTexData, SamplerMode, NumMipsToLoad, mipBias, MipGeneration);
+}
+
+//-----------------------------------------------------------------------------
+VulkanTexInfo LoadKTXTextureFromMemory(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, const tcb::span<const char> FileData, VkSamplerAddressMode SamplerMode, int32_t NumMipsToLoad, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    LOGI("Loading KTX texture (from memory): %s", pFileName);
+
+    VulkanTexData TexData = {};
+    if (!L_ParseTexData(*pVulkan, pFileName, FileData, &TexData, MipGeneration))
+    {
+        return {};
+    }
+    return L_CreateTexture(pVulkan, assetManager, pFileName, TexData, SamplerMode, NumMipsToLoad, mipBias, MipGeneration);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t GetKTXTextureMipLevels(const char* pFileName, const tcb::span<const char> FileData)
+//-----------------------------------------------------------------------------
+{
+    // Header only (no decode), mirrors the level counts L_ParseKTXBuffer and L_ParseKTX2Buffer end up with.
+    size_t filenameLength = strlen( pFileName );
+    if (filenameLength > 5 && strcmp( pFileName + filenameLength - 5, ".ktx2" ) == 0)
+    {
+        KTX2Header Header;
+        if (FileData.size() < sizeof(KTX2Header))
+            return 0;
+        memcpy(&Header, FileData.data(), sizeof(KTX2Header));
+        if (memcmp(Header.identifier, KTX2_IDENTIFIER_REF.data(), KTX2_IDENTIFIER_REF.size()) != 0)
+            return 0;
+        return std::max(1u, Header.levelCount);
+    }
+    else if (filenameLength > 4 && strcmp( pFileName + filenameLength - 4, ".ktx" ) == 0)
+    {
+        KTXHeader Header;
+        if (FileData.size() < sizeof(KTXHeader))
+            return 0;
+        memcpy(&Header, FileData.data(), sizeof(KTXHeader));
+        if (memcmp(Header.identifier, KTX_IDENTIFIER_REF.data(), KTX_IDENTIFIER_REF.size()) != 0 || Header.endianness != KTX_ENDIAN_REF)
+            return 0;
+        return std::max(1u, Header.numberOfMipmapLevels);
+    }
+    // png (no mips in the file)
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<VulkanTexInfo> LoadKTXTextures(Vulkan* pVulkan, AssetManager& assetManager, CWorker& worker, const tcb::span<const std::string> filenames, VkSamplerAddressMode SamplerMode, float mipBias, const TextureMipGeneration& MipGeneration)
+//-----------------------------------------------------------------------------
+{
+    LOGI("Loading %zu KTX textures", filenames.size());
+
+    // One job per file, reading and decoding on the worker threads.
+    struct Job
+    {
+        const Vulkan*   pVulkan = nullptr;
+        AssetManager*   pAssetManager = nullptr;
+        const char*     pFileName = nullptr;
+        const TextureMipGeneration* pMipGeneration = nullptr;
+        VulkanTexData   TexData = {};
+        bool            Loaded = false;
+        Semaphore       Done{ 0 };
+    };
+    std::vector<Job> jobs(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        Job& job = jobs[i];
+        job.pVulkan = pVulkan;
+        job.pAssetManager = &assetManager;
+        job.pFileName = filenames[i].c_str();
+        job.pMipGeneration = &MipGeneration;
+        const auto JobFn = [](void* pParam) {
+            Job& job = *static_cast<Job*>(pParam);
+            job.Loaded = L_LoadTexData(*job.pVulkan, *job.pAssetManager, job.pFileName, &job.TexData, *job.pMipGeneration);
+            job.Done.Post();
+        };
+        if (worker.NumThreads() > 0)
+            worker.DoWork(JobFn, &job, 0);
+        else
+            JobFn(&job);    // no threads, decode on this thread
+    }
+
+    // Upload each texture (in order) as soon as it is decoded, while the workers continue decoding the rest.  All the uploads go in to a single setup command buffer (unless they overflow the staging ring buffer).
+    std::vector<VulkanTexInfo> textures;
+    textures.reserve(filenames.size());
+    std::vector<std::pair<size_t, VkFormat>> fallbacks;
+    TextureUploader Uploader(pVulkan);
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        Job& job = jobs[i];
+        job.Done.Wait();
+        if (!job.Loaded)
+        {
+            textures.emplace_back();
+            continue;
+        }
+        if (pVulkan->IsTextureFormatSupported(job.TexData.VulkanFormat))
+        {
+            textures.push_back(L_CreateTextureFromTexData(Uploader, job.TexData, job.pFileName, SamplerMode, 0x7fffffff, mipBias, MipGeneration));
+        }
+        else
+        {
+            // Fallback loads (if any) are done after we are finished with the setup command buffer.
+            textures.emplace_back();
+            fallbacks.push_back({ i, job.TexData.VulkanFormat });
+        }
+        L_FreeTexData(&job.TexData);
+    }
+
+    // Submit the command buffer we have been working on
+    const uint64_t SetupSubmissionId = Uploader.Finish();
+    for (auto& texture : textures)
+    {
+        if (!texture.IsEmpty())
+            texture.SetupSubmissionId = SetupSubmissionId;
+    }
+
+    for (const auto& [index, VulkanFormat] : fallbacks)
+    {
+        textures[index] = L_LoadFallbackKTXTexture(pVulkan, assetManager, jobs[index].pFileName, VulkanFormat, SamplerMode, mipBias, MipGeneration);
+    }
+    return textures;
 }
 
 //-----------------------------------------------------------------------------
@@ -1056,83 +1541,15 @@ void DumpKTXMipFiles(AssetManager& assetManager, std::string SourceFile, std::st
 VulkanTexInfo LoadPPMTexture(Vulkan* pVulkan, AssetManager& assetManager, const char* pFileName, VkSamplerAddressMode SamplerMode)
 //-----------------------------------------------------------------------------
 {
+    // Same decode and upload path as the other formats (L_ParseTexData handles .ppm), so LoadKTXTextures can also load .ppm files.
     LOGI("Loading PPM texture: %s", pFileName);
 
-    std::vector<char> fileData;
-    if (!assetManager.LoadFileIntoMemory(pFileName, fileData))
+    VulkanTexData TexData = {};
+    if (!L_LoadTexData(*pVulkan, assetManager, pFileName, &TexData, {}))
     {
-        LOGE("Error reading texture file: %s", pFileName);
         return {};
     }
-
-    if (fileData.size() < 20)
-        return {};
-    auto fileDataIt = fileData.begin();
-    if (*fileDataIt++ != 'P' || *fileDataIt++ != '6' || !isspace(*fileDataIt++))
-        return {};
-    while (isspace(*fileDataIt))
-        ++fileDataIt;
-    uint32_t width = 0, height = 0, maxColor = 0;
-    while (isdigit(*fileDataIt))
-        width = width * 10 + uint32_t(*fileDataIt++ - '0');
-    while (isspace(*fileDataIt))
-        ++fileDataIt;
-    while (isdigit(*fileDataIt))
-        height = height * 10 + uint32_t(*fileDataIt++ - '0');
-    while (isspace(*fileDataIt))
-        ++fileDataIt;
-    while (isdigit(*fileDataIt))
-        maxColor = maxColor * 10 + uint32_t(*fileDataIt++ - '0');
-    uint32_t bytesPerPPMPixel = maxColor < 256 ? 1 : 2;
-    if (!isspace(*fileDataIt++))
-        return {};
-    // Images follow.
-    size_t singleImageBytes = width * height * 3 * bytesPerPPMPixel;
-    // If there are multiple images treat this as a 3d texture.
-    size_t dataOffset = fileDataIt - fileData.begin();
-    size_t dataBytes = fileData.size() - dataOffset;
-    uint32_t depth = (uint32_t)(dataBytes / singleImageBytes);
-
-    // Copy image data in to correct format for copying in to vulkan texture.
-
-    //VkFormat format = VK_FORMAT_R8_UNORM;
-    VkFormat format = VK_FORMAT_R8G8_UNORM;
-    size_t bytesPerPixel = 2;
-    std::vector<uint8_t> targetData;
-    targetData.resize(width * height * depth * bytesPerPixel);
-    if (bytesPerPixel == 1)
-    {
-        for (auto& target : targetData)
-        {
-            target = *fileDataIt;
-            fileDataIt += 3;
-        }
-    }
-    else
-    {
-        auto targetIt = targetData.begin();
-        for (size_t i = 0; i < width * height * depth; ++i)
-        {
-            *targetIt = *fileDataIt;
-            ++targetIt;
-            ++fileDataIt;
-            *targetIt = *fileDataIt;
-            ++targetIt;
-            ++fileDataIt;
-            if (bytesPerPixel > 2)
-            {
-                *targetIt = *fileDataIt;
-                ++targetIt;
-            }
-            if (bytesPerPixel > 3)
-            {
-                *targetIt = 255;   // no alpha in ppm
-                ++targetIt;
-            }
-            ++fileDataIt;
-        }
-    }
-    return LoadTextureFromBuffer(pVulkan, targetData.data(), targetData.size(), width, height, depth, format, SamplerMode);
+    return L_CreateTexture(pVulkan, assetManager, pFileName, TexData, SamplerMode, 0x7fffffff, 0.0f, {});
 }
 
 //-----------------------------------------------------------------------------
@@ -1145,148 +1562,38 @@ VulkanTexInfo LoadTextureFromBuffer(Vulkan* pVulkan, const void* pData, size_t D
     uint32_t MipLevels = 1;
     VkFormat VulkanFormat = Format;
 
-    // Image creation info.  Will change below based on need
-    VkImageCreateInfo ImageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-    ImageInfo.flags = 0;
-    ImageInfo.imageType = VK_IMAGE_TYPE_2D;
-    ImageInfo.format = VulkanFormat;
-    ImageInfo.extent.width = Width;
-    ImageInfo.extent.height = Height;
-    ImageInfo.extent.depth = Depth;
-    ImageInfo.mipLevels = 1;	// Set to 1 since making each level.  Later will be set to MipLevels;
-    ImageInfo.arrayLayers = 1;  // Set to 6 for cube maps
-    ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    ImageInfo.tiling = VK_IMAGE_TILING_LINEAR;
-    ImageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-    ImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    ImageInfo.queueFamilyIndexCount = 0;
-    ImageInfo.pQueueFamilyIndices = NULL;
-    ImageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;   // VK_IMAGE_LAYOUT_UNDEFINED says data not guaranteed to be preserved when changing state
-
-    struct CubeFace
+    if (Vulkan::FormatIsCompressed(VulkanFormat))
     {
-        CubeFace(uint32_t depthSlices, uint32_t mips) : mipsPerDepthSlice(mips), images(depthSlices*mips)
-        {}
-        const auto& GetImage(uint32_t depth, uint32_t mip) const { return images[depth * mipsPerDepthSlice]; }
-        auto& GetImage(uint32_t depth, uint32_t mip) { return images[depth * mipsPerDepthSlice + mip]; }
-        const uint32_t mipsPerDepthSlice;
-        std::vector<Wrap_VkImage> images;
-    };
-
-    // Allocate the depth slices (and contained mips) for each face
-    std::vector<CubeFace> cubeFaces;
-    cubeFaces.reserve(Faces);
-    for (uint32_t WhichFace = 0; WhichFace < Faces; ++WhichFace)
-    {
-        cubeFaces.emplace_back(Depth, MipLevels);
+        LOGE("LoadTextureFromBuffer: Compressed formats are not supported (%d)", int(VulkanFormat));
+        return {};
     }
-
-    // Create and copy mip levels
-
-    // Need the setup command buffer for loading images
-    VkCommandBuffer SetupCmdBuffer = pVulkan->StartSetupCommandBuffer();
-
-    uint32_t FormatBytesPerPixel = 4;
-    if (VulkanFormat == VK_FORMAT_R32G32B32A32_SFLOAT)
-        FormatBytesPerPixel = 16;
-    else if (VulkanFormat >= VK_FORMAT_R8_UNORM && VulkanFormat <= VK_FORMAT_R8_SRGB)
-        FormatBytesPerPixel = 1;
-    else if (VulkanFormat >= VK_FORMAT_R8G8_UNORM && VulkanFormat <= VK_FORMAT_R8G8_SRGB)
-        FormatBytesPerPixel = 2;
-    else if (VulkanFormat >= VK_FORMAT_R16_UNORM && VulkanFormat <= VK_FORMAT_R16_SFLOAT)
-        FormatBytesPerPixel = 2;
-
-    const uint8_t* pData8 = static_cast<const uint8_t*>(pData);
-
-    // Load separate cube map faces into linear tiled textures (for copying only).
-    // Split into faces and 2d depth slices because linear textures have extremely limited format/size restrictions.
-    for (uint32_t WhichFace = 0; WhichFace < Faces; WhichFace++)
+    uint32_t FormatBytesPerPixel = Vulkan::FormatBytesPerBlock(VulkanFormat);
+    if (FormatBytesPerPixel == 0)
+        FormatBytesPerPixel = 4;
+    const size_t ImageSize = size_t(Width) * Height * Depth * FormatBytesPerPixel;
+    if (DataSize < ImageSize)
     {
-        for (uint32_t WhichDepth = 0; WhichDepth < Depth; WhichDepth++)
-        {
-            for (uint32_t WhichMip = 0; WhichMip < MipLevels; WhichMip++)
-            {
-                ImageInfo.extent.width = Width;
-                ImageInfo.extent.height = Height;
-                ImageInfo.extent.depth = 1;
-
-                Wrap_VkImage& faceImage = cubeFaces[WhichFace].GetImage(WhichDepth, WhichMip);
-                if (!faceImage.Initialize(pVulkan, ImageInfo, MemoryManager::MemoryUsage::CpuToGpu))
-                {
-                    LOGE("LoadTextureFromBuffer: Unable to initialize mip %d of face %d", WhichMip + 1, WhichFace + 1);
-                    return {};
-                }
-
-                // ... copy texture data into the image
-                VkImageSubresource SubresInfo = {};
-                SubresInfo.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                SubresInfo.mipLevel = 0;
-                SubresInfo.arrayLayer = 0;
-
-                VkSubresourceLayout SubResLayout = {};
-                auto& faceImageMem = faceImage.m_VmaImage;
-                vkGetImageSubresourceLayout(pVulkan->m_VulkanDevice, faceImageMem.GetVkBuffer(), &SubresInfo, &SubResLayout);
-
-                {
-                    MemoryManager& memorymanager = pVulkan->GetMemoryManager();
-                    auto mappedMemory = memorymanager.Map<uint8_t>(faceImageMem);
-                    if (SubResLayout.rowPitch == Width * FormatBytesPerPixel)
-                    {
-                        memcpy(mappedMemory.data(), pData8, SubResLayout.size);
-                        pData8 += Width * Height * FormatBytesPerPixel;
-                    }
-                    else
-                    {
-                        uint8_t* pDest = mappedMemory.data();
-                        for (uint32_t h = 0; h < Height; ++h)
-                        {
-                            memcpy(pDest, pData8, Width * FormatBytesPerPixel);
-                            pDest += SubResLayout.rowPitch;
-                            pData8 += Width * FormatBytesPerPixel;
-                        }
-                    }
-                    memorymanager.Unmap(faceImageMem, std::move(mappedMemory));
-                }
+        LOGE("LoadTextureFromBuffer: Buffer is too small (%zu bytes) for the texture (%zu bytes)", DataSize, ImageSize);
+        return {};
+    }
 
-                // Image barrier for linear image (base)
-                // Linear image will be used as a source for the copy
-                VkPipelineStageFlags srcMask = 0;
-                VkPipelineStageFlags dstMask = 1;
-                uint32_t baseMipLevel = 0;
-                uint32_t mipLevelCount = 1;
-
-                pVulkan->SetImageLayout(faceImageMem.GetVkBuffer(),
-                    SetupCmdBuffer,
-                    VK_IMAGE_ASPECT_COLOR_BIT,
-                    VK_IMAGE_LAYOUT_PREINITIALIZED,
-                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    srcMask,
-                    dstMask,
-                    baseMipLevel,
-                    mipLevelCount);
-            }   // Each mipmap in each depth slice
-        }   // Each depth slice in each face
-    }   // Each Face
-
-    // Transfer cube map faces to optimal tiling
-
-    // Now that creating the whole thing we need the correct size and type
+    // Setup texture as copy target with optimal tiling
+    VkImageCreateInfo ImageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    ImageInfo.flags = (Faces == 6) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+    ImageInfo.imageType = Depth == 1 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_3D;
+    ImageInfo.format = VulkanFormat;
     ImageInfo.extent.width = Width;
     ImageInfo.extent.height = Height;
     ImageInfo.extent.depth = Depth;
-    ImageInfo.imageType = Depth == 1 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_3D;
-
-    // Now that we are done creating single images, need to create all mip levels
     ImageInfo.mipLevels = MipLevels;
-
-    // Setup texture as blit target with optimal tiling
-    ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    ImageInfo.usage = FinalUsage;
-
-    if (Faces == 6)
-        ImageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-
     ImageInfo.arrayLayers = Faces;
+    ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ImageInfo.usage = FinalUsage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ImageInfo.queueFamilyIndexCount = 0;
+    ImageInfo.pQueueFamilyIndices = NULL;
+    ImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
     // Need the return image
     Wrap_VkImage RetImage;
@@ -1296,91 +1603,7 @@ VulkanTexInfo LoadTextureFromBuffer(Vulkan* pVulkan, const void* pData, size_t D
         return {};
     }
 
-    // Image barrier for optimal image (target)
-    // Optimal image will be used as destination for the copy
-    VkPipelineStageFlags srcMask = 0;
-    VkPipelineStageFlags dstMask = 1;
-    uint32_t baseMipLevel = 0;
-    uint32_t mipLevelCount = MipLevels;
-    uint32_t baseLayer = 0;
-    uint32_t layerCount = Faces;
-
-    pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(),
-        SetupCmdBuffer,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        VK_IMAGE_LAYOUT_PREINITIALIZED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        srcMask,
-        dstMask,
-        baseMipLevel,
-        mipLevelCount,
-        baseLayer,
-        layerCount);
-
-    // Copy cube map faces one by one
-    // Vulkan spec says the order is +X, -X, +Y, -Y, +Z, -Z
-    for (uint32_t WhichFace = 0; WhichFace < Faces; WhichFace++)
-    {
-        // Copy depth slices one at a time
-        for (uint32_t WhichDepth = 0; WhichDepth < Depth; WhichDepth++)
-        {
-            for (uint32_t WhichMip = 0; WhichMip < MipLevels; WhichMip++)
-            {
-                // Copy region for image blit
-                VkImageCopy copyRegion = {};
-
-                // Source is always base level because we have an image for each face and each mip
-                copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                copyRegion.srcSubresource.baseArrayLayer = 0;
-                copyRegion.srcSubresource.mipLevel = 0;
-                copyRegion.srcSubresource.layerCount = 1;
-                copyRegion.srcOffset.x = 0;
-                copyRegion.srcOffset.y = 0;
-                copyRegion.srcOffset.z = 0;
-
-                // Source is the section of the main image
-                copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                copyRegion.dstSubresource.baseArrayLayer = WhichFace;
-                copyRegion.dstSubresource.mipLevel = WhichMip;
-                copyRegion.dstSubresource.layerCount = 1;
-                copyRegion.dstOffset.x = 0;
-                copyRegion.dstOffset.y = 0;
-                copyRegion.dstOffset.z = WhichDepth;
-
-                // Size is the size of this mip
-                copyRegion.extent.width = Width;
-                copyRegion.extent.height = Height;
-                copyRegion.extent.depth = 1;
-
-                // Put image copy into command buffer
-                vkCmdCopyImage(
-                    SetupCmdBuffer,
-                    cubeFaces[WhichFace].GetImage(WhichDepth, WhichMip).m_VmaImage.GetVkBuffer(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    RetImage.m_VmaImage.GetVkBuffer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    1, &copyRegion);
-            }   // Each mipmap in each depth slice
-        }   // Each depth slice in each face
-    }   // Each Face
-
-    // Change texture image layout to the 'final' settings now we are done transferring
-    srcMask = 0;
-    dstMask = 1;
-    baseMipLevel = 0;
-    mipLevelCount = MipLevels;
-    baseLayer = 0;
-    layerCount = Faces;
-
-    pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, FinalLayout,
-        srcMask,
-        dstMask,
-        baseMipLevel,
-        mipLevelCount,
-        baseLayer,
-        layerCount);
-
-    // Submit the command buffer we have been working on
-    pVulkan->FinishSetupCommandBuffer(SetupCmdBuffer);
-
+    // Create the sampler and view before recording the upload so a failure here leaves no gpu work referencing RetImage.
     // Need a sampler...
     VkSampler RetSampler;
     if (!CreateSampler(pVulkan, SamplerMode, Filter, VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK, false, 0.0f, &RetSampler))
@@ -1405,7 +1628,7 @@ VulkanTexInfo LoadTextureFromBuffer(Vulkan* pVulkan, const void* pData, size_t D
     ImageViewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
     ImageViewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
     ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    ImageViewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    ImageViewInfo.subresourceRange.baseMipLevel = 0;
     ImageViewInfo.subresourceRange.levelCount = MipLevels;
     ImageViewInfo.subresourceRange.baseArrayLayer = 0;
     ImageViewInfo.subresourceRange.layerCount = 1;
@@ -1418,14 +1641,30 @@ VulkanTexInfo LoadTextureFromBuffer(Vulkan* pVulkan, const void* pData, size_t D
     RetVal = vkCreateImageView(pVulkan->m_VulkanDevice, &ImageViewInfo, NULL, &RetImageView);
     if (!CheckVkError("vkCreateImageView()", RetVal))
     {
+        vkDestroySampler(pVulkan->m_VulkanDevice, RetSampler, NULL);
         return {};
     }
 
-    // Cleanup
-    cubeFaces.clear();
+    // Copy all the depth slices in one go (data is tightly packed)
+    const TextureSubresourceData Subresource { static_cast<const uint8_t*>(pData), ImageSize, Width, Height, Depth, 0, 0 };
+    uint64_t SetupSubmissionId = 0;
+    {
+        TextureUploader Uploader(pVulkan);
+        if (!RecordImageUpload(Uploader, RetImage.m_VmaImage.GetVkBuffer(), VulkanFormat, { &Subresource, 1 }, MipLevels, Faces, FinalLayout))
+        {
+            // Nothing referencing RetImage was recorded (staging allocation failed before any commands).
+            LOGE("LoadTextureFromBuffer: Unable to upload texture image");
+            vkDestroyImageView(pVulkan->m_VulkanDevice, RetImageView, NULL);
+            vkDestroySampler(pVulkan->m_VulkanDevice, RetSampler, NULL);
+            return {};
+        }
+        // Submit the command buffer we have been working on (not waited on, later queue submissions execute after it)
+        SetupSubmissionId = Uploader.Finish();
+    }
 
     // Set the return values
     VulkanTexInfo RetTex{ Width, Height, Depth, MipLevels, ImageInfo.format, FinalLayout, std::move( RetImage.m_VmaImage ), RetSampler, RetImageView };
+    RetTex.SetupSubmissionId = SetupSubmissionId;
     return RetTex;
 }
 
@@ -1459,6 +1698,7 @@ VulkanTexInfo& VulkanTexInfo::operator=(VulkanTexInfo&& other) noexcept
         FirstMip = other.FirstMip;
         Format = other.Format;
         ImageLayout = other.ImageLayout;
+        SetupSubmissionId = other.SetupSubmissionId;
         // Actually transfer ownership from 'other'
         VmaImage = std::move(other.VmaImage);
         Sampler = other.Sampler;
@@ -1492,10 +1732,16 @@ void VulkanTexInfo::Release( Vulkan* pVulkan )
     Sampler = VK_NULL_HANDLE;
 
     if( VmaImage )
+    {
+        // Texture loaders do not wait for their uploads (or layout transitions) to complete, make sure the gpu is done with the image (usually long since complete, so no stall).
+        if( SetupSubmissionId != 0 && !pVulkan->IsSetupSubmissionComplete( SetupSubmissionId ) )
+            pVulkan->WaitSetupSubmission( SetupSubmissionId );
         pVulkan->GetMemoryManager().Destroy( std::move( VmaImage ) );
+    }
 
     Image = VK_NULL_HANDLE;
     Memory = VK_NULL_HANDLE;
+    SetupSubmissionId = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -1514,20 +1760,9 @@ VulkanTexInfo CreateTextureObject(Vulkan* pVulkan, uint32_t uiWidth, uint32_t ui
 }
 
 //-----------------------------------------------------------------------------
-VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo)
+VkImageCreateInfo GetTextureObjectImageInfo(const CreateTexObjectInfo& texInfo, MemoryManager::MemoryUsage* pMemoryUsage)
 //-----------------------------------------------------------------------------
 {
-    VkResult RetVal;
-
-    if(texInfo.pName == nullptr)
-        LOGI("CreateTextureObject (%dx%d): <No Name>", texInfo.uiWidth, texInfo.uiHeight);
-    else
-        LOGI("CreateTextureObject (%dx%d): %s", texInfo.uiWidth, texInfo.uiHeight, texInfo.pName);
-
-    VkSampler RetSampler = VK_NULL_HANDLE;
-    VkImageView RetImageView = VK_NULL_HANDLE;
-    VkImageLayout RetImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
     // How this texture object will be used.
     MemoryManager::MemoryUsage MemoryUsage = MemoryManager::MemoryUsage::GpuExclusive;
 
@@ -1603,6 +1838,23 @@ VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, const CreateTexObjectInfo& te
         if(texInfo.Msaa != VK_SAMPLE_COUNT_1_BIT )
             ImageInfo.flags |= VK_IMAGE_CREATE_SAMPLE_LOCATIONS_COMPATIBLE_DEPTH_BIT_EXT;
         break;
+    case TT_RENDER_TARGET_TRANSIENT:
+        ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        ImageInfo.samples = texInfo.Msaa;
+        // Contents never leave the tile memory, so dont need to be backed by memory
+        MemoryUsage = MemoryManager::MemoryUsage::GpuLazilyAllocated;
+        break;
+    case TT_DEPTH_TARGET_TRANSIENT:
+        ImageInfo.mipLevels = 1;
+        ImageInfo.arrayLayers = 1;
+        ImageInfo.samples = texInfo.Msaa;
+        ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        if(texInfo.Msaa != VK_SAMPLE_COUNT_1_BIT )
+            ImageInfo.flags |= VK_IMAGE_CREATE_SAMPLE_LOCATIONS_COMPATIBLE_DEPTH_BIT_EXT;
+        MemoryUsage = MemoryManager::MemoryUsage::GpuLazilyAllocated;
+        break;
 
     default:
         assert(0);
@@ -1614,135 +1866,209 @@ VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, const CreateTexObjectInfo& te
     if ((texInfo.Flags & TEXTURE_FLAGS::ForceLinearTiling) != 0)
         ImageInfo.tiling = VK_IMAGE_TILING_LINEAR;
 
-    // Need the return image
-    Wrap_VkImage RetImage;
-    bool ImageInitialized = RetImage.Initialize( pVulkan, ImageInfo, MemoryUsage, texInfo.pName );
-    if( !ImageInitialized && MemoryUsage == MemoryManager::MemoryUsage::GpuLazilyAllocated )
+    if (pMemoryUsage)
+        *pMemoryUsage = MemoryUsage;
+    return ImageInfo;
+}
+
+//-----------------------------------------------------------------------------
+static bool CreateTextureObjectViewAndSampler(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo, const VkImageCreateInfo& ImageInfo, VkImage Image, VkImageLayout* pRetImageLayout, VkImageView* pRetImageView, VkSampler* pRetSampler, uint64_t* pRetSetupSubmissionId)
+//-----------------------------------------------------------------------------
+{
+    // ... and an ImageView
+    VkImageViewCreateInfo ImageViewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    ImageViewInfo.flags = 0;
+    ImageViewInfo.image = Image;
+    ImageViewInfo.viewType = (texInfo.uiDepth == 1) ? VK_IMAGE_VIEW_TYPE_2D : VK_IMAGE_VIEW_TYPE_3D; // <== No support for VK_IMAGE_VIEW_TYPE_CUBE
+    ImageViewInfo.format = ImageInfo.format;
+    ImageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_R;
+    ImageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_G;
+    ImageViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_B;
+    ImageViewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_A;
+    ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ImageViewInfo.subresourceRange.baseMipLevel = 0;
+    ImageViewInfo.subresourceRange.levelCount = ImageInfo.mipLevels;
+    ImageViewInfo.subresourceRange.baseArrayLayer = 0;
+    ImageViewInfo.subresourceRange.layerCount = 1;
+
+    VkSamplerAddressMode SamplerMode = texInfo.SamplerMode;
+
+    VkBorderColor BorderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    switch (texInfo.TexType)
     {
-        LOGI( "Unable to initialize GpuLazilyAllocated image (probably not supported by GPU hardware).  Falling back to GpuExclusive" );
-        MemoryUsage = MemoryManager::MemoryUsage::GpuExclusive;
-        ImageInfo.usage &= ~VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
-        ImageInitialized = RetImage.Initialize( pVulkan, ImageInfo, MemoryUsage, texInfo.pName );
+    case TT_SHADING_RATE_IMAGE:
+    case TT_CPU_UPDATE:
+    case TT_NORMAL:
+    case TT_RENDER_TARGET:
+    case TT_RENDER_TARGET_WITH_STORAGE:
+    case TT_RENDER_TARGET_TRANSFERSRC:
+    case TT_RENDER_TARGET_SUBPASS:
+    case TT_RENDER_TARGET_TRANSIENT:
+    case TT_COMPUTE_TARGET:
+        ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        break;
+    case TT_DEPTH_TARGET:
+    case TT_DEPTH_TARGET_TRANSIENT:
+        ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        SamplerMode = (SamplerMode == VK_SAMPLER_ADDRESS_MODE_MAX_ENUM) ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER : SamplerMode;    // default to VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER
+        BorderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        break;
+    default:
+        assert(0);
+        break;
     }
-    if (!ImageInitialized)
+    SamplerMode = (SamplerMode == VK_SAMPLER_ADDRESS_MODE_MAX_ENUM) ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE : SamplerMode; // default to VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+
+    VkResult RetVal = vkCreateImageView(pVulkan->m_VulkanDevice, &ImageViewInfo, NULL, pRetImageView);
+    if (!CheckVkError("vkCreateImageView()", RetVal))
     {
-        LOGE("Unable to initialize image (Not from file)");
-        return {};
+        return false;
     }
 
+    // LOGI("vkCreateImageView: %s -> %p", pName, RetImageView);
+
+    // Need a sampler...
+    if (!CreateSampler(pVulkan, SamplerMode, texInfo.FilterMode, BorderColor, texInfo.UnNormalizedCoordinates, 0.0f, pRetSampler))
+    {
+        vkDestroyImageView(pVulkan->m_VulkanDevice, *pRetImageView, NULL);
+        *pRetImageView = VK_NULL_HANDLE;
+        return false;
+    }
+
+    // Transition the image to its initial layout (after the view and sampler so the failure paths above leave no gpu work referencing the image)...
     VkCommandBuffer SetupCmdBuffer = pVulkan->StartSetupCommandBuffer();
     switch (texInfo.TexType)
     {
     case TT_SHADING_RATE_IMAGE:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
-        RetImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_GENERAL;
         break;
     case TT_CPU_UPDATE:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
-        RetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         break;
     case TT_NORMAL:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
-        RetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         break;
     case TT_RENDER_TARGET:
     case TT_RENDER_TARGET_WITH_STORAGE:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, 1, 0, 1);
-        RetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, 1, 0, 1);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         break;
     case TT_RENDER_TARGET_TRANSFERSRC:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, 1, 0, 1);
-        RetImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, 1, 0, 1);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         break;
     case TT_RENDER_TARGET_SUBPASS:
-        RetImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    case TT_RENDER_TARGET_TRANSIENT:
+        *pRetImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         break;
     case TT_COMPUTE_TARGET:
-        pVulkan->SetImageLayout(RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_GENERAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
-        RetImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        pVulkan->SetImageLayout(Image, SetupCmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_GENERAL, (VkPipelineStageFlags)0/*unused param*/, (VkPipelineStageFlags)0/*unused param*/, 0, ImageInfo.mipLevels, 0, ImageInfo.arrayLayers);
+        *pRetImageLayout = VK_IMAGE_LAYOUT_GENERAL;
         break;
     case TT_DEPTH_TARGET:
+    case TT_DEPTH_TARGET_TRANSIENT:
         if( Vulkan::FormatHasStencil(texInfo.Format ) )
         {
             // Can have depth and stencil flag
-            pVulkan->SetImageLayout( RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags) 0/*unused param*/, (VkPipelineStageFlags) 0/*unused param*/, 0, 1, 0, 1 );
+            pVulkan->SetImageLayout( Image, SetupCmdBuffer, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags) 0/*unused param*/, (VkPipelineStageFlags) 0/*unused param*/, 0, 1, 0, 1 );
         }
         else if ( Vulkan::FormatHasDepth(texInfo.Format ) )
         {
             // Only has the depth flag set
-            pVulkan->SetImageLayout( RetImage.m_VmaImage.GetVkBuffer(), SetupCmdBuffer, VK_IMAGE_ASPECT_DEPTH_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags) 0/*unused param*/, (VkPipelineStageFlags) 0/*unused param*/, 0, 1, 0, 1 );
+            pVulkan->SetImageLayout( Image, SetupCmdBuffer, VK_IMAGE_ASPECT_DEPTH_BIT, ImageInfo.initialLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, (VkPipelineStageFlags) 0/*unused param*/, (VkPipelineStageFlags) 0/*unused param*/, 0, 1, 0, 1 );
         }
         else
         {
             LOGE("Unhandled depth format!!!");
         }
-        RetImageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        *pRetImageLayout = (texInfo.TexType == TT_DEPTH_TARGET_TRANSIENT) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
         break;
     default:
         assert(0);
         break;
     }
 
-    pVulkan->FinishSetupCommandBuffer(SetupCmdBuffer);
+    // Layout transitions only (no staging data), no need to wait for them; later work on the queue executes after them (VulkanTexInfo::Release waits for this submission before destroying the image).
+    *pRetSetupSubmissionId = pVulkan->SubmitSetupCommandBuffer(SetupCmdBuffer);
 
-    // ... and an ImageView
-    VkImageViewCreateInfo ImageViewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
-    ImageViewInfo.flags = 0;
-    ImageViewInfo.image = RetImage.m_VmaImage.GetVkBuffer();
-    ImageViewInfo.viewType = (texInfo.uiDepth == 1) ? VK_IMAGE_VIEW_TYPE_2D : VK_IMAGE_VIEW_TYPE_3D; // <== No support for VK_IMAGE_VIEW_TYPE_CUBE
-    ImageViewInfo.format = ImageInfo.format;
-    ImageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_R;
-    ImageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_G;
-    ImageViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_B;
-    ImageViewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY; // VK_COMPONENT_SWIZZLE_A;
-    ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    ImageViewInfo.subresourceRange.baseMipLevel = 0;
-    ImageViewInfo.subresourceRange.levelCount = ImageInfo.mipLevels;
-    ImageViewInfo.subresourceRange.baseArrayLayer = 0;
-    ImageViewInfo.subresourceRange.layerCount = 1;
+    // ... except for images the host writes directly (mapped linear memory), the queue does not order host writes so the transition out of UNDEFINED must complete before we hand the image back.
+    if (texInfo.TexType == TT_CPU_UPDATE || ImageInfo.tiling == VK_IMAGE_TILING_LINEAR)
+    {
+        if (*pRetSetupSubmissionId != 0 && !pVulkan->WaitSetupSubmission(*pRetSetupSubmissionId))
+        {
+            LOGE("Unable to wait for the initial layout transition");
+        }
+        *pRetSetupSubmissionId = 0;
+    }
 
-    VkSamplerAddressMode SamplerMode = texInfo.SamplerMode;
+    return true;
+}
 
-    VkBorderColor BorderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+//-----------------------------------------------------------------------------
+VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo)
+//-----------------------------------------------------------------------------
+{
+    if(texInfo.pName == nullptr)
+        LOGI("CreateTextureObject (%dx%d): <No Name>", texInfo.uiWidth, texInfo.uiHeight);
+    else
+        LOGI("CreateTextureObject (%dx%d): %s", texInfo.uiWidth, texInfo.uiHeight, texInfo.pName);
 
-    switch (texInfo.TexType)
+    VkSampler RetSampler = VK_NULL_HANDLE;
+    VkImageView RetImageView = VK_NULL_HANDLE;
+    VkImageLayout RetImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    uint64_t SetupSubmissionId = 0;
+
+    // How this texture object will be used.
+    MemoryManager::MemoryUsage MemoryUsage = MemoryManager::MemoryUsage::GpuExclusive;
+    VkImageCreateInfo ImageInfo = GetTextureObjectImageInfo(texInfo, &MemoryUsage);
+
+    // Need the return image
+    Wrap_VkImage RetImage;
+    bool ImageInitialized = RetImage.Initialize( pVulkan, ImageInfo, MemoryUsage, texInfo.pName );
+    if( !ImageInitialized && MemoryUsage == MemoryManager::MemoryUsage::GpuLazilyAllocated )
     {
-    case TT_SHADING_RATE_IMAGE:
-    case TT_CPU_UPDATE:
-    case TT_NORMAL:
-    case TT_RENDER_TARGET:
-    case TT_RENDER_TARGET_WITH_STORAGE:
-    case TT_RENDER_TARGET_TRANSFERSRC:
-    case TT_RENDER_TARGET_SUBPASS:
-    case TT_COMPUTE_TARGET:
-        ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        break;
-    case TT_DEPTH_TARGET:
-        ImageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-        SamplerMode = (SamplerMode == VK_SAMPLER_ADDRESS_MODE_MAX_ENUM) ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER : SamplerMode;    // default to VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER
-        BorderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-        break;
-    default:
-        assert(0);
-        break;
+        LOGI( "Unable to initialize GpuLazilyAllocated image (probably not supported by GPU hardware).  Falling back to GpuExclusive" );
+        MemoryUsage = MemoryManager::MemoryUsage::GpuExclusive;
+        ImageInfo.usage &= ~VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        ImageInitialized = RetImage.Initialize( pVulkan, ImageInfo, MemoryUsage, texInfo.pName );
+    }
+    if (!ImageInitialized)
+    {
+        LOGE("Unable to initialize image (Not from file)");
+        return {};
     }
-    SamplerMode = (SamplerMode == VK_SAMPLER_ADDRESS_MODE_MAX_ENUM) ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE : SamplerMode; // default to VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
 
-    RetVal = vkCreateImageView(pVulkan->m_VulkanDevice, &ImageViewInfo, NULL, &RetImageView);
-    if (!CheckVkError("vkCreateImageView()", RetVal))
+    if (!CreateTextureObjectViewAndSampler(pVulkan, texInfo, ImageInfo, RetImage.m_VmaImage.GetVkBuffer(), &RetImageLayout, &RetImageView, &RetSampler, &SetupSubmissionId))
     {
         return {};
     }
 
-    // LOGI("vkCreateImageView: %s -> %p", pName, RetImageView);
+    VulkanTexInfo RetTex{ texInfo.uiWidth, texInfo.uiHeight, texInfo.uiDepth, texInfo.uiMips, texInfo.Format, RetImageLayout, std::move( RetImage.m_VmaImage ), RetSampler, RetImageView };
+    RetTex.SetupSubmissionId = SetupSubmissionId;
+    return RetTex;
+}
 
-    // Need a sampler...
-    if (!CreateSampler(pVulkan, SamplerMode, texInfo.FilterMode, BorderColor, texInfo.UnNormalizedCoordinates, 0.0f, &RetSampler))
+//-----------------------------------------------------------------------------
+VulkanTexInfo	CreateTextureObjectFromImage(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo, const VkImageCreateInfo& ImageInfo, VkImage Image)
+//-----------------------------------------------------------------------------
+{
+    VkSampler RetSampler = VK_NULL_HANDLE;
+    VkImageView RetImageView = VK_NULL_HANDLE;
+    VkImageLayout RetImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    uint64_t SetupSubmissionId = 0;
+
+    if (!CreateTextureObjectViewAndSampler(pVulkan, texInfo, ImageInfo, Image, &RetImageLayout, &RetImageView, &RetSampler, &SetupSubmissionId))
     {
         return {};
     }
 
-    VulkanTexInfo RetTex{ texInfo.uiWidth, texInfo.uiHeight, texInfo.uiDepth, texInfo.uiMips, texInfo.Format, RetImageLayout, std::move( RetImage.m_VmaImage ), RetSampler, RetImageView };
+    // Image is not owned by the VulkanTexInfo (Release only destroys the view and sampler, the owner waits on SetupSubmissionId before destroying the image).
+    VulkanTexInfo RetTex{ texInfo.uiWidth, texInfo.uiHeight, ImageInfo.mipLevels, 0, texInfo.Format, RetImageLayout, Image, VK_NULL_HANDLE, RetSampler, RetImageView };
+    RetTex.SetupSubmissionId = SetupSubmissionId;
     return RetTex;
 }
 
@@ -1761,7 +2087,7 @@ VulkanTexInfo	CreateTextureObjectView( Vulkan* pVulkan, const VulkanTexInfo& ori
     imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
     imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
     imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-    imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageViewCreateInfo.subresourceRange.aspectMask = Vulkan::FormatHasDepth( viewFormat ) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
     imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
     imageViewCreateInfo.subresourceRange.levelCount = original.MipLevels;
     imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
@@ -1775,11 +2101,12 @@ VulkanTexInfo	CreateTextureObjectView( Vulkan* pVulkan, const VulkanTexInfo& ori
 
     if (!CreateSampler( pVulkan, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_FILTER_LINEAR, {}, false, 0.0f, &sampler ))
     {
+        vkDestroyImageView( pVulkan->m_VulkanDevice, imageView, NULL );
         return {};
     }
 
-    //    VulkanTexInfo( uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageLayout imageLayout, VkImage image, VkDeviceMemory memory, VkSampler sampler, VkImageView imageView )
-    VulkanTexInfo RetTex { original.Width, original.Height, original.Depth, original.MipLevels, original.Format, original.GetVkImageLayout(), original.GetVkImage(), VK_NULL_HANDLE, sampler, imageView };
+    //    VulkanTexInfo( uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t firstMip, VkFormat format, VkImageLayout imageLayout, VkImage image, VkDeviceMemory memory, VkSampler sampler, VkImageView imageView )
+    VulkanTexInfo RetTex { original.Width, original.Height, original.MipLevels, original.FirstMip, original.Format, original.GetVkImageLayout(), original.GetVkImage(), VK_NULL_HANDLE, sampler, imageView };
     return RetTex;
 }
 
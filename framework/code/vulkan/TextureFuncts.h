@@ -11,8 +11,13 @@
 //      Vulkan texture handling support
 
 #include "vulkan/vulkan.hpp"
+#include "texture/mipGenerator.hpp"
+#include <memory>
 
 class AssetManager;
+class CWorker;
+class DecodedKTXTexture;
+struct _VulkanTexData;
 
 /// @brief A Vulkan texture
 /// Owns memory and sampler etc associated with a single texture.
@@ -70,6 +75,7 @@ public:
 	VkSampler			  GetVkSampler() const				 { return Sampler; }
 	VkImageView			  GetVkImageView() const			 { return ImageView;  }
 	bool				  IsEmpty() const					 { return !VmaImage; }
+	const MemoryVmaAllocatedBuffer<VkImage>& GetVmaImage() const { return VmaImage; }
 
 	uint32_t  Width = 0;
 	uint32_t  Height = 0;
@@ -78,6 +84,7 @@ public:
 	uint32_t  FirstMip = 0;
 	VkFormat  Format = VK_FORMAT_UNDEFINED;
     VkImageLayout ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    uint64_t  SetupSubmissionId = 0;    ///< Last setup submission (upload or layout transition) that writes the image (0 if none).  Release waits for it (see Vulkan::WaitSetupSubmission).
 
 protected:
 
@@ -103,6 +110,8 @@ enum TEXTURE_TYPE
 	TT_COMPUTE_TARGET,
     TT_CPU_UPDATE,
 	TT_SHADING_RATE_IMAGE,
+	TT_RENDER_TARGET_TRANSIENT,	///< color attachment whose contents do not outlive the render pass (lazily allocated memory, cannot be sampled)
+	TT_DEPTH_TARGET_TRANSIENT,	///< depth attachment whose contents do not outlive the render pass (lazily allocated memory, cannot be sampled)
 	NUM_TEXTURE_TYPES
 };
 
@@ -132,26 +141,83 @@ struct CreateTexObjectInfo
 	bool UnNormalizedCoordinates = false;
 };
 
-// Actual support functions
+/// Mip generation for loaded textures that do not contain a mip chain (eg png files or single level ktx files)
+struct TextureMipGeneration
+{
+	enum class Mode {
+		None,       ///< use the mips in the file (if any)
+		Cpu,        ///< generate mips on the cpu (on the loading thread) with the given Filter.  8 bit per channel uncompressed formats only.
+		GpuBlit     ///< generate mips with a vkCmdBlitImage chain (linear filter) in the upload command buffer.  Formats that support linear blits only.
+	};
+	Mode      Generate = Mode::None;
+	MipFilter Filter = MipFilter::Box;          ///< Cpu mode only
+	float     AlphaCoverageCutoff = -1.0f;      ///< Cpu mode only.  If >= 0 preserve alpha test coverage at this cutoff down the mip chain (eg 0.5 for alphaCutout materials)
+};
 
-/// Load/create texture from .ktx file (Mips to load are lowest resolution, NOT 0,1,2...)
-VulkanTexInfo   LoadKTXTexture(Vulkan *pVulkan, AssetManager&, const char* pFileName, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, int32_t NumMipsToLoad = 0x7fffffff, float mipBias = 0.0f);
+// Actual support functions
+//
+// The texture loaders/creators below submit their uploads and layout transitions (Vulkan::SubmitSetupCommandBuffer) WITHOUT waiting for them.
+// The returned texture may still be being written by the gpu; work later submitted to Vulkan::m_VulkanQueue executes after it so can use the texture straight away,
+// but the cpu must not destroy the image until Vulkan::WaitSetupSubmission(VulkanTexInfo::SetupSubmissionId) (ReleaseTexture/VulkanTexInfo::Release waits for that submission only).
+
+/// Load/create texture from .ktx, .ktx2 (no supercompression or zlib) or .png file (Mips to load are lowest resolution, NOT 0,1,2...)
+/// Texture data in a format the device does not support is transcoded to one it does, where possible (see SelectTranscodeFormat).
+/// Upload may still be in flight on the gpu when this returns (see above).
+VulkanTexInfo   LoadKTXTexture(Vulkan *pVulkan, AssetManager&, const char* pFileName, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, int32_t NumMipsToLoad = 0x7fffffff, float mipBias = 0.0f, const TextureMipGeneration& MipGeneration = {});
+/// Load/create texture from .ktx (or .png) file contents already loaded in to memory (eg with AssetManager::LoadFileIntoMemory).
+/// @param pFileName name of the file the data came from (determines the file type, used for any fallback load and for logging)
+VulkanTexInfo   LoadKTXTextureFromMemory(Vulkan* pVulkan, AssetManager&, const char* pFileName, const tcb::span<const char> FileData, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, int32_t NumMipsToLoad = 0x7fffffff, float mipBias = 0.0f, const TextureMipGeneration& MipGeneration = {});
+/// Decode .ktx/.ktx2/.png file contents (parse, transcode and generate any Cpu mips) in to cpu memory, the first half of LoadKTXTextureFromMemory.
+/// Makes no Vulkan calls so can run on a worker thread (FileData must stay valid until it returns).
+/// @returns false if the data could not be decoded (pDecoded is left empty)
+bool            DecodeKTXTexture(const Vulkan& vulkan, const char* pFileName, const tcb::span<const char> FileData, DecodedKTXTexture* pDecoded, const TextureMipGeneration& MipGeneration = {});
+/// Create texture from data decoded with DecodeKTXTexture, the second half of LoadKTXTextureFromMemory (uploads through the staging ring buffer, not waited on).  Empties Decoded.
+/// Must be called on the thread that owns the Vulkan setup command buffers.
+VulkanTexInfo   CreateDecodedKTXTexture(Vulkan* pVulkan, AssetManager&, const char* pFileName, DecodedKTXTexture& Decoded, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, int32_t NumMipsToLoad = 0x7fffffff, float mipBias = 0.0f, const TextureMipGeneration& MipGeneration = {});
+/// Number of mip levels in a .ktx/.ktx2 file (1 for .png) loaded in to memory.  Only parses the file header.
+/// @returns 0 if the header is not valid
+uint32_t        GetKTXTextureMipLevels(const char* pFileName, const tcb::span<const char> FileData);
+/// Load/create multiple textures from .ktx (or .png/.ppm) files.
+/// Files are read and decoded (and any Cpu mips generated) in parallel on the worker's threads, uploads are recorded (in filename order, as each file finishes decoding) in to a single setup command buffer which is submitted once all the textures are created.
+/// Must not be called from one of the worker's threads (may deadlock).
+/// @returns one texture per filename (empty VulkanTexInfo for any file that failed to load)
+std::vector<VulkanTexInfo> LoadKTXTextures(Vulkan* pVulkan, AssetManager&, CWorker& worker, const tcb::span<const std::string> filenames, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, float mipBias = 0.0f, const TextureMipGeneration& MipGeneration = {});
 /// Parse a KTX texture and dump each mip to individual file (restrictions on faces, formats, output, etc.)
 void DumpKTXMipFiles(AssetManager& assetManager, std::string SourceFile, std::string OutBaseFile);
-/// Load/create texture from .ppm file
+/// Load/create texture from .ppm file (red and green channels, R8G8_UNORM).  Multiple images in the file are loaded as a 3d texture.
+/// Decoded and uploaded the same way as LoadKTXTexture (upload may still be in flight on the gpu when this returns).
 VulkanTexInfo   LoadPPMTexture(Vulkan* pVulkan, AssetManager&, const char* pFileName, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-/// Create texture from an existing memory buffer
+/// Create texture from an existing memory buffer.  pData can be freed as soon as this returns (it is staged), the upload may still be in flight on the gpu.
 VulkanTexInfo   LoadTextureFromBuffer(Vulkan* pVulkan, const void *pData, size_t DataSize, uint32_t Width, uint32_t Height, uint32_t Depth, VkFormat Format, VkSamplerAddressMode SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VkFilter Filter = VK_FILTER_LINEAR, VkImageUsageFlags FinalUsage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT), VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 /// Save texture data to 'filename'
 /// @returns true on success
 bool SaveTextureData(const char* pFileName, VkFormat format, int width, int height, const void* data);
-/// Create texture (generally for render target usage)
+/// Create texture (generally for render target usage).  Initial layout transition may still be in flight on the gpu when this returns (except for TT_CPU_UPDATE and linear tiled textures, which the cpu may write as soon as this returns).
 VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, VkFormat Format, TEXTURE_TYPE TexType, const char* pName, VkSampleCountFlagBits Msaa = VK_SAMPLE_COUNT_1_BIT, TEXTURE_FLAGS Flags = TEXTURE_FLAGS::None);
 /// Create texture (generally for render target usage).  Uses CreateTexObjectInfo structure to define texture creation parameters.
 VulkanTexInfo	CreateTextureObject(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo);
+/// Image create parameters (and memory usage) that CreateTextureObject uses for the given texture parameters.  For creating the VkImage elsewhere (eg placed in aliased memory).
+VkImageCreateInfo GetTextureObjectImageInfo(const CreateTexObjectInfo& texInfo, MemoryManager::MemoryUsage* pMemoryUsage = nullptr);
+/// Create texture from an image made (and bound to memory) using the GetTextureObjectImageInfo parameters.  Transitions the image layout and creates the image view and sampler, as CreateTextureObject.
+/// Does NOT take ownership of the VkImage (caller must destroy it after the returned texture is released, and after Vulkan::WaitSetupSubmission(SetupSubmissionId) as the layout transition is not waited on).
+VulkanTexInfo	CreateTextureObjectFromImage(Vulkan* pVulkan, const CreateTexObjectInfo& texInfo, const VkImageCreateInfo& ImageInfo, VkImage Image);
 /// Create texture that is an imageview referencing an existing VulkanTexInfo.
 /// Required that the referenced originalTexInfo does not go out of scope (be destroyed) before the referencing texture. 
 VulkanTexInfo	CreateTextureObjectView( Vulkan* pVulkan, const VulkanTexInfo& original, VkFormat viewFormat );
-/// Release memory associated with the given texture and reset to 'empty' state
+/// Release memory associated with the given texture and reset to 'empty' state.  Waits for the texture's setup submission (upload) if it may still be using the image.
 void            ReleaseTexture(Vulkan* pVulkan, VulkanTexInfo *pTexInfo);
 
+/// Texture data decoded in to cpu memory by DecodeKTXTexture, waiting to be created/uploaded with CreateDecodedKTXTexture.
+/// Owns the decoded data (freed on destruction).
+class DecodedKTXTexture
+{
+public:
+    bool IsEmpty() const { return !m_pTexData; }
+
+private:
+    friend bool DecodeKTXTexture(const Vulkan&, const char*, const tcb::span<const char>, DecodedKTXTexture*, const TextureMipGeneration&);
+    friend VulkanTexInfo CreateDecodedKTXTexture(Vulkan*, AssetManager&, const char*, DecodedKTXTexture&, VkSamplerAddressMode, int32_t, float, const TextureMipGeneration&);
+    struct TexDataDeleter { void operator()(_VulkanTexData*) const; };
+    std::unique_ptr<_VulkanTexData, TexDataDeleter> m_pTexData;
+};
+
@@ -0,0 +1,426 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "aliasedRenderTargets.hpp"
+#include "vulkan.hpp"
+#include "memory/memoryManager.hpp"
+#include "system/os_common.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+///////////////////////////////////////////////////////////////////////////////
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AliasedRenderTargets::~AliasedRenderTargets()
+{
+    Destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AliasedRenderTargets::tTextureId AliasedRenderTargets::AddTexture(const CreateTexObjectInfo& texInfo)
+{
+    if (m_Built)
+    {
+        LOGE("AliasedRenderTargets::AddTexture (%s) called after Build", texInfo.pName ? texInfo.pName : "");
+        return cInvalidTextureId;
+    }
+    switch (texInfo.TexType)
+    {
+    case TT_RENDER_TARGET:
+    case TT_RENDER_TARGET_WITH_STORAGE:
+    case TT_RENDER_TARGET_TRANSFERSRC:
+    case TT_DEPTH_TARGET:
+    case TT_COMPUTE_TARGET:
+        break;
+    default:
+        LOGE("AliasedRenderTargets::AddTexture (%s) unsupported texture type %d", texInfo.pName ? texInfo.pName : "", (int)texInfo.TexType);
+        return cInvalidTextureId;
+    }
+    if ((texInfo.Flags & TEXTURE_FLAGS::ForceLinearTiling) != 0)
+    {
+        LOGE("AliasedRenderTargets::AddTexture (%s) linear tiling is not supported", texInfo.pName ? texInfo.pName : "");
+        return cInvalidTextureId;
+    }
+
+    Texture& texture = m_Textures.emplace_back();
+    texture.Info = texInfo;
+    texture.Name = texInfo.pName ? texInfo.pName : "AliasedRenderTarget";
+    texture.Info.pName = nullptr;
+    return (tTextureId)(m_Textures.size() - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t AliasedRenderTargets::AddPass(const char* pName, const tcb::span<const tTextureId> Writes, const tcb::span<const tTextureId> Reads)
+{
+    assert(!m_Built);
+    Pass& pass = m_Passes.emplace_back();
+    pass.Name = pName ? pName : "";
+    for (tTextureId textureId : Writes)
+    {
+        assert(textureId < m_Textures.size());
+        pass.Writes.push_back(textureId);
+    }
+    for (tTextureId textureId : Reads)
+    {
+        assert(textureId < m_Textures.size());
+        pass.Reads.push_back(textureId);
+    }
+    return (uint32_t)(m_Passes.size() - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AliasedRenderTargets::Build(Vulkan* pVulkan, bool EnableAliasing)
+{
+    assert(!m_Built);
+    const uint64_t BuildStartUS = OS_GetTimeUS();
+    m_pVulkan = pVulkan;
+    m_EnableAliasing = EnableAliasing;
+    m_Built = true;
+
+    // Lifetime of each texture is from the first to the last pass that uses it.
+    // A texture read before it is written needs the previous frame's contents, so it is alive for the whole frame (and is never aliased).
+    for (uint32_t passIdx = 0; passIdx < (uint32_t)m_Passes.size(); ++passIdx)
+    {
+        const Pass& pass = m_Passes[passIdx];
+        for (tTextureId textureId : pass.Reads)
+        {
+            Texture& texture = m_Textures[textureId];
+            if (texture.FirstPass == UINT32_MAX)
+            {
+                texture.ReadBeforeWrite = true;
+                texture.FirstPass = passIdx;
+            }
+            texture.LastPass = std::max(texture.LastPass, passIdx);
+        }
+        for (tTextureId textureId : pass.Writes)
+        {
+            Texture& texture = m_Textures[textureId];
+            texture.FirstPass = std::min(texture.FirstPass, passIdx);
+            texture.LastPass = std::max(texture.LastPass, passIdx);
+        }
+    }
+    for (auto& texture : m_Textures)
+    {
+        if (texture.FirstPass == UINT32_MAX)
+        {
+            LOGI("AliasedRenderTargets: texture %s is not used by any pass (not aliased)", texture.Name.c_str());
+            texture.ReadBeforeWrite = true;
+        }
+        if (texture.ReadBeforeWrite)
+        {
+            texture.FirstPass = 0;
+            texture.LastPass = m_Passes.empty() ? 0 : (uint32_t)m_Passes.size() - 1;
+        }
+    }
+
+    if (!CreateImages())
+    {
+        Destroy();
+        return false;
+    }
+    PlaceTextures();
+    if (!AllocateAndBind())
+    {
+        Destroy();
+        return false;
+    }
+
+    // Create the textures (image views, samplers and initial layout transitions).
+    for (auto& texture : m_Textures)
+    {
+        CreateTexObjectInfo texInfo = texture.Info;
+        texInfo.pName = texture.Name.c_str();
+        texture.Texture = CreateTextureObjectFromImage(m_pVulkan, texInfo, texture.ImageInfo, texture.Image);
+        if (texture.Texture.GetVkImageView() == VK_NULL_HANDLE)
+        {
+            LOGE("AliasedRenderTargets: unable to create texture %s", texture.Name.c_str());
+            Destroy();
+            return false;
+        }
+    }
+
+    // Textures that take over memory used by other textures need a barrier at the start of their lifetime.
+    for (tTextureId textureId = 0; textureId < (tTextureId)m_Textures.size(); ++textureId)
+    {
+        const Texture& texture = m_Textures[textureId];
+        if (texture.Aliased && !texture.ReadBeforeWrite)
+            m_Passes[texture.FirstPass].AliasedFirstUses.push_back(textureId);
+    }
+
+    m_Stats.BuildTimeUS = OS_GetTimeUS() - BuildStartUS;
+    LogStats();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AliasedRenderTargets::CreateImages()
+{
+    for (auto& texture : m_Textures)
+    {
+        texture.ImageInfo = GetTextureObjectImageInfo(texture.Info);
+        VkResult RetVal = vkCreateImage(m_pVulkan->m_VulkanDevice, &texture.ImageInfo, nullptr, &texture.Image);
+        if (!CheckVkError("vkCreateImage()", RetVal))
+        {
+            texture.Image = VK_NULL_HANDLE;
+            return false;
+        }
+        m_pVulkan->SetDebugObjectName(texture.Image, texture.Name.c_str());
+        vkGetImageMemoryRequirements(m_pVulkan->m_VulkanDevice, texture.Image, &texture.MemoryRequirements);
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AliasedRenderTargets::LifetimesOverlap(const Texture& a, const Texture& b) const
+{
+    if (!m_EnableAliasing || a.ReadBeforeWrite || b.ReadBeforeWrite)
+        return true;
+    return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkDeviceSize AliasedRenderTargets::FindOffset(const MemoryBlock& block, const Texture& texture) const
+{
+    // Memory ranges (in the block) of the textures that are alive at the same time as this texture.
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> usedRanges;
+    for (tTextureId placedId : block.Textures)
+    {
+        const Texture& placed = m_Textures[placedId];
+        if (LifetimesOverlap(placed, texture))
+            usedRanges.push_back({ placed.Offset, placed.Offset + placed.MemoryRequirements.size });
+    }
+    std::sort(usedRanges.begin(), usedRanges.end());
+
+    // First fit.
+    VkDeviceSize offset = 0;
+    for (const auto& [rangeStart, rangeEnd] : usedRanges)
+    {
+        if (offset + texture.MemoryRequirements.size <= rangeStart)
+            break;
+        offset = std::max(offset, AlignUp(rangeEnd, texture.MemoryRequirements.alignment));
+    }
+    return offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AliasedRenderTargets::PlaceTextures()
+{
+    // Largest textures first, so smaller textures fill in around them.
+    std::vector<tTextureId> order(m_Textures.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](tTextureId a, tTextureId b) { return m_Textures[a].MemoryRequirements.size > m_Textures[b].MemoryRequirements.size; });
+
+    for (tTextureId textureId : order)
+    {
+        Texture& texture = m_Textures[textureId];
+
+        // Find the block that grows the least when this texture is added to it.
+        uint32_t bestBlockIdx = UINT32_MAX;
+        VkDeviceSize bestOffset = 0;
+        VkDeviceSize bestGrowth = 0;
+        if (!texture.ReadBeforeWrite && m_EnableAliasing)
+        {
+            for (uint32_t blockIdx = 0; blockIdx < (uint32_t)m_MemoryBlocks.size(); ++blockIdx)
+            {
+                const MemoryBlock& block = m_MemoryBlocks[blockIdx];
+                if ((block.MemoryTypeBits & texture.MemoryRequirements.memoryTypeBits) == 0)
+                    continue;
+                const VkDeviceSize offset = FindOffset(block, texture);
+                const VkDeviceSize end = offset + texture.MemoryRequirements.size;
+                const VkDeviceSize growth = end > block.Size ? end - block.Size : 0;
+                if (bestBlockIdx == UINT32_MAX || growth < bestGrowth)
+                {
+                    bestBlockIdx = blockIdx;
+                    bestOffset = offset;
+                    bestGrowth = growth;
+                }
+            }
+        }
+        if (bestBlockIdx == UINT32_MAX)
+        {
+            bestBlockIdx = (uint32_t)m_MemoryBlocks.size();
+            bestOffset = 0;
+            m_MemoryBlocks.emplace_back();
+        }
+
+        MemoryBlock& block = m_MemoryBlocks[bestBlockIdx];
+        block.MemoryTypeBits &= texture.MemoryRequirements.memoryTypeBits;
+        block.Alignment = std::max(block.Alignment, texture.MemoryRequirements.alignment);
+        block.Size = std::max(block.Size, bestOffset + texture.MemoryRequirements.size);
+        block.Textures.push_back(textureId);
+        texture.BlockIdx = bestBlockIdx;
+        texture.Offset = bestOffset;
+    }
+
+    // Textures aliasing (sharing memory with) any other texture.
+    m_Stats = {};
+    for (auto& texture : m_Textures)
+    {
+        for (tTextureId otherId : m_MemoryBlocks[texture.BlockIdx].Textures)
+        {
+            const Texture& other = m_Textures[otherId];
+            if (&other != &texture && texture.Offset < other.Offset + other.MemoryRequirements.size && other.Offset < texture.Offset + texture.MemoryRequirements.size)
+            {
+                texture.Aliased = true;
+                break;
+            }
+        }
+        m_Stats.UnaliasedSize += (size_t)texture.MemoryRequirements.size;
+        m_Stats.NumAliasedTextures += texture.Aliased ? 1 : 0;
+    }
+    for (const auto& block : m_MemoryBlocks)
+        m_Stats.AliasedSize += (size_t)block.Size;
+    m_Stats.NumTextures = (uint32_t)m_Textures.size();
+    m_Stats.NumMemoryBlocks = (uint32_t)m_MemoryBlocks.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AliasedRenderTargets::AllocateAndBind()
+{
+    auto& memoryManager = m_pVulkan->GetMemoryManager();
+    for (auto& block : m_MemoryBlocks)
+    {
+        VkMemoryRequirements memoryRequirements{};
+        memoryRequirements.size = block.Size;
+        memoryRequirements.alignment = block.Alignment;
+        memoryRequirements.memoryTypeBits = block.MemoryTypeBits;
+        block.Memory = memoryManager.AllocateMemory(memoryRequirements, MemoryManager::MemoryUsage::GpuExclusive, MemoryCategory::RenderTarget, "AliasedRenderTargets");
+        if (!block.Memory)
+        {
+            LOGE("AliasedRenderTargets: unable to allocate memory block (%zu bytes)", (size_t)block.Size);
+            return false;
+        }
+        for (tTextureId textureId : block.Textures)
+        {
+            const Texture& texture = m_Textures[textureId];
+            if (!memoryManager.BindImage(texture.Image, block.Memory, texture.Offset))
+            {
+                LOGE("AliasedRenderTargets: unable to bind texture %s to memory", texture.Name.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AliasedRenderTargets::Destroy()
+{
+    if (m_pVulkan)
+    {
+        // Layout transitions (CreateTextureObjectFromImage) are submitted without waiting, images must not be destroyed while they may still be executing.
+        m_pVulkan->WaitAllSetupSubmissions();
+        for (auto& texture : m_Textures)
+        {
+            ReleaseTexture(m_pVulkan, &texture.Texture);
+            if (texture.Image != VK_NULL_HANDLE)
+                vkDestroyImage(m_pVulkan->m_VulkanDevice, texture.Image, nullptr);
+            texture.Image = VK_NULL_HANDLE;
+        }
+        // Memory destroyed after all the images bound to it.
+        for (auto& block : m_MemoryBlocks)
+            m_pVulkan->GetMemoryManager().Destroy(std::move(block.Memory));
+    }
+    m_Textures.clear();
+    m_Passes.clear();
+    m_MemoryBlocks.clear();
+    m_Stats = {};
+    m_Built = false;
+    m_pVulkan = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VulkanTexInfo AliasedRenderTargets::CreateTextureView(tTextureId textureId) const
+{
+    assert(m_Built && textureId < m_Textures.size());
+    const VulkanTexInfo& texture = m_Textures[textureId].Texture;
+    return CreateTextureObjectView(m_pVulkan, texture, texture.Format);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AliasedRenderTargets::CmdBeginPass(VkCommandBuffer cmdBuffer, uint32_t passIdx) const
+{
+    assert(passIdx < m_Passes.size());
+    const Pass& pass = m_Passes[passIdx];
+    if (pass.AliasedFirstUses.empty())
+        return;
+
+    // Wait for every earlier write to the aliased memory (by whichever texture last used it) before the first write by the new texture.
+    VkPipelineStageFlags dstStageMask = 0;
+    VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+
+    for (tTextureId textureId : pass.AliasedFirstUses)
+    {
+        const Texture& texture = m_Textures[textureId];
+        switch (texture.Info.TexType)
+        {
+        case TT_DEPTH_TARGET:
+            dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            memoryBarrier.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            break;
+        case TT_COMPUTE_TARGET:
+        {
+            dstStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            memoryBarrier.dstAccessMask |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            // Contents are undefined after another texture used the memory, the layout has to be re-established.
+            VkImageMemoryBarrier& imageBarrier = imageBarriers.emplace_back(VkImageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER });
+            imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = texture.Image;
+            imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.ImageInfo.mipLevels, 0, texture.ImageInfo.arrayLayers };
+            break;
+        }
+        default:
+            // Render target color attachments (render pass transitions them from VK_IMAGE_LAYOUT_UNDEFINED).
+            dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            memoryBarrier.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            break;
+        }
+    }
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AliasedRenderTargets::LogStats() const
+{
+    const size_t SavedSize = m_Stats.UnaliasedSize > m_Stats.AliasedSize ? m_Stats.UnaliasedSize - m_Stats.AliasedSize : 0;
+    LOGI("AliasedRenderTargets: %u textures (%u aliased) in %u memory blocks.  %zu bytes allocated, %zu bytes without aliasing (%zu bytes, %.1f%%, saved).  Built in %.2f ms",
+         m_Stats.NumTextures, m_Stats.NumAliasedTextures, m_Stats.NumMemoryBlocks, m_Stats.AliasedSize, m_Stats.UnaliasedSize,
+         SavedSize, m_Stats.UnaliasedSize > 0 ? 100.0 * double(SavedSize) / double(m_Stats.UnaliasedSize) : 0.0, double(m_Stats.BuildTimeUS) / 1000.0);
+    for (const auto& texture : m_Textures)
+    {
+        LOGI("    %s: block %u offset %zu size %zu, passes %u-%u%s%s", texture.Name.c_str(), texture.BlockIdx, (size_t)texture.Offset, (size_t)texture.MemoryRequirements.size,
+             texture.FirstPass, texture.LastPass, texture.ReadBeforeWrite ? " (persistent)" : "", texture.Aliased ? " (aliased)" : "");
+    }
+}
@@ -0,0 +1,135 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include "TextureFuncts.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tcb/span.hpp"
+
+// Forward declarations
+class Vulkan;
+
+/// Render targets (and compute targets) that share memory when their lifetimes within a frame do not overlap.
+/// Declare the textures (AddTexture) and then the frame's passes in the order they execute, with the textures each pass writes and reads (AddPass).
+/// Build works out each texture's lifetime (its first to last pass) and places the textures in memory blocks, so textures that are never alive at the same time use the same memory.
+/// While recording the frame call CmdBeginPass before each pass, to record the barriers for textures taking over memory last used by a different texture.
+/// Aliased texture contents do not survive from one frame to the next, so the first pass using a texture must write it without reading the previous contents
+/// (render pass load op clear or don't care); textures read before they are written in the frame keep memory of their own.
+/// All passes are expected to be on one queue.  Not thread safe.
+class AliasedRenderTargets
+{
+    AliasedRenderTargets(const AliasedRenderTargets&) = delete;
+    AliasedRenderTargets& operator=(const AliasedRenderTargets&) = delete;
+public:
+    typedef uint32_t tTextureId;
+    static constexpr tTextureId cInvalidTextureId = 0xffffffff;
+
+    AliasedRenderTargets() = default;
+    /// Destroys the textures.  As with Destroy the caller must ensure the gpu is no longer using them.
+    ~AliasedRenderTargets();
+
+    /// Declare a texture (before Build).
+    /// Supported types are TT_RENDER_TARGET, TT_RENDER_TARGET_WITH_STORAGE, TT_RENDER_TARGET_TRANSFERSRC, TT_DEPTH_TARGET and TT_COMPUTE_TARGET (optimal tiling only).
+    /// @returns id of the texture, cInvalidTextureId if the texture type is not supported (or Build has already been called)
+    tTextureId AddTexture(const CreateTexObjectInfo& texInfo);
+
+    /// Declare the next pass of the frame (before Build) and the textures it uses.
+    /// @param Writes textures the pass writes (color/depth attachments, storage images)
+    /// @param Reads textures the pass reads (sampled, input attachments, attachments loaded by the render pass)
+    /// @returns index of the pass (for CmdBeginPass)
+    uint32_t AddPass(const char* pName, const tcb::span<const tTextureId> Writes, const tcb::span<const tTextureId> Reads = {});
+
+    /// Work out the texture lifetimes, place the textures in memory and create them.
+    /// @param EnableAliasing false to give every texture memory of its own (for comparison; CmdBeginPass still records its barriers)
+    /// @returns false if any of the textures (or their memory) could not be created
+    bool Build(Vulkan* pVulkan, bool EnableAliasing = true);
+
+    /// Destroy the textures and memory, and forget the declared textures and passes (so new ones can be declared and built).
+    /// Caller must ensure the gpu is no longer using the textures, and any views created with CreateTextureView must already be released.
+    void Destroy();
+
+    /// @returns the (built) texture.  The VkImage is owned by this class.
+    const VulkanTexInfo& GetTexture(tTextureId textureId) const { return m_Textures[textureId].Texture; }
+    /// @returns the parameters the texture was declared with
+    const CreateTexObjectInfo& GetTextureInfo(tTextureId textureId) const { return m_Textures[textureId].Info; }
+
+    /// Create a texture with its own image view and sampler that references a built texture's image, eg for a CRenderTarget attachment.
+    /// Must be released (ReleaseTexture) before this class is destroyed.
+    VulkanTexInfo CreateTextureView(tTextureId textureId) const;
+
+    /// Record the barriers needed before the given pass; textures whose lifetimes start in this pass wait for all previous use of the memory they alias (by other textures in this frame or in earlier frames).
+    /// Compute targets are transitioned (from undefined) to VK_IMAGE_LAYOUT_GENERAL; render target attachments rely on their render pass initialLayout being VK_IMAGE_LAYOUT_UNDEFINED.
+    /// Must be recorded outside of a render pass.  Records nothing if no texture takes over aliased memory in the pass.
+    void CmdBeginPass(VkCommandBuffer cmdBuffer, uint32_t passIdx) const;
+
+    struct Stats
+    {
+        size_t   UnaliasedSize = 0;         ///< bytes the textures would need with memory of their own
+        size_t   AliasedSize = 0;           ///< bytes allocated (all memory blocks)
+        uint32_t NumTextures = 0;
+        uint32_t NumAliasedTextures = 0;    ///< textures sharing memory with at least one other texture
+        uint32_t NumMemoryBlocks = 0;
+        uint64_t BuildTimeUS = 0;           ///< time taken by Build (images, placement, memory allocation and texture creation)
+    };
+    const Stats& GetStats() const { return m_Stats; }
+    /// Log the stats and the placement (memory block, offset and lifetime) of each texture.
+    void LogStats() const;
+
+protected:
+    struct Texture
+    {
+        CreateTexObjectInfo     Info;                   ///< Info.pName is not kept (see Name)
+        std::string             Name;
+        uint32_t                FirstPass = UINT32_MAX;
+        uint32_t                LastPass = 0;
+        bool                    ReadBeforeWrite = false;///< contents needed from the previous frame (cannot alias)
+        VkImageCreateInfo       ImageInfo{};
+        VkImage                 Image = VK_NULL_HANDLE;
+        VkMemoryRequirements    MemoryRequirements{};
+        uint32_t                BlockIdx = UINT32_MAX;
+        VkDeviceSize            Offset = 0;
+        bool                    Aliased = false;
+        VulkanTexInfo           Texture;
+    };
+
+    struct Pass
+    {
+        std::string             Name;
+        std::vector<tTextureId> Writes;
+        std::vector<tTextureId> Reads;
+        std::vector<tTextureId> AliasedFirstUses;       ///< textures that take over aliased memory at the start of this pass (set by Build)
+    };
+
+    struct MemoryBlock
+    {
+        uint32_t                MemoryTypeBits = ~0u;
+        VkDeviceSize            Size = 0;
+        VkDeviceSize            Alignment = 1;
+        std::vector<tTextureId> Textures;
+        MemoryVmaAllocation     Memory;
+    };
+
+    /// @returns true if the two textures are alive during (at least) one common pass
+    bool LifetimesOverlap(const Texture& a, const Texture& b) const;
+    /// Find the lowest offset in the block where the texture does not overlap (in memory) any placed texture with an overlapping lifetime
+    VkDeviceSize FindOffset(const MemoryBlock& block, const Texture& texture) const;
+    bool CreateImages();
+    void PlaceTextures();
+    bool AllocateAndBind();
+
+protected:
+    Vulkan*                     m_pVulkan = nullptr;
+    bool                        m_EnableAliasing = true;
+    bool                        m_Built = false;
+    std::vector<Texture>        m_Textures;
+    std::vector<Pass>           m_Passes;
+    std::vector<MemoryBlock>    m_MemoryBlocks;
+    Stats                       m_Stats;
+};
@@ -8,6 +8,7 @@
 
 #include "renderTarget.hpp"
 #include "system/os_common.h"
+#include "memory/memoryManager.hpp"
 //#include "vulkan_support.hpp"
 //#include "system/assetManager.hpp"
 //#include "memory/memoryManager.hpp"
@@ -66,6 +67,11 @@ CRenderTarget& CRenderTarget::operator=( CRenderTarget&& src) noexcept
 
         m_pVulkan = src.m_pVulkan;
         src.m_pVulkan = nullptr;
+
+        m_AutoTransientUsage = src.m_AutoTransientUsage;
+        src.m_AutoTransientUsage.reset();
+        m_TransientMemorySaved = src.m_TransientMemorySaved;
+        src.m_TransientMemorySaved = 0;
     }
 
     return *this;
@@ -96,13 +102,21 @@ void CRenderTarget::HardReset()
     m_FrameBufferDepthOnly = VK_NULL_HANDLE;
 
     m_pVulkan = nullptr;
+
+    m_AutoTransientUsage.reset();
+    m_TransientMemorySaved = 0;
 }
 
 //-----------------------------------------------------------------------------
-bool CRenderTarget::Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, tcb::span<const VkSampleCountFlagBits> Msaa, const char* pName)
+bool CRenderTarget::Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, tcb::span<const VkSampleCountFlagBits> Msaa, const char* pName, const RenderTargetAttachmentUsage* pAutoTransientUsage)
 //-----------------------------------------------------------------------------
 {
     m_pVulkan = pVulkan;
+    m_AutoTransientUsage.reset();
+    if (pAutoTransientUsage)
+    {
+        m_AutoTransientUsage = *pAutoTransientUsage;
+    }
     m_DepthFormat = DepthFormat;
     m_Msaa.assign(Msaa.begin(), Msaa.end());
     m_Msaa.resize( pLayerFormats.size(), VK_SAMPLE_COUNT_1_BIT );
@@ -134,7 +148,12 @@ bool CRenderTarget::InitializeDepth()
     {
         char szName[256];
         sprintf(szName, "%s: Depth", m_Name.c_str());
-        m_DepthAttachment = CreateTextureObject(m_pVulkan, m_Width, m_Height, m_DepthFormat, TT_DEPTH_TARGET, m_Name.c_str(), m_Msaa.empty() ? VK_SAMPLE_COUNT_1_BIT : m_Msaa[0]);
+        const bool Transient = m_AutoTransientUsage && Vulkan::IsTransientDepthAttachment(m_AutoTransientUsage->ShouldClearDepth, m_AutoTransientUsage->DepthOutputUsage);
+        m_DepthAttachment = CreateTextureObject(m_pVulkan, m_Width, m_Height, m_DepthFormat, Transient ? TT_DEPTH_TARGET_TRANSIENT : TT_DEPTH_TARGET, m_Name.c_str(), m_Msaa.empty() ? VK_SAMPLE_COUNT_1_BIT : m_Msaa[0]);
+        if (Transient)
+        {
+            AddTransientMemorySaved(m_DepthAttachment, "Depth");
+        }
     }
     else
     {
@@ -172,7 +191,21 @@ bool CRenderTarget::InitializeColor(const tcb::span<const TEXTURE_TYPE> TextureT
         createInfo.Msaa = m_Msaa[WhichLayer];
         createInfo.FilterMode = m_FilterMode[WhichLayer];
 
+        // Only plain render targets are made transient (other types need their contents for storage, transfers, subpass inputs).
+        // When the pass resolves, the single sampled layers are the resolve targets (always stored).
+        const bool Transient = m_AutoTransientUsage && createInfo.TexType == TT_RENDER_TARGET
+                            && !(m_AutoTransientUsage->ColorResolved && createInfo.Msaa == VK_SAMPLE_COUNT_1_BIT)
+                            && Vulkan::IsTransientColorAttachment(m_AutoTransientUsage->ColorInputUsage, m_AutoTransientUsage->ColorOutputUsage, m_AutoTransientUsage->ColorResolved);
+        if (Transient)
+        {
+            createInfo.TexType = TT_RENDER_TARGET_TRANSIENT;
+        }
+
         m_ColorAttachments.emplace_back(CreateTextureObject(m_pVulkan, createInfo));
+        if (Transient)
+        {
+            AddTransientMemorySaved(m_ColorAttachments.back(), "Color");
+        }
     }
 
     return true;
@@ -249,6 +282,42 @@ bool CRenderTarget::InitializeResolve(const SwapchainBuffers& SwapchainBuffer)
     return true;
 }
 
+//-----------------------------------------------------------------------------
+bool CRenderTarget::InitializeAliased(const AliasedRenderTargets& AliasedTargets, const tcb::span<const AliasedRenderTargets::tTextureId> ColorTextures, AliasedRenderTargets::tTextureId DepthTexture)
+//-----------------------------------------------------------------------------
+{
+    assert(ColorTextures.size() == GetNumColorLayers());
+    LOGI("Creating Render Target (%s): (%d x %d); %d aliased color layer[s]", m_Name.c_str(), m_Width, m_Height, (int)ColorTextures.size());
+
+    m_ColorAttachments.clear();
+    m_ColorAttachments.reserve(ColorTextures.size());
+    m_ClearColorValues.clear();
+    m_ClearColorValues.resize(ColorTextures.size(), { 0.0f,0.0f,0.0f,0.0f });
+
+    for (const auto TextureId : ColorTextures)
+    {
+        m_ColorAttachments.emplace_back(AliasedTargets.CreateTextureView(TextureId));
+        if (m_ColorAttachments.back().GetVkImageView() == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+    }
+
+    if (DepthTexture != AliasedRenderTargets::cInvalidTextureId)
+    {
+        m_DepthAttachment = AliasedTargets.CreateTextureView(DepthTexture);
+        if (m_DepthAttachment.GetVkImageView() == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        ReleaseTexture(m_pVulkan, &m_DepthAttachment);
+    }
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 bool CRenderTarget::InitializeFrameBuffer(VkRenderPass renderPass, const tcb::span<const VulkanTexInfo> ColorAttachments, const VulkanTexInfo* pDepthAttachment, const tcb::span<const VulkanTexInfo> ResolveAttachments, const VulkanTexInfo* pVRSAttachment, VkFramebuffer* pFramebuffer )
 //-----------------------------------------------------------------------------
@@ -302,6 +371,22 @@ void CRenderTarget::SetClearColors(const tcb::span<const VkClearColorValue> clea
     m_ClearColorValues.assign( std::begin(clearColors), std::end(clearColors) );
 }
 
+//-----------------------------------------------------------------------------
+void CRenderTarget::AddTransientMemorySaved(const VulkanTexInfo& Attachment, const char* pAttachmentName)
+//-----------------------------------------------------------------------------
+{
+    VkDeviceSize AllocationSize = 0;
+    if (m_pVulkan->GetMemoryManager().IsLazilyAllocated(Attachment.GetVmaImage(), &AllocationSize))
+    {
+        LOGI("Render Target (%s): %s attachment is transient (%llu bytes of lazily allocated memory)", m_Name.c_str(), pAttachmentName, (unsigned long long)AllocationSize);
+        m_TransientMemorySaved += (size_t)AllocationSize;
+    }
+    else
+    {
+        LOGI("Render Target (%s): %s attachment could not be lazily allocated (no memory saved)", m_Name.c_str(), pAttachmentName);
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CRenderTarget::Release()
 //-----------------------------------------------------------------------------
@@ -9,12 +9,26 @@
 
 #include <assert.h>
 #include <array>
+#include <optional>
 #include "vulkan.hpp"
 #include "tcb/span.hpp"
 #include "vulkan/TextureFuncts.h"
+#include "vulkan/aliasedRenderTargets.hpp"
 #include "material/shaderModule.hpp"
 #include "system/os_common.h"
 
+/// Load/store usage of a render target's attachments (as passed to Vulkan::CreateRenderPass).
+/// Used by the automatic transient attachment mode to find the attachments whose contents do not outlive the render pass,
+/// these are created as transient attachments backed by lazily allocated memory (see TT_RENDER_TARGET_TRANSIENT, TT_DEPTH_TARGET_TRANSIENT).
+struct RenderTargetAttachmentUsage
+{
+    RenderPassInputUsage    ColorInputUsage = RenderPassInputUsage::Clear;
+    RenderPassOutputUsage   ColorOutputUsage = RenderPassOutputUsage::StoreReadOnly;
+    bool                    ShouldClearDepth = true;
+    RenderPassOutputUsage   DepthOutputUsage = RenderPassOutputUsage::StoreReadOnly;
+    bool                    ColorResolved = false;  ///< msaa color layers are resolved by the pass (the VK_SAMPLE_COUNT_1_BIT color layers are the resolve targets and are always stored)
+};
+
 //=============================================================================
 // CRenderTarget
 //=============================================================================
@@ -31,12 +45,16 @@ public:
     CRenderTarget& operator=( CRenderTarget&& ) noexcept;
 
     uint32_t GetNumColorLayers() const { return (uint32_t)m_pLayerFormats.size(); }
+    /// @return bytes of attachment memory (color and depth) placed in lazily allocated memory by the automatic transient attachment mode, ie memory not committed up front
+    size_t GetTransientMemorySaved() const { return m_TransientMemorySaved; }
 
     void HardReset();
-    bool Initialize( Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat = VK_FORMAT_D24_UNORM_S8_UINT, tcb::span<const VkSampleCountFlagBits> Msaa = {}, const char* pName = NULL);
-    bool Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat = VK_FORMAT_D24_UNORM_S8_UINT, VkSampleCountFlagBits Msaa = VK_SAMPLE_COUNT_1_BIT, const char* pName = NULL)
+    /// @param pAutoTransientUsage if not null, enables the automatic transient attachment mode for the attachments this target creates: TT_RENDER_TARGET color layers and the depth buffer
+    /// that the render pass(es) (created with the load/store usage in *pAutoTransientUsage) do not load or store are created in lazily allocated memory.  Null disables the mode.
+    bool Initialize( Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat = VK_FORMAT_D24_UNORM_S8_UINT, tcb::span<const VkSampleCountFlagBits> Msaa = {}, const char* pName = NULL, const RenderTargetAttachmentUsage* pAutoTransientUsage = nullptr);
+    bool Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat = VK_FORMAT_D24_UNORM_S8_UINT, VkSampleCountFlagBits Msaa = VK_SAMPLE_COUNT_1_BIT, const char* pName = NULL, const RenderTargetAttachmentUsage* pAutoTransientUsage = nullptr)
     {
-        return Initialize(pVulkan, uiWidth, uiHeight, pLayerFormats, DepthFormat, { &Msaa,1 }, pName);
+        return Initialize(pVulkan, uiWidth, uiHeight, pLayerFormats, DepthFormat, { &Msaa,1 }, pName, pAutoTransientUsage);
     }
 private:
     template<uint32_t T_NUM_BUFFERS> friend class CRenderTargetArray;
@@ -48,10 +66,16 @@ private:
     bool InitializeColor(const SwapchainBuffers& SwapchainBuffer);
     bool InitializeResolve(const SwapchainBuffers& SwapchainBuffer);
 
+    // Initialize the color and depth attachments as views of textures owned by an AliasedRenderTargets (which must outlive this render target).
+    bool InitializeAliased(const AliasedRenderTargets& AliasedTargets, const tcb::span<const AliasedRenderTargets::tTextureId> ColorTextures, AliasedRenderTargets::tTextureId DepthTexture);
+
     bool InitializeFrameBuffer(VkRenderPass renderPass, const tcb::span<const VulkanTexInfo> ColorAttachments, const VulkanTexInfo* pDepthAttachment, const tcb::span<const VulkanTexInfo> ResolveAttachments, const VulkanTexInfo* pVRSAttachment, VkFramebuffer* pFramebuffer);
 
     void SetClearColors(const tcb::span<const VkClearColorValue> clearColors);
 
+    /// Log (and add to m_TransientMemorySaved) the memory saved by a transient attachment.
+    void AddTransientMemorySaved(const VulkanTexInfo& Attachment, const char* pAttachmentName);
+
     void Release();
 
     // Attributes
@@ -85,6 +109,9 @@ public:
 
 private:
     Vulkan* m_pVulkan;
+
+    std::optional<RenderTargetAttachmentUsage> m_AutoTransientUsage;
+    size_t              m_TransientMemorySaved;
 };
 
 /// Fixed size array of CRenderTargets (eg one per 'frame') that share RenderPass objects
@@ -108,13 +135,22 @@ public:
     /// @return true if successful
     bool Initialize( Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, const CRenderTargetArray<T_NUM_BUFFERS>& inheritDepth, VkSampleCountFlagBits Msaa = VK_SAMPLE_COUNT_1_BIT, const char* pName = NULL, const tcb::span<const TEXTURE_TYPE> ColorTypes = {}, VkFilter FilterMode = VK_FILTER_LINEAR, const VulkanTexInfo* pVRSMap = VK_NULL_HANDLE);
     /// @brief initialize the render target array with the given dimensions and buffer formats.  DOES take ownership of the passed in render passes.  Because render passes could have a mix of msaa settings  take a span for each color buffer.
-    bool Initialize( Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, tcb::span<const VkSampleCountFlagBits> Msaa = {}, const char* pName = NULL, const tcb::span<const TEXTURE_TYPE> ColorTypes = {}, VkFilter FilterMode = VK_FILTER_LINEAR, const VulkanTexInfo* pVRSMap = VK_NULL_HANDLE);
+    /// @param pAutoTransientUsage if not null, enables the automatic transient attachment mode: TT_RENDER_TARGET color layers and the depth buffer that the render passes (described by *pAutoTransientUsage) do not load or store are created in lazily allocated memory (and cannot be sampled or used by any other pass).
+    bool Initialize( Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, tcb::span<const VkSampleCountFlagBits> Msaa = {}, const char* pName = NULL, const tcb::span<const TEXTURE_TYPE> ColorTypes = {}, VkFilter FilterMode = VK_FILTER_LINEAR, const VulkanTexInfo* pVRSMap = VK_NULL_HANDLE, const RenderTargetAttachmentUsage* pAutoTransientUsage = nullptr);
+    /// @brief initialize the render target array with attachments that are views of (built) textures from an AliasedRenderTargets, ie attachments whose memory may be shared with other render targets used at different points in the frame.
+    /// Dimensions, formats and msaa come from the textures.  DOES take ownership of the passed in render passes.  AliasedTargets must outlive this render target array (Release this first).
+    /// @param ColorTextures color layers of each buffer (GetNumColorLayers * T_NUM_BUFFERS ids, all of buffer 0's layers, then buffer 1's...)
+    /// @param DepthTextures depth texture of each buffer (T_NUM_BUFFERS ids), or empty for no depth
+    bool Initialize( Vulkan* pVulkan, const AliasedRenderTargets& AliasedTargets, const tcb::span<const AliasedRenderTargets::tTextureId> ColorTextures, const tcb::span<const AliasedRenderTargets::tTextureId> DepthTextures, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, const char* pName = NULL );
     /// @brief initialize the render target array using the vulkan swapchain pipeline and swapchain resolution/format.  Use as a helper to render to the swapchain  
     bool InitializeFromSwapchain( Vulkan* pVulkan );
 
     /// @brief Set the clear colors for all the render target buffers (all targets set to the same set of clear colors)
     void SetClearColors(const tcb::span<const VkClearColorValue> clearColors);
 
+    /// @return bytes of attachment memory placed in lazily allocated memory (by the automatic transient attachment mode) across all the buffers
+    size_t GetTransientMemorySaved() const;
+
     void Release();
     const CRenderTarget& operator[](size_t idx) const { return m_RenderTargets[idx]; }
     CRenderTarget& operator[](size_t idx)             { return m_RenderTargets[idx]; }
@@ -235,7 +271,7 @@ bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, uint32_t uiW
 }
 
 template<uint32_t T_NUM_BUFFERS>
-bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, tcb::span<const VkSampleCountFlagBits> Msaa, const char* pName, const tcb::span<const TEXTURE_TYPE> ColorTypes, VkFilter FilterMode, const VulkanTexInfo* pVRSMap)
+bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, uint32_t uiWidth, uint32_t uiHeight, const tcb::span<const VkFormat> pLayerFormats, VkFormat DepthFormat, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, tcb::span<const VkSampleCountFlagBits> Msaa, const char* pName, const tcb::span<const TEXTURE_TYPE> ColorTypes, VkFilter FilterMode, const VulkanTexInfo* pVRSMap, const RenderTargetAttachmentUsage* pAutoTransientUsage)
 {
     m_pVulkan = pVulkan;
     m_RenderPass = RenderPass;
@@ -247,7 +283,7 @@ bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, uint32_t uiW
     for (auto& RenderTarget : m_RenderTargets)
     {
         snprintf(szName, sizeof(szName), "%s (Buffer %d of %d)", pName, WhichBuffer + 1, T_NUM_BUFFERS);  szName[sizeof(szName) - 1] = 0;
-        if (!RenderTarget.Initialize(pVulkan, uiWidth, uiHeight, pLayerFormats, DepthFormat, Msaa, szName))
+        if (!RenderTarget.Initialize(pVulkan, uiWidth, uiHeight, pLayerFormats, DepthFormat, Msaa, szName, pAutoTransientUsage))
         {
             return false;
         }
@@ -264,6 +300,73 @@ bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, uint32_t uiW
         }
         ++WhichBuffer;
     }
+    if (pAutoTransientUsage)
+    {
+        LOGI("Render Target Array (%s): %zu bytes of transient attachments in lazily allocated memory", pName ? pName : "", GetTransientMemorySaved());
+    }
+    return true;
+}
+
+template<uint32_t T_NUM_BUFFERS>
+bool CRenderTargetArray<T_NUM_BUFFERS>::Initialize(Vulkan* pVulkan, const AliasedRenderTargets& AliasedTargets, const tcb::span<const AliasedRenderTargets::tTextureId> ColorTextures, const tcb::span<const AliasedRenderTargets::tTextureId> DepthTextures, VkRenderPass RenderPass, VkRenderPass RenderPassDepthOnly, const char* pName)
+{
+    m_pVulkan = pVulkan;
+    m_RenderPass = RenderPass;
+    m_RenderPassDepthOnly = RenderPassDepthOnly;
+
+    assert(ColorTextures.size() % T_NUM_BUFFERS == 0);
+    assert(DepthTextures.empty() || DepthTextures.size() == T_NUM_BUFFERS);
+    const size_t NumColorLayers = ColorTextures.size() / T_NUM_BUFFERS;
+
+    // ... create the render targets...
+    char szName[128];
+    uint32_t WhichBuffer = 0;
+    for (auto& RenderTarget : m_RenderTargets)
+    {
+        snprintf(szName, sizeof(szName), "%s (Buffer %d of %d)", pName, WhichBuffer + 1, T_NUM_BUFFERS);  szName[sizeof(szName) - 1] = 0;
+
+        const auto BufferColorTextures = ColorTextures.subspan(WhichBuffer * NumColorLayers, NumColorLayers);
+        const AliasedRenderTargets::tTextureId DepthTexture = DepthTextures.empty() ? AliasedRenderTargets::cInvalidTextureId : DepthTextures[WhichBuffer];
+
+        std::vector<VkFormat> LayerFormats;
+        std::vector<VkSampleCountFlagBits> Msaa;
+        for (const auto TextureId : BufferColorTextures)
+        {
+            LayerFormats.push_back(AliasedTargets.GetTextureInfo(TextureId).Format);
+            Msaa.push_back(AliasedTargets.GetTextureInfo(TextureId).Msaa);
+        }
+        const CreateTexObjectInfo& SizeInfo = AliasedTargets.GetTextureInfo(BufferColorTextures.empty() ? DepthTexture : BufferColorTextures.front());
+        const VkFormat DepthFormat = (DepthTexture == AliasedRenderTargets::cInvalidTextureId) ? VK_FORMAT_UNDEFINED : AliasedTargets.GetTextureInfo(DepthTexture).Format;
+
+        if (!RenderTarget.Initialize(pVulkan, SizeInfo.uiWidth, SizeInfo.uiHeight, LayerFormats, DepthFormat, Msaa, szName))
+        {
+            return false;
+        }
+        for (size_t WhichLayer = 0; WhichLayer < BufferColorTextures.size(); ++WhichLayer)
+        {
+            RenderTarget.m_FilterMode[WhichLayer] = AliasedTargets.GetTextureInfo(BufferColorTextures[WhichLayer]).FilterMode;
+        }
+        if (!RenderTarget.InitializeAliased(AliasedTargets, BufferColorTextures, DepthTexture))
+        {
+            return false;
+        }
+        if( RenderPass != VK_NULL_HANDLE )
+        {
+            if (!RenderTarget.InitializeFrameBuffer( RenderPass, RenderTarget.m_ColorAttachments, &RenderTarget.m_DepthAttachment, RenderTarget.m_ResolveAttachments, nullptr, &RenderTarget.m_FrameBuffer ))
+            {
+                return false;
+            }
+            pVulkan->SetDebugObjectName(RenderTarget.m_FrameBuffer, szName);
+        }
+        if( RenderPassDepthOnly != VK_NULL_HANDLE )
+        {
+            if (!RenderTarget.InitializeFrameBuffer(RenderPassDepthOnly, {}, &RenderTarget.m_DepthAttachment, {}, nullptr, &RenderTarget.m_FrameBufferDepthOnly))
+            {
+                return false;
+            }
+        }
+        ++WhichBuffer;
+    }
     return true;
 }
 
@@ -341,3 +444,12 @@ void CRenderTargetArray<T_NUM_BUFFERS>::SetClearColors(const tcb::span<const VkC
     for (auto& RenderTarget : m_RenderTargets)
         RenderTarget.SetClearColors(clearColors);
 }
+
+template<uint32_t T_NUM_BUFFERS>
+size_t CRenderTargetArray<T_NUM_BUFFERS>::GetTransientMemorySaved() const
+{
+    size_t MemorySaved = 0;
+    for (const auto& RenderTarget : m_RenderTargets)
+        MemorySaved += RenderTarget.GetTransientMemorySaved();
+    return MemorySaved;
+}
@@ -0,0 +1,282 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "textureCache.hpp"
+#include "vulkan.hpp"
+#include "system/assetManager.hpp"
+#include "system/crc32c.hpp"
+#include "system/os_common.h"
+#include <cassert>
+#include <vector>
+
+// Frames an evicted texture is kept for before being released.  Vulkan::SetNextBackBuffer waits for the frame that last used the back buffer it returns, so after this many frames any frame that could have been using the texture has completed.
+static constexpr uint64_t cFramesBeforeRelease = NUM_VULKAN_BUFFERS;
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::Handle::Handle(Entry* pEntry) : m_pEntry(pEntry)
+{
+    if (m_pEntry)
+        ++m_pEntry->RefCount;
+}
+
+TextureCache::Handle::Handle(const Handle& other) : Handle(other.m_pEntry)
+{
+}
+
+TextureCache::Handle::Handle(Handle&& other) noexcept : m_pEntry(other.m_pEntry)
+{
+    other.m_pEntry = nullptr;
+}
+
+TextureCache::Handle& TextureCache::Handle::operator=(const Handle& other)
+{
+    if (this != &other)
+    {
+        Handle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+TextureCache::Handle& TextureCache::Handle::operator=(Handle&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_pEntry = other.m_pEntry;
+        other.m_pEntry = nullptr;
+    }
+    return *this;
+}
+
+TextureCache::Handle::~Handle()
+{
+    reset();
+}
+
+const VulkanTexInfo* TextureCache::Handle::get() const
+{
+    return m_pEntry ? &m_pEntry->Texture : nullptr;
+}
+
+void TextureCache::Handle::reset()
+{
+    if (m_pEntry)
+    {
+        // Texture stays in the cache (for reuse) until evicted.
+        assert(m_pEntry->RefCount > 0);
+        --m_pEntry->RefCount;
+        m_pEntry = nullptr;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::TextureCache(Vulkan& vulkan, AssetManager& assetManager, size_t memoryBudget)
+    : m_Vulkan(vulkan)
+    , m_AssetManager(assetManager)
+    , m_MemoryBudget(memoryBudget)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::~TextureCache()
+{
+    for (auto it = m_Entries.begin(); it != m_Entries.end(); it = m_Entries.begin())
+    {
+        if (it->second.RefCount != 0)
+        {
+            LOGE("TextureCache destroyed with %u handle(s) still referencing a texture", it->second.RefCount);
+            assert(0);
+        }
+        Release(it);
+    }
+    ReleasePending(true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::Handle TextureCache::GetOrLoad(const std::string& filename, VkSamplerAddressMode samplerMode, const TextureMipGeneration& mipGeneration)
+{
+    const tOptionsKey optionsKey{ samplerMode, mipGeneration.Generate, mipGeneration.Filter, mipGeneration.AlphaCoverageCutoff };
+    auto nameKey = std::make_pair(filename, optionsKey);
+
+    // Already requested this filename?  Avoids re-reading (and re-hashing) the file.
+    auto nameIt = m_ContentKeysByName.find(nameKey);
+    if (nameIt != m_ContentKeysByName.end())
+    {
+        auto entryIt = m_Entries.find(nameIt->second);
+        if (entryIt != m_Entries.end())
+        {
+            ++m_Stats.NumNameHits;
+            return Acquire(entryIt->second);
+        }
+        // else the texture was evicted, load it again
+    }
+
+    std::vector<char> fileData;
+    if (!m_AssetManager.LoadFileIntoMemory(filename, fileData))
+    {
+        LOGE("Error reading texture file: %s", filename.c_str());
+        return {};
+    }
+
+    const uint32_t hash = crc32c(0, { (const uint8_t*)fileData.data(), fileData.size() });
+    const tContentKey contentKey{ hash, fileData.size(), optionsKey };
+    m_ContentKeysByName.insert_or_assign(std::move(nameKey), contentKey);
+
+    // Same contents as a texture we already have (through a different filename)?
+    auto entryIt = m_Entries.find(contentKey);
+    if (entryIt != m_Entries.end())
+    {
+        ++m_Stats.NumContentHits;
+        return Acquire(entryIt->second);
+    }
+
+    VulkanTexInfo texture = LoadKTXTextureFromMemory(&m_Vulkan, m_AssetManager, filename.c_str(), fileData, samplerMode, 0x7fffffff, 0.0f, mipGeneration);
+    if (texture.IsEmpty())
+    {
+        return {};
+    }
+    ++m_Stats.NumLoads;
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetImageMemoryRequirements(m_Vulkan.m_VulkanDevice, texture.GetVkImage(), &memoryRequirements);
+    const size_t memorySize = (size_t)memoryRequirements.size;
+
+    // Make room for the new texture (it is already loaded, so the cache can go over budget by up to one texture while it is being loaded).
+    EvictToBudget(memorySize);
+    if (m_MemoryBudget != 0 && m_MemoryUsed + memorySize > m_MemoryBudget)
+    {
+        LOGI("TextureCache over budget (%zu + %zu > %zu bytes), all cached textures are in use", m_MemoryUsed, memorySize, m_MemoryBudget);
+    }
+
+    Entry& entry = m_Entries[contentKey];
+    entry.Texture = std::move(texture);
+    entry.MemorySize = memorySize;
+    m_MemoryUsed += memorySize;
+    return Acquire(entry);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::SetMemoryBudget(size_t memoryBudget)
+{
+    m_MemoryBudget = memoryBudget;
+    EvictToBudget(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::ReleaseUnreferenced()
+{
+    for (auto it = m_Entries.begin(); it != m_Entries.end();)
+    {
+        auto nextIt = std::next(it);
+        if (it->second.RefCount == 0)
+        {
+            Release(it);
+            ++m_Stats.NumEvictions;
+        }
+        it = nextIt;
+    }
+    ReleasePending(true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::NextFrame()
+{
+    ++m_FrameCounter;
+    ReleasePending(false);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::Stats TextureCache::GetStats() const
+{
+    Stats stats = m_Stats;
+    stats.NumTextures = (uint32_t)m_Entries.size();
+    stats.NumReferenced = 0;
+    for (const auto& [key, entry] : m_Entries)
+        stats.NumReferenced += (entry.RefCount > 0) ? 1 : 0;
+    stats.MemoryUsed = m_MemoryUsed;
+    stats.NumPendingRelease = (uint32_t)m_PendingReleases.size();
+    for (const auto& pending : m_PendingReleases)
+        stats.MemoryPendingRelease += pending.MemorySize;
+    return stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::EvictToBudget(size_t extraBytes)
+{
+    if (m_MemoryBudget == 0)
+        return;
+
+    while (m_MemoryUsed + extraBytes > m_MemoryBudget)
+    {
+        // Least recently requested texture that has no handles.
+        auto oldestIt = m_Entries.end();
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+        {
+            if (it->second.RefCount == 0 && (oldestIt == m_Entries.end() || it->second.LastRequested < oldestIt->second.LastRequested))
+                oldestIt = it;
+        }
+        if (oldestIt == m_Entries.end())
+            break;  // everything is in use
+        Evict(oldestIt);
+        ++m_Stats.NumEvictions;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::Evict(std::map<tContentKey, Entry>::iterator it)
+{
+    // No handles, but frames still in flight (or the upload) may be using the texture.
+    assert(m_MemoryUsed >= it->second.MemorySize);
+    m_MemoryUsed -= it->second.MemorySize;
+    const uint64_t setupSubmissionId = it->second.Texture.SetupSubmissionId;
+    m_PendingReleases.push_back({ std::move(it->second.Texture), it->second.MemorySize, m_FrameCounter, setupSubmissionId });
+    m_Entries.erase(it);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::ReleasePending(bool force)
+{
+    while (!m_PendingReleases.empty())
+    {
+        PendingRelease& pending = m_PendingReleases.front();
+        if (!force && (m_FrameCounter < pending.Frame + cFramesBeforeRelease || !m_Vulkan.IsSetupSubmissionComplete(pending.SetupSubmissionId)))
+            break;  // later entries were evicted later, so cannot be released either
+        ReleaseTexture(&m_Vulkan, &pending.Texture);
+        m_PendingReleases.pop_front();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::Release(std::map<tContentKey, Entry>::iterator it)
+{
+    assert(m_MemoryUsed >= it->second.MemorySize);
+    m_MemoryUsed -= it->second.MemorySize;
+    ReleaseTexture(&m_Vulkan, &it->second.Texture);
+    m_Entries.erase(it);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureCache::Handle TextureCache::Acquire(Entry& entry)
+{
+    entry.LastRequested = ++m_RequestCounter;
+    return Handle(&entry);
+}
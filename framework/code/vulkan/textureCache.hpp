@@ -0,0 +1,137 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include "TextureFuncts.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <tuple>
+
+// Forward declarations
+class AssetManager;
+class Vulkan;
+
+/// Cache of loaded textures, keyed by a (crc32c) hash of the texture file contents.
+/// Files with different names but the same contents (common in gltf scenes where materials reference the same image through different paths) share a single decode and a single gpu copy.
+/// Textures are reference counted by TextureCache::Handle.  Textures with no handles stay in the cache (for reuse) until evicted to keep the cache within its memory budget.
+/// Evicted textures may still be in use by frames in flight (or their upload may still be in flight), so they are only released by NextFrame once that can no longer be the case.
+/// Not thread safe; intended to be used by the thread doing the material loading.
+class TextureCache
+{
+    TextureCache() = delete;
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+protected:
+    struct Entry;
+public:
+    /// Reference counted handle to a cached texture.  The texture stays loaded while any Handle references it.
+    /// Handles must be released before the TextureCache is destroyed.
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(const Handle&);
+        Handle(Handle&&) noexcept;
+        Handle& operator=(const Handle&);
+        Handle& operator=(Handle&&) noexcept;
+        ~Handle();
+
+        const VulkanTexInfo* get() const;
+        const VulkanTexInfo* operator->() const { return get(); }
+        const VulkanTexInfo& operator*() const { return *get(); }
+        explicit operator bool() const { return m_pEntry != nullptr; }
+        /// Release the reference (handle becomes empty)
+        void reset();
+
+    private:
+        friend class TextureCache;
+        explicit Handle(Entry* pEntry);
+        Entry* m_pEntry = nullptr;
+    };
+
+    /// @param memoryBudget gpu memory (bytes) the cache tries to stay within, by evicting textures that have no handles.  0 for no limit.
+    TextureCache(Vulkan& vulkan, AssetManager& assetManager, size_t memoryBudget = 0);
+    ~TextureCache();
+
+    /// Get the texture for the given file, loading it (LoadKTXTexture) if its contents are not already in the cache.
+    /// @returns empty Handle if the file could not be loaded
+    Handle GetOrLoad(const std::string& filename, VkSamplerAddressMode samplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, const TextureMipGeneration& mipGeneration = {});
+
+    /// Set the memory budget (0 for no limit).  Evicts unreferenced textures if the cache is over the new budget.
+    void SetMemoryBudget(size_t memoryBudget);
+    size_t GetMemoryBudget() const { return m_MemoryBudget; }
+    /// @returns gpu memory (bytes) used by all the cached textures (referenced or not)
+    size_t GetMemoryUsed() const { return m_MemoryUsed; }
+
+    /// Release all the textures that have no handles (eg after a level is unloaded), and any evicted textures waiting to be released.
+    /// As with ReleaseTexture the caller must ensure the gpu is no longer using them.
+    void ReleaseUnreferenced();
+
+    /// Call once per frame (after Vulkan::SetNextBackBuffer).  Releases evicted textures once every frame that may have been using them (and their upload) has completed.
+    void NextFrame();
+
+    struct Stats
+    {
+        uint32_t NumTextures = 0;       ///< textures currently in the cache
+        uint32_t NumReferenced = 0;     ///< textures with at least one handle
+        size_t   MemoryUsed = 0;
+        uint32_t NumLoads = 0;          ///< textures loaded (decoded and uploaded)
+        uint32_t NumNameHits = 0;       ///< requests for an already requested filename (no file read)
+        uint32_t NumContentHits = 0;    ///< requests for a new filename whose contents matched a cached texture (file read but not decoded)
+        uint32_t NumEvictions = 0;
+        uint32_t NumPendingRelease = 0; ///< evicted textures waiting for the gpu to finish with them
+        size_t   MemoryPendingRelease = 0;
+    };
+    Stats GetStats() const;
+
+protected:
+    // Load settings that change the created texture (part of the cache key).
+    typedef std::tuple<VkSamplerAddressMode, TextureMipGeneration::Mode, MipFilter, float> tOptionsKey;
+    // Hash and size of the file contents, plus the load settings.
+    typedef std::tuple<uint32_t, size_t, tOptionsKey> tContentKey;
+
+    struct Entry
+    {
+        VulkanTexInfo   Texture;
+        size_t          MemorySize = 0;
+        uint32_t        RefCount = 0;
+        uint64_t        LastRequested = 0;  ///< m_RequestCounter at the last GetOrLoad (for least recently used eviction)
+    };
+
+    /// Evicted texture waiting for the gpu to finish with it.
+    struct PendingRelease
+    {
+        VulkanTexInfo   Texture;
+        size_t          MemorySize = 0;
+        uint64_t        Frame = 0;              ///< m_FrameCounter when evicted
+        uint64_t        SetupSubmissionId = 0;  ///< setup submission (upload) that wrote the texture
+    };
+
+    /// Evict unreferenced textures (least recently requested first) until m_MemoryUsed + extraBytes is within the budget (or there is nothing left to evict).
+    /// Evicted textures are queued in m_PendingReleases (released by NextFrame).
+    void EvictToBudget(size_t extraBytes);
+    void Evict(std::map<tContentKey, Entry>::iterator it);
+    void Release(std::map<tContentKey, Entry>::iterator it);
+    /// Release the queued evictions, all of them if force (gpu known to be idle), otherwise only those the gpu can no longer be using.
+    void ReleasePending(bool force);
+    Handle Acquire(Entry& entry);
+
+protected:
+    Vulkan&                                         m_Vulkan;
+    AssetManager&                                   m_AssetManager;
+    size_t                                          m_MemoryBudget = 0;
+    size_t                                          m_MemoryUsed = 0;           ///< by m_Entries (not including m_PendingReleases)
+    uint64_t                                        m_RequestCounter = 0;
+    uint64_t                                        m_FrameCounter = 0;
+    std::map<tContentKey, Entry>                    m_Entries;
+    std::deque<PendingRelease>                      m_PendingReleases;          ///< in eviction order
+    std::map<std::pair<std::string, tOptionsKey>, tContentKey> m_ContentKeysByName;    ///< filenames (and settings) we have already hashed
+    Stats                                           m_Stats;
+};
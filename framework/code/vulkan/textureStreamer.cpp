@@ -0,0 +1,382 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "textureStreamer.hpp"
+#include "vulkan.hpp"
+#include "material/material.hpp"
+#include "system/assetManager.hpp"
+#include "system/os_common.h"
+#include "system/Worker.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Textures not requested for this many Updates are the first to have their mips dropped.
+static constexpr uint64_t cUnrequestedFrames = 60;
+
+///////////////////////////////////////////////////////////////////////////////
+
+static size_t L_GetImageMemorySize(Vulkan& vulkan, const VulkanTexInfo& texture)
+{
+    VkMemoryRequirements memoryRequirements{};
+    vkGetImageMemoryRequirements(vulkan.m_VulkanDevice, texture.GetVkImage(), &memoryRequirements);
+    return (size_t)memoryRequirements.size;
+}
+
+// Each mip level is (roughly) 4x the size of the level below it, so the texture grows (or shrinks) by 4x per level added (or dropped).
+static size_t L_EstimateMemorySize(size_t memorySize, uint32_t fromMipLevels, uint32_t toMipLevels)
+{
+    if (toMipLevels >= fromMipLevels)
+        return memorySize << std::min(2u * (toMipLevels - fromMipLevels), 40u);
+    return memorySize >> std::min(2u * (fromMipLevels - toMipLevels), 40u);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStreamer::TextureStreamer(Vulkan& vulkan, AssetManager& assetManager, CWorker& worker, uint32_t numFrameBuffers, size_t memoryBudget)
+    : m_Vulkan(vulkan)
+    , m_AssetManager(assetManager)
+    , m_Worker(worker)
+    , m_NumFrameBuffers(numFrameBuffers)
+    , m_AllBuffersMask(numFrameBuffers >= 32 ? 0xffffffff : (1u << numFrameBuffers) - 1)
+    , m_MemoryBudget(memoryBudget)
+{
+    assert(numFrameBuffers > 0 && numFrameBuffers <= 32);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStreamer::~TextureStreamer()
+{
+    // The worker may still be decoding in to the pending loads.
+    if (std::any_of(m_Textures.begin(), m_Textures.end(), [](const StreamedTexture& texture) { return texture.pPendingLoad != nullptr; }))
+        m_Worker.FinishAllWork();
+    for (auto& texture : m_Textures)
+        ReleaseTexture(&m_Vulkan, &texture.Texture);
+    for (auto& releasing : m_ReleasingTextures)
+        ReleaseTexture(&m_Vulkan, &releasing.Texture);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStreamer::tTextureId TextureStreamer::AddTexture(const std::string& filename, VkSamplerAddressMode samplerMode, uint32_t tailMipLevels)
+{
+    StreamedTexture texture;
+    texture.Filename = filename;
+    texture.SamplerMode = samplerMode;
+    if (!m_AssetManager.LoadFileIntoMemory(filename, texture.FileData))
+    {
+        LOGE("Error reading texture file: %s", filename.c_str());
+        return cInvalidTextureId;
+    }
+    texture.NumMipLevels = GetKTXTextureMipLevels(filename.c_str(), texture.FileData);
+    if (texture.NumMipLevels == 0)
+    {
+        LOGE("Error reading texture header: %s", filename.c_str());
+        return cInvalidTextureId;
+    }
+    texture.TailMipLevels = std::clamp(tailMipLevels, 1u, texture.NumMipLevels);
+    texture.WantedMipLevels = texture.TailMipLevels;
+
+    if (!Replace(texture, LoadKTXTextureFromMemory(&m_Vulkan, m_AssetManager, filename.c_str(), texture.FileData, samplerMode, (int32_t)texture.TailMipLevels)))
+        return cInvalidTextureId;
+    // Nothing has been bound to the texture yet.
+    texture.DirtyBuffers = 0;
+    texture.CommittedSize = texture.MemorySize;
+    m_MemoryCommitted += texture.CommittedSize;
+
+    m_Textures.push_back(std::move(texture));
+    return (tTextureId)(m_Textures.size() - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const VulkanTexInfo* TextureStreamer::GetTexture(tTextureId textureId) const
+{
+    if (textureId >= m_Textures.size())
+        return nullptr;
+    return &m_Textures[textureId].Texture;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStreamer::AddMaterialBinding(tTextureId textureId, const Material& material, const std::string& bindingName)
+{
+    if (textureId >= m_Textures.size())
+        return false;
+    if (material.GetNumFrameBuffers() != m_NumFrameBuffers)
+    {
+        LOGE("TextureStreamer material binding \"%s\" has %u frame buffers (expected %u), texture will not be streamed: %s", bindingName.c_str(), material.GetNumFrameBuffers(), m_NumFrameBuffers, m_Textures[textureId].Filename.c_str());
+        return false;
+    }
+    m_Textures[textureId].Bindings.push_back({ &material, bindingName });
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::RequestMipLevel(tTextureId textureId, float mipLevel)
+{
+    if (textureId >= m_Textures.size())
+        return;
+    auto& texture = m_Textures[textureId];
+    mipLevel = std::max(mipLevel, 0.0f);
+    if (texture.RequestedMipLevel < 0.0f || mipLevel < texture.RequestedMipLevel)
+        texture.RequestedMipLevel = mipLevel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+float TextureStreamer::CalcMipLevelFromDistance(uint32_t textureSize, float objectSize, float distance, float fovY, uint32_t screenHeight)
+{
+    if (distance <= 0.0f || objectSize <= 0.0f)
+        return 0.0f;
+    const float screenPixels = objectSize / (2.0f * distance * std::tan(fovY * 0.5f)) * float(screenHeight);
+    if (screenPixels <= 0.0f)
+        return 0.0f;
+    return std::max(0.0f, std::log2(float(textureSize) / screenPixels));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStreamer::Update(uint32_t bufferIdx)
+{
+    assert(bufferIdx < m_NumFrameBuffers);
+    ++m_FrameIndex;
+
+    FinishLoads();
+    UpdateResidency();
+
+    // Point this frame buffer's descriptor sets at the current textures.
+    const uint32_t bufferBit = 1u << bufferIdx;
+    bool descriptorsUpdated = false;
+    for (auto& texture : m_Textures)
+    {
+        if ((texture.DirtyBuffers & bufferBit) == 0)
+            continue;
+        for (const auto& binding : texture.Bindings)
+        {
+            if (!binding.pMaterial->UpdateDescriptorSetBinding(bufferIdx, binding.BindingName, texture.Texture))
+                LOGE("TextureStreamer failed to update material binding \"%s\": %s", binding.BindingName.c_str(), texture.Filename.c_str());
+            descriptorsUpdated = true;
+        }
+        texture.DirtyBuffers &= ~bufferBit;
+    }
+
+    // This frame buffer's previous commands have completed and its descriptor sets no longer reference any replaced textures.
+    for (auto it = m_ReleasingTextures.begin(); it != m_ReleasingTextures.end();)
+    {
+        it->PendingBuffers &= ~bufferBit;
+        if (it->PendingBuffers == 0)
+        {
+            m_Stats.MemoryReleasing -= it->MemorySize;
+            ReleaseTexture(&m_Vulkan, &it->Texture);
+            it = m_ReleasingTextures.erase(it);
+        }
+        else
+            ++it;
+    }
+    return descriptorsUpdated;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::FinishLoads()
+{
+    for (auto& texture : m_Textures)
+    {
+        if (!texture.pPendingLoad || !texture.pPendingLoad->Done.load(std::memory_order_acquire))
+            continue;
+        const std::unique_ptr<PendingLoad> pLoad = std::move(texture.pPendingLoad);
+
+        VulkanTexInfo newTexture;
+        if (!pLoad->Decoded.IsEmpty())
+            newTexture = CreateDecodedKTXTexture(&m_Vulkan, m_AssetManager, texture.Filename.c_str(), pLoad->Decoded, texture.SamplerMode, (int32_t)pLoad->NumMipLevels);
+        const uint32_t previousMipLevels = texture.Texture.MipLevels;
+        if (Replace(texture, std::move(newTexture)))
+        {
+            if (texture.Texture.MipLevels > previousMipLevels)
+                ++m_Stats.NumUpgrades;
+            else
+                ++m_Stats.NumDowngrades;
+        }
+
+        // Swap the estimate for the actual size.
+        m_MemoryCommitted -= texture.CommittedSize;
+        texture.CommittedSize = texture.MemorySize;
+        m_MemoryCommitted += texture.CommittedSize;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::UpdateResidency()
+{
+    std::vector<StreamedTexture*> upgrades;
+    for (auto& texture : m_Textures)
+    {
+        if (texture.RequestedMipLevel >= 0.0f)
+        {
+            const uint32_t firstMip = std::min((uint32_t)texture.RequestedMipLevel, texture.NumMipLevels - 1);
+            texture.WantedMipLevels = std::max(texture.NumMipLevels - firstMip, texture.TailMipLevels);
+            texture.LastRequestFrame = m_FrameIndex;
+            texture.RequestedMipLevel = -1.0f;
+        }
+        else if (texture.LastRequestFrame + cUnrequestedFrames < m_FrameIndex)
+        {
+            // Not requested recently, happy to drop back to the mip tail (when the budget needs the room).
+            texture.WantedMipLevels = texture.TailMipLevels;
+        }
+
+        if (!texture.pPendingLoad && texture.WantedMipLevels > texture.Texture.MipLevels)
+            upgrades.push_back(&texture);
+    }
+
+    uint32_t loadsRemaining = m_MaxLoadsPerUpdate;
+
+    // Get back within budget (eg after SetMemoryBudget) before adding anything.
+    if (m_MemoryBudget != 0 && m_MemoryCommitted > m_MemoryBudget)
+        FreeMemory(m_MemoryCommitted - m_MemoryBudget, nullptr, loadsRemaining);
+
+    // Largest shortfall first (most visibly blurry), most recently requested breaking ties.
+    std::sort(upgrades.begin(), upgrades.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        const uint32_t shortfallA = a->WantedMipLevels - a->Texture.MipLevels;
+        const uint32_t shortfallB = b->WantedMipLevels - b->Texture.MipLevels;
+        if (shortfallA != shortfallB)
+            return shortfallA > shortfallB;
+        return a->LastRequestFrame > b->LastRequestFrame;
+    });
+
+    for (StreamedTexture* pTexture : upgrades)
+    {
+        if (loadsRemaining == 0)
+            break;
+
+        if (m_MemoryBudget != 0)
+        {
+            const size_t estimatedSize = L_EstimateMemorySize(pTexture->MemorySize, pTexture->Texture.MipLevels, pTexture->WantedMipLevels);
+            const size_t estimatedUsed = m_MemoryCommitted - pTexture->CommittedSize + estimatedSize;
+            if (estimatedUsed > m_MemoryBudget && !FreeMemory(estimatedUsed - m_MemoryBudget, pTexture, loadsRemaining))
+            {
+                ++m_Stats.NumBudgetLimited;
+                continue;
+            }
+            if (loadsRemaining == 0)
+                break;
+        }
+
+        --loadsRemaining;
+        StartLoad(*pTexture, pTexture->WantedMipLevels);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStreamer::FreeMemory(size_t bytesNeeded, const StreamedTexture* pExcludeTexture, uint32_t& loadsRemaining)
+{
+    std::vector<StreamedTexture*> candidates;
+    for (auto& texture : m_Textures)
+    {
+        if (&texture != pExcludeTexture && !texture.pPendingLoad && texture.Texture.MipLevels > texture.WantedMipLevels)
+            candidates.push_back(&texture);
+    }
+    // Least recently requested first.
+    std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->LastRequestFrame < b->LastRequestFrame;
+    });
+
+    size_t bytesFreed = 0;
+    for (StreamedTexture* pTexture : candidates)
+    {
+        if (bytesFreed >= bytesNeeded || loadsRemaining == 0)
+            break;
+        --loadsRemaining;
+        const size_t previousSize = pTexture->CommittedSize;
+        StartLoad(*pTexture, pTexture->WantedMipLevels);
+        if (pTexture->CommittedSize < previousSize)
+            bytesFreed += previousSize - pTexture->CommittedSize;
+    }
+    return bytesFreed >= bytesNeeded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::StartLoad(StreamedTexture& texture, uint32_t numMipLevels)
+{
+    assert(!texture.pPendingLoad);
+    texture.pPendingLoad = std::make_unique<PendingLoad>();
+    PendingLoad& load = *texture.pPendingLoad;
+    load.NumMipLevels = numMipLevels;
+    load.pVulkan = &m_Vulkan;
+    load.pFileName = texture.Filename.c_str();
+    load.FileData = texture.FileData;
+
+    // Count the estimated size against the budget until FinishLoads knows the actual size.
+    m_MemoryCommitted -= texture.CommittedSize;
+    texture.CommittedSize = L_EstimateMemorySize(texture.MemorySize, texture.Texture.MipLevels, numMipLevels);
+    m_MemoryCommitted += texture.CommittedSize;
+
+    const auto JobFn = [](void* pParam) {
+        PendingLoad& load = *static_cast<PendingLoad*>(pParam);
+        DecodeKTXTexture(*load.pVulkan, load.pFileName, load.FileData, &load.Decoded);
+        load.Done.store(true, std::memory_order_release);
+    };
+    if (m_Worker.NumThreads() > 0)
+        m_Worker.DoWork(JobFn, &load, 0);
+    else
+        JobFn(&load);   // no threads, decode on this thread (uploaded by the next Update)
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStreamer::Replace(StreamedTexture& texture, VulkanTexInfo newTexture)
+{
+    if (newTexture.IsEmpty())
+    {
+        // Do not keep trying to load levels we cannot load.
+        texture.NumMipLevels = std::max(texture.Texture.MipLevels, 1u);
+        texture.TailMipLevels = std::min(texture.TailMipLevels, texture.NumMipLevels);
+        texture.WantedMipLevels = std::min(texture.WantedMipLevels, texture.NumMipLevels);
+        return false;
+    }
+    // A fallback file (LoadKTXTexture loads .win.ktx files when the format is not supported) may have had all its mips loaded.
+    texture.NumMipLevels = std::max(texture.NumMipLevels, newTexture.MipLevels);
+
+    const size_t memorySize = L_GetImageMemorySize(m_Vulkan, newTexture);
+    if (!texture.Texture.IsEmpty())
+    {
+        // Keep the old texture until every frame buffer has been updated to the new one.
+        m_ReleasingTextures.push_back({ std::move(texture.Texture), texture.MemorySize, m_AllBuffersMask });
+        m_Stats.MemoryReleasing += texture.MemorySize;
+        m_MemoryUsed -= texture.MemorySize;
+    }
+    texture.Texture = std::move(newTexture);
+    texture.MemorySize = memorySize;
+    texture.DirtyBuffers = m_AllBuffersMask;
+    m_MemoryUsed += memorySize;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStreamer::Stats TextureStreamer::GetStats() const
+{
+    Stats stats = m_Stats;
+    stats.NumTextures = (uint32_t)m_Textures.size();
+    stats.NumFullyResident = 0;
+    stats.FileMemoryUsed = 0;
+    stats.NumLoading = 0;
+    for (const auto& texture : m_Textures)
+    {
+        stats.NumFullyResident += (texture.Texture.MipLevels >= texture.NumMipLevels) ? 1 : 0;
+        stats.FileMemoryUsed += texture.FileData.size();
+        stats.NumLoading += texture.pPendingLoad ? 1 : 0;
+    }
+    stats.MemoryUsed = m_MemoryUsed;
+    return stats;
+}
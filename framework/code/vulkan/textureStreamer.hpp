@@ -0,0 +1,168 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include "TextureFuncts.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Forward declarations
+class AssetManager;
+class CWorker;
+class Material;
+class Vulkan;
+
+/// Streams texture mip levels in and out of gpu memory.
+/// Textures start with just their lowest resolution mips (the 'mip tail') resident, so scenes can start drawing as soon as the small mips are uploaded.
+/// Each frame the application requests the finest mip level it needs for each texture (eg from camera distance with CalcMipLevelFromDistance, or from shader written feedback) and Update
+/// uploads finer mips (a few textures per frame) while keeping the resident textures within a memory budget, dropping mips that are no longer requested when it needs room.
+/// Changing residency creates a new VkImage (and VkImageView) containing the new set of mips; registered material bindings are pointed at the new texture with
+/// Material::UpdateDescriptorSetBinding (one frame buffer at a time, as each becomes idle) and the old texture is released once no frame buffer can be referencing it.
+/// The texture file contents are kept in (cpu) memory so mips can be reloaded without going back to disk; reloads are decoded on the worker's threads and uploaded
+/// (through the staging ring buffer, not waited on) by a later Update, so Update never decodes a texture itself.
+/// Not thread safe.
+class TextureStreamer
+{
+    TextureStreamer() = delete;
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+public:
+    typedef uint32_t tTextureId;
+    static constexpr tTextureId cInvalidTextureId = 0xffffffff;
+
+    /// @param worker threads the texture reloads are decoded on (decoded on the calling thread, in Update, if the worker has no threads).  Must outlive the TextureStreamer.
+    /// @param numFrameBuffers number of frame buffers (descriptor sets per material) the application cycles through (eg NUM_VULKAN_BUFFERS).  32 maximum.
+    /// @param memoryBudget gpu memory (bytes) the resident textures are kept within (by dropping mips that are not requested).  0 for no limit.
+    TextureStreamer(Vulkan& vulkan, AssetManager& assetManager, CWorker& worker, uint32_t numFrameBuffers, size_t memoryBudget = 0);
+    /// Waits for any reloads still being decoded and releases all the textures.  As with ReleaseTexture the caller must ensure the gpu is no longer using them.
+    ~TextureStreamer();
+
+    /// Add a texture to be streamed, loading (just) its mip tail (synchronously, the tail is small).
+    /// @param tailMipLevels number of (lowest resolution) mip levels that are always resident (default is 64x64 and smaller for a full mip chain)
+    /// @returns id of the streamed texture, cInvalidTextureId if the file could not be loaded
+    tTextureId AddTexture(const std::string& filename, VkSamplerAddressMode samplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, uint32_t tailMipLevels = 7);
+
+    /// @returns the current texture for the given id.  The pointer stays valid (for the life of the TextureStreamer) but the texture it points to changes as mips are streamed,
+    /// so users that are not registered with AddMaterialBinding should re-read the VkImageView each frame.
+    const VulkanTexInfo* GetTexture(tTextureId textureId) const;
+
+    /// Register a material binding that uses the texture, so it is updated whenever the texture's residency changes.
+    /// The material must have one descriptor set per frame buffer, and must not move or be destroyed while registered.
+    /// @returns false if the material does not have one descriptor set per frame buffer (the binding would be updated while in use by the gpu)
+    bool AddMaterialBinding(tTextureId textureId, const Material& material, const std::string& bindingName);
+
+    /// Request the texture be resident down to (at least) the given mip level (0 is full resolution) for the next Update.  Multiple requests in a frame use the finest level.
+    /// Textures that are not requested for a number of frames are candidates for their mips being dropped (back to the mip tail) when the streamer needs room.
+    void RequestMipLevel(tTextureId textureId, float mipLevel);
+
+    /// @returns the mip level needed to draw a texture of textureSize texels across an object objectSize (world units) across at the given distance from the camera,
+    /// with one texel per pixel on a screen screenHeight pixels high with a vertical field of view of fovY (radians).
+    static float CalcMipLevelFromDistance(uint32_t textureSize, float objectSize, float distance, float fovY, uint32_t screenHeight);
+
+    /// Upload any reloads the worker has finished decoding, start reloads (upload or drop mips) to match this frame's requests and point the bufferIdx descriptor sets of registered material bindings at any textures that have changed.
+    /// Call once per frame, after waiting for the gpu to finish with bufferIdx (its descriptor sets must not be in use) and before recording any commands that use them.
+    /// @returns true if any descriptor sets for bufferIdx were updated (command buffers that bind them must be re-recorded)
+    bool Update(uint32_t bufferIdx);
+
+    /// Set the memory budget (0 for no limit).  Mips are dropped (over the following Updates) if the streamer is over the new budget.
+    void SetMemoryBudget(size_t memoryBudget) { m_MemoryBudget = memoryBudget; }
+    size_t GetMemoryBudget() const { return m_MemoryBudget; }
+    /// @returns gpu memory (bytes) used by the resident textures (not including textures waiting to be released)
+    size_t GetMemoryUsed() const { return m_MemoryUsed; }
+    /// Maximum number of texture reloads (residency changes) started by each Update.  Limits how much decoding is queued on the worker and uploaded in any one frame.
+    void SetMaxLoadsPerUpdate(uint32_t maxLoadsPerUpdate) { m_MaxLoadsPerUpdate = maxLoadsPerUpdate; }
+
+    struct Stats
+    {
+        uint32_t NumTextures = 0;
+        uint32_t NumFullyResident = 0;  ///< textures with all their mips resident
+        size_t   MemoryUsed = 0;        ///< gpu memory used by the resident textures
+        size_t   MemoryReleasing = 0;   ///< gpu memory used by replaced textures still waiting for all the frame buffers to stop using them
+        size_t   FileMemoryUsed = 0;    ///< cpu memory holding the texture file contents
+        uint32_t NumUpgrades = 0;       ///< loads that added mips
+        uint32_t NumDowngrades = 0;     ///< loads that dropped mips
+        uint32_t NumBudgetLimited = 0;  ///< upgrades skipped because the budget was full of requested mips
+        uint32_t NumLoading = 0;        ///< reloads still being decoded on the worker
+    };
+    Stats GetStats() const;
+
+protected:
+    struct MaterialBinding
+    {
+        const Material* pMaterial = nullptr;
+        std::string     BindingName;
+    };
+
+    /// A reload being decoded on the worker.  Only the worker touches it until Done is set.
+    struct PendingLoad
+    {
+        uint32_t                    NumMipLevels = 0;       ///< levels to create once decoded
+        const Vulkan*               pVulkan = nullptr;
+        const char*                 pFileName = nullptr;
+        tcb::span<const char>       FileData;
+        DecodedKTXTexture           Decoded;                ///< empty if the decode failed
+        std::atomic<bool>           Done{ false };
+    };
+
+    struct StreamedTexture
+    {
+        std::string                 Filename;
+        VkSamplerAddressMode        SamplerMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        std::vector<char>           FileData;
+        uint32_t                    NumMipLevels = 0;       ///< levels in the file
+        uint32_t                    TailMipLevels = 0;      ///< levels that are always resident
+        uint32_t                    WantedMipLevels = 0;    ///< levels wanted resident (from the requests)
+        float                       RequestedMipLevel = -1.0f;  ///< finest level requested since the last Update (-1 if not requested)
+        uint64_t                    LastRequestFrame = 0;
+        VulkanTexInfo               Texture;
+        size_t                      MemorySize = 0;
+        size_t                      CommittedSize = 0;      ///< MemorySize, or the estimated size of the pending load (counted against the budget)
+        uint32_t                    DirtyBuffers = 0;       ///< frame buffers whose descriptor sets have not been updated with Texture
+        std::vector<MaterialBinding> Bindings;
+        std::unique_ptr<PendingLoad> pPendingLoad;          ///< reload in progress (null if none)
+    };
+
+    struct ReleasingTexture
+    {
+        VulkanTexInfo   Texture;
+        size_t          MemorySize = 0;
+        uint32_t        PendingBuffers = 0;     ///< frame buffers that may still be referencing the texture
+    };
+
+    /// Create (upload) the textures the worker has finished decoding and swap them in.
+    void FinishLoads();
+    /// Work out each texture's wanted mip levels from the requests and start reloads to upload/drop mips (up to m_MaxLoadsPerUpdate textures).
+    void UpdateResidency();
+    /// Start dropping mips from textures that have more resident than wanted (least recently requested first, skipping pExcludeTexture) until (an estimated) bytesNeeded will be freed.
+    /// @returns true if enough memory will be freed
+    bool FreeMemory(size_t bytesNeeded, const StreamedTexture* pExcludeTexture, uint32_t& loadsRemaining);
+    /// Start decoding the texture on the worker, FinishLoads replaces it with one containing the lowest numMipLevels levels.
+    void StartLoad(StreamedTexture& texture, uint32_t numMipLevels);
+    /// Replace the texture with newTexture.  The old texture is released once all the frame buffers have been updated.
+    /// @returns false (and stops trying to load more levels than are resident) if newTexture is empty
+    bool Replace(StreamedTexture& texture, VulkanTexInfo newTexture);
+
+protected:
+    Vulkan&                         m_Vulkan;
+    AssetManager&                   m_AssetManager;
+    CWorker&                        m_Worker;
+    const uint32_t                  m_NumFrameBuffers;
+    const uint32_t                  m_AllBuffersMask;       ///< one bit per frame buffer
+    size_t                          m_MemoryBudget = 0;
+    size_t                          m_MemoryUsed = 0;
+    size_t                          m_MemoryCommitted = 0;  ///< m_MemoryUsed with pending loads at their estimated size
+    uint32_t                        m_MaxLoadsPerUpdate = 2;
+    uint64_t                        m_FrameIndex = 0;
+    std::deque<StreamedTexture>     m_Textures;             ///< indexed by tTextureId (deque so GetTexture pointers stay valid as textures are added)
+    std::vector<ReleasingTexture>   m_ReleasingTextures;
+    Stats                           m_Stats;
+};
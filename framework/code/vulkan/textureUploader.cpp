@@ -0,0 +1,204 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+#include "textureUploader.hpp"
+#include "vulkan.hpp"
+#include "system/os_common.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+TextureUploader::TextureUploader(Vulkan* pVulkan) : m_pVulkan(pVulkan), m_Ring(pVulkan->GetStagingRingBuffer())
+//-----------------------------------------------------------------------------
+{
+    m_pVulkan->ReclaimStagingRingBuffer(false);
+    m_SetupCmdBuffer = m_pVulkan->StartSetupCommandBuffer();
+}
+
+//-----------------------------------------------------------------------------
+TextureUploader::~TextureUploader()
+//-----------------------------------------------------------------------------
+{
+    Finish();
+}
+
+//-----------------------------------------------------------------------------
+StagingRingBuffer::Allocation TextureUploader::Allocate(size_t size, size_t alignment)
+//-----------------------------------------------------------------------------
+{
+    if (!m_Ring && !m_Ring.Initialize(&m_pVulkan->GetMemoryManager(), std::max(size, cDefaultStagingRingSize)))
+    {
+        LOGE("Unable to initialize the staging ring buffer");
+        return {};
+    }
+    auto allocation = m_Ring.Allocate(size, alignment);
+    if (!allocation)
+    {
+        // Ring is full (of data for commands already recorded or in flight), submit ours and wait for the oldest submissions until there is room.
+        Finish();
+        m_SetupCmdBuffer = m_pVulkan->StartSetupCommandBuffer();
+        while (!(allocation = m_Ring.Allocate(size, alignment)) && m_pVulkan->ReclaimStagingRingBuffer(true))
+        {
+        }
+        // Nothing left in flight (ring is empty) and still does not fit, grow it.
+        if (!allocation && !m_pVulkan->HasPendingStagingRingBufferReleases())
+        {
+            if (!m_Ring.Initialize(&m_pVulkan->GetMemoryManager(), std::max(size, m_Ring.GetSize() * 2)))
+            {
+                LOGE("Unable to grow the staging ring buffer to %zu bytes", size);
+                return {};
+            }
+            allocation = m_Ring.Allocate(size, alignment);
+        }
+    }
+    return allocation;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t TextureUploader::Finish()
+//-----------------------------------------------------------------------------
+{
+    if (m_SetupCmdBuffer != VK_NULL_HANDLE)
+    {
+        const uint64_t SubmissionId = m_pVulkan->SubmitSetupCommandBuffer(m_SetupCmdBuffer);
+        m_SetupCmdBuffer = VK_NULL_HANDLE;
+        m_pVulkan->ReleaseStagingRingBufferOnSubmission(SubmissionId, m_Ring.GetHead());
+        m_LastSubmissionId = SubmissionId;
+    }
+    return m_LastSubmissionId;
+}
+
+//-----------------------------------------------------------------------------
+bool RecordImageUpload(TextureUploader& Uploader, VkImage Image, VkFormat Format, const tcb::span<const TextureSubresourceData> Subresources, uint32_t MipLevels, uint32_t ArrayLayers, VkImageLayout FinalLayout)
+//-----------------------------------------------------------------------------
+{
+    Vulkan* pVulkan = Uploader.GetVulkan();
+    const bool Compressed = Vulkan::FormatIsCompressed(Format);
+    const uint32_t BytesPerBlock = Vulkan::FormatBytesPerBlock(Format);
+
+    // Buffer offsets must be a multiple of the texel (block) size and of 4.
+    size_t Alignment = std::lcm(size_t(4), size_t(BytesPerBlock ? BytesPerBlock : 16));
+    Alignment = std::lcm(Alignment, std::max(size_t(1), (size_t)pVulkan->GetGpuProperties().Base.properties.limits.optimalBufferCopyOffsetAlignment));
+
+    // Staged data is tightly packed (source rows may be padded, eg KTX pads uncompressed rows to 4 bytes).
+    const auto StagedRowBytes = [&](const TextureSubresourceData& Subresource) -> size_t {
+        if (Compressed)
+            return 0;   // copied as is
+        if (BytesPerBlock != 0)
+            return size_t(Subresource.Width) * BytesPerBlock;
+        return Subresource.Size / (size_t(Subresource.Height) * Subresource.Depth);   // unknown format, assume no padding
+    };
+    const auto StagedSize = [&](const TextureSubresourceData& Subresource) -> size_t {
+        const size_t RowBytes = StagedRowBytes(Subresource);
+        return RowBytes ? RowBytes * Subresource.Height * Subresource.Depth : Subresource.Size;
+    };
+
+    size_t TotalSize = 0;
+    for (const auto& Subresource : Subresources)
+    {
+        TotalSize = ((TotalSize + Alignment - 1) / Alignment) * Alignment;
+        TotalSize += StagedSize(Subresource);
+    }
+
+    auto Staging = Uploader.Allocate(TotalSize, Alignment);
+    if (!Staging)
+    {
+        LOGE("Unable to allocate %zu bytes of staging memory", TotalSize);
+        return false;
+    }
+
+    std::vector<VkBufferImageCopy> Regions;
+    Regions.reserve(Subresources.size());
+    size_t Offset = 0;
+    for (const auto& Subresource : Subresources)
+    {
+        Offset = ((Offset + Alignment - 1) / Alignment) * Alignment;
+        uint8_t* pDst = Staging.pData + Offset;
+        const size_t RowBytes = StagedRowBytes(Subresource);
+        const size_t Rows = size_t(Subresource.Height) * Subresource.Depth;
+        const size_t SrcRowPitch = Rows ? Subresource.Size / Rows : 0;
+        if (RowBytes == 0 || RowBytes == SrcRowPitch)
+        {
+            memcpy(pDst, Subresource.pData, StagedSize(Subresource));
+        }
+        else
+        {
+            // Pitch is such that we need to copy line by line
+            const uint8_t* pSrc = Subresource.pData;
+            for (size_t Row = 0; Row < Rows; ++Row)
+            {
+                memcpy(pDst, pSrc, std::min(RowBytes, SrcRowPitch));
+                pDst += RowBytes;
+                pSrc += SrcRowPitch;
+            }
+        }
+
+        VkBufferImageCopy Region {};
+        Region.bufferOffset = Staging.offset + Offset;
+        Region.bufferRowLength = 0;     // tightly packed
+        Region.bufferImageHeight = 0;
+        Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        Region.imageSubresource.mipLevel = Subresource.MipLevel;
+        Region.imageSubresource.baseArrayLayer = Subresource.ArrayLayer;
+        Region.imageSubresource.layerCount = 1;
+        Region.imageOffset = { 0, 0, 0 };
+        Region.imageExtent = { Subresource.Width, Subresource.Height, Subresource.Depth };
+        Regions.push_back(Region);
+
+        Offset += StagedSize(Subresource);
+    }
+
+    // Get the command buffer after allocating (Allocate may have submitted the previous one).
+    VkCommandBuffer SetupCmdBuffer = Uploader.GetCommandBuffer();
+
+    // Image barrier for optimal image (target)
+    // Optimal image will be used as destination for the copy
+    VkPipelineStageFlags srcMask = 0;
+    VkPipelineStageFlags dstMask = 1;
+    uint32_t baseMipLevel = 0;
+    uint32_t mipLevelCount = MipLevels;
+    uint32_t baseLayer = 0;
+    uint32_t layerCount = ArrayLayers;
+
+    pVulkan->SetImageLayout(Image,
+        SetupCmdBuffer,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        srcMask,
+        dstMask,
+        baseMipLevel,
+        mipLevelCount,
+        baseLayer,
+        layerCount);
+
+    // Copy all the faces and mips
+    // Vulkan spec says the (cube map) face order is +X, -X, +Y, -Y, +Z, -Z
+    vkCmdCopyBufferToImage(SetupCmdBuffer, Staging.buffer, Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)Regions.size(), Regions.data());
+
+    // Leave in transfer destination layout if the caller has more transfers to record (eg mip generation)
+    if (FinalLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+        return true;
+
+    // Change texture image layout to the 'final' settings now we are done transferring
+    pVulkan->SetImageLayout(Image,
+        SetupCmdBuffer,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        FinalLayout,
+        srcMask,
+        dstMask,
+        baseMipLevel,
+        mipLevelCount,
+        baseLayer,
+        layerCount);
+
+    return true;
+}
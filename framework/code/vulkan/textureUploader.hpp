@@ -0,0 +1,70 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include "tcb/span.hpp"
+#include "memory/stagingRingBuffer.hpp"
+
+// Forward declarations
+class Vulkan;
+
+/// Records texture uploads in to a setup command buffer, with the texel data staged in the Vulkan staging ring buffer (persistently mapped).
+/// Finish submits without waiting; the ring space is released once that submission completes (Vulkan::ReclaimStagingRingBuffer), so the cpu can go on to load/decode the next texture while the gpu does the copies.
+/// When the ring buffer is full the commands recorded so far are submitted and we wait for the oldest submissions until there is room (growing the ring if one upload is bigger than all of it), so any amount of data can be uploaded through one TextureUploader.
+/// @ingroup Vulkan
+class TextureUploader
+{
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+public:
+    /// Default size of the staging ring buffer (if not already initialized by its first user).
+    static constexpr size_t cDefaultStagingRingSize = 16 * 1024 * 1024;
+
+    explicit TextureUploader(Vulkan* pVulkan);
+    /// Submits (does not wait for) anything recorded.
+    ~TextureUploader();
+
+    Vulkan* GetVulkan() const { return m_pVulkan; }
+
+    /// Current setup command buffer.  Changes when Allocate has to submit, so get it after Allocate.
+    VkCommandBuffer GetCommandBuffer() const { return m_SetupCmdBuffer; }
+
+    /// Allocate staging memory for data to be copied by commands recorded in to GetCommandBuffer().
+    StagingRingBuffer::Allocation Allocate(size_t size, size_t alignment);
+
+    /// Submit the recorded commands (does not wait for them to complete).
+    /// @returns id of the last submission made through this uploader (waiting on it also waits for any earlier submissions Allocate made), for VulkanTexInfo::SetupSubmissionId
+    uint64_t Finish();
+
+private:
+    Vulkan*             m_pVulkan;
+    StagingRingBuffer&  m_Ring;
+    VkCommandBuffer     m_SetupCmdBuffer = VK_NULL_HANDLE;
+    uint64_t            m_LastSubmissionId = 0;
+};
+
+/// Texel data for one mip level of one array layer (face), source for RecordImageUpload
+struct TextureSubresourceData
+{
+    const uint8_t*  pData;
+    size_t          Size;       ///< bytes of pData (uncompressed rows may be padded)
+    uint32_t        Width;
+    uint32_t        Height;
+    uint32_t        Depth;
+    uint32_t        MipLevel;
+    uint32_t        ArrayLayer;
+};
+
+/// Record the upload of the given subresources in to Image (all MipLevels and ArrayLayers are transitioned from VK_IMAGE_LAYOUT_UNDEFINED to FinalLayout).
+/// Stages all the subresources in one TextureUploader allocation and copies them with a single vkCmdCopyBufferToImage.
+/// @param FinalLayout VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL leaves the image ready for more transfers (eg mip generation) in Uploader.GetCommandBuffer()
+/// @returns false if the staging memory could not be allocated (nothing is recorded)
+/// @ingroup Vulkan
+bool RecordImageUpload(TextureUploader& Uploader, VkImage Image, VkFormat Format, const tcb::span<const TextureSubresourceData> Subresources, uint32_t MipLevels, uint32_t ArrayLayers, VkImageLayout FinalLayout);
@@ -77,7 +77,10 @@ Vulkan::Vulkan()
     m_SwapchainImageCount = 0;
     m_VulkanSwapchain = VK_NULL_HANDLE;
     m_SwapchainCurrentIndx = 0;
-    // m_SwapchainDepth;
+    m_SwapchainDepth.format = VK_FORMAT_UNDEFINED;
+    m_SwapchainDepth.view = VK_NULL_HANDLE;
+    m_SwapchainRenderPass = VK_NULL_HANDLE;
+    m_VulkanSurface = VK_NULL_HANDLE;
 
     // Vulkan Objects
     m_VulkanInstance = VK_NULL_HANDLE;
@@ -115,7 +118,6 @@ Vulkan::Vulkan()
 
     m_VulkanCmdPool = VK_NULL_HANDLE;
     m_VulkanComputeCmdPool = VK_NULL_HANDLE;
-    m_SetupCmdBuffer = VK_NULL_HANDLE;
 
     m_VulkanQueryPool = VK_NULL_HANDLE;
 
@@ -130,7 +132,11 @@ Vulkan::~Vulkan()
     DestroySwapchainRenderPass();
     DestroySwapChain();
 
+    if (m_VulkanDevice != VK_NULL_HANDLE)
+        DestroySetupCommandBuffers();
+
     //DestroyMemoryManager();
+    m_StagingRingBuffer.Destroy();
     m_MemoryManager.Destroy();
 
     //DestroyCommandPools();
@@ -268,6 +274,60 @@ bool Vulkan::Init(uintptr_t windowHandle, uintptr_t hInst, const Vulkan::tSelect
     return true;
 }
 
+//-----------------------------------------------------------------------------
+bool Vulkan::InitHeadless(const Vulkan::tConfigurationFn& CustomConfigurationFn)
+//-----------------------------------------------------------------------------
+{
+    // Same as Init up to (and including) the memory manager, without the surface and swapchain.
+    if (CustomConfigurationFn)
+        CustomConfigurationFn( m_ConfigOverride );
+
+    if (!RegisterKnownExtensions())
+        return false;
+
+    if (!CreateInstance())
+        return false;
+
+    if (!InitInstanceFunctions())
+        return false;
+
+    if (!GetPhysicalDevices())
+        return false;
+
+    if (!InitQueue())
+        return false;
+
+#if defined(USES_VULKAN_DEBUG_LAYERS)
+    if (gEnableValidation && m_LayerKhronosValidationAvailable && !InitDebugCallback())
+        return false;
+#endif // USES_VULKAN_DEBUG_LAYERS
+
+    if (!InitHeadlessQueue())
+        return false;
+
+    if (!InitCompute())
+        return false;
+
+    if (!InitDevice())
+        return false;
+
+    if (!InitSyncElements())
+        return false;
+
+    if (!InitCommandPools())
+        return false;
+
+    if (!InitQueryPools())
+        return false;
+
+    if (!InitMemoryManager())
+        return false;
+
+    InitPipelineCache();    //ok for this to fail!
+
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 void Vulkan::Terminate()
 //-----------------------------------------------------------------------------
@@ -535,6 +595,119 @@ bool Vulkan::FormatIsSrgb( VkFormat format )
     }
 }
 
+//-----------------------------------------------------------------------------
+uint32_t Vulkan::FormatBytesPerBlock( VkFormat format )
+//-----------------------------------------------------------------------------
+{
+    switch (format) {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SNORM:
+    case VK_FORMAT_R8_UINT:
+    case VK_FORMAT_R8_SINT:
+    case VK_FORMAT_R8_SRGB:
+        return 1;
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SNORM:
+    case VK_FORMAT_R8G8_UINT:
+    case VK_FORMAT_R8G8_SINT:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R16_UNORM:
+    case VK_FORMAT_R16_SNORM:
+    case VK_FORMAT_R16_UINT:
+    case VK_FORMAT_R16_SINT:
+    case VK_FORMAT_R16_SFLOAT:
+    case VK_FORMAT_R5G6B5_UNORM_PACK16:
+    case VK_FORMAT_B5G6R5_UNORM_PACK16:
+    case VK_FORMAT_R4G4B4A4_UNORM_PACK16:
+    case VK_FORMAT_B4G4R4A4_UNORM_PACK16:
+    case VK_FORMAT_R5G5B5A1_UNORM_PACK16:
+    case VK_FORMAT_B5G5R5A1_UNORM_PACK16:
+    case VK_FORMAT_A1R5G5B5_UNORM_PACK16:
+        return 2;
+    case VK_FORMAT_R8G8B8_UNORM:
+    case VK_FORMAT_R8G8B8_SNORM:
+    case VK_FORMAT_R8G8B8_UINT:
+    case VK_FORMAT_R8G8B8_SINT:
+    case VK_FORMAT_R8G8B8_SRGB:
+    case VK_FORMAT_B8G8R8_UNORM:
+    case VK_FORMAT_B8G8R8_SRGB:
+        return 3;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SNORM:
+    case VK_FORMAT_R8G8B8A8_UINT:
+    case VK_FORMAT_R8G8B8A8_SINT:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+    case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+    case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+    case VK_FORMAT_R16G16_UNORM:
+    case VK_FORMAT_R16G16_SNORM:
+    case VK_FORMAT_R16G16_UINT:
+    case VK_FORMAT_R16G16_SINT:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_UINT:
+    case VK_FORMAT_R32_SINT:
+    case VK_FORMAT_R32_SFLOAT:
+        return 4;
+    case VK_FORMAT_R16G16B16_UNORM:
+    case VK_FORMAT_R16G16B16_SFLOAT:
+        return 6;
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SNORM:
+    case VK_FORMAT_R16G16B16A16_UINT:
+    case VK_FORMAT_R16G16B16A16_SINT:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32G32_UINT:
+    case VK_FORMAT_R32G32_SINT:
+    case VK_FORMAT_R32G32_SFLOAT:
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+        return 8;
+    case VK_FORMAT_R32G32B32_UINT:
+    case VK_FORMAT_R32G32B32_SINT:
+    case VK_FORMAT_R32G32B32_SFLOAT:
+        return 12;
+    case VK_FORMAT_R32G32B32A32_UINT:
+    case VK_FORMAT_R32G32B32A32_SINT:
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        return 16;
+    default:
+        // All the ASTC block sizes are 16 bytes
+        if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+            return 16;
+        return 0;
+    }
+}
+
 //-----------------------------------------------------------------------------
 bool Vulkan::IsTextureFormatSupported( VkFormat format ) const
 //-----------------------------------------------------------------------------
@@ -687,7 +860,10 @@ void Vulkan::SetImageLayout(VkImage image,
         break;
 
     case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-        imageMemoryBarrier.srcAccessMask = 0;
+        // Old layout is transfer destination (copy, blit)
+        // Make sure any writes to the image have been finished (eg before blitting from a just written mip level)
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
         break;
 
     case VK_IMAGE_LAYOUT_PREINITIALIZED:
@@ -755,7 +931,8 @@ void Vulkan::SetImageLayout(VkImage image,
         imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        destStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        // Any shader stage (vertex, compute etc) in a later submission may sample the image.
+        destStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
         break;
 
     case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
@@ -839,6 +1016,8 @@ bool Vulkan::RegisterKnownExtensions()
     m_DeviceExtensions.AddExtension( VK_EXT_GLOBAL_PRIORITY_EXTENSION_NAME, VulkanExtension::eOptional );
     m_ExtHdrMetadata = m_DeviceExtensions.AddExtension<ExtensionHelper::Ext_VK_EXT_hdr_metadata>( VulkanExtension::eOptional );
     m_DeviceExtensions.AddExtension( VK_EXT_SAMPLE_LOCATIONS_EXTENSION_NAME, VulkanExtension::eOptional );
+    // Driver reported heap usage/budget for the MemoryManager statistics (estimated if not available).
+    m_DeviceExtensions.AddExtension( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, VulkanExtension::eOptional );
     m_DeviceExtensions.AddExtension( "VK_QCOM_render_pass_transform", VulkanExtension::eOptional);
     // This extension allows us to set  VK_SUBPASS_DESCRIPTION_SHADER_RESOLVE_BIT_QCOM (enable if available)
     m_DeviceExtensions.AddExtension( "VK_QCOM_render_pass_shader_resolve", VulkanExtension::eOptional);
@@ -1940,6 +2119,24 @@ bool Vulkan::InitSurface()
     return true;
 }
 
+//-----------------------------------------------------------------------------
+bool Vulkan::InitHeadlessQueue()
+//-----------------------------------------------------------------------------
+{
+    // No surface (InitHeadless), so no present support needed.  Take the first graphics queue (and use it for transfers too).
+    for (uint32_t uiIndx = 0; uiIndx < m_pVulkanQueueProps.size(); uiIndx++)
+    {
+        if ((m_pVulkanQueueProps[uiIndx].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+        {
+            m_VulkanGraphicsQueueIndx = uiIndx;
+            m_VulkanTransferQueueIndx = uiIndx;
+            return true;
+        }
+    }
+    LOGE("Unable to find a queue that supports graphics!");
+    return false;
+}
+
 //-----------------------------------------------------------------------------
 bool Vulkan::InitCompute()
 //-----------------------------------------------------------------------------
@@ -2148,6 +2345,12 @@ bool Vulkan::InitDevice()
         vkGetDeviceQueue(m_VulkanDevice, m_VulkanComputeQueueIndx, 0, &m_VulkanComputeQueue);
     }
 
+    // No surface to get the formats of (InitHeadless)
+    if (m_VulkanSurface == VK_NULL_HANDLE)
+    {
+        return true;
+    }
+
     // ********************************
     // Get Supported Formats
     // ********************************
@@ -2328,7 +2531,7 @@ bool Vulkan::InitQueryPools()
 bool Vulkan::InitMemoryManager()
 //-----------------------------------------------------------------------------
 {
-    return m_MemoryManager.Initialize(m_VulkanGpu, m_VulkanDevice, m_VulkanInstance, HasLoadedVulkanDeviceExtension("VK_KHR_buffer_device_address"));
+    return m_MemoryManager.Initialize(m_VulkanGpu, m_VulkanDevice, m_VulkanInstance, HasLoadedVulkanDeviceExtension("VK_KHR_buffer_device_address"), HasLoadedVulkanDeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME));
 }
 
 //-----------------------------------------------------------------------------
@@ -3675,6 +3878,42 @@ bool Vulkan::CreateRenderPass(tcb::span<const VkFormat> ColorFormats, VkFormat D
     return true;
 }
 
+//-----------------------------------------------------------------------------
+bool Vulkan::IsTransientAttachment( const VkAttachmentDescription& AttachmentDesc )
+//-----------------------------------------------------------------------------
+{
+    if (AttachmentDesc.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD || AttachmentDesc.storeOp != VK_ATTACHMENT_STORE_OP_DONT_CARE)
+        return false;
+    if (FormatHasStencil( AttachmentDesc.format ))
+        return AttachmentDesc.stencilLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD && AttachmentDesc.stencilStoreOp == VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Vulkan::IsTransientColorAttachment( RenderPassInputUsage ColorInputUsage, RenderPassOutputUsage ColorOutputUsage, bool IsResolved )
+//-----------------------------------------------------------------------------
+{
+    if (ColorInputUsage == RenderPassInputUsage::Load)
+        return false;
+    switch (ColorOutputUsage) {
+    case RenderPassOutputUsage::Discard:
+        return true;
+    case RenderPassOutputUsage::Present:
+        // Presenting passes with a resolve write to the (swapchain) resolve buffer and do not store the msaa buffer.
+        return IsResolved;
+    default:
+        return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool Vulkan::IsTransientDepthAttachment( bool ShouldClearDepth, RenderPassOutputUsage DepthOutputUsage )
+//-----------------------------------------------------------------------------
+{
+    // Stencil is always DONT_CARE (load and store) in the passes made by CreateRenderPass.
+    return ShouldClearDepth && DepthOutputUsage == RenderPassOutputUsage::Discard;
+}
+
 
 //-----------------------------------------------------------------------------
 bool Vulkan::CreateRenderPassVRS(tcb::span<const VkFormat> ColorFormats, VkFormat DepthFormat, VkSampleCountFlagBits Msaa,
@@ -4407,94 +4646,223 @@ VkCommandBuffer Vulkan::StartSetupCommandBuffer()
 {
     VkResult RetVal = VK_SUCCESS;
 
-    // Make sure we are not leaking by starting without releasing!
-    if (m_SetupCmdBuffer != VK_NULL_HANDLE)
+    // Recycle the command buffers of setup submissions that have completed...
+    RetireSetupCommandBuffers();
+
+    SetupCmdBuffer Setup;
+    if (!m_SetupCmdBuffersFree.empty())
     {
-        LOGE("Setup CommandBuffer has NOT been freed!");
-        vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &m_SetupCmdBuffer);
-        m_SetupCmdBuffer = VK_NULL_HANDLE;
+        Setup = m_SetupCmdBuffersFree.back();
+        m_SetupCmdBuffersFree.pop_back();
     }
+    else
+    {
+        // ... or allocate a new setup command buffer (and the fence that tells us when it can be reused) ...
+        VkCommandBufferAllocateInfo AllocInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        AllocInfo.commandPool = m_VulkanCmdPool;
+        AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        AllocInfo.commandBufferCount = 1;
 
-    // Allocate the setup command buffer...
-    VkCommandBufferAllocateInfo AllocInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
-    AllocInfo.commandPool = m_VulkanCmdPool;
-    AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    AllocInfo.commandBufferCount = 1;
+        RetVal = vkAllocateCommandBuffers(m_VulkanDevice, &AllocInfo, &Setup.CmdBuffer);
+        if (!CheckVkError("vkAllocateCommandBuffers()", RetVal))
+        {
+            return VK_NULL_HANDLE;
+        }
 
-    RetVal = vkAllocateCommandBuffers(m_VulkanDevice, &AllocInfo, &m_SetupCmdBuffer);
-    if (!CheckVkError("vkAllocateCommandBuffers()", RetVal))
-    {
-        return VK_NULL_HANDLE;
+        VkFenceCreateInfo FenceInfo {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        RetVal = vkCreateFence(m_VulkanDevice, &FenceInfo, nullptr, &Setup.Fence);
+        if (!CheckVkError("vkCreateFence()", RetVal))
+        {
+            vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &Setup.CmdBuffer);
+            return VK_NULL_HANDLE;
+        }
     }
 
-    // ... and start it up
+    // ... and start it up (implicitly resets a recycled command buffer)
     VkCommandBufferBeginInfo BeginInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    BeginInfo.flags = 0;
+    BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     BeginInfo.pInheritanceInfo = nullptr;
 
-    RetVal = vkBeginCommandBuffer(m_SetupCmdBuffer, &BeginInfo);
+    RetVal = vkBeginCommandBuffer(Setup.CmdBuffer, &BeginInfo);
     if (!CheckVkError("vkBeginCommandBuffer()", RetVal))
     {
+        m_SetupCmdBuffersFree.push_back(Setup);
         return VK_NULL_HANDLE;
     }
-    return m_SetupCmdBuffer;
+    m_SetupCmdBuffersRecording.push_back(Setup);
+    return Setup.CmdBuffer;
 }
 
 //-----------------------------------------------------------------------------
 void Vulkan::FinishSetupCommandBuffer(VkCommandBuffer setupCmdBuffer)
 //-----------------------------------------------------------------------------
 {
-    VkResult RetVal = VK_SUCCESS;
-
-    // Make sure we are not out of state!
-    if (m_SetupCmdBuffer == VK_NULL_HANDLE)
+    // Submit the command buffer...
+    const uint64_t SubmissionId = SubmitSetupCommandBuffer(setupCmdBuffer);
+    if (SubmissionId == 0)
     {
-        LOGE("Setup CommandBuffer has NOT been set started!");
         return;
     }
-    if (m_SetupCmdBuffer != setupCmdBuffer)
+
+    // ... and wait for it to complete (on its fence, rather than idling the whole queue).
+    WaitSetupSubmission(SubmissionId);
+}
+
+//-----------------------------------------------------------------------------
+uint64_t Vulkan::SubmitSetupCommandBuffer(VkCommandBuffer setupCmdBuffer)
+//-----------------------------------------------------------------------------
+{
+    VkResult RetVal = VK_SUCCESS;
+
+    // Make sure we are not out of state!
+    auto RecordingIt = std::find_if(m_SetupCmdBuffersRecording.begin(), m_SetupCmdBuffersRecording.end(), [setupCmdBuffer](const SetupCmdBuffer& Setup) { return Setup.CmdBuffer == setupCmdBuffer; });
+    if (RecordingIt == m_SetupCmdBuffersRecording.end())
     {
-        LOGE("Setup CommandBuffer does not match he one passed in to FinishSetupCommandBuffer!");
+        LOGE("Setup CommandBuffer passed to SubmitSetupCommandBuffer has NOT been started!");
+        return 0;
     }
+    SetupCmdBuffer Setup = *RecordingIt;
+    m_SetupCmdBuffersRecording.erase(RecordingIt);
 
     // Stop recording the command buffer...
-    RetVal = vkEndCommandBuffer(m_SetupCmdBuffer);
+    RetVal = vkEndCommandBuffer(Setup.CmdBuffer);
     if (!CheckVkError("vkEndCommandBuffer()", RetVal))
     {
-        return;
+        m_SetupCmdBuffersFree.push_back(Setup);
+        return 0;
     }
 
-    // ... submit the command buffer ...
+    // ... submit the command buffer (signalling its fence on completion) ...
     VkSubmitInfo SubmitInfo {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     SubmitInfo.waitSemaphoreCount = 0;
     SubmitInfo.pWaitSemaphores = nullptr;
     SubmitInfo.pWaitDstStageMask = nullptr;
     SubmitInfo.commandBufferCount = 1;
-    SubmitInfo.pCommandBuffers = &m_SetupCmdBuffer;
+    SubmitInfo.pCommandBuffers = &Setup.CmdBuffer;
     SubmitInfo.signalSemaphoreCount = 0;
     SubmitInfo.pSignalSemaphores = nullptr;
 
-    RetVal = vkQueueSubmit(m_VulkanQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+    RetVal = vkQueueSubmit(m_VulkanQueue, 1, &SubmitInfo, Setup.Fence);
     if (!CheckVkError("vkQueueSubmit()", RetVal))
     {
-        vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &m_SetupCmdBuffer);
-        m_SetupCmdBuffer = VK_NULL_HANDLE;
-        return;
+        m_SetupCmdBuffersFree.push_back(Setup);
+        return 0;
+    }
+
+    // ... and keep hold of it until the fence says it has completed (freeing it while still executing crashes desktop drivers).
+    Setup.SubmissionId = ++m_LastSetupSubmissionId;
+    m_SetupCmdBuffersInFlight.push_back(Setup);
+    return Setup.SubmissionId;
+}
+
+//-----------------------------------------------------------------------------
+bool Vulkan::WaitSetupSubmission(uint64_t submissionId)
+//-----------------------------------------------------------------------------
+{
+    std::vector<VkFence> Fences;
+    for (const auto& Setup : m_SetupCmdBuffersInFlight)
+    {
+        if (Setup.SubmissionId > submissionId)
+            break;
+        Fences.push_back(Setup.Fence);
+    }
+
+    if (!Fences.empty())
+    {
+        VkResult RetVal = vkWaitForFences(m_VulkanDevice, (uint32_t)Fences.size(), Fences.data(), VK_TRUE, UINT64_MAX);
+        if (!CheckVkError("vkWaitForFences()", RetVal))
+        {
+            return false;
+        }
+    }
+    RetireSetupCommandBuffers();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Vulkan::IsSetupSubmissionComplete(uint64_t submissionId)
+//-----------------------------------------------------------------------------
+{
+    RetireSetupCommandBuffers();
+    return m_SetupCmdBuffersInFlight.empty() || m_SetupCmdBuffersInFlight.front().SubmissionId > submissionId;
+}
+
+//-----------------------------------------------------------------------------
+void Vulkan::RetireSetupCommandBuffers()
+//-----------------------------------------------------------------------------
+{
+    // Retire in submission order (stop at the first incomplete one) so every submission before the front of m_SetupCmdBuffersInFlight is known to be complete.
+    while (!m_SetupCmdBuffersInFlight.empty())
+    {
+        SetupCmdBuffer& Setup = m_SetupCmdBuffersInFlight.front();
+        if (vkGetFenceStatus(m_VulkanDevice, Setup.Fence) != VK_SUCCESS)
+        {
+            break;
+        }
+        vkResetFences(m_VulkanDevice, 1, &Setup.Fence);
+        Setup.SubmissionId = 0;
+        m_SetupCmdBuffersFree.push_back(Setup);
+        m_SetupCmdBuffersInFlight.pop_front();
     }
+}
 
-    // ... wait for it to complete...
-    // This CRASHES the desktop drivers if commented out!
-    RetVal = vkQueueWaitIdle(m_VulkanQueue);
-    if (!CheckVkError("vkQueueWaitIdle()", RetVal))
+//-----------------------------------------------------------------------------
+void Vulkan::DestroySetupCommandBuffers()
+//-----------------------------------------------------------------------------
+{
+    WaitAllSetupSubmissions();
+    m_StagingRingBufferReleases.clear();
+
+    if (!m_SetupCmdBuffersRecording.empty())
     {
-        vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &m_SetupCmdBuffer);
-        m_SetupCmdBuffer = VK_NULL_HANDLE;
+        LOGE("%zu setup CommandBuffer(s) were started but never submitted!", m_SetupCmdBuffersRecording.size());
+    }
+
+    auto DestroySetup = [this](const SetupCmdBuffer& Setup) {
+        vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &Setup.CmdBuffer);
+        vkDestroyFence(m_VulkanDevice, Setup.Fence, nullptr);
+    };
+    std::for_each(m_SetupCmdBuffersFree.begin(), m_SetupCmdBuffersFree.end(), DestroySetup);
+    std::for_each(m_SetupCmdBuffersRecording.begin(), m_SetupCmdBuffersRecording.end(), DestroySetup);
+    std::for_each(m_SetupCmdBuffersInFlight.begin(), m_SetupCmdBuffersInFlight.end(), DestroySetup);
+    m_SetupCmdBuffersFree.clear();
+    m_SetupCmdBuffersRecording.clear();
+    m_SetupCmdBuffersInFlight.clear();
+}
+
+//-----------------------------------------------------------------------------
+void Vulkan::ReleaseStagingRingBufferOnSubmission(uint64_t submissionId, uint64_t ringHead)
+//-----------------------------------------------------------------------------
+{
+    if (IsSetupSubmissionComplete(submissionId) && m_StagingRingBufferReleases.empty())
+    {
+        m_StagingRingBuffer.Release(ringHead);
         return;
     }
+    m_StagingRingBufferReleases.push_back({ submissionId, ringHead });
+}
 
-    // ... and then clean up the command buffer
-    vkFreeCommandBuffers(m_VulkanDevice, m_VulkanCmdPool, 1, &m_SetupCmdBuffer);
-    m_SetupCmdBuffer = VK_NULL_HANDLE;
+//-----------------------------------------------------------------------------
+bool Vulkan::ReclaimStagingRingBuffer(bool wait)
+//-----------------------------------------------------------------------------
+{
+    if (m_StagingRingBufferReleases.empty())
+    {
+        return false;
+    }
+    if (wait && !IsSetupSubmissionComplete(m_StagingRingBufferReleases.front().SubmissionId))
+    {
+        WaitSetupSubmission(m_StagingRingBufferReleases.front().SubmissionId);
+    }
+
+    bool Released = false;
+    while (!m_StagingRingBufferReleases.empty() && IsSetupSubmissionComplete(m_StagingRingBufferReleases.front().SubmissionId))
+    {
+        m_StagingRingBuffer.Release(m_StagingRingBufferReleases.front().RingHead);
+        m_StagingRingBufferReleases.pop_front();
+        Released = true;
+    }
+    return Released;
 }
 
 //-----------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #ifdef OS_ANDROID
 #endif // OS_ANDROID
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <optional>
@@ -32,6 +33,7 @@
 #include "extension.hpp"
 #include "tcb/span.hpp"
 #include "memory/memoryManager.hpp"
+#include "memory/stagingRingBuffer.hpp"
 
 // This should actually be defined in the makefile!
 #define USES_VULKAN_DEBUG_LAYERS
@@ -170,6 +172,9 @@ public:
     typedef std::function<int(tcb::span<const VkSurfaceFormatKHR>)> tSelectSurfaceFormatFn;
     typedef std::function<void(AppConfiguration&)> tConfigurationFn;
     bool Init(uintptr_t hWnd, uintptr_t hInst, const tSelectSurfaceFormatFn& SelectSurfaceFormatFn = nullptr, const tConfigurationFn& CustomConfigurationFn = nullptr);
+    /// Initialize without a window: creates the device, queues, command pools and memory manager but no surface or swapchain (so nothing can be presented).
+    /// For offscreen tools and tests, eg uploading and reading back images on a software Vulkan driver.
+    bool InitHeadless(const tConfigurationFn& CustomConfigurationFn = nullptr);
 
     void Terminate();
 
@@ -227,8 +232,31 @@ public:
 
     typedef std::function<void( uint32_t width, uint32_t height, VkFormat format, uint32_t span, const void* data)> tDumpSwapChainOutputFn;
 
+    /// Start recording a (one time) setup command buffer.  Command buffers are recycled from a pool once their submissions have completed, several can be recording at once.
     VkCommandBuffer StartSetupCommandBuffer();
+    /// Submit a setup command buffer (from StartSetupCommandBuffer) and wait for it (and any earlier setup submissions) to complete.
     void FinishSetupCommandBuffer(VkCommandBuffer setupCmdBuffer);
+    /// Submit a setup command buffer (from StartSetupCommandBuffer) without waiting for it.
+    /// Work submitted later to m_VulkanQueue executes after it, so the cpu only needs to wait (WaitSetupSubmission) before touching or destroying resources the commands use (eg staging memory).
+    /// @returns setup submission id (increasing in submission order), 0 on error
+    uint64_t SubmitSetupCommandBuffer(VkCommandBuffer setupCmdBuffer);
+    /// Wait for the given setup submission, and all setup submissions before it, to complete.
+    bool WaitSetupSubmission(uint64_t submissionId);
+    /// Wait for all outstanding setup submissions to complete.
+    bool WaitAllSetupSubmissions() { return WaitSetupSubmission(m_LastSetupSubmissionId); }
+    /// @returns true if the given setup submission (and all setup submissions before it) has completed.  Does not block.
+    bool IsSetupSubmissionComplete(uint64_t submissionId);
+    /// @returns id of the most recent setup submission (0 if there have been none)
+    uint64_t GetLastSetupSubmissionId() const { return m_LastSetupSubmissionId; }
+
+    /// Release the staging ring buffer allocations made before ringHead (StagingRingBuffer::GetHead) once the given setup submission (which reads them) has completed.
+    void ReleaseStagingRingBufferOnSubmission(uint64_t submissionId, uint64_t ringHead);
+    /// Release the staging ring buffer space of completed setup submissions (from ReleaseStagingRingBufferOnSubmission).
+    /// @param wait if nothing could be released wait for the oldest pending submission (rather than returning false)
+    /// @returns true if any space was released
+    bool ReclaimStagingRingBuffer(bool wait);
+    /// @returns true if staging ring buffer space is waiting on a setup submission to be released
+    bool HasPendingStagingRingBufferReleases() const { return !m_StagingRingBufferReleases.empty(); }
 
     VkCompositeAlphaFlagBitsKHR     GetBestVulkanCompositeAlpha();
     /// @brief return the supported depth format with the highest precision depth/stencil supported with optimal tiling
@@ -242,6 +270,8 @@ public:
     static bool FormatIsCompressed( VkFormat );
     /// @return true if the given format is sRGB, return false if linear
     static bool FormatIsSrgb( VkFormat );
+    /// @return size (in bytes) of one texel (or one compressed block) of the given color format, or 0 if the format is not known
+    static uint32_t FormatBytesPerBlock( VkFormat );
 
     /// Check if the Vulkan device supports the given texture format.
     /// Typically used to check block compression formats when loading images.
@@ -293,6 +323,14 @@ public:
         tcb::span<const VkFormat> ResolveFormats = {},
         bool hasDensityMap = false);
 
+    /// @return true if the attachment is neither loaded nor stored by its render pass (contents do not outlive the pass) so can be a transient attachment backed by lazily allocated memory.
+    static bool IsTransientAttachment( const VkAttachmentDescription& AttachmentDesc );
+    /// @return true if the color attachments of a render pass made by CreateRenderPass (or CreateRenderPassVRS) with the given usages are transient (see IsTransientAttachment).
+    /// @param IsResolved true if the (msaa) color attachment is resolved in the pass (has a defined ResolveFormats entry)
+    static bool IsTransientColorAttachment( RenderPassInputUsage ColorInputUsage, RenderPassOutputUsage ColorOutputUsage, bool IsResolved );
+    /// @return true if the depth attachment of a render pass made by CreateRenderPass (or CreateRenderPassVRS) with the given usages is transient (see IsTransientAttachment).
+    static bool IsTransientDepthAttachment( bool ShouldClearDepth, RenderPassOutputUsage DepthOutputUsage );
+
     /// @brief Create a VkRenderPass (two subpasses) with MSAA resolves (including shader resolves if supported).
     /// First subpass writes to the buffers described by 'InternalColorFormats'.  Those buffers are cleared before use and discarded at the end of the (entire) pass.
     /// Second subpass takes the buffers written by the first subpass as inputs and writes to buffers described by OutputColorFormats.  Those buffers are NOT cleared before use (assumed 2nd pass writes to all pixels).
@@ -375,6 +413,8 @@ public:
     // Accessors
     MemoryManager& GetMemoryManager() { return m_MemoryManager; }
     const MemoryManager& GetMemoryManager() const { return m_MemoryManager; }
+    /// Staging buffer for uploads done in the setup command buffer (initialized by the first user, not on Vulkan initialization)
+    StagingRingBuffer& GetStagingRingBuffer() { return m_StagingRingBuffer; }
     VkInstance GetVulkanInstance() const { return m_VulkanInstance; }
     uint32_t GetVulkanQueueIndx() const { return m_VulkanGraphicsQueueIndx; }
     const auto& GetGpuProperties() const { return m_VulkanGpuProperties; }
@@ -446,6 +486,7 @@ private:
 #endif // USES_VULKAN_DEBUG_LAYERS
 
     bool InitSurface();
+    bool InitHeadlessQueue();
     bool InitCompute();
     bool InitDevice();
     bool InitSyncElements();
@@ -462,6 +503,10 @@ private:
     void DestroySwapChain();
     void DestroySwapchainRenderPass();
     void DestroyFrameBuffers();
+    void DestroySetupCommandBuffers();
+
+    /// Recycle the setup command buffers (and fences) of completed setup submissions.
+    void RetireSetupCommandBuffers();
 
     struct PhysicalDeviceFeatures;
     struct PhysicalDeviceProperties;
@@ -691,8 +736,24 @@ private:
     VkSurfaceTransformFlagBitsKHR       m_SwapchainPreTransform;///< Current swapchain pre-transform
 
     MemoryManager                       m_MemoryManager;
+    StagingRingBuffer                   m_StagingRingBuffer;
+    struct StagingRingBufferRelease
+    {
+        uint64_t    SubmissionId;
+        uint64_t    RingHead;
+    };
+    std::deque<StagingRingBufferRelease> m_StagingRingBufferReleases;   ///< staging ring space waiting on setup submissions (in submission order)
 
-    VkCommandBuffer                     m_SetupCmdBuffer;
+    struct SetupCmdBuffer
+    {
+        VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
+        VkFence         Fence = VK_NULL_HANDLE;         ///< signalled when the submission completes (unsignalled while recording or free)
+        uint64_t        SubmissionId = 0;
+    };
+    std::vector<SetupCmdBuffer>         m_SetupCmdBuffersFree;          ///< ready to be reused by StartSetupCommandBuffer
+    std::vector<SetupCmdBuffer>         m_SetupCmdBuffersRecording;     ///< started but not yet submitted
+    std::deque<SetupCmdBuffer>          m_SetupCmdBuffersInFlight;      ///< submitted, in submission order
+    uint64_t                            m_LastSetupSubmissionId = 0;
 
     VkPipelineCache                     m_PipelineCache;
 };
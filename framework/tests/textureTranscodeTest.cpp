@@ -0,0 +1,424 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+// CPU tests for textureTranscode (no Vulkan device needed).
+// Golden blocks are hand built from the BC (S3TC/RGTC) and ETC2/EAC specifications with the expected texels worked out from the spec, not from the decoder.
+
+#include "texture/textureTranscode.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+    int gFailures = 0;
+
+    void Fail(const char* pTest, const char* pMessage)
+    {
+        printf("FAILED %s: %s\n", pTest, pMessage);
+        ++gFailures;
+    }
+
+    /// Decode one 4x4 block and compare every texel (channels wide) against expected (row major).
+    void CheckBlock(const char* pTest, VkFormat format, VkFormat decodedFormat, uint32_t channels, std::initializer_list<uint8_t> block, const uint8_t (*pExpected)[4])
+    {
+        if (SelectTranscodeFormat(format, [decodedFormat](VkFormat f) { return f == decodedFormat; }, false) != decodedFormat)
+        {
+            Fail(pTest, "unexpected decode format");
+            return;
+        }
+        std::vector<uint8_t> decoded;
+        if (!TranscodeImage(format, decodedFormat, block.begin(), block.size(), 4, 4, 0, decoded) || decoded.size() != 16 * channels)
+        {
+            Fail(pTest, "TranscodeImage failed");
+            return;
+        }
+        for (uint32_t i = 0; i < 16; ++i)
+            for (uint32_t c = 0; c < channels; ++c)
+                if (decoded[i * channels + c] != pExpected[i][c])
+                {
+                    char message[128];
+                    snprintf(message, sizeof(message), "texel (%u,%u) channel %u is %u, expected %u", i % 4, i / 4, c, decoded[i * channels + c], pExpected[i][c]);
+                    Fail(pTest, message);
+                    return;
+                }
+    }
+
+    /// Expand a 4 entry palette (indexed by texel x) to 16 row major texels.
+    void PaletteByColumn(const uint8_t (&palette)[4][4], uint8_t (*pTexels)[4])
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+            memcpy(pTexels[i], palette[i % 4], 4);
+    }
+
+    //
+    // BC
+    //
+
+    void TestBc1()
+    {
+        // c0 = 0xF800 (red) > c1 = 0x001F (blue): 4 color mode.  Every row uses indices 0,1,2,3.
+        const uint8_t fourColor[4][4] = { {255, 0, 0, 255}, {0, 0, 255, 255}, {170, 0, 85, 255}, {85, 0, 170, 255} };
+        uint8_t expected[16][4];
+        PaletteByColumn(fourColor, expected);
+        CheckBlock("BC1 4 color", VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 }, expected);
+
+        // c0 = 0x001F <= c1 = 0xF800: 3 color mode, color 2 is the average and color 3 is black (transparent for BC1 RGBA).
+        const uint8_t threeColorRgb[4][4] = { {0, 0, 255, 255}, {255, 0, 0, 255}, {127, 0, 127, 255}, {0, 0, 0, 255} };
+        PaletteByColumn(threeColorRgb, expected);
+        CheckBlock("BC1 RGB 3 color", VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 }, expected);
+
+        const uint8_t threeColorRgba[4][4] = { {0, 0, 255, 255}, {255, 0, 0, 255}, {127, 0, 127, 255}, {0, 0, 0, 0} };
+        PaletteByColumn(threeColorRgba, expected);
+        CheckBlock("BC1 RGBA 3 color", VK_FORMAT_BC1_RGBA_SRGB_BLOCK, VK_FORMAT_R8G8B8A8_SRGB, 4, { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 }, expected);
+    }
+
+    void TestBc2()
+    {
+        // Explicit alpha (texel i has alpha i*17).  The color part has c0 < c1 but BC2 is always 4 color mode.
+        const uint8_t colors[4][4] = { {0, 0, 255, 0}, {255, 0, 0, 0}, {85, 0, 170, 0}, {170, 0, 85, 0} };
+        uint8_t expected[16][4];
+        PaletteByColumn(colors, expected);
+        for (uint32_t i = 0; i < 16; ++i)
+            expected[i][3] = uint8_t(i * 17);
+        CheckBlock("BC2", VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4,
+            { 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 }, expected);
+    }
+
+    // Alpha/channel values for the BC4 style blocks below, texel i uses index i % 8.
+    const uint8_t cEightValue[8] = { 255, 0, 218, 182, 145, 109, 72, 36 };   // a0 = 255 > a1 = 0
+    const uint8_t cSixValue[8] = { 0, 255, 51, 102, 153, 204, 0, 255 };     // a0 = 0 <= a1 = 255 (indices 6 and 7 are 0 and 255)
+
+    void TestBc3()
+    {
+        // Alpha in 8 value mode, color c0 = 0x07E0 (green) > c1 = 0 (black).
+        const uint8_t colors[4][4] = { {0, 255, 0, 0}, {0, 0, 0, 0}, {0, 170, 0, 0}, {0, 85, 0, 0} };
+        uint8_t expected[16][4];
+        PaletteByColumn(colors, expected);
+        for (uint32_t i = 0; i < 16; ++i)
+            expected[i][3] = cEightValue[i % 8];
+        CheckBlock("BC3", VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_R8G8B8A8_SRGB, 4,
+            { 0xFF, 0x00, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0xE0, 0x07, 0x00, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 }, expected);
+    }
+
+    void TestBc4Bc5()
+    {
+        uint8_t expected[16][4] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+            expected[i][0] = cSixValue[i % 8];
+        CheckBlock("BC4", VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_R8_UNORM, 1, { 0x00, 0xFF, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA }, expected);
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            expected[i][0] = cEightValue[i % 8];
+            expected[i][1] = cSixValue[i % 8];
+        }
+        CheckBlock("BC5", VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_R8G8_UNORM, 2,
+            { 0xFF, 0x00, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x00, 0xFF, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA }, expected);
+    }
+
+    //
+    // ETC2
+    // Index bytes FF 00 F0 F0 give every texel the index of its column (x).
+    //
+
+    void TestEtc2Rgb()
+    {
+        uint8_t expected[16][4];
+
+        // Individual mode: bases 0xF08 / 0x0F8 (side by side sub blocks), tables 0 and 7.
+        const uint8_t individual[4][4] = { {255, 2, 138, 255}, {255, 8, 144, 255}, {0, 208, 89, 255}, {0, 72, 0, 255} };
+        PaletteByColumn(individual, expected);
+        CheckBlock("ETC2 RGB individual", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0xF0, 0x0F, 0x88, 0x1C, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // Differential mode: base (16,8,31) delta (3,-4,0), tables 1 and 2, flipped (stacked sub blocks).
+        const uint8_t differential[2][4][4] = {
+            { {137, 71, 255, 255}, {149, 83, 255, 255}, {127, 61, 250, 255}, {115, 49, 238, 255} },
+            { {165, 42, 255, 255}, {185, 62, 255, 255}, {147, 24, 246, 255}, {127, 4, 226, 255} } };
+        for (uint32_t i = 0; i < 16; ++i)
+            memcpy(expected[i], differential[i / 8][i % 4], 4);
+        CheckBlock("ETC2 RGB differential", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x83, 0x44, 0xF8, 0x2B, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // T mode (red overflows): c0 = 0xA5A, c1 = 0x3C6, distance 32.
+        const uint8_t tMode[4][4] = { {170, 85, 170, 255}, {83, 236, 134, 255}, {51, 204, 102, 255}, {19, 172, 70, 255} };
+        PaletteByColumn(tMode, expected);
+        CheckBlock("ETC2 RGB T mode", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0xF2, 0x5A, 0x3C, 0x6B, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // H mode (green overflows): c0 = 0xC6E, c1 = 0x2A5, c0 >= c1 so distance 32.
+        const uint8_t hMode[4][4] = { {236, 134, 255, 255}, {172, 70, 206, 255}, {66, 202, 117, 255}, {2, 138, 53, 255} };
+        PaletteByColumn(hMode, expected);
+        CheckBlock("ETC2 RGB H mode", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x63, 0xEB, 0x15, 0x2E, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // Planar mode (blue overflows): origin (130,129,251), horizontal (0,255,0), vertical (255,0,255).
+        const uint8_t planar[16][4] = {
+            {130, 129, 251, 255}, {98, 161, 188, 255}, {65, 192, 126, 255}, {33, 224, 63, 255},
+            {161, 97, 252, 255}, {129, 128, 189, 255}, {96, 160, 127, 255}, {64, 191, 64, 255},
+            {193, 65, 253, 255}, {160, 96, 190, 255}, {128, 128, 128, 255}, {95, 159, 65, 255},
+            {224, 32, 254, 255}, {191, 64, 191, 255}, {159, 95, 129, 255}, {126, 127, 66, 255} };
+        CheckBlock("ETC2 RGB planar", VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, VK_FORMAT_R8G8B8A8_SRGB, 4, { 0x41, 0x01, 0xFB, 0x02, 0xFE, 0x07, 0xE0, 0x3F }, planar);
+    }
+
+    void TestEtc2RgbA1()
+    {
+        uint8_t expected[16][4];
+
+        // Opaque flag clear: index 2 is transparent black and index 0 is the unmodified base color.
+        const uint8_t punchThrough[2][4][4] = {
+            { {132, 66, 255, 255}, {149, 83, 255, 255}, {0, 0, 0, 0}, {115, 49, 238, 255} },
+            { {156, 33, 255, 255}, {185, 62, 255, 255}, {0, 0, 0, 0}, {127, 4, 226, 255} } };
+        for (uint32_t i = 0; i < 16; ++i)
+            memcpy(expected[i], punchThrough[i / 8][i % 4], 4);
+        CheckBlock("ETC2 A1 transparent", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x83, 0x44, 0xF8, 0x29, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // Opaque flag set: same as the ETC2 RGB differential block.
+        const uint8_t opaque[2][4][4] = {
+            { {137, 71, 255, 255}, {149, 83, 255, 255}, {127, 61, 250, 255}, {115, 49, 238, 255} },
+            { {165, 42, 255, 255}, {185, 62, 255, 255}, {147, 24, 246, 255}, {127, 4, 226, 255} } };
+        for (uint32_t i = 0; i < 16; ++i)
+            memcpy(expected[i], opaque[i / 8][i % 4], 4);
+        CheckBlock("ETC2 A1 opaque", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0x83, 0x44, 0xF8, 0x2B, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+
+        // T mode with the opaque flag clear: index 2 is transparent black, the other paint colors are unchanged.
+        const uint8_t tMode[4][4] = { {170, 85, 170, 255}, {83, 236, 134, 255}, {0, 0, 0, 0}, {19, 172, 70, 255} };
+        PaletteByColumn(tMode, expected);
+        CheckBlock("ETC2 A1 T mode", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4, { 0xF2, 0x5A, 0x3C, 0x69, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+    }
+
+    void TestEtc2Rgba()
+    {
+        // EAC alpha base 128, multiplier 2, table 13.  Texel (x,y) uses index (x*4+y) % 8 (indices stored column major, first texel in the top bits).
+        const uint8_t alphas[8] = { 126, 124, 122, 108, 128, 130, 132, 146 };
+        const uint8_t colors[4][4] = { {255, 2, 138, 0}, {255, 8, 144, 0}, {0, 208, 89, 0}, {0, 72, 0, 0} };
+        uint8_t expected[16][4];
+        PaletteByColumn(colors, expected);
+        for (uint32_t y = 0; y < 4; ++y)
+            for (uint32_t x = 0; x < 4; ++x)
+                expected[y * 4 + x][3] = alphas[(x * 4 + y) % 8];
+        CheckBlock("ETC2 RGBA", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, 4,
+            { 0x80, 0x2D, 0x05, 0x39, 0x77, 0x05, 0x39, 0x77, 0xF0, 0x0F, 0x88, 0x1C, 0xFF, 0x00, 0xF0, 0xF0 }, expected);
+    }
+
+    void TestRgb8()
+    {
+        // 3x2 image with rows padded to 12 bytes (as KTX1 does), expanded to opaque rgba.
+        const uint8_t source[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xEE, 0xEE, 0xEE,
+                                   10, 11, 12, 13, 14, 15, 16, 17, 18 };
+        const uint8_t expected[] = { 1, 2, 3, 255, 4, 5, 6, 255, 7, 8, 9, 255, 10, 11, 12, 255, 13, 14, 15, 255, 16, 17, 18, 255 };
+        std::vector<uint8_t> decoded;
+        if (!TranscodeImage(VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, source, sizeof(source), 3, 2, 12, decoded))
+            Fail("RGB8", "TranscodeImage failed");
+        else if (decoded.size() != sizeof(expected) || memcmp(decoded.data(), expected, sizeof(expected)) != 0)
+            Fail("RGB8", "unexpected texels");
+        if (TranscodeImage(VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, source, sizeof(source) - 1, 3, 2, 12, decoded))
+            Fail("RGB8", "accepted a truncated image");
+        if (TranscodeImage(VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_R8G8B8A8_UNORM, source, 8 * 3, 8, 8, 0, decoded))
+            Fail("BC1", "accepted a truncated image");
+        if (TranscodeImage(VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, source, sizeof(source), 4, 4, 0, decoded))
+            Fail("BC1", "accepted a target SelectTranscodeFormat never picks");
+    }
+
+    //
+    // Block re-encode (decode -> re-encode -> decode) error bounds.
+    //
+
+    std::vector<uint8_t> Decode(const char* pTest, VkFormat format, const std::vector<uint8_t>& blocks, uint32_t width, uint32_t height)
+    {
+        const VkFormat decodedFormat = SelectTranscodeFormat(format, [](VkFormat f) { return f == VK_FORMAT_R8G8B8A8_UNORM || f == VK_FORMAT_R8G8B8A8_SRGB; }, false);
+        std::vector<uint8_t> decoded;
+        if (!TranscodeImage(format, decodedFormat, blocks.data(), blocks.size(), width, height, 0, decoded))
+            Fail(pTest, "decode failed");
+        return decoded;
+    }
+
+    std::vector<uint8_t> Reencode(const char* pTest, VkFormat format, VkFormat targetFormat, const std::vector<uint8_t>& blocks, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> reencoded;
+        if (!TranscodeImage(format, targetFormat, blocks.data(), blocks.size(), width, height, 0, reencoded))
+            Fail(pTest, "re-encode failed");
+        return reencoded;
+    }
+
+    /// Check the root mean square error of the given channels is within maxRmse and no texel is off by more than maxError.
+    /// The color of fully transparent reference texels is ignored.
+    void CheckError(const char* pTest, const std::vector<uint8_t>& reference, const std::vector<uint8_t>& decoded, uint32_t firstChannel, uint32_t numChannels, double maxRmse, int maxError)
+    {
+        if (reference.empty() || reference.size() != decoded.size())
+        {
+            Fail(pTest, "size mismatch");
+            return;
+        }
+        double sumSquared = 0.0;
+        int worst = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < reference.size(); i += 4)
+        {
+            if (reference[i + 3] == 0 && firstChannel < 3)
+                continue;
+            for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c, ++count)
+            {
+                const int error = std::abs(int(reference[i + c]) - int(decoded[i + c]));
+                sumSquared += double(error * error);
+                worst = std::max(worst, error);
+            }
+        }
+        const double rmse = std::sqrt(sumSquared / double(count));
+        printf("%s: rmse %.2f, max error %d\n", pTest, rmse, worst);
+        if (rmse > maxRmse || worst > maxError)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "rmse %.2f (limit %.2f), max error %d (limit %d)", rmse, maxRmse, worst, maxError);
+            Fail(pTest, message);
+        }
+    }
+
+    uint16_t Pack565(int r, int g, int b)
+    {
+        return uint16_t(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+    }
+
+    /// BC1 color blocks for a smooth image (endpoints follow a gradient across the image, indices ramp across each block).
+    void AppendBc1Color(std::vector<uint8_t>& blocks, uint32_t blockX, uint32_t blockY)
+    {
+        const int r = int(blockX * 16), g = int(blockY * 16), b = 255 - int(blockX * 8);
+        uint16_t c0 = Pack565(std::min(r + 40, 255), std::min(g + 24, 255), b);
+        uint16_t c1 = Pack565(r, g, std::max(b - 32, 0));
+        if (c0 <= c1)
+            std::swap(c0, c1);
+        const uint8_t rowIndices[4] = { 0xA0, 0xE8, 0xFA, 0x7E };  // diagonal ramp from c0 (index 0) through indices 2 and 3 to c1 (index 1)
+        for (uint8_t byte : { uint8_t(c0), uint8_t(c0 >> 8), uint8_t(c1), uint8_t(c1 >> 8), rowIndices[0], rowIndices[1], rowIndices[2], rowIndices[3] })
+            blocks.push_back(byte);
+    }
+
+    void TestReencode()
+    {
+        const uint32_t width = 64, height = 64;
+
+        // BC1 RGB -> ETC2 RGB -> BC1 RGB
+        std::vector<uint8_t> bc1;
+        for (uint32_t blockY = 0; blockY < height / 4; ++blockY)
+            for (uint32_t blockX = 0; blockX < width / 4; ++blockX)
+                AppendBc1Color(bc1, blockX, blockY);
+        const std::vector<uint8_t> bc1Texels = Decode("BC1", VK_FORMAT_BC1_RGB_UNORM_BLOCK, bc1, width, height);
+        const std::vector<uint8_t> etc2Rgb = Reencode("BC1 -> ETC2 RGB", VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, bc1, width, height);
+        const std::vector<uint8_t> etc2RgbTexels = Decode("ETC2 RGB", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, etc2Rgb, width, height);
+        CheckError("BC1 -> ETC2 RGB", bc1Texels, etc2RgbTexels, 0, 4, 6.0, 24);
+        const std::vector<uint8_t> bc1Again = Reencode("ETC2 RGB -> BC1", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_BC1_RGB_UNORM_BLOCK, etc2Rgb, width, height);
+        CheckError("ETC2 RGB -> BC1", etc2RgbTexels, Decode("BC1", VK_FORMAT_BC1_RGB_UNORM_BLOCK, bc1Again, width, height), 0, 4, 6.0, 24);
+
+        // BC3 -> ETC2 RGBA -> BC3 (alpha gradient across the image, ramping across each block)
+        std::vector<uint8_t> bc3;
+        for (uint32_t blockY = 0; blockY < height / 4; ++blockY)
+            for (uint32_t blockX = 0; blockX < width / 4; ++blockX)
+            {
+                const uint8_t a0 = uint8_t(255 - blockY * 8), a1 = uint8_t(a0 - 48 - blockX);
+                for (uint8_t byte : { a0, a1, uint8_t(0x88), uint8_t(0xC6), uint8_t(0xFA), uint8_t(0x88), uint8_t(0xC6), uint8_t(0xFA) })
+                    bc3.push_back(byte);
+                AppendBc1Color(bc3, blockX, blockY);
+            }
+        const std::vector<uint8_t> bc3Texels = Decode("BC3", VK_FORMAT_BC3_UNORM_BLOCK, bc3, width, height);
+        const std::vector<uint8_t> etc2Rgba = Reencode("BC3 -> ETC2 RGBA", VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, bc3, width, height);
+        const std::vector<uint8_t> etc2RgbaTexels = Decode("ETC2 RGBA", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, etc2Rgba, width, height);
+        CheckError("BC3 -> ETC2 RGBA color", bc3Texels, etc2RgbaTexels, 0, 3, 6.0, 24);
+        CheckError("BC3 -> ETC2 RGBA alpha", bc3Texels, etc2RgbaTexels, 3, 1, 2.0, 4);
+        const std::vector<uint8_t> bc3Again = Reencode("ETC2 RGBA -> BC3", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, etc2Rgba, width, height);
+        const std::vector<uint8_t> bc3AgainTexels = Decode("BC3", VK_FORMAT_BC3_UNORM_BLOCK, bc3Again, width, height);
+        CheckError("ETC2 RGBA -> BC3 color", etc2RgbaTexels, bc3AgainTexels, 0, 3, 6.0, 24);
+        CheckError("ETC2 RGBA -> BC3 alpha", etc2RgbaTexels, bc3AgainTexels, 3, 1, 2.0, 4);
+
+        // ETC2 punch through alpha -> BC3 keeps the alpha exact (0 or 255).  The golden differential block's colors are far from a line so BC1 color error is higher.
+        std::vector<uint8_t> etc2A1;
+        for (uint32_t i = 0; i < (width / 4) * (height / 4); ++i)
+            for (uint8_t byte : { uint8_t(0x83), uint8_t(0x44), uint8_t(0xF8), uint8_t((i & 1) ? 0x29 : 0x2B), uint8_t(0xFF), uint8_t(0x00), uint8_t(0xF0), uint8_t(0xF0) })
+                etc2A1.push_back(byte);
+        const std::vector<uint8_t> etc2A1Texels = Decode("ETC2 A1", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, etc2A1, width, height);
+        const std::vector<uint8_t> bc3FromA1 = Reencode("ETC2 A1 -> BC3", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, etc2A1, width, height);
+        const std::vector<uint8_t> bc3FromA1Texels = Decode("BC3", VK_FORMAT_BC3_UNORM_BLOCK, bc3FromA1, width, height);
+        CheckError("ETC2 A1 -> BC3 color", etc2A1Texels, bc3FromA1Texels, 0, 3, 16.0, 40);
+        CheckError("ETC2 A1 -> BC3 alpha", etc2A1Texels, bc3FromA1Texels, 3, 1, 0.0, 0);
+    }
+
+    //
+    // SelectTranscodeFormat
+    //
+
+    void CheckSelect(const char* pTest, VkFormat source, std::initializer_list<VkFormat> supported, bool allowBlockReencode, VkFormat expected)
+    {
+        const std::vector<VkFormat> supportedFormats(supported);
+        const auto IsSupported = [&supportedFormats](VkFormat format) {
+            return std::find(supportedFormats.begin(), supportedFormats.end(), format) != supportedFormats.end();
+        };
+        const VkFormat selected = SelectTranscodeFormat(source, IsSupported, allowBlockReencode);
+        if (selected != expected)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "selected format %d, expected %d", int(selected), int(expected));
+            Fail(pTest, message);
+        }
+    }
+
+    void TestSelect()
+    {
+        const auto bcDevice = { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB };
+        const auto etcDevice = { VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB };
+        const auto astcDevice = { VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK, VK_FORMAT_ASTC_8x8_UNORM_BLOCK };
+
+        // Supported formats are used as is.
+        CheckSelect("supported source", VK_FORMAT_BC3_UNORM_BLOCK, bcDevice, true, VK_FORMAT_BC3_UNORM_BLOCK);
+        CheckSelect("supported ASTC source", VK_FORMAT_ASTC_4x4_UNORM_BLOCK, astcDevice, true, VK_FORMAT_ASTC_4x4_UNORM_BLOCK);
+
+        // Block re-encode (keeping srgb).
+        CheckSelect("BC1 RGB on ETC2", VK_FORMAT_BC1_RGB_UNORM_BLOCK, etcDevice, true, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK);
+        CheckSelect("BC1 RGB srgb on ETC2", VK_FORMAT_BC1_RGB_SRGB_BLOCK, etcDevice, true, VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK);
+        CheckSelect("BC1 RGBA on ETC2", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, etcDevice, true, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK);
+        CheckSelect("BC2 on ETC2", VK_FORMAT_BC2_SRGB_BLOCK, etcDevice, true, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK);
+        CheckSelect("BC3 on ETC2", VK_FORMAT_BC3_UNORM_BLOCK, etcDevice, true, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK);
+        CheckSelect("ETC2 RGB on BC", VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, bcDevice, true, VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+        CheckSelect("ETC2 A1 on BC", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, bcDevice, true, VK_FORMAT_BC3_UNORM_BLOCK);
+        CheckSelect("ETC2 RGBA on BC", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, bcDevice, true, VK_FORMAT_BC3_UNORM_BLOCK);
+
+        // Decode to uncompressed when block re-encode is disabled or the block target is not supported.
+        CheckSelect("BC3 on ETC2, no re-encode", VK_FORMAT_BC3_SRGB_BLOCK, etcDevice, false, VK_FORMAT_R8G8B8A8_SRGB);
+        CheckSelect("ETC2 RGB on BC, no re-encode", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, bcDevice, false, VK_FORMAT_R8G8B8A8_UNORM);
+        CheckSelect("BC1 on rgba8 only", VK_FORMAT_BC1_RGBA_SRGB_BLOCK, { VK_FORMAT_R8G8B8A8_SRGB }, true, VK_FORMAT_R8G8B8A8_SRGB);
+        CheckSelect("BC4 on ETC2", VK_FORMAT_BC4_UNORM_BLOCK, etcDevice, true, VK_FORMAT_R8_UNORM);
+        CheckSelect("BC5 on ETC2", VK_FORMAT_BC5_UNORM_BLOCK, etcDevice, true, VK_FORMAT_R8G8_UNORM);
+        CheckSelect("RGB8 expand", VK_FORMAT_R8G8B8_SRGB, bcDevice, true, VK_FORMAT_R8G8B8A8_SRGB);
+
+        // Nothing usable: srgb never falls back to unorm, and ASTC is never chosen (as a target, or transcoded from).
+        CheckSelect("srgb only unorm supported", VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_BC1_RGB_UNORM_BLOCK }, true, VK_FORMAT_UNDEFINED);
+        CheckSelect("ASTC source", VK_FORMAT_ASTC_4x4_UNORM_BLOCK, bcDevice, true, VK_FORMAT_UNDEFINED);
+        for (VkFormat source : { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, VK_FORMAT_R8G8B8_UNORM })
+            CheckSelect("ASTC only device", source, astcDevice, true, VK_FORMAT_UNDEFINED);
+    }
+}
+
+int main()
+{
+    TestBc1();
+    TestBc2();
+    TestBc3();
+    TestBc4Bc5();
+    TestEtc2Rgb();
+    TestEtc2RgbA1();
+    TestEtc2Rgba();
+    TestRgb8();
+    TestReencode();
+    TestSelect();
+
+    if (gFailures != 0)
+    {
+        printf("%d textureTranscode test(s) FAILED\n", gFailures);
+        return 1;
+    }
+    printf("textureTranscode tests passed\n");
+    return 0;
+}
@@ -0,0 +1,270 @@
+//============================================================================================================
+//
+//
+//                  Copyright (c) 2022, Qualcomm Innovation Center, Inc. All rights reserved.
+//                              SPDX-License-Identifier: BSD-3-Clause
+//
+//============================================================================================================
+
+// Uploads textures through TextureUploader / RecordImageUpload on a real Vulkan device (intended to run on a software driver, eg SwiftShader) and reads them back.
+// Covers 2d, cube and multi mip images in uncompressed and block compressed formats, padded source rows, and the staging ring buffer wrapping and growing.
+
+#include "vulkan/vulkan.hpp"
+#include "vulkan/textureUploader.hpp"
+#include "memory/memoryManager.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    /// Exit code ctest reports as skipped (SKIP_RETURN_CODE), when there is no Vulkan device to run on.
+    constexpr int cSkipReturnCode = 77;
+
+    /// Staging ring size for the test.  Smaller than the total of the uploads (so the ring wraps) and than the last texture (so the ring grows).
+    constexpr size_t cTestRingSize = 48 * 1024;
+
+    /// Buffer offset alignment for the readback copies (multiple of 4 and of every texel/block size used)
+    constexpr size_t cReadbackAlignment = 16;
+
+    struct TestTexture
+    {
+        const char* pName;
+        VkFormat    Format;
+        uint32_t    Width;
+        uint32_t    Height;
+        uint32_t    MipLevels;
+        uint32_t    Faces;
+        bool        PadRows;    ///< source rows padded to 4 bytes (as KTX1 does for uncompressed data)
+    };
+
+    // The first two (formats every device supports) are enough to wrap the ring, the last is bigger than the whole ring.
+    const TestTexture cTestTextures[] = {
+        { "2d rgba8 mips", VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 7, 1, false },
+        { "cube rgba8 mips", VK_FORMAT_R8G8B8A8_SRGB, 32, 32, 6, 6, false },
+        { "2d r8 padded rows mips", VK_FORMAT_R8_UNORM, 13, 7, 3, 1, true },
+        { "2d bc1 mips", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 64, 64, 7, 1, false },
+        { "cube bc3 mips", VK_FORMAT_BC3_UNORM_BLOCK, 32, 32, 6, 6, false },
+        { "2d bc5 non power of 2", VK_FORMAT_BC5_UNORM_BLOCK, 30, 18, 1, 1, false },
+        { "2d etc2 rgba mips", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 32, 32, 6, 1, false },
+        { "2d rgba8 bigger than the ring", VK_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1, false },
+    };
+
+    /// Source data of one subresource, and its layout in the image (tightly packed).
+    struct Subresource
+    {
+        uint32_t                Width;
+        uint32_t                Height;
+        uint32_t                MipLevel;
+        uint32_t                Face;
+        size_t                  RowBytes;   ///< bytes of one row of texels (or blocks)
+        size_t                  Rows;       ///< rows of texels (or blocks)
+        size_t                  RowPitch;   ///< bytes between source rows (RowBytes, or more if padded)
+        std::vector<uint8_t>    Data;
+    };
+
+    struct UploadedTexture
+    {
+        const TestTexture*                  pTest;
+        MemoryVmaAllocatedBuffer<VkImage>   Image;
+        std::vector<Subresource>            Subresources;
+    };
+
+    bool IsFormatUsable(Vulkan& vulkan, VkFormat format)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(vulkan.m_VulkanGpu, format, &properties);
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        return (properties.optimalTilingFeatures & required) == required;
+    }
+
+    /// Fill the subresources of the given texture with data unique to each subresource (so a copy to the wrong mip or face is caught).
+    std::vector<Subresource> MakeSubresources(const TestTexture& test, uint32_t seed)
+    {
+        const bool compressed = Vulkan::FormatIsCompressed(test.Format);
+        const uint32_t bytesPerBlock = Vulkan::FormatBytesPerBlock(test.Format);
+        std::vector<Subresource> subresources;
+        for (uint32_t face = 0; face < test.Faces; ++face)
+            for (uint32_t mip = 0; mip < test.MipLevels; ++mip)
+            {
+                Subresource subresource { std::max(1u, test.Width >> mip), std::max(1u, test.Height >> mip), mip, face };
+                subresource.RowBytes = size_t(compressed ? (subresource.Width + 3) / 4 : subresource.Width) * bytesPerBlock;
+                subresource.Rows = compressed ? (subresource.Height + 3) / 4 : subresource.Height;
+                subresource.RowPitch = test.PadRows ? (subresource.RowBytes + 3) & ~size_t(3) : subresource.RowBytes;
+                subresource.Data.resize(subresource.RowPitch * subresource.Rows);
+                const uint32_t subresourceSeed = seed * 64 + face * 8 + mip;
+                for (size_t i = 0; i < subresource.Data.size(); ++i)
+                    subresource.Data[i] = uint8_t(i * 7 + subresourceSeed * 13 + (i >> 9));
+                subresources.push_back(std::move(subresource));
+            }
+        return subresources;
+    }
+
+    bool Upload(Vulkan& vulkan, TextureUploader& uploader, const TestTexture& test, uint32_t seed, UploadedTexture& uploaded)
+    {
+        VkImageCreateInfo imageInfo { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        imageInfo.flags = (test.Faces == 6) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = test.Format;
+        imageInfo.extent = { test.Width, test.Height, 1 };
+        imageInfo.mipLevels = test.MipLevels;
+        imageInfo.arrayLayers = test.Faces;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        uploaded.pTest = &test;
+        uploaded.Image = vulkan.GetMemoryManager().CreateImage(imageInfo, MemoryManager::MemoryUsage::GpuExclusive);
+        if (!uploaded.Image)
+        {
+            printf("FAILED %s: unable to create image\n", test.pName);
+            return false;
+        }
+        uploaded.Subresources = MakeSubresources(test, seed);
+
+        std::vector<TextureSubresourceData> subresourceData;
+        for (const auto& subresource : uploaded.Subresources)
+            subresourceData.push_back({ subresource.Data.data(), subresource.Data.size(), subresource.Width, subresource.Height, 1, subresource.MipLevel, subresource.Face });
+        if (!RecordImageUpload(uploader, uploaded.Image.GetVkBuffer(), test.Format, subresourceData, test.MipLevels, test.Faces, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+        {
+            printf("FAILED %s: RecordImageUpload failed\n", test.pName);
+            return false;
+        }
+        return true;
+    }
+
+    /// Copy every subresource of the (uploaded) image back to the cpu and compare with the source data.
+    bool ReadbackAndCompare(Vulkan& vulkan, UploadedTexture& uploaded)
+    {
+        const TestTexture& test = *uploaded.pTest;
+        MemoryManager& memoryManager = vulkan.GetMemoryManager();
+
+        std::vector<VkBufferImageCopy> regions;
+        size_t readbackSize = 0;
+        for (const auto& subresource : uploaded.Subresources)
+        {
+            readbackSize = ((readbackSize + cReadbackAlignment - 1) / cReadbackAlignment) * cReadbackAlignment;
+            VkBufferImageCopy region {};
+            region.bufferOffset = readbackSize;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, subresource.MipLevel, subresource.Face, 1 };
+            region.imageExtent = { subresource.Width, subresource.Height, 1 };
+            regions.push_back(region);
+            readbackSize += subresource.RowBytes * subresource.Rows;
+        }
+
+        auto readback = memoryManager.CreateBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryManager::MemoryUsage::CpuExclusive);
+        if (!readback)
+        {
+            printf("FAILED %s: unable to create readback buffer\n", test.pName);
+            return false;
+        }
+
+        VkCommandBuffer cmdBuffer = vulkan.StartSetupCommandBuffer();
+        vulkan.SetImageLayout(uploaded.Image.GetVkBuffer(), cmdBuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, test.MipLevels, 0, test.Faces);
+        vkCmdCopyImageToBuffer(cmdBuffer, uploaded.Image.GetVkBuffer(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetVkBuffer(), (uint32_t)regions.size(), regions.data());
+        vulkan.FinishSetupCommandBuffer(cmdBuffer);
+
+        bool match = true;
+        {
+            MemoryCpuMapped<uint8_t> mapped = memoryManager.Map<uint8_t>(readback);
+            for (size_t i = 0; i < uploaded.Subresources.size() && match; ++i)
+            {
+                const Subresource& subresource = uploaded.Subresources[i];
+                const uint8_t* pReadback = mapped.data() + regions[i].bufferOffset;
+                for (size_t row = 0; row < subresource.Rows; ++row)
+                {
+                    if (memcmp(pReadback + row * subresource.RowBytes, subresource.Data.data() + row * subresource.RowPitch, subresource.RowBytes) != 0)
+                    {
+                        printf("FAILED %s: face %u mip %u row %zu does not match the uploaded data\n", test.pName, subresource.Face, subresource.MipLevel, row);
+                        match = false;
+                        break;
+                    }
+                }
+            }
+            memoryManager.Unmap(readback, std::move(mapped));
+        }
+        memoryManager.Destroy(std::move(readback));
+        return match;
+    }
+}
+
+int main()
+{
+    Vulkan vulkan;
+    if (!vulkan.InitHeadless())
+    {
+        printf("No Vulkan device, skipping\n");
+        return cSkipReturnCode;
+    }
+
+    // Start with a small ring, so the uploads below have to wait for (and reuse) ring space and then grow it.
+    StagingRingBuffer& ring = vulkan.GetStagingRingBuffer();
+    if (!ring.Initialize(&vulkan.GetMemoryManager(), cTestRingSize))
+    {
+        printf("FAILED: unable to initialize the staging ring buffer\n");
+        return 1;
+    }
+
+    int failures = 0;
+    std::vector<UploadedTexture> uploaded;
+    uploaded.reserve(std::size(cTestTextures));
+    {
+        // All the uploads through one uploader (as LoadKTXTextures does), so it submits part way through when the ring is full.
+        TextureUploader uploader(&vulkan);
+        for (const auto& test : cTestTextures)
+        {
+            if (!IsFormatUsable(vulkan, test.Format))
+            {
+                printf("Skipping %s: format %s not supported by the device\n", test.pName, Vulkan::VulkanFormatString(test.Format));
+                continue;
+            }
+            if (&test == &cTestTextures[std::size(cTestTextures) - 1])
+            {
+                // Everything so far has gone through the ring without growing it
+                if (ring.GetSize() != cTestRingSize || ring.GetHead() <= cTestRingSize)
+                {
+                    printf("FAILED: staging ring did not wrap (size %zu, %llu bytes allocated)\n", ring.GetSize(), (unsigned long long)ring.GetHead());
+                    ++failures;
+                }
+            }
+            uploaded.push_back({});
+            if (!Upload(vulkan, uploader, test, (uint32_t)uploaded.size(), uploaded.back()))
+            {
+                ++failures;
+                if (uploaded.back().Image)
+                    vulkan.GetMemoryManager().Destroy(std::move(uploaded.back().Image));
+                uploaded.pop_back();
+            }
+        }
+        if (!vulkan.WaitSetupSubmission(uploader.Finish()))
+        {
+            printf("FAILED: waiting for the uploads\n");
+            ++failures;
+        }
+    }
+    if (ring.GetSize() <= cTestRingSize)
+    {
+        printf("FAILED: staging ring did not grow for a texture bigger than it (size %zu)\n", ring.GetSize());
+        ++failures;
+    }
+
+    for (auto& texture : uploaded)
+    {
+        if (!ReadbackAndCompare(vulkan, texture))
+            ++failures;
+        vulkan.GetMemoryManager().Destroy(std::move(texture.Image));
+    }
+
+    if (failures != 0)
+    {
+        printf("%d textureUploader test(s) FAILED\n", failures);
+        return 1;
+    }
+    printf("textureUploader tests passed (%zu textures)\n", uploaded.size());
+    return 0;
+}
@@ -281,7 +281,10 @@ bool Application::InitFramebuffersRenderPassesAndDrawables()
     }
 
     // Create render target(s) for the scene render (sub) passes.
-    if (!m_LinearColorRT.Initialize(pVulkan, gRenderWidth, gRenderHeight, PassColorFormats, DepthFormat, ObjectRenderPass, (VkRenderPass)VK_NULL_HANDLE, PassColorMsaa, "Main RT", PassTextureTypes))
+    // Depth is cleared and discarded by the (sub)passes so can be transient (lazily allocated).
+    RenderTargetAttachmentUsage ObjectPassUsage{};
+    ObjectPassUsage.DepthOutputUsage = RenderPassOutputUsage::Discard;
+    if (!m_LinearColorRT.Initialize(pVulkan, gRenderWidth, gRenderHeight, PassColorFormats, DepthFormat, ObjectRenderPass, (VkRenderPass)VK_NULL_HANDLE, PassColorMsaa, "Main RT", PassTextureTypes, VK_FILTER_LINEAR, nullptr, &ObjectPassUsage))
     {
         LOGE("Error initializing LinearColorRT");
         return false;
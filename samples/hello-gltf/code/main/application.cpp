@@ -16,6 +16,7 @@
 #include "material/drawable.hpp"
 #include "material/shaderManager.hpp"
 #include "material/materialManager.hpp"
+#include "memory/bufferUploader.hpp"
 #include "camera/cameraController.hpp"
 #include "camera/cameraControllerTouch.hpp"
 #include "system/math_common.hpp"
@@ -40,6 +41,9 @@ namespace
 
     const char* gMuseumAssetsPath = "Media\\Meshes";
     const char* gTextureFolder    = "Media\\Textures\\";
+
+    // Per frame space for the per material uniforms (ObjectFragUB rounded up to minUniformBufferOffsetAlignment, typically 256 bytes, so room for 2k materials)
+    static constexpr size_t cUniformRingFrameSize = 512 * 1024;
 }
 
 ///
@@ -136,11 +140,9 @@ void Application::Destroy()
     // Uniform Buffers
     ReleaseUniformBuffer(pVulkan, &m_ObjectVertUniform);
     ReleaseUniformBuffer(pVulkan, &m_LightUniform);
-     
-    for (auto& [hash, objectUniform] : m_ObjectFragUniforms)
-    {
-        ReleaseUniformBuffer(pVulkan, &objectUniform.objectFragUniform);
-    }
+    m_UniformRingBuffer.Destroy();
+    m_ObjectFragUniformOrder.clear();
+    m_ObjectFragUniforms.clear();
 
     // Cmd buffers
     for (int whichPass = 0; whichPass < NUM_RENDER_PASSES; whichPass++)
@@ -168,13 +170,11 @@ void Application::Destroy()
     // Drawables
     m_SceneDrawables.clear();
     m_BlitQuadDrawable.reset();
+    m_GeometryArena.Destroy();
 
     // Textures
-    for (auto& [key, texture] : m_LoadedTextures)
-    {
-        texture.Release(m_vulkan.get());
-    }
     m_LoadedTextures.clear();
+    m_TextureCache.reset();
 
     // Internal
     m_ShaderManager.reset();
@@ -319,7 +319,14 @@ bool Application::InitUniforms()
     {
         return false;
     }
-    
+
+    // Per material uniforms are sub-allocated (each frame) from one persistently mapped buffer and bound with dynamic offsets.
+    const size_t minAlignment = (size_t)pVulkan->GetGpuProperties().Base.properties.limits.minUniformBufferOffsetAlignment;
+    if (!m_UniformRingBuffer.Initialize(&pVulkan->GetMemoryManager(), cUniformRingFrameSize, NUM_VULKAN_BUFFERS, minAlignment))
+    {
+        return false;
+    }
+
     return true;
 }
 
@@ -381,7 +388,7 @@ bool Application::InitGui(uintptr_t windowHandle)
 }
 
 //-----------------------------------------------------------------------------
-VulkanTexInfo* Application::GetOrLoadTexture(const char* textureName)
+const VulkanTexInfo* Application::GetOrLoadTexture(const char* textureName)
 //-----------------------------------------------------------------------------
 {
     if (textureName == nullptr || textureName[0] == 0)
@@ -400,7 +407,7 @@ VulkanTexInfo* Application::GetOrLoadTexture(const char* textureName)
     auto iter = m_LoadedTextures.find(textureFilename.string());
     if (iter != m_LoadedTextures.end())
     {
-        return &iter->second;
+        return iter->second.get();
     }
 
     // Prepare the texture path
@@ -408,12 +415,11 @@ VulkanTexInfo* Application::GetOrLoadTexture(const char* textureName)
     textureInternalPath.append(textureFilename.string());
     textureInternalPath.append(".ktx");
 
-    auto loadedTexture = LoadKTXTexture(m_vulkan.get(), *m_AssetManager, textureInternalPath.c_str());
-    if (!loadedTexture.IsEmpty())
+    // Texture cache shares the texture between filenames with the same contents.
+    auto loadedTexture = m_TextureCache->GetOrLoad(textureInternalPath);
+    if (loadedTexture)
     {
-        m_LoadedTextures.insert({ textureFilename.string() , std::move(loadedTexture) });
-        VulkanTexInfo* texInfo = &m_LoadedTextures[textureFilename.string()];
-        return texInfo;
+        return m_LoadedTextures.insert({ textureFilename.string() , std::move(loadedTexture) }).first->second.get();
     }
 
     return nullptr;
@@ -439,6 +445,8 @@ bool Application::LoadMeshObjects()
     LOGI("Loading and preparing the museum...");
     LOGI("***********************************");
 
+    m_TextureCache = std::make_unique<TextureCache>(*m_vulkan, *m_AssetManager);
+
     auto* whiteTexture         = GetOrLoadTexture("white_d.ktx");
     auto* blackTexture         = GetOrLoadTexture("black_d.ktx");
     auto* normalDefaultTexture = GetOrLoadTexture("normal_default.ktx");
@@ -449,22 +457,31 @@ bool Application::LoadMeshObjects()
         return false;
     }
 
-    auto UniformBufferLoader = [&](const ObjectMaterialParameters& objectMaterialParameters) -> ObjectMaterialParameters&
+    // Set if there are more materials than fit in the uniform ring buffer (fails the load).
+    bool uniformRingOverflow = false;
+
+    auto UniformBufferLoader = [&](const ObjectMaterialParameters& objectMaterialParameters) -> const ObjectMaterialParameters*
     {
         auto hash = objectMaterialParameters.GetHash();
 
         auto iter = m_ObjectFragUniforms.try_emplace(hash, ObjectMaterialParameters());
         if (iter.second)
         {
-            Vulkan* pVulkan = m_vulkan.get();
-            iter.first->second.objectFragUniformData = objectMaterialParameters.objectFragUniformData;
-            if (!CreateUniformBuffer(pVulkan, iter.first->second.objectFragUniform))
+            // Written to the ring buffer in creation order, so each material's data is at the same offset in every frame's region.
+            const uint32_t frameOffset = (uint32_t)(m_ObjectFragUniformOrder.size() * m_UniformRingBuffer.GetAlignedSize(sizeof(ObjectFragUB)));
+            if (frameOffset + sizeof(ObjectFragUB) > m_UniformRingBuffer.GetFrameSize())
             {
-                LOGE("Failed to create object uniform buffer");
+                LOGE("Too many object materials for the uniform ring buffer (%zu)", m_ObjectFragUniformOrder.size() + 1);
+                m_ObjectFragUniforms.erase(iter.first);
+                uniformRingOverflow = true;
+                return nullptr;
             }
+            iter.first->second.objectFragUniformData = objectMaterialParameters.objectFragUniformData;
+            iter.first->second.frameOffset = frameOffset;
+            m_ObjectFragUniformOrder.push_back(&iter.first->second);
         }
 
-        return iter.first->second;
+        return &iter.first->second;
     };
 
     auto MaterialLoader = [&](const MeshObjectIntermediate::MaterialDef& materialDef)->std::optional<Material>
@@ -516,7 +533,7 @@ bool Application::LoadMeshObjects()
                 }
                 else if (bufferName == "Frag")
                 {
-                    return { UniformBufferLoader(objectMaterial).objectFragUniform.buf.GetVkBuffer()};
+                    return { m_UniformRingBuffer.GetVkBuffer() };
                 }
                 else if (bufferName == "Light")
                 {
@@ -527,6 +544,17 @@ bool Application::LoadMeshObjects()
             }
             );
 
+        const ObjectMaterialParameters* pFragUniform = UniformBufferLoader(objectMaterial);
+        if (!pFragUniform)
+        {
+            return std::nullopt;    // not drawn, load fails once the mesh file is loaded
+        }
+        const uint32_t fragFrameOffset = pFragUniform->frameOffset;
+        for (uint32_t whichBuffer = 0; whichBuffer < NUM_VULKAN_BUFFERS; ++whichBuffer)
+        {
+            shaderMaterial.SetDynamicOffset(whichBuffer, "Frag", m_UniformRingBuffer.GetFrameOffset(whichBuffer) + fragFrameOffset);
+        }
+
         return shaderMaterial;
     };
 
@@ -557,6 +585,14 @@ bool Application::LoadMeshObjects()
         LOGI("Found %d meshes", static_cast<int>(meshFiles.size()));
     }
 
+    // All the scene meshes share vertex/index buffers (sub-allocated from the arena) rather than each having their own.
+    // Device local (filled by the drawable loader's BufferUploader) on discrete gpus, host visible on unified memory gpus.
+    if (!m_GeometryArena.Initialize(&m_vulkan->GetMemoryManager(), 1024 * 1024, 4 * 1024 * 1024, 0, BufferUploader::PrefersDeviceLocal(*m_vulkan)))
+    {
+        LOGE("Error initializing the geometry arena");
+        return false;
+    }
+
     for (auto& meshFile : meshFiles)
     {
         bool sceneMeshResult = DrawableLoader::LoadDrawables(
@@ -569,7 +605,14 @@ bool Application::LoadMeshObjects()
             m_SceneDrawables,
             {},    // RenderPassMultisample 
             false, // UseInstancing
-            {});   // RenderPassSubpasses
+            {},    // RenderPassSubpasses
+            glm::vec3(1.0f, 1.0f, 1.0f),
+            &m_GeometryArena);
+        if (uniformRingOverflow)
+        {
+            LOGE("Error Loading the %s gltf file, it has more materials than fit in the uniform ring buffer (%zu bytes per frame)", meshFile.c_str(), m_UniformRingBuffer.GetFrameSize());
+            return false;
+        }
         if (!sceneMeshResult)
         {
             LOGE("Error Loading the %s gltf file", meshFile.c_str());
@@ -579,6 +622,12 @@ bool Application::LoadMeshObjects()
         }
     }
 
+    const auto textureStats = m_TextureCache->GetStats();
+    LOGI("Loaded %u textures (%zu bytes), %u filenames shared an already loaded texture", textureStats.NumLoads, textureStats.MemoryUsed, textureStats.NumContentHits);
+    const auto geometryStats = m_GeometryArena.GetStats();
+    LOGI("Geometry arena: %u ranges in %u buffer blocks (%zu of %zu bytes used)", geometryStats.NumAllocations, geometryStats.NumBlocks, geometryStats.MemoryUsed, geometryStats.BufferMemory);
+    m_vulkan->GetMemoryManager().LogStats();
+
     LOGI("*********************");
     LOGI("Creating Quad mesh...");
     LOGI("*********************");
@@ -811,6 +860,22 @@ void Application::UpdateGui()
             glm::vec3 LightDirNotNormalized   = m_LightUniformData.LightDirection;
             LightDirNotNormalized             = glm::normalize(LightDirNotNormalized);
             m_LightUniformData.LightDirection = glm::vec4(LightDirNotNormalized, 0.0f);
+
+            if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_Framed))
+            {
+                const auto memoryStats = m_vulkan->GetMemoryManager().GetStats();
+                for (uint32_t category = 1/*skip Unspecified*/; category < (uint32_t)MemoryCategory::Count; ++category)
+                {
+                    const auto& categoryStats = memoryStats.Categories[category];
+                    if (categoryStats.TotalAllocations > 0)
+                        ImGui::Text("%s: %.1f MB (peak %.1f MB)", MemoryManager::GetCategoryName((MemoryCategory)category), categoryStats.LiveBytes / (1024.0f * 1024.0f), categoryStats.PeakBytes / (1024.0f * 1024.0f));
+                }
+                for (const auto& heapStats : memoryStats.Heaps)
+                {
+                    if ((heapStats.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0)
+                        ImGui::Text("Device heap: %.1f of %.1f MB budget%s", heapStats.Usage / (1024.0f * 1024.0f), heapStats.Budget / (1024.0f * 1024.0f), memoryStats.HasMemoryBudgetExt ? "" : " (estimated)");
+                }
+            }
         }
         ImGui::End();
 
@@ -836,10 +901,17 @@ bool Application::UpdateUniforms(uint32_t whichBuffer)
         UpdateUniformBuffer(pVulkan, m_ObjectVertUniform, m_ObjectVertUniformData);
     }
 
-    // Frag data
-    for (auto& [hash, objectUniform] : m_ObjectFragUniforms)
+    // Frag data (same order every frame, so each material's data lands at the offset its command buffers were recorded with)
+    m_UniformRingBuffer.BeginFrame(whichBuffer);
+    for (const ObjectMaterialParameters* pObjectUniform : m_ObjectFragUniformOrder)
     {
-        UpdateUniformBuffer(pVulkan, objectUniform.objectFragUniform, objectUniform.objectFragUniformData);
+        const uint32_t dynamicOffset = m_UniformRingBuffer.Write(pObjectUniform->objectFragUniformData);
+        if (dynamicOffset == UINT32_MAX)
+        {
+            LOGE("Uniform ring buffer full (%zu materials)", m_ObjectFragUniformOrder.size());
+            return false;
+        }
+        assert(dynamicOffset == m_UniformRingBuffer.GetFrameOffset(whichBuffer) + pObjectUniform->frameOffset);
     }
 
     // Light data
@@ -868,6 +940,9 @@ void Application::Render(float fltDiffTime)
     auto currentVulkanBuffer = m_vulkan->SetNextBackBuffer();
     uint32_t whichBuffer     = currentVulkanBuffer.idx;
 
+    // Release any textures evicted from the cache that the gpu has finished with.
+    m_TextureCache->NextFrame();
+
     // ********************************
     // Application Draw() - Begin
     // ********************************
@@ -12,6 +12,9 @@
 #pragma once
 
 #include "main/applicationHelperBase.hpp"
+#include "memory/geometryArena.hpp"
+#include "memory/uniformRingBuffer.hpp"
+#include "vulkan/textureCache.hpp"
 #include <map>
 #include <unordered_map>
 #include <functional>
@@ -106,8 +109,8 @@ class Application : public ApplicationHelperBase
 {
     struct ObjectMaterialParameters
     {
-        UniformT<ObjectFragUB>  objectFragUniform;
         ObjectFragUB            objectFragUniformData;
+        uint32_t                frameOffset = 0;    // offset of objectFragUniformData within each m_UniformRingBuffer frame region
 
         std::size_t GetHash() const
         {
@@ -156,7 +159,7 @@ private:
     bool InitLocalSemaphores();
     bool BuildCmdBuffers();
 
-    VulkanTexInfo* GetOrLoadTexture(const char* textureName);
+    const VulkanTexInfo* GetOrLoadTexture(const char* textureName);
 
 private:
 
@@ -179,8 +182,11 @@ private:
     UniformT<LightUB>                                         m_LightUniform;
     LightUB                                                   m_LightUniformData;
     std::unordered_map<std::size_t, ObjectMaterialParameters> m_ObjectFragUniforms;
+    std::vector<const ObjectMaterialParameters*>              m_ObjectFragUniformOrder;   // m_ObjectFragUniforms in the order they are written to the ring buffer (each frame)
+    UniformRingBuffer                                         m_UniformRingBuffer;
 
     // Drawables
+    GeometryArena         m_GeometryArena;      // vertex/index data for all of m_SceneDrawables
     std::vector<Drawable> m_SceneDrawables;
     std::unique_ptr<Drawable> m_BlitQuadDrawable;
 
@@ -191,5 +197,6 @@ private:
     std::unique_ptr<MaterialManager> m_MaterialManager;
 
     // Textures
-    std::map<std::string, VulkanTexInfo> m_LoadedTextures;
+    std::unique_ptr<TextureCache> m_TextureCache;
+    std::map<std::string, TextureCache::Handle> m_LoadedTextures;   // textures referenced by the materials (by filename stem)
 };
@@ -170,6 +170,7 @@ bool Application::InitFramebuffersRenderPassesAndDrawables()
     // Clean up old render targets and render passes
     m_LinearColorRT.Release();
     m_TonemapRT.Release();
+    m_AliasedTargets.Destroy();
 
     if (m_BlitRenderPass != VK_NULL_HANDLE)
     {
@@ -272,8 +273,54 @@ bool Application::InitFramebuffersRenderPassesAndDrawables()
         }
         pVulkan->SetDebugObjectName( TonemapRenderPass, "TonemapRenderPass" );
 
+        //
+        // Render targets for the two passes share memory where their lifetimes (within the frame) do not overlap.
+        // The object pass depth is discarded after the object pass so its memory is reused by the tonemap output.
+        //
+        CreateTexObjectInfo TexInfo{};
+        TexInfo.uiWidth = gRenderWidth;
+        TexInfo.uiHeight = gRenderHeight;
+
+        TexInfo.Format = PassColorFormats.front();
+        TexInfo.TexType = TT_RENDER_TARGET;
+        TexInfo.Msaa = PassColorMsaa.front();
+        TexInfo.pName = "Main RT: Color";
+        const auto MainColorId = m_AliasedTargets.AddTexture( TexInfo );
+
+        TexInfo.Format = DepthFormat;
+        TexInfo.TexType = TT_DEPTH_TARGET;
+        TexInfo.pName = "Main RT: Depth";
+        const auto MainDepthId = m_AliasedTargets.AddTexture( TexInfo );
+
+        std::vector<AliasedRenderTargets::tTextureId> TonemapIds;
+        for( size_t WhichLayer = 0; WhichLayer < TonemapColorAndResolveFormats.size(); ++WhichLayer )
+        {
+            TexInfo.Format = TonemapColorAndResolveFormats[WhichLayer];
+            TexInfo.TexType = TonemapColorAndResolveTextureTypes[WhichLayer];
+            TexInfo.Msaa = TonemapColorAndResolveMsaa[WhichLayer];
+            TexInfo.pName = (WhichLayer == 0) ? "Tonemap RT: Color" : "Tonemap RT: Resolve";
+            TonemapIds.push_back( m_AliasedTargets.AddTexture( TexInfo ) );
+        }
+
+        const AliasedRenderTargets::tTextureId ObjectPassWrites[] = { MainColorId, MainDepthId };
+        m_ObjectPassIdx = m_AliasedTargets.AddPass( "Object", ObjectPassWrites );
+        m_TonemapPassIdx = m_AliasedTargets.AddPass( "Tonemap", TonemapIds, { &MainColorId, 1 } );
+        m_AliasedTargets.AddPass( "Blit", {}, { &TonemapIds.back(), 1 } );
+        if( !m_AliasedTargets.Build( pVulkan ) )
+        {
+            LOGE( "Error building aliased render targets" );
+            return false;
+        }
+
         // Create the render target for the Tonemap (only needed when passes are seperate - subpass variant has all the rendertarget buffers for both subpasses in m_LinearColorRT)
-        if( !m_TonemapRT.Initialize( pVulkan, gRenderWidth, gRenderHeight, TonemapColorAndResolveFormats, VK_FORMAT_UNDEFINED, TonemapRenderPass/*takes ownership*/, (VkRenderPass) VK_NULL_HANDLE, TonemapColorAndResolveMsaa, "Tonemap RT", TonemapColorAndResolveTextureTypes ) )
+        if( !m_TonemapRT.Initialize( pVulkan, m_AliasedTargets, TonemapIds, {}, TonemapRenderPass/*takes ownership*/, (VkRenderPass) VK_NULL_HANDLE, "Tonemap RT" ) )
+        {
+            LOGE( "Error initializing TonemapRT" );
+            return false;
+        }
+
+        // Create render target for the scene render pass.
+        if( !m_LinearColorRT.Initialize( pVulkan, m_AliasedTargets, { &MainColorId, 1 }, { &MainDepthId, 1 }, ObjectRenderPass/*takes ownership*/, (VkRenderPass) VK_NULL_HANDLE, "Main RT" ) )
         {
             LOGE( "Error initializing LinearColorRT" );
             return false;
@@ -282,8 +329,8 @@ bool Application::InitFramebuffersRenderPassesAndDrawables()
         m_TonemapSubPassIdx = 0;    // not subpassed!
     }
 
-    // Create render target(s) for the scene render (sub) passes.
-    if (!m_LinearColorRT.Initialize(pVulkan, gRenderWidth, gRenderHeight, PassColorFormats, DepthFormat, ObjectRenderPass, (VkRenderPass)VK_NULL_HANDLE, PassColorMsaa, "Main RT", PassTextureTypes))
+    // Create render target(s) for the scene render subpasses.
+    if( gUseSubpasses && !m_LinearColorRT.Initialize(pVulkan, gRenderWidth, gRenderHeight, PassColorFormats, DepthFormat, ObjectRenderPass, (VkRenderPass)VK_NULL_HANDLE, PassColorMsaa, "Main RT", PassTextureTypes))
     {
         LOGE("Error initializing LinearColorRT");
         return false;
@@ -626,6 +673,12 @@ bool Application::UpdateCommandBuffer(uint32_t bufferIdx)
     std::fill( std::begin(ClearColor.float32), std::end(ClearColor.float32), 0.0f);
     ClearColor.float32[0] = 0.1f;
 
+    if( !gUseSubpasses )
+    {
+        // Barriers for render targets reusing memory of targets from earlier passes (or the previous frame).
+        m_AliasedTargets.CmdBeginPass( commandBuffer.m_VkCommandBuffer, m_ObjectPassIdx );
+    }
+
     if( !commandBuffer.BeginRenderPass( Scissor, 0.0f, 1.0f, { &ClearColor , 1 }, m_LinearColorRT[0].GetNumColorLayers(), true, m_LinearColorRT.m_RenderPass, false, m_LinearColorRT[0].m_FrameBuffer, VK_SUBPASS_CONTENTS_INLINE  ) )
     {
         return false;
@@ -647,6 +700,8 @@ bool Application::UpdateCommandBuffer(uint32_t bufferIdx)
         // Tonemap has its own render pass.
         commandBuffer.EndRenderPass();
 
+        m_AliasedTargets.CmdBeginPass( commandBuffer.m_VkCommandBuffer, m_TonemapPassIdx );
+
         if( !commandBuffer.BeginRenderPass( Scissor, 0.0f, 1.0f, { &ClearColor , 1 }, 1, true, m_TonemapRT.m_RenderPass, false, m_TonemapRT[0].m_FrameBuffer, VK_SUBPASS_CONTENTS_INLINE ) )
         {
             return false;
@@ -1001,6 +1056,7 @@ void Application::Destroy()
     m_GuiRT.Release();
     m_TonemapRT.Release();
     m_LinearColorRT.Release();
+    m_AliasedTargets.Destroy();
 
     m_MaterialManager.reset();
     m_ShaderManager.reset();
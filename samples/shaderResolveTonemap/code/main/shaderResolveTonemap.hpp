@@ -106,6 +106,11 @@ private:
     // Render target for tonemap (when not running as part of a subpass chain)
     CRenderTargetArray<1>                   m_TonemapRT;
 
+    // Memory for the object and tonemap render targets (when not running as a subpass chain), aliased where their lifetimes do not overlap.
+    AliasedRenderTargets                    m_AliasedTargets;
+    uint32_t                                m_ObjectPassIdx = 0;
+    uint32_t                                m_TonemapPassIdx = 0;
+
     // Render target for GUI.
     CRenderTargetArray<1>                   m_GuiRT;
 